@@ -13,10 +13,17 @@
 #include <d3dcompiler.h> // For compiling shaders! D3DCompile
 #include <openxr/openxr.h>
 #include <openxr/openxr_platform.h>
+#include "xr_pose_history.h"
+#include "xr_pose_filter.h"
+#include "xr_input_log.h"
+#include "xr_locate_cache.h"
+#include "xr_swapchain_images.h"
 
 #include <thread> // sleep_for
+#include <chrono> // steady_clock, for frame timing
 #include <vector>
-#include <algorithm> // any_of
+#include <string>
+#include <algorithm> // any_of, sort
 
 using namespace std;
 using namespace DirectX; // Matrix math
@@ -43,8 +50,10 @@ struct input_state_t {
 	XrPath   handSubactionPath[2];
 	XrSpace  handSpace[2];
 	XrPosef  handPose[2];
+	XrTime   handPoseTime[2]; // When handPose was located
 	XrBool32 renderHand[2];
 	XrBool32 handSelect[2];
+	XrTime   predictedTime; // The display time the predicted poses are for
 };
 
 ///////////////////////////////////////////
@@ -57,10 +66,25 @@ PFN_xrDestroyDebugUtilsMessengerEXT   ext_xrDestroyDebugUtilsMessengerEXT = null
 ///////////////////////////////////////////
 
 struct app_transform_buffer_t {
-	XMFLOAT4X4 world;
 	XMFLOAT4X4 viewproj;
 };
 
+// Everything app_draw needs to draw one viewpoint, worked out ahead of time by
+// app_prepare_views. Instances for each view live in one shared instance buffer.
+struct app_view_draw_t {
+	XMFLOAT4X4 viewproj;
+	uint32_t   instance_start;
+	uint32_t   instance_count;
+};
+
+// Where our frame time goes. The CPU side work and the time we spend blocked on
+// the compositor are tracked separately, so it's easy to tell which one is the problem!
+struct xr_frame_timing_t {
+	double             prepare_ms; // Culling, sorting and filling instance data
+	swapchain_timing_t swapchain;  // Acquiring and waiting on images, see xr_swapchain_images.h
+	uint32_t           frames;
+};
+
 XrFormFactor            app_config_form = XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY;
 XrViewConfigurationType app_config_view = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
 
@@ -70,13 +94,27 @@ ID3D11InputLayout* app_shader_layout;
 ID3D11Buffer* app_constant_buffer;
 ID3D11Buffer* app_vertex_buffer;
 ID3D11Buffer* app_index_buffer;
+ID3D11Buffer* app_instance_buffer;
+uint32_t      app_instance_capacity = 0;
 
 vector<XrPosef> app_cubes;
 
+// Per-frame scratch data, kept around so we don't reallocate it every frame
+vector<XMFLOAT4X4>            app_cube_worlds;
+vector<XMFLOAT4X4>            app_instances;
+vector<pair<float, uint32_t>> app_sort_keys;
+vector<app_view_draw_t>       app_view_draws;
+
+// Smooths out the hand cursors, see xr_pose_filter.h for what the knobs do
+pose_filter_config_t app_hand_filter_config = pose_filter_default_config;
+pose_filter_t        app_hand_filter;
+
 void app_init();
-void app_draw(XrCompositionLayerProjectionView& layerView);
+void app_reserve_instances(uint32_t count);
+void app_prepare_views(const vector<XrCompositionLayerProjectionView>& views);
+void app_draw(XrCompositionLayerProjectionView& layerView, const app_view_draw_t& draw);
 void app_update();
-void app_update_predicted();
+void app_update_predicted(XrTime predicted_time);
 
 ///////////////////////////////////////////
 
@@ -86,6 +124,7 @@ XrSession      xr_session = {};
 XrSessionState xr_session_state = XR_SESSION_STATE_UNKNOWN;
 bool           xr_running = false;
 XrSpace        xr_app_space = {};
+XrSpace        xr_head_space = {};
 XrSystemId     xr_system_id = XR_NULL_SYSTEM_ID;
 input_state_t  xr_input = { };
 XrEnvironmentBlendMode   xr_blend = {};
@@ -94,6 +133,27 @@ XrDebugUtilsMessengerEXT xr_debug = {};
 vector<XrView>                  xr_views;
 vector<XrViewConfigurationView> xr_config_views;
 vector<swapchain_t>             xr_swapchains;
+vector<swapchain_image_t>       xr_frame_images; // One for each swapchain, what we hold of it this frame
+swapchain_calls_t               xr_swapchain_calls = {};
+
+// Every pose we locate at predicted time goes in here, so we can look up where the
+// hands and head were later on without asking the runtime again.
+pose_history_t xr_hand_history[2];
+pose_history_t xr_head_history;
+
+// Input can be recorded to a file, or replayed from one in place of the runtime. See
+// xr_input_log.h for the format, and wWinMain for how to turn it on. A headless replay
+// doesn't touch the runtime or the GPU at all, see openxr_replay_frame.
+input_log_t xr_input_log = {};
+bool        xr_headless  = false;
+
+// All our xrLocateSpace calls go through here, so nothing gets located twice in a frame
+locate_cache_t xr_locate_cache = {};
+
+// Frame timing is always counted, but only printed when "--timing" is on the command line
+const uint32_t    xr_timing_report_frames = 300;
+bool              xr_timing_report        = false;
+xr_frame_timing_t xr_timing = {};
 
 bool openxr_init(const char* app_name, int64_t swapchain_format);
 void openxr_make_actions();
@@ -103,6 +163,10 @@ void openxr_poll_actions();
 void openxr_poll_predicted(XrTime predicted_time);
 void openxr_render_frame();
 bool openxr_render_layer(XrTime predictedTime, vector<XrCompositionLayerProjectionView>& projectionViews, XrCompositionLayerProjection& layer);
+void openxr_report_timing();
+void openxr_record_input(uint8_t tag);
+void openxr_replay_input(uint8_t tag);
+void openxr_replay_frame();
 
 ///////////////////////////////////////////
 
@@ -114,7 +178,7 @@ bool                 d3d_init(LUID& adapter_luid);
 void                 d3d_shutdown();
 IDXGIAdapter1* d3d_get_adapter(LUID& adapter_luid);
 swapchain_surfdata_t d3d_make_surface_data(XrBaseInStructure& swapchainImage);
-void                 d3d_render_layer(XrCompositionLayerProjectionView& layerView, swapchain_surfdata_t& surface);
+void                 d3d_render_layer(XrCompositionLayerProjectionView& layerView, const app_view_draw_t& draw, swapchain_surfdata_t& surface);
 void                 d3d_swapchain_destroy(swapchain_t& swapchain);
 XMMATRIX             d3d_xr_projection(XrFovf fov, float clip_near, float clip_far);
 ID3DBlob* d3d_compile_shader(const char* hlsl, const char* entrypoint, const char* target);
@@ -123,12 +187,15 @@ ID3DBlob* d3d_compile_shader(const char* hlsl, const char* entrypoint, const cha
 
 constexpr char app_shader_code[] = R"_(
 cbuffer TransformBuffer : register(b0) {
-	float4x4 world;
 	float4x4 viewproj;
 };
 struct vsIn {
-	float4 pos  : SV_POSITION;
-	float3 norm : NORMAL;
+	float4 pos    : SV_POSITION;
+	float3 norm   : NORMAL;
+	float4 world0 : WORLD0;
+	float4 world1 : WORLD1;
+	float4 world2 : WORLD2;
+	float4 world3 : WORLD3;
 };
 struct psIn {
 	float4 pos   : SV_POSITION;
@@ -137,6 +204,7 @@ struct psIn {
 
 psIn vs(vsIn input) {
 	psIn output;
+	float4x4 world = float4x4(input.world0, input.world1, input.world2, input.world3);
 	output.pos = mul(float4(input.pos.xyz, 1), world);
 	output.pos = mul(output.pos, viewproj);
 
@@ -168,21 +236,66 @@ uint16_t app_inds[] = {
 // Main                                  //
 ///////////////////////////////////////////
 
-int __stdcall wWinMain(HINSTANCE, HINSTANCE, LPWSTR, int) {
-	if (!openxr_init("Single file OpenXR", d3d_swapchain_fmt)) {
+int __stdcall wWinMain(HINSTANCE, HINSTANCE, LPWSTR cmd_line, int) {
+	// Pass "--record <file>" to save all the input we get to a file, or "--replay <file>" to
+	// play it back instead of reading the controllers. Since we're a UWP app, the file needs
+	// to be somewhere we can reach, like the app's LocalState folder. "--timing" prints where
+	// the frame time goes every few seconds. "--headless" along with "--replay" runs the log
+	// without a headset or a GPU, as fast as it can, for benchmarking big scenes.
+	wstring  args    = cmd_line ? cmd_line : L"";
+	wchar_t* context  = nullptr;
+	for (wchar_t* arg = wcstok_s(&args[0], L" ", &context); arg != nullptr; arg = wcstok_s(nullptr, L" ", &context)) {
+		if (wcscmp(arg, L"--timing") == 0) {
+			xr_timing_report = true;
+			continue;
+		}
+		if (wcscmp(arg, L"--headless") == 0) {
+			xr_headless      = true;
+			xr_timing_report = true;
+			continue;
+		}
+
+		bool record = wcscmp(arg, L"--record") == 0;
+		bool replay = wcscmp(arg, L"--replay") == 0;
+		wchar_t* path = record || replay ? wcstok_s(nullptr, L" ", &context) : nullptr;
+		if (path == nullptr)
+			continue;
+
+		FILE* file = nullptr;
+		if (_wfopen_s(&file, path, record ? L"wb" : L"rb") != 0 ||
+			!input_log_begin(xr_input_log, file, record ? input_log_record : input_log_replay)) {
+			printf("Couldn't open input log %ls\n", path);
+			input_log_end(xr_input_log);
+			return 1;
+		}
+	}
+
+	if (xr_headless && xr_input_log.mode != input_log_replay) {
+		printf("--headless only works with --replay\n");
+		input_log_end(xr_input_log);
+		return 1;
+	}
+
+	if (!xr_headless && !openxr_init("Single file OpenXR", d3d_swapchain_fmt)) {
 		d3d_shutdown();
 		//MessageBox(nullptr, "OpenXR initialization failed\n", "Error", 1);
 		return 1;
 	}
-	openxr_make_actions();
+	if (!xr_headless)
+		openxr_make_actions();
 	app_init();
 
 	bool quit = false;
 	while (!quit) {
-		openxr_poll_events(quit);
+		if (xr_headless) {
+			openxr_replay_frame();
+		} else {
+			openxr_poll_events(quit);
+		}
 
-		if (xr_running) {
+		if (xr_running && !xr_headless) {
 			openxr_poll_actions();
+			openxr_record_input(input_log_tag_actions);
 			app_update();
 			openxr_render_frame();
 
@@ -191,8 +304,13 @@ int __stdcall wWinMain(HINSTANCE, HINSTANCE, LPWSTR, int) {
 				this_thread::sleep_for(chrono::milliseconds(250));
 			}
 		}
+
+		// A replay is over once the log runs out
+		if (xr_input_log.mode == input_log_replay && xr_input_log.finished)
+			quit = true;
 	}
 
+	input_log_end(xr_input_log);
 	openxr_shutdown();
 	d3d_shutdown();
 	return 0;
@@ -341,6 +459,13 @@ bool openxr_init(const char* app_name, int64_t swapchain_format) {
 		ref_space.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_LOCAL;
 		xrCreateReferenceSpace(xr_session, &ref_space, &xr_app_space);
 
+		// The VIEW space follows the user's head around, we locate it each frame to keep a
+		// history of where the head was.
+		ref_space.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_VIEW;
+		xrCreateReferenceSpace(xr_session, &ref_space, &xr_head_space);
+		locate_cache_init(xr_locate_cache, xrLocateSpace);
+		xr_swapchain_calls = { xrAcquireSwapchainImage, xrWaitSwapchainImage, xrReleaseSwapchainImage };
+
 		// Now we need to find all the viewpoints we need to take care of! For a stereo headset, this should be 2.
 		// Similarly, for an AR phone, we'll need 1, and a VR cave could have 6, or even 12!
 		uint32_t view_count = 0;
@@ -386,6 +511,10 @@ bool openxr_init(const char* app_name, int64_t swapchain_format) {
 				swapchain.surface_data[i] = d3d_make_surface_data((XrBaseInStructure&)swapchain.surface_images[i]);
 			}
 			xr_swapchains.push_back(swapchain);
+
+			swapchain_image_t image = {};
+			image.swapchain = handle;
+			xr_frame_images.push_back(image);
 		}
 
 		return true;
@@ -467,6 +596,7 @@ void openxr_shutdown() {
 		d3d_swapchain_destroy(xr_swapchains[i]);
 	}
 	xr_swapchains.clear();
+	xr_frame_images.clear();
 
 	// Release all the other OpenXR resources that we've created!
 	// What gets allocated, must get deallocated!
@@ -475,6 +605,7 @@ void openxr_shutdown() {
 		if (xr_input.handSpace[1] != XR_NULL_HANDLE) xrDestroySpace(xr_input.handSpace[1]);
 		xrDestroyActionSet(xr_input.actionSet);
 	}
+	if (xr_head_space != XR_NULL_HANDLE) xrDestroySpace(xr_head_space);
 	if (xr_app_space != XR_NULL_HANDLE) xrDestroySpace(xr_app_space);
 	if (xr_session != XR_NULL_HANDLE) xrDestroySession(xr_session);
 	if (xr_debug != XR_NULL_HANDLE) ext_xrDestroyDebugUtilsMessengerEXT(xr_debug);
@@ -493,6 +624,8 @@ void openxr_poll_events(bool& exit) {
 		case XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED: {
 			XrEventDataSessionStateChanged* changed = (XrEventDataSessionStateChanged*)&event_buffer;
 			xr_session_state = changed->state;
+			if (xr_input_log.mode == input_log_record)
+				input_log_write_session(xr_input_log, xr_session_state);
 
 			// Session state change is where we can begin and end sessions, as well as find quit messages!
 			switch (xr_session_state) {
@@ -519,6 +652,13 @@ void openxr_poll_events(bool& exit) {
 ///////////////////////////////////////////
 
 void openxr_poll_actions() {
+	// This is the start of a new frame, so last frame's locations are stale now
+	locate_cache_begin_frame(xr_locate_cache);
+
+	if (xr_input_log.mode == input_log_replay) {
+		openxr_replay_input(input_log_tag_actions);
+		return;
+	}
 	if (xr_session_state != XR_SESSION_STATE_FOCUSED)
 		return;
 
@@ -549,38 +689,54 @@ void openxr_poll_actions() {
 		xrGetActionStateBoolean(xr_session, &get_info, &select_state);
 		xr_input.handSelect[hand] = select_state.currentState && select_state.changedSinceLastSync;
 
-		// If we have a select event, update the hand pose to match the event's timestamp
-		if (xr_input.handSelect[hand]) {
-			XrSpaceLocation space_location = { XR_TYPE_SPACE_LOCATION };
-			XrResult        res = xrLocateSpace(xr_input.handSpace[hand], xr_app_space, select_state.lastChangeTime, &space_location);
-			if (XR_UNQUALIFIED_SUCCESS(res) &&
-				(space_location.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT) != 0 &&
-				(space_location.locationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT) != 0) {
-				xr_input.handPose[hand] = space_location.pose;
-			}
+		// If we have a select event, update the hand pose to match the event's timestamp. We
+		// usually already have poses on both sides of that time in the history, so we only
+		// need to ask the runtime when it's outside of what we've seen.
+		if (xr_input.handSelect[hand] &&
+			!pose_history_sample(xr_hand_history[hand], select_state.lastChangeTime, &xr_input.handPose[hand])) {
+			locate_cache_pose(xr_locate_cache, xr_input.handSpace[hand], xr_app_space, select_state.lastChangeTime, &xr_input.handPose[hand]);
 		}
+		if (xr_input.handSelect[hand])
+			xr_input.handPoseTime[hand] = select_state.lastChangeTime;
 	}
 }
 
 ///////////////////////////////////////////
 
 void openxr_poll_predicted(XrTime predicted_time) {
+	if (xr_input_log.mode == input_log_replay) {
+		openxr_replay_input(input_log_tag_predicted);
+		return;
+	}
+	xr_input.predictedTime = predicted_time;
 	if (xr_session_state != XR_SESSION_STATE_FOCUSED)
 		return;
 
+	// Ask for everything we'll need at the predicted time up front, and locate it all
+	// together. Anything else that wants one of these locations this frame gets the one
+	// we already have, instead of asking the runtime again.
+	for (size_t i = 0; i < 2; i++) {
+		if (xr_input.renderHand[i])
+			locate_cache_request(xr_locate_cache, xr_input.handSpace[i], xr_app_space, predicted_time);
+	}
+	locate_cache_request(xr_locate_cache, xr_head_space, xr_app_space, predicted_time);
+	locate_cache_resolve(xr_locate_cache);
+
 	// Update hand position based on the predicted time of when the frame will be rendered! This 
 	// should result in a more accurate location, and reduce perceived lag.
 	for (size_t i = 0; i < 2; i++) {
-		if (!xr_input.renderHand[i])
-			continue;
-		XrSpaceLocation spaceRelation = { XR_TYPE_SPACE_LOCATION };
-		XrResult        res = xrLocateSpace(xr_input.handSpace[i], xr_app_space, predicted_time, &spaceRelation);
-		if (XR_UNQUALIFIED_SUCCESS(res) &&
-			(spaceRelation.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT) != 0 &&
-			(spaceRelation.locationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT) != 0) {
-			xr_input.handPose[i] = spaceRelation.pose;
+		XrPosef pose;
+		if (xr_input.renderHand[i] && locate_cache_pose(xr_locate_cache, xr_input.handSpace[i], xr_app_space, predicted_time, &pose)) {
+			xr_input.handPose[i]     = pose;
+			xr_input.handPoseTime[i] = predicted_time;
+			pose_history_push(xr_hand_history[i], predicted_time, pose);
 		}
 	}
+
+	// Keep track of where the head is going to be too
+	XrPosef head_pose;
+	if (locate_cache_pose(xr_locate_cache, xr_head_space, xr_app_space, predicted_time, &head_pose))
+		pose_history_push(xr_head_history, predicted_time, head_pose);
 }
 
 ///////////////////////////////////////////
@@ -599,7 +755,8 @@ void openxr_render_frame() {
 	// Execute any code that's dependant on the predicted time, such as updating the location of
 	// controller models.
 	openxr_poll_predicted(frame_state.predictedDisplayTime);
-	app_update_predicted();
+	openxr_record_input(input_log_tag_predicted);
+	app_update_predicted(xr_input.predictedTime);
 
 	// If the session is active, lets render our layer in the compositor!
 	XrCompositionLayerBaseHeader* layer = nullptr;
@@ -617,6 +774,8 @@ void openxr_render_frame() {
 	end_info.layerCount = layer == nullptr ? 0 : 1;
 	end_info.layers = &layer;
 	xrEndFrame(xr_session, &end_info);
+
+	openxr_report_timing();
 }
 
 ///////////////////////////////////////////
@@ -633,35 +792,44 @@ bool openxr_render_layer(XrTime predictedTime, vector<XrCompositionLayerProjecti
 	xrLocateViews(xr_session, &locate_info, &view_state, (uint32_t)xr_views.size(), &view_count, xr_views.data());
 	views.resize(view_count);
 
-	// And now we'll iterate through each viewpoint, and render it!
+	// Set up our rendering information for each viewpoint, and then do all the CPU work for
+	// every view before we touch the swapchains! Culling, sorting and filling the instance
+	// buffer don't care which image we'll draw into, so there's no reason for them to sit
+	// behind the compositor.
+	auto prepare_start = chrono::steady_clock::now();
 	for (uint32_t i = 0; i < view_count; i++) {
-
-		// We need to ask which swapchain image to use for rendering! Which one will we get?
-		// Who knows! It's up to the runtime to decide.
-		uint32_t                    img_id;
-		XrSwapchainImageAcquireInfo acquire_info = { XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO };
-		xrAcquireSwapchainImage(xr_swapchains[i].handle, &acquire_info, &img_id);
-
-		// Wait until the image is available to render to. The compositor could still be
-		// reading from it.
-		XrSwapchainImageWaitInfo wait_info = { XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO };
-		wait_info.timeout = XR_INFINITE_DURATION;
-		xrWaitSwapchainImage(xr_swapchains[i].handle, &wait_info);
-
-		// Set up our rendering information for the viewpoint we're using right now!
 		views[i] = { XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW };
 		views[i].pose = xr_views[i].pose;
 		views[i].fov = xr_views[i].fov;
 		views[i].subImage.swapchain = xr_swapchains[i].handle;
 		views[i].subImage.imageRect.offset = { 0, 0 };
 		views[i].subImage.imageRect.extent = { xr_swapchains[i].width, xr_swapchains[i].height };
+	}
+	app_prepare_views(views);
+	auto prepare_end = chrono::steady_clock::now();
+	xr_timing.prepare_ms += chrono::duration<double, milli>(prepare_end - prepare_start).count();
+
+	// We need to ask which swapchain image to use for rendering! Which one will we get?
+	// Who knows! It's up to the runtime to decide. We grab them all up front, and only
+	// wait on each one right before we draw into it, so the compositor gets as much
+	// time as possible to let go of them. If anything fails, every image we still hold
+	// goes back, so next frame can start over.
+	if (!swapchain_acquire_all(xr_swapchain_calls, xr_frame_images.data(), view_count, xr_timing.swapchain))
+		return false;
+
+	// And now we'll iterate through each viewpoint, and render it!
+	for (uint32_t i = 0; i < view_count; i++) {
+		swapchain_image_t& image = xr_frame_images[i];
+		if (!swapchain_wait(xr_swapchain_calls, image, xr_timing.swapchain)) {
+			swapchain_release_all(xr_swapchain_calls, xr_frame_images.data(), view_count, xr_timing.swapchain);
+			return false;
+		}
 
 		// Call the rendering callback with our view and swapchain info
-		d3d_render_layer(views[i], xr_swapchains[i].surface_data[img_id]);
+		d3d_render_layer(views[i], app_view_draws[i], xr_swapchains[i].surface_data[image.index]);
 
 		// And tell OpenXR we're done with rendering to this one!
-		XrSwapchainImageReleaseInfo release_info = { XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO };
-		xrReleaseSwapchainImage(xr_swapchains[i].handle, &release_info);
+		swapchain_release(xr_swapchain_calls, image, xr_timing.swapchain);
 	}
 
 	layer.space = xr_app_space;
@@ -670,6 +838,105 @@ bool openxr_render_layer(XrTime predictedTime, vector<XrCompositionLayerProjecti
 	return true;
 }
 
+///////////////////////////////////////////
+
+void openxr_report_timing() {
+	xr_timing.frames++;
+	if (xr_timing.frames < xr_timing_report_frames)
+		return;
+
+	if (xr_timing_report) {
+		const swapchain_timing_t& swapchain = xr_timing.swapchain;
+		double frames = xr_timing.frames;
+		char   text[256];
+		sprintf_s(text, "Frame timing over %u frames: prepare %.3fms, acquire %.3fms, blocked %.3fms, %u wait timeouts, %u failed\n",
+			xr_timing.frames, xr_timing.prepare_ms / frames, swapchain.acquire_ms / frames, swapchain.blocked_ms / frames, swapchain.wait_timeouts, swapchain.failures);
+		printf("%s", text);
+		OutputDebugStringA(text);
+
+		const locate_cache_counters_t& locates = xr_locate_cache.counters;
+		sprintf_s(text, "Space locations per frame: %.2f queries, %.2f cache hits, %.2f runtime calls\n",
+			locates.queries / frames, locates.hits / frames, locates.runtime_calls / frames);
+		printf("%s", text);
+		OutputDebugStringA(text);
+	}
+
+	xr_timing = {};
+	xr_locate_cache.counters = {};
+}
+
+///////////////////////////////////////////
+
+void openxr_record_input(uint8_t tag) {
+	if (xr_input_log.mode != input_log_record)
+		return;
+
+	input_log_snapshot_t snapshot;
+	snapshot.predicted_time = xr_input.predictedTime;
+	for (uint32_t hand = 0; hand < 2; hand++) {
+		snapshot.hand_pose_time[hand] = xr_input.handPoseTime[hand];
+		snapshot.hand_pose     [hand] = xr_input.handPose[hand];
+		snapshot.render_hand   [hand] = xr_input.renderHand[hand];
+		snapshot.hand_select   [hand] = xr_input.handSelect[hand];
+	}
+	input_log_write_snapshot(xr_input_log, tag, snapshot);
+}
+
+///////////////////////////////////////////
+
+void openxr_replay_input(uint8_t tag) {
+	// Once the log is done, we leave the input as it was, and wWinMain shuts us down
+	input_log_snapshot_t snapshot;
+	if (!input_log_read_snapshot(xr_input_log, tag, &snapshot))
+		return;
+
+	// The session goes through the same states it did while recording, so the app skips
+	// the same frames it did then. With a runtime, xr_running still follows the runtime's
+	// own session, since that's the one we have to begin and end.
+	xr_session_state = xr_input_log.session_state;
+	xr_input.predictedTime = snapshot.predicted_time;
+	for (uint32_t hand = 0; hand < 2; hand++) {
+		xr_input.handPoseTime[hand] = snapshot.hand_pose_time[hand];
+		xr_input.handPose    [hand] = snapshot.hand_pose[hand];
+		xr_input.renderHand  [hand] = snapshot.render_hand[hand];
+		xr_input.handSelect  [hand] = snapshot.hand_select[hand];
+		if (tag == input_log_tag_predicted && snapshot.render_hand[hand])
+			pose_history_push(xr_hand_history[hand], snapshot.hand_pose_time[hand], snapshot.hand_pose[hand]);
+	}
+}
+
+///////////////////////////////////////////
+
+void openxr_replay_frame() {
+	// Stands in for a whole frame of the main loop when there's no runtime: the same input
+	// and session state the app saw while recording, the same updates, and the same culling,
+	// sorting and instance building, from a fixed pair of eyes at the origin. Nothing waits
+	// on a display, so this runs as fast as the CPU side of the app can go.
+	static vector<XrCompositionLayerProjectionView> views;
+	if (views.empty()) {
+		views.resize(2, { XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW });
+		for (uint32_t i = 0; i < 2; i++) {
+			views[i].pose = xr_pose_identity;
+			views[i].pose.position.x = i == 0 ? -0.032f : 0.032f;
+			views[i].fov = { -0.8f, 0.8f, 0.8f, -0.8f };
+		}
+	}
+
+	openxr_poll_actions();
+	if (xr_input_log.finished)
+		return;
+	app_update();
+	openxr_poll_predicted(xr_input.predictedTime);
+	app_update_predicted(xr_input.predictedTime);
+
+	if (xr_session_state == XR_SESSION_STATE_VISIBLE || xr_session_state == XR_SESSION_STATE_FOCUSED) {
+		auto prepare_start = chrono::steady_clock::now();
+		app_prepare_views(views);
+		xr_timing.prepare_ms += chrono::duration<double, milli>(chrono::steady_clock::now() - prepare_start).count();
+	}
+	openxr_report_timing();
+}
+
 ///////////////////////////////////////////
 // DirectX code                          //
 ///////////////////////////////////////////
@@ -765,7 +1032,7 @@ swapchain_surfdata_t d3d_make_surface_data(XrBaseInStructure& swapchain_img) {
 
 ///////////////////////////////////////////
 
-void d3d_render_layer(XrCompositionLayerProjectionView& view, swapchain_surfdata_t& surface) {
+void d3d_render_layer(XrCompositionLayerProjectionView& view, const app_view_draw_t& draw, swapchain_surfdata_t& surface) {
 	// Set up where on the render target we want to draw, the view has a 
 	XrRect2Di& rect = view.subImage.imageRect;
 	D3D11_VIEWPORT viewport = CD3D11_VIEWPORT((float)rect.offset.x, (float)rect.offset.y, (float)rect.extent.width, (float)rect.extent.height);
@@ -778,7 +1045,7 @@ void d3d_render_layer(XrCompositionLayerProjectionView& view, swapchain_surfdata
 	d3d_context->OMSetRenderTargets(1, &surface.target_view, surface.depth_view);
 
 	// And now that we're set up, pass on the rest of our rendering to the application
-	app_draw(view);
+	app_draw(view, draw);
 }
 
 ///////////////////////////////////////////
@@ -824,6 +1091,12 @@ ID3DBlob* d3d_compile_shader(const char* hlsl, const char* entrypoint, const cha
 ///////////////////////////////////////////
 
 void app_init() {
+	pose_filter_init(app_hand_filter, 2, app_hand_filter_config);
+
+	// A headless replay never draws anything, so it doesn't get a GPU
+	if (d3d_device == nullptr)
+		return;
+
 	// Compile our shader code, and turn it into a shader resource!
 	ID3DBlob* vert_shader_blob = d3d_compile_shader(app_shader_code, "vs", "vs_5_0");
 	ID3DBlob* pixel_shader_blob = d3d_compile_shader(app_shader_code, "ps", "ps_5_0");
@@ -831,9 +1104,14 @@ void app_init() {
 	d3d_device->CreatePixelShader(pixel_shader_blob->GetBufferPointer(), pixel_shader_blob->GetBufferSize(), nullptr, &app_pshader);
 
 	// Describe how our mesh is laid out in memory
+	// The second slot is the instance buffer, one world matrix per cube.
 	D3D11_INPUT_ELEMENT_DESC vert_desc[] = {
-		{"SV_POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
-		{"NORMAL",      0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0}, };
+		{"SV_POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT,    0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA,   0},
+		{"NORMAL",      0, DXGI_FORMAT_R32G32B32_FLOAT,    0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA,   0},
+		{"WORLD",       0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+		{"WORLD",       1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+		{"WORLD",       2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+		{"WORLD",       3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1}, };
 	d3d_device->CreateInputLayout(vert_desc, (UINT)_countof(vert_desc), vert_shader_blob->GetBufferPointer(), vert_shader_blob->GetBufferSize(), &app_shader_layout);
 
 	// Create GPU resources for our mesh's vertices and indices! Constant buffers are for passing transform
@@ -850,44 +1128,123 @@ void app_init() {
 
 ///////////////////////////////////////////
 
-void app_draw(XrCompositionLayerProjectionView& view) {
-	// Set up camera matrices based on OpenXR's predicted viewpoint information
-	XMMATRIX mat_projection = d3d_xr_projection(view.fov, 0.05f, 100.0f);
-	XMMATRIX mat_view = XMMatrixInverse(nullptr, XMMatrixAffineTransformation(
-		DirectX::g_XMOne, DirectX::g_XMZero,
-		XMLoadFloat4((XMFLOAT4*)&view.pose.orientation),
-		XMLoadFloat3((XMFLOAT3*)&view.pose.position)));
+void app_reserve_instances(uint32_t count) {
+	if (count <= app_instance_capacity)
+		return;
+
+	// Grow geometrically, so placing lots of cubes doesn't mean recreating the buffer every frame
+	uint32_t capacity = app_instance_capacity * 2;
+	if (capacity < 64)    capacity = 64;
+	if (capacity < count) capacity = count;
+
+	if (app_instance_buffer) app_instance_buffer->Release();
+	CD3D11_BUFFER_DESC inst_buff_desc(sizeof(XMFLOAT4X4) * capacity, D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+	d3d_device->CreateBuffer(&inst_buff_desc, nullptr, &app_instance_buffer);
+	app_instance_capacity = capacity;
+}
+
+///////////////////////////////////////////
+
+void app_prepare_views(const vector<XrCompositionLayerProjectionView>& views) {
+	// A bounding sphere for our cubes, they're 2 units across and scaled down to 0.05
+	const float cube_scale  = 0.05f;
+	const float cube_radius = cube_scale * 1.7320508f;
+
+	// World matrices don't depend on the viewpoint, so only build them once for all views
+	app_cube_worlds.resize(app_cubes.size());
+	for (size_t i = 0; i < app_cubes.size(); i++) {
+		XMMATRIX mat_model = XMMatrixAffineTransformation(
+			DirectX::g_XMOne * cube_scale, DirectX::g_XMZero,
+			XMLoadFloat4((XMFLOAT4*)&app_cubes[i].orientation),
+			XMLoadFloat3((XMFLOAT3*)&app_cubes[i].position));
+		XMStoreFloat4x4(&app_cube_worlds[i], mat_model);
+	}
+
+	app_instances.clear();
+	app_view_draws.resize(views.size());
+	for (size_t v = 0; v < views.size(); v++) {
+		// Set up camera matrices based on OpenXR's predicted viewpoint information
+		XMMATRIX mat_projection = d3d_xr_projection(views[v].fov, 0.05f, 100.0f);
+		XMMATRIX mat_view = XMMatrixInverse(nullptr, XMMatrixAffineTransformation(
+			DirectX::g_XMOne, DirectX::g_XMZero,
+			XMLoadFloat4((XMFLOAT4*)&views[v].pose.orientation),
+			XMLoadFloat3((XMFLOAT3*)&views[v].pose.position)));
+		XMMATRIX mat_viewproj = mat_view * mat_projection;
+
+		app_view_draw_t& draw = app_view_draws[v];
+		XMStoreFloat4x4(&draw.viewproj, XMMatrixTranspose(mat_viewproj));
+
+		// Pull the frustum planes straight out of the view-projection matrix. Since we use row
+		// vectors, the planes come from its columns, which are the rows of the transpose.
+		XMMATRIX columns = XMMatrixTranspose(mat_viewproj);
+		XMVECTOR planes[6] = {
+			XMPlaneNormalize(columns.r[3] + columns.r[0]), // Left
+			XMPlaneNormalize(columns.r[3] - columns.r[0]), // Right
+			XMPlaneNormalize(columns.r[3] + columns.r[1]), // Bottom
+			XMPlaneNormalize(columns.r[3] - columns.r[1]), // Top
+			XMPlaneNormalize(columns.r[2]),                // Near, D3D depth starts at 0
+			XMPlaneNormalize(columns.r[3] - columns.r[2]), // Far
+		};
+
+		// Cull anything outside the view, and keep the distance of what's left so we can draw
+		// front to back, and let the depth buffer reject as many pixels as possible.
+		app_sort_keys.clear();
+		for (uint32_t i = 0; i < app_cubes.size(); i++) {
+			XMVECTOR center = XMLoadFloat3((XMFLOAT3*)&app_cubes[i].position);
+			bool     visible = true;
+			for (int32_t p = 0; p < _countof(planes) && visible; p++) {
+				visible = XMVectorGetX(XMPlaneDotCoord(planes[p], center)) >= -cube_radius;
+			}
+			if (visible)
+				app_sort_keys.push_back({ XMVectorGetX(XMVector3Dot(center, columns.r[3])) + XMVectorGetW(columns.r[3]), i });
+		}
+		sort(app_sort_keys.begin(), app_sort_keys.end());
+
+		draw.instance_start = (uint32_t)app_instances.size();
+		draw.instance_count = (uint32_t)app_sort_keys.size();
+		for (size_t i = 0; i < app_sort_keys.size(); i++) {
+			app_instances.push_back(app_cube_worlds[app_sort_keys[i].second]);
+		}
+	}
+
+	// Send the instances for every view off to the GPU in one go
+	if (app_instances.empty() || d3d_context == nullptr)
+		return;
+	app_reserve_instances((uint32_t)app_instances.size());
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	if (SUCCEEDED(d3d_context->Map(app_instance_buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+		memcpy(mapped.pData, app_instances.data(), sizeof(XMFLOAT4X4) * app_instances.size());
+		d3d_context->Unmap(app_instance_buffer, 0);
+	}
+}
+
+///////////////////////////////////////////
+
+void app_draw(XrCompositionLayerProjectionView& view, const app_view_draw_t& draw) {
+	if (draw.instance_count == 0)
+		return;
 
 	// Set the active shaders and constant buffers.
 	d3d_context->VSSetConstantBuffers(0, 1, &app_constant_buffer);
 	d3d_context->VSSetShader(app_vshader, nullptr, 0);
 	d3d_context->PSSetShader(app_pshader, nullptr, 0);
 
-	// Set up the cube mesh's information
-	UINT strides[] = { sizeof(float) * 6 };
-	UINT offsets[] = { 0 };
-	d3d_context->IASetVertexBuffers(0, 1, &app_vertex_buffer, strides, offsets);
+	// Set up the cube mesh's information, and the instance buffer with a world matrix for each cube
+	ID3D11Buffer* buffers[] = { app_vertex_buffer, app_instance_buffer };
+	UINT          strides[] = { sizeof(float) * 6, sizeof(XMFLOAT4X4) };
+	UINT          offsets[] = { 0, 0 };
+	d3d_context->IASetVertexBuffers(0, _countof(buffers), buffers, strides, offsets);
 	d3d_context->IASetIndexBuffer(app_index_buffer, DXGI_FORMAT_R16_UINT, 0);
 	d3d_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 	d3d_context->IASetInputLayout(app_shader_layout);
 
 	// Put camera matrices into the shader's constant buffer
 	app_transform_buffer_t transform_buffer;
-	XMStoreFloat4x4(&transform_buffer.viewproj, XMMatrixTranspose(mat_view * mat_projection));
+	transform_buffer.viewproj = draw.viewproj;
+	d3d_context->UpdateSubresource(app_constant_buffer, 0, nullptr, &transform_buffer, 0, 0);
 
-	// Draw all the cubes we have in our list!
-	for (size_t i = 0; i < app_cubes.size(); i++) {
-		// Create a translate, rotate, scale matrix for the cube's world location
-		XMMATRIX mat_model = XMMatrixAffineTransformation(
-			DirectX::g_XMOne * 0.05f, DirectX::g_XMZero,
-			XMLoadFloat4((XMFLOAT4*)&app_cubes[i].orientation),
-			XMLoadFloat3((XMFLOAT3*)&app_cubes[i].position));
-
-		// Update the shader's constant buffer with the transform matrix info, and then draw the mesh!
-		XMStoreFloat4x4(&transform_buffer.world, XMMatrixTranspose(mat_model));
-		d3d_context->UpdateSubresource(app_constant_buffer, 0, nullptr, &transform_buffer, 0, 0);
-		d3d_context->DrawIndexed((UINT)_countof(app_inds), 0, 0);
-	}
+	// Draw all the cubes this view can see, already culled and sorted by app_prepare_views!
+	d3d_context->DrawIndexedInstanced((UINT)_countof(app_inds), draw.instance_count, 0, 0, draw.instance_start);
 }
 
 ///////////////////////////////////////////
@@ -902,12 +1259,18 @@ void app_update() {
 
 ///////////////////////////////////////////
 
-void app_update_predicted() {
+void app_update_predicted(XrTime predicted_time) {
 	// Update the location of the hand cubes. This is done after the inputs have been updated to 
 	// use the predicted location, but during the render code, so we have the most up-to-date location.
+	// Both hands go through the filter together, which smooths out jitter while they're still,
+	// and extrapolates them to display time if the runtime didn't give us a fresh pose.
+	XrPosef hand_poses[2];
+	app_hand_filter.config = app_hand_filter_config;
+	pose_filter_update(app_hand_filter, xr_input.handPose, xr_input.handPoseTime, xr_input.renderHand, predicted_time, hand_poses);
+
 	if (app_cubes.size() < 2)
 		app_cubes.resize(2, xr_pose_identity);
 	for (uint32_t i = 0; i < 2; i++) {
-		app_cubes[i] = xr_input.renderHand[i] ? xr_input.handPose[i] : xr_pose_identity;
+		app_cubes[i] = xr_input.renderHand[i] ? hand_poses[i] : xr_pose_identity;
 	}
 }
\ No newline at end of file
@@ -0,0 +1,182 @@
+﻿#pragma once
+
+#include "MappedFile.h"
+#include "LzCodec.h"
+#include <algorithm>
+
+namespace DX
+{
+	// Format de l'archive d'actifs (Assets.pak), écrite par Tools/AssetPacker. Tous les champs sont en
+	// petit-boutiste. L'en-tête est suivi de la table des matières, alignée sur 64 octets et triée par
+	// hachage de nom, puis des données. Chaque entrée commence sur un multiple de c_assetArchiveAlignment,
+	// ce qui permet de copier une entrée non compressée telle quelle vers une ressource GPU.
+	static const uint32_t c_assetArchiveMagic = 0x4B415043;	// « CPAK »
+	static const uint32_t c_assetArchiveVersion = 1;
+	static const uint32_t c_assetArchiveAlignment = 512;	// D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT.
+	static const uint64_t c_assetArchiveTocOffset = 64;
+
+	enum AssetArchiveFlags : uint32_t
+	{
+		AssetArchiveFlagCompressed = 0x1,	// Données compressées avec LzCompress.
+	};
+
+	// Nature d'une entrée, déduite de l'extension par l'outil d'empaquetage. Sert aux outils, le chargeur
+	// traite toutes les entrées de la même façon.
+	enum class AssetKind : uint32_t
+	{
+		Raw,
+		Shader,
+		Mesh,
+		Texture,
+	};
+
+	struct AssetArchiveHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t entryCount;
+		uint32_t alignment;
+		uint64_t tocOffset;
+		uint64_t fileSize;
+	};
+
+	struct AssetArchiveEntry
+	{
+		uint64_t nameHash;
+		uint64_t offset;		// Depuis le début de l'archive.
+		uint64_t storedSize;	// Taille dans l'archive.
+		uint64_t size;			// Taille une fois décompressée.
+		uint32_t flags;			// AssetArchiveFlags.
+		AssetKind kind;
+	};
+
+	static_assert(sizeof(AssetArchiveHeader) == 32, "L'en-tête de l'archive fait partie du format.");
+	static_assert(sizeof(AssetArchiveEntry) == 40, "Les entrées de l'archive font partie du format.");
+
+	// Hachage FNV-1a 64 bits d'un nom d'actif en UTF-8. Les noms sont comparés sans tenir compte de la casse
+	// ASCII, et « \ » équivaut à « / », comme sur le système de fichiers de Windows.
+	inline uint64_t AssetArchiveHash(const char* name, size_t length)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t i = 0; i < length; i++)
+		{
+			char c = name[i];
+			if (c >= 'A' && c <= 'Z')
+			{
+				c = static_cast<char>(c - 'A' + 'a');
+			}
+			else if (c == '\\')
+			{
+				c = '/';
+			}
+			hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	inline uint64_t AssetArchiveHash(const std::wstring& name)
+	{
+		std::string utf8 = WideToUtf8(name);
+		return AssetArchiveHash(utf8.data(), utf8.size());
+	}
+
+	// Archive ouverte en une seule projection. Les entrées non compressées sont lues sur place ; les
+	// entrées compressées doivent être décompressées dans une mémoire fournie par l'appelant.
+	class AssetArchive
+	{
+	public:
+		// Ouvre et valide l'archive path. Retourne nullptr en cas d'échec ; error vaut alors le code du
+		// système, ou 0 si le fichier existe mais n'est pas une archive valide.
+		static std::shared_ptr<AssetArchive> Open(const std::wstring& path, uint32_t& error)
+		{
+			std::shared_ptr<MappedFile> file = MappedFile::Open(path, error);
+			if (file == nullptr)
+			{
+				return nullptr;
+			}
+
+			std::shared_ptr<AssetArchive> archive(new AssetArchive(std::move(file)));
+			if (!archive->Validate())
+			{
+				error = 0;
+				return nullptr;
+			}
+			return archive;
+		}
+
+		// Retourne l'entrée du nom donné, ou nullptr si l'archive ne la contient pas.
+		const AssetArchiveEntry* Find(const std::wstring& name) const
+		{
+			uint64_t hash = AssetArchiveHash(name);
+			const AssetArchiveEntry* end = m_entries + m_entryCount;
+			const AssetArchiveEntry* entry = std::lower_bound(m_entries, end, hash,
+				[](const AssetArchiveEntry& e, uint64_t h) { return e.nameHash < h; });
+			return (entry != end && entry->nameHash == hash) ? entry : nullptr;
+		}
+
+		// Données telles que stockées dans l'archive.
+		const uint8_t* GetStoredData(const AssetArchiveEntry& entry) const
+		{
+			return m_file->GetData() + entry.offset;
+		}
+
+		bool IsCompressed(const AssetArchiveEntry& entry) const
+		{
+			return (entry.flags & AssetArchiveFlagCompressed) != 0;
+		}
+
+		// Décompresse entry dans destination, qui doit pouvoir contenir entry.size octets.
+		bool Decompress(const AssetArchiveEntry& entry, uint8_t* destination) const
+		{
+			return LzDecompress(GetStoredData(entry), static_cast<size_t>(entry.storedSize), destination, static_cast<size_t>(entry.size));
+		}
+
+		uint32_t GetEntryCount() const { return m_entryCount; }
+
+	private:
+		explicit AssetArchive(std::shared_ptr<MappedFile> file) :
+			m_file(std::move(file)),
+			m_entries(nullptr),
+			m_entryCount(0)
+		{
+		}
+
+		bool Validate()
+		{
+			size_t fileSize = m_file->GetSize();
+			if (fileSize < sizeof(AssetArchiveHeader))
+			{
+				return false;
+			}
+
+			AssetArchiveHeader header;
+			memcpy(&header, m_file->GetData(), sizeof(header));
+			if (header.magic != c_assetArchiveMagic || header.version != c_assetArchiveVersion ||
+				header.fileSize != fileSize || header.tocOffset % alignof(AssetArchiveEntry) != 0 ||
+				header.tocOffset > fileSize || header.entryCount > (fileSize - header.tocOffset) / sizeof(AssetArchiveEntry))
+			{
+				return false;
+			}
+
+			// La projection est alignée sur une page, la table peut donc être lue sur place.
+			m_entries = reinterpret_cast<const AssetArchiveEntry*>(m_file->GetData() + header.tocOffset);
+			m_entryCount = header.entryCount;
+
+			for (uint32_t i = 0; i < m_entryCount; i++)
+			{
+				const AssetArchiveEntry& entry = m_entries[i];
+				if ((i > 0 && m_entries[i - 1].nameHash >= entry.nameHash) ||
+					entry.offset > fileSize || entry.storedSize > fileSize - entry.offset ||
+					(!IsCompressed(entry) && entry.storedSize != entry.size))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		std::shared_ptr<MappedFile>	m_file;
+		const AssetArchiveEntry*	m_entries;
+		uint32_t					m_entryCount;
+	};
+}
@@ -0,0 +1,351 @@
+﻿#pragma once
+
+#include "AssetArchive.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace DX
+{
+	// Vue sur le contenu d'un actif chargé. Les données ne sont pas copiées : elles pointent dans la
+	// projection du fichier, que owner garde en vie tant qu'une vue existe.
+	struct AssetView
+	{
+		const uint8_t*				data;
+		size_t						size;
+		std::shared_ptr<const void>	owner;
+
+		AssetView() : data(nullptr), size(0) {}
+		bool IsValid() const { return owner != nullptr; }
+	};
+
+	// Exception levée par une requête dont le fichier n'a pas pu être projeté, ou dont l'entrée d'archive
+	// est corrompue (error vaut alors 0).
+	class AssetLoadError : public std::runtime_error
+	{
+	public:
+		AssetLoadError(const std::wstring& name, uint32_t error) :
+			std::runtime_error("Impossible de charger un actif."),
+			m_name(name),
+			m_error(error)
+		{
+		}
+
+		const std::wstring&	GetName() const		{ return m_name; }
+		uint32_t			GetError() const	{ return m_error; }
+
+	private:
+		std::wstring	m_name;
+		uint32_t		m_error;
+	};
+
+	// Un nœud du graphe de chargement : soit la projection d'un fichier, soit un travail qui en dépend.
+	// Une requête ne s'exécute qu'une fois toutes ses dépendances terminées ; si l'une d'elles a échoué,
+	// son travail est sauté et elle échoue avec la même exception.
+	class AssetRequest
+	{
+	public:
+		AssetRequest() :
+			m_remaining(1),
+			m_done(false)
+		{
+		}
+
+		bool IsDone() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_done;
+		}
+
+		// Ne sont valides qu'une fois la requête terminée.
+		const AssetView&	GetView() const			{ return m_view; }
+		std::exception_ptr	GetException() const	{ return m_exception; }
+
+	private:
+		friend class AssetLoader;
+
+		mutable std::mutex									m_mutex;
+		std::condition_variable								m_doneCondition;
+		std::atomic<size_t>									m_remaining;	// Dépendances non terminées, plus une tant que la requête est en construction.
+		bool												m_done;
+		std::function<void(AssetRequest&)>					m_work;
+		std::vector<std::shared_ptr<AssetRequest>>			m_dependents;
+		std::vector<std::function<void(const AssetRequest&)>>	m_callbacks;
+		AssetView											m_view;
+		std::exception_ptr									m_exception;
+	};
+
+	typedef std::shared_ptr<AssetRequest> AssetHandle;
+
+	struct AssetLoaderStats
+	{
+		uint64_t filesMapped;	// Projections créées.
+		uint64_t bytesMapped;	// Total de leurs tailles.
+		uint64_t cacheHits;		// Chargements servis par une projection encore en vie.
+		uint64_t archiveHits;	// Chargements servis par une archive.
+	};
+
+	// Charge les actifs en projetant leurs fichiers en mémoire, sur une réserve de threads. Les chargements
+	// et les travaux qui en dépendent (créer un état de pipeline une fois ses nuanceurs chargés, etc.) forment
+	// un graphe acyclique : chaque requête est soumise à la réserve dès que ses dépendances sont terminées.
+	//
+	// Le chargeur ne garde qu'une référence faible vers chaque projection : un fichier est libéré dès qu'il
+	// n'a plus de vue, et le recharger tant qu'il en a une ne le projette pas une seconde fois.
+	//
+	// Les archives montées sont consultées avant le système de fichiers : un actif qui s'y trouve ne coûte
+	// aucune ouverture de fichier. Les fichiers séparés restent utilisés pour tout ce qu'elles ne contiennent pas.
+	class AssetLoader
+	{
+	public:
+		// rootPath est préfixé aux noms d'actifs ; il doit se terminer par un séparateur, ou être vide.
+		AssetLoader(const std::wstring& rootPath, size_t threadCount) :
+			m_rootPath(rootPath),
+			m_stats(),
+			m_pool(threadCount)
+		{
+		}
+
+		// Ouvre l'archive name et la consulte lors des chargements suivants. Retourne false si elle n'existe
+		// pas ou n'est pas valide. Les archives doivent être montées avant de lancer des chargements.
+		bool MountArchive(const std::wstring& name)
+		{
+			uint32_t error = 0;
+			std::shared_ptr<AssetArchive> archive = AssetArchive::Open(m_rootPath + name, error);
+			if (archive == nullptr)
+			{
+				return false;
+			}
+
+			std::lock_guard<std::mutex> lock(m_cacheMutex);
+			m_archives.push_back(std::move(archive));
+			return true;
+		}
+
+		// Projette le fichier name, une fois dependencies terminées.
+		AssetHandle Load(const std::wstring& name, const std::vector<AssetHandle>& dependencies = std::vector<AssetHandle>())
+		{
+			return Schedule(dependencies, [this, name](AssetRequest& request)
+			{
+				if (LoadFromArchive(name, request.m_view))
+				{
+					return;
+				}
+
+				uint32_t error = 0;
+				std::shared_ptr<MappedFile> file = Map(name, error);
+				if (file == nullptr)
+				{
+					throw AssetLoadError(name, error);
+				}
+				request.m_view.data = file->GetData();
+				request.m_view.size = file->GetSize();
+				request.m_view.owner = std::move(file);
+			});
+		}
+
+		// Exécute work sur la réserve, une fois dependencies terminées avec succès.
+		AssetHandle Then(const std::vector<AssetHandle>& dependencies, std::function<void()> work)
+		{
+			return Schedule(dependencies, [work](AssetRequest&) { work(); });
+		}
+
+		// Appelle callback une fois request terminée, sur le thread qui la termine, ou immédiatement si c'est déjà fait.
+		void OnComplete(const AssetHandle& request, std::function<void(const AssetRequest&)> callback)
+		{
+			{
+				std::lock_guard<std::mutex> lock(request->m_mutex);
+				if (!request->m_done)
+				{
+					request->m_callbacks.push_back(std::move(callback));
+					return;
+				}
+			}
+			callback(*request);
+		}
+
+		// Bloque jusqu'à la fin de request, et relance son exception le cas échéant. Ne pas appeler depuis
+		// un travail du chargeur : il occuperait un thread de la réserve dont la requête a peut-être besoin.
+		void Wait(const AssetHandle& request)
+		{
+			std::unique_lock<std::mutex> lock(request->m_mutex);
+			request->m_doneCondition.wait(lock, [&request]() { return request->m_done; });
+			if (request->m_exception)
+			{
+				std::rethrow_exception(request->m_exception);
+			}
+		}
+
+		AssetLoaderStats GetStats()
+		{
+			std::lock_guard<std::mutex> lock(m_cacheMutex);
+			return m_stats;
+		}
+
+	private:
+		AssetHandle Schedule(const std::vector<AssetHandle>& dependencies, std::function<void(AssetRequest&)> work)
+		{
+			AssetHandle request = std::make_shared<AssetRequest>();
+			request->m_work = std::move(work);
+
+			for (const AssetHandle& dependency : dependencies)
+			{
+				std::lock_guard<std::mutex> lock(dependency->m_mutex);
+				if (dependency->m_done)
+				{
+					// Une autre dépendance peut échouer en parallèle et écrire la même exception.
+					std::lock_guard<std::mutex> requestLock(request->m_mutex);
+					if (dependency->m_exception && !request->m_exception)
+					{
+						request->m_exception = dependency->m_exception;
+					}
+				}
+				else
+				{
+					request->m_remaining++;
+					dependency->m_dependents.push_back(request);
+				}
+			}
+
+			// Retire la référence de construction ; la requête part si tout était déjà terminé.
+			Release(request);
+			return request;
+		}
+
+		void Release(const AssetHandle& request)
+		{
+			if (--request->m_remaining == 0)
+			{
+				m_pool.Submit([this, request]() { Run(request); });
+			}
+		}
+
+		void Run(const AssetHandle& request)
+		{
+			// Les dépendances sont toutes terminées, plus personne ne modifie m_exception en parallèle.
+			if (!request->m_exception)
+			{
+				try
+				{
+					request->m_work(*request);
+				}
+				catch (...)
+				{
+					request->m_exception = std::current_exception();
+				}
+			}
+			request->m_work = nullptr;
+
+			std::vector<AssetHandle> dependents;
+			std::vector<std::function<void(const AssetRequest&)>> callbacks;
+			{
+				std::lock_guard<std::mutex> lock(request->m_mutex);
+				request->m_done = true;
+				dependents.swap(request->m_dependents);
+				callbacks.swap(request->m_callbacks);
+			}
+			request->m_doneCondition.notify_all();
+
+			for (const AssetHandle& dependent : dependents)
+			{
+				if (request->m_exception)
+				{
+					std::lock_guard<std::mutex> lock(dependent->m_mutex);
+					if (!dependent->m_exception)
+					{
+						dependent->m_exception = request->m_exception;
+					}
+				}
+				Release(dependent);
+			}
+			for (auto& callback : callbacks)
+			{
+				callback(*request);
+			}
+		}
+
+		bool LoadFromArchive(const std::wstring& name, AssetView& view)
+		{
+			std::shared_ptr<AssetArchive> archive;
+			const AssetArchiveEntry* entry = nullptr;
+			{
+				std::lock_guard<std::mutex> lock(m_cacheMutex);
+				for (const auto& mounted : m_archives)
+				{
+					entry = mounted->Find(name);
+					if (entry != nullptr)
+					{
+						archive = mounted;
+						m_stats.archiveHits++;
+						break;
+					}
+				}
+			}
+			if (entry == nullptr)
+			{
+				return false;
+			}
+
+			if (!archive->IsCompressed(*entry))
+			{
+				view.data = archive->GetStoredData(*entry);
+				view.size = static_cast<size_t>(entry->size);
+				view.owner = std::move(archive);
+				return true;
+			}
+
+			// Une entrée compressée est décompressée dans une mémoire propre à cette vue.
+			auto buffer = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(entry->size));
+			if (!archive->Decompress(*entry, buffer->data()))
+			{
+				throw AssetLoadError(name, 0);
+			}
+			view.data = buffer->data();
+			view.size = buffer->size();
+			view.owner = std::move(buffer);
+			return true;
+		}
+
+		std::shared_ptr<MappedFile> Map(const std::wstring& name, uint32_t& error)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_cacheMutex);
+				auto cached = m_cache.find(name);
+				if (cached != m_cache.end())
+				{
+					std::shared_ptr<MappedFile> file = cached->second.lock();
+					if (file != nullptr)
+					{
+						m_stats.cacheHits++;
+						return file;
+					}
+				}
+			}
+
+			// La projection se fait hors du verrou ; si deux threads projettent le même fichier en même temps,
+			// la seconde projection remplace simplement la première dans le cache.
+			std::shared_ptr<MappedFile> file = MappedFile::Open(m_rootPath + name, error);
+			if (file != nullptr)
+			{
+				std::lock_guard<std::mutex> lock(m_cacheMutex);
+				m_cache[name] = file;
+				m_stats.filesMapped++;
+				m_stats.bytesMapped += file->GetSize();
+			}
+			return file;
+		}
+
+		std::wstring												m_rootPath;
+		std::mutex													m_cacheMutex;
+		std::unordered_map<std::wstring, std::weak_ptr<MappedFile>>	m_cache;
+		std::vector<std::shared_ptr<AssetArchive>>					m_archives;
+		AssetLoaderStats											m_stats;
+
+		// Déclarée en dernier : elle est détruite en premier, et termine les requêtes en cours pendant que le reste du chargeur existe encore.
+		ThreadPool													m_pool;
+	};
+}
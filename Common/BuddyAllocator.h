@@ -0,0 +1,163 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace DX
+{
+	// Statistiques d'un allocateur, utiles pour suivre la fragmentation.
+	struct BuddyAllocatorStats
+	{
+		uint64_t capacity;			// Taille totale gérée.
+		uint64_t allocatedBytes;	// Taille des blocs alloués, arrondis à une puissance de deux.
+		uint64_t requestedBytes;	// Taille réellement demandée par les appelants.
+		uint64_t largestFreeBlock;	// Plus grand bloc libre, soit la plus grande allocation possible.
+		uint32_t allocationCount;
+		uint32_t freeBlockCount;
+
+		// Fragmentation externe : 0 quand tout l'espace libre est d'un seul tenant, proche de 1 quand il est émietté.
+		float GetExternalFragmentation() const
+		{
+			uint64_t freeBytes = capacity - allocatedBytes;
+			return freeBytes == 0 ? 0.0f : 1.0f - static_cast<float>(largestFreeBlock) / static_cast<float>(freeBytes);
+		}
+
+		// Fragmentation interne : part des blocs alloués perdue à l'arrondi.
+		float GetInternalFragmentation() const
+		{
+			return allocatedBytes == 0 ? 0.0f : 1.0f - static_cast<float>(requestedBytes) / static_cast<float>(allocatedBytes);
+		}
+	};
+
+	// Allocateur par blocs compagnons (« buddy ») pour sous-allouer une grande plage de mémoire, par exemple un
+	// ID3D12Heap. Chaque bloc a une taille de minBlockSize * 2^n et est aligné sur sa taille ; un bloc libéré est
+	// fusionné avec son compagnon dès que celui-ci est libre aussi. Ne dépend pas de D3D12, il ne manipule que des offsets.
+	class BuddyAllocator
+	{
+	public:
+		// capacity doit être minBlockSize multiplié par une puissance de deux.
+		BuddyAllocator(uint64_t capacity, uint64_t minBlockSize) :
+			m_minBlockSize(minBlockSize),
+			m_requestedBytes(0),
+			m_allocatedBytes(0)
+		{
+			uint32_t orderCount = 1;
+			while ((minBlockSize << (orderCount - 1)) < capacity)
+			{
+				orderCount++;
+			}
+			m_capacity = minBlockSize << (orderCount - 1);
+			m_freeBlocks.resize(orderCount);
+			m_freeBlocks[orderCount - 1].insert(0);
+		}
+
+		// Réserve size octets alignés sur alignment (une puissance de deux). Retourne false si aucun bloc libre
+		// n'est assez grand.
+		bool Allocate(uint64_t size, uint64_t alignment, uint64_t& offset)
+		{
+			uint64_t blockSize = size > alignment ? size : alignment;
+			uint32_t order = 0;
+			while ((m_minBlockSize << order) < blockSize)
+			{
+				order++;
+				if (order >= m_freeBlocks.size())
+				{
+					return false;
+				}
+			}
+
+			// Prenez le plus petit bloc libre assez grand, puis découpez-le jusqu'à la bonne taille.
+			uint32_t found = order;
+			while (found < m_freeBlocks.size() && m_freeBlocks[found].empty())
+			{
+				found++;
+			}
+			if (found == m_freeBlocks.size())
+			{
+				return false;
+			}
+
+			// Le bloc au plus petit offset garde les allocations tassées au début.
+			uint64_t block = *m_freeBlocks[found].begin();
+			m_freeBlocks[found].erase(m_freeBlocks[found].begin());
+			while (found > order)
+			{
+				found--;
+				m_freeBlocks[found].insert(block + (m_minBlockSize << found));
+			}
+
+			m_allocations[block] = Allocation{ size, order };
+			m_requestedBytes += size;
+			m_allocatedBytes += m_minBlockSize << order;
+			offset = block;
+			return true;
+		}
+
+		// Libère un bloc retourné par Allocate.
+		void Free(uint64_t offset)
+		{
+			auto allocation = m_allocations.find(offset);
+			if (allocation == m_allocations.end())
+			{
+				return;
+			}
+			uint32_t order = allocation->second.order;
+			m_requestedBytes -= allocation->second.size;
+			m_allocatedBytes -= m_minBlockSize << order;
+			m_allocations.erase(allocation);
+
+			// Fusionnez avec le compagnon tant qu'il est libre.
+			while (order + 1 < m_freeBlocks.size())
+			{
+				uint64_t buddy = offset ^ (m_minBlockSize << order);
+				auto freeBuddy = m_freeBlocks[order].find(buddy);
+				if (freeBuddy == m_freeBlocks[order].end())
+				{
+					break;
+				}
+				m_freeBlocks[order].erase(freeBuddy);
+				offset = offset < buddy ? offset : buddy;
+				order++;
+			}
+			m_freeBlocks[order].insert(offset);
+		}
+
+		BuddyAllocatorStats GetStats() const
+		{
+			BuddyAllocatorStats stats = {};
+			stats.capacity = m_capacity;
+			stats.allocatedBytes = m_allocatedBytes;
+			stats.requestedBytes = m_requestedBytes;
+			stats.allocationCount = static_cast<uint32_t>(m_allocations.size());
+			for (size_t order = 0; order < m_freeBlocks.size(); order++)
+			{
+				stats.freeBlockCount += static_cast<uint32_t>(m_freeBlocks[order].size());
+				if (!m_freeBlocks[order].empty())
+				{
+					stats.largestFreeBlock = m_minBlockSize << order;
+				}
+			}
+			return stats;
+		}
+
+		uint64_t GetCapacity() const	{ return m_capacity; }
+		bool IsEmpty() const			{ return m_allocations.empty(); }
+
+	private:
+		struct Allocation
+		{
+			uint64_t size;
+			uint32_t order;
+		};
+
+		uint64_t								m_capacity;
+		uint64_t								m_minBlockSize;
+		uint64_t								m_requestedBytes;
+		uint64_t								m_allocatedBytes;
+		std::vector<std::set<uint64_t>>			m_freeBlocks;	// Offsets des blocs libres, par ordre de taille.
+		std::unordered_map<uint64_t, Allocation>	m_allocations;	// Blocs alloués, par offset.
+	};
+}
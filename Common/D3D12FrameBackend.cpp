@@ -0,0 +1,91 @@
+﻿#include "pch.h"
+#include "D3D12FrameBackend.h"
+#include "DirectXHelper.h"
+
+DX::D3D12FrameBackend::D3D12FrameBackend(ID3D12CommandQueue* queue, ID3D12Fence* fence) :
+	m_queue(queue),
+	m_fence(fence),
+	m_fenceEvent(0),
+	m_latencyWaitable(0),
+	m_frameLatency(1)
+{
+	m_fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+	if (m_fenceEvent == nullptr)
+	{
+		DX::ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+	}
+
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	m_ticksToSeconds = 1.0 / static_cast<double>(frequency.QuadPart);
+}
+
+DX::D3D12FrameBackend::~D3D12FrameBackend()
+{
+	if (m_latencyWaitable != 0)
+	{
+		CloseHandle(m_latencyWaitable);
+	}
+	CloseHandle(m_fenceEvent);
+}
+
+// La chaîne de permutation doit avoir été créée avec DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT.
+void DX::D3D12FrameBackend::SetSwapChain(IDXGISwapChain2* swapChain)
+{
+	if (m_latencyWaitable != 0)
+	{
+		CloseHandle(m_latencyWaitable);
+		m_latencyWaitable = 0;
+	}
+
+	m_swapChain = swapChain;
+	if (m_swapChain)
+	{
+		DX::ThrowIfFailed(m_swapChain->SetMaximumFrameLatency(m_frameLatency));
+		m_latencyWaitable = m_swapChain->GetFrameLatencyWaitableObject();
+	}
+}
+
+uint64_t DX::D3D12FrameBackend::GetCompletedFenceValue()
+{
+	return m_fence->GetCompletedValue();
+}
+
+void DX::D3D12FrameBackend::SignalFence(uint64_t value)
+{
+	DX::ThrowIfFailed(m_queue->Signal(m_fence.Get(), value));
+}
+
+void DX::D3D12FrameBackend::WaitForFence(uint64_t value)
+{
+	if (m_fence->GetCompletedValue() < value)
+	{
+		DX::ThrowIfFailed(m_fence->SetEventOnCompletion(value, m_fenceEvent));
+		WaitForSingleObjectEx(m_fenceEvent, INFINITE, FALSE);
+	}
+}
+
+void DX::D3D12FrameBackend::WaitForFrameLatency()
+{
+	// Un délai d'une seconde évite de bloquer indéfiniment si la fenêtre n'est plus affichée.
+	if (m_latencyWaitable != 0)
+	{
+		WaitForSingleObjectEx(m_latencyWaitable, 1000, TRUE);
+	}
+}
+
+void DX::D3D12FrameBackend::SetFrameLatency(uint32_t frames)
+{
+	m_frameLatency = frames;
+	if (m_swapChain)
+	{
+		DX::ThrowIfFailed(m_swapChain->SetMaximumFrameLatency(frames));
+	}
+}
+
+double DX::D3D12FrameBackend::GetTime()
+{
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return static_cast<double>(counter.QuadPart) * m_ticksToSeconds;
+}
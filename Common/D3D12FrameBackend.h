@@ -0,0 +1,35 @@
+﻿#pragma once
+
+#include "FrameScheduler.h"
+
+namespace DX
+{
+	// Backend de FrameScheduler pour une file de commandes D3D12. Les attentes passent par un événement sur
+	// l'isolation, et la latence par l'objet d'attente d'une chaîne de permutation créée avec
+	// DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT. Tant qu'aucune chaîne de permutation n'est fournie,
+	// WaitForFrameLatency ne bloque pas.
+	class D3D12FrameBackend : public FrameSchedulerBackend
+	{
+	public:
+		D3D12FrameBackend(ID3D12CommandQueue* queue, ID3D12Fence* fence);
+		~D3D12FrameBackend();
+
+		void SetSwapChain(IDXGISwapChain2* swapChain);
+
+		uint64_t GetCompletedFenceValue() override;
+		void SignalFence(uint64_t value) override;
+		void WaitForFence(uint64_t value) override;
+		void WaitForFrameLatency() override;
+		void SetFrameLatency(uint32_t frames) override;
+		double GetTime() override;
+
+	private:
+		Microsoft::WRL::ComPtr<ID3D12CommandQueue>	m_queue;
+		Microsoft::WRL::ComPtr<ID3D12Fence>			m_fence;
+		Microsoft::WRL::ComPtr<IDXGISwapChain2>		m_swapChain;
+		HANDLE										m_fenceEvent;
+		HANDLE										m_latencyWaitable;
+		uint32_t									m_frameLatency;
+		double										m_ticksToSeconds;
+	};
+}
@@ -0,0 +1,93 @@
+﻿#include "pch.h"
+#include "DescriptorHeap.h"
+#include "DirectXHelper.h"
+
+using namespace Microsoft::WRL;
+
+DX::DescriptorHeap::DescriptorHeap(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT persistentCount, UINT transientCount, LPCWSTR name) :
+	m_persistentCount(persistentCount),
+	m_shaderVisible(type == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV || type == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER),
+	m_persistent(persistentCount),
+	m_transient(transientCount)
+{
+	D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+	heapDesc.NumDescriptors = persistentCount + transientCount;
+	heapDesc.Type = type;
+	heapDesc.Flags = m_shaderVisible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+	DX::ThrowIfFailed(device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&m_heap)));
+	DX::SetName(m_heap.Get(), name);
+
+	m_descriptorSize = device->GetDescriptorHandleIncrementSize(type);
+}
+
+DX::DescriptorAllocation DX::DescriptorHeap::AllocatePersistent(UINT count)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	uint32_t index = 0;
+	if (!m_persistent.Allocate(count, index))
+	{
+		DX::ThrowIfFailed(E_OUTOFMEMORY);
+	}
+	return GetAllocation(index, count);
+}
+
+void DX::DescriptorHeap::FreePersistent(const DescriptorAllocation& allocation, UINT64 fenceValue)
+{
+	if (allocation.count == 0)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_pendingFrees.Release(std::make_pair(allocation.index, allocation.count), fenceValue);
+}
+
+DX::DescriptorAllocation DX::DescriptorHeap::AllocateTransient(UINT count)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// La région transitoire suit la région persistante dans le tas.
+	uint64_t offset = 0;
+	if (!m_transient.Allocate(count, 1, offset))
+	{
+		DX::ThrowIfFailed(E_OUTOFMEMORY);
+	}
+	return GetAllocation(m_persistentCount + static_cast<UINT>(offset), count);
+}
+
+void DX::DescriptorHeap::Submit(UINT64 fenceValue)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_transient.Submit(fenceValue);
+}
+
+void DX::DescriptorHeap::Retire(UINT64 completedFenceValue)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_transient.Retire(completedFenceValue);
+
+	std::pair<UINT, UINT> range;
+	while (m_pendingFrees.Acquire(completedFenceValue, range))
+	{
+		m_persistent.Free(range.first, range.second);
+	}
+}
+
+DX::DescriptorAllocation DX::DescriptorHeap::GetAllocation(UINT index, UINT count) const
+{
+	DescriptorAllocation allocation = {};
+	allocation.index = index;
+	allocation.count = count;
+	allocation.cpuHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_heap->GetCPUDescriptorHandleForHeapStart(), index, m_descriptorSize);
+	if (m_shaderVisible)
+	{
+		allocation.gpuHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(m_heap->GetGPUDescriptorHandleForHeapStart(), index, m_descriptorSize);
+	}
+	else
+	{
+		allocation.gpuHandle.ptr = 0;
+	}
+	return allocation;
+}
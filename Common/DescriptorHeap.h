@@ -0,0 +1,59 @@
+﻿#pragma once
+
+#include "FreeListAllocator.h"
+#include "RingAllocator.h"
+#include "FencedPool.h"
+#include <mutex>
+#include <utility>
+
+namespace DX
+{
+	// Plage de descripteurs consécutifs dans un DescriptorHeap.
+	struct DescriptorAllocation
+	{
+		UINT							index;
+		UINT							count;
+		CD3DX12_CPU_DESCRIPTOR_HANDLE	cpuHandle;
+		CD3DX12_GPU_DESCRIPTOR_HANDLE	gpuHandle;	// Nul si le tas n'est pas visible par les nuanceurs.
+	};
+
+	// Tas de descripteurs partagé en deux régions :
+	// - une région persistante, gérée par une liste libre, pour les descripteurs qui vivent longtemps (vues des
+	//   ressources, cibles de rendu) ;
+	// - une région transitoire, gérée en anneau, pour les tables qui ne servent qu'à une frame.
+	// Le GPU peut encore lire un descripteur après qu'il a été libéré : les plages persistantes libérées et les
+	// frames transitoires sont étiquetées avec une valeur d'isolation et ne sont réutilisées qu'une fois Retire
+	// appelé avec une valeur atteinte. Les tas CBV/SRV/UAV et d'échantillonneurs sont visibles par les nuanceurs.
+	class DescriptorHeap
+	{
+	public:
+		DescriptorHeap(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT persistentCount, UINT transientCount, LPCWSTR name);
+
+		DescriptorAllocation AllocatePersistent(UINT count);
+		void FreePersistent(const DescriptorAllocation& allocation, UINT64 fenceValue);
+
+		// Les descripteurs transitoires restent valides jusqu'à ce que l'isolation passée au Submit suivant soit atteinte.
+		DescriptorAllocation AllocateTransient(UINT count);
+
+		// Étiquette les descripteurs transitoires alloués depuis le dernier appel avec la valeur d'isolation de la frame.
+		void Submit(UINT64 fenceValue);
+
+		// Rend les descripteurs que le GPU a fini de lire.
+		void Retire(UINT64 completedFenceValue);
+
+		ID3D12DescriptorHeap*	GetHeap() const				{ return m_heap.Get(); }
+		UINT					GetDescriptorSize() const	{ return m_descriptorSize; }
+
+	private:
+		DescriptorAllocation GetAllocation(UINT index, UINT count) const;
+
+		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>	m_heap;
+		UINT											m_descriptorSize;
+		UINT											m_persistentCount;
+		bool											m_shaderVisible;
+		std::mutex										m_mutex;
+		FreeListAllocator								m_persistent;
+		FencedPool<std::pair<UINT, UINT>>				m_pendingFrees;	// Index, nombre de descripteurs.
+		RingAllocator									m_transient;
+	};
+}
@@ -67,11 +67,11 @@ namespace ScreenRotation
 DX::DeviceResources::DeviceResources(DXGI_FORMAT backBufferFormat, DXGI_FORMAT depthBufferFormat) :
 	m_currentFrame(0),
 	m_screenViewport(),
-	m_rtvDescriptorSize(0),
-	m_fenceEvent(0),
+	m_rtvDescriptors(),
+	m_dsvDescriptor(),
+	m_resourceStates(c_readOnlyResourceStates),
 	m_backBufferFormat(backBufferFormat),
 	m_depthBufferFormat(depthBufferFormat),
-	m_fenceValues{},
 	m_d3dRenderTargetSize(),
 	m_outputSize(),
 	m_logicalSize(),
@@ -88,6 +88,12 @@ DX::DeviceResources::DeviceResources(DXGI_FORMAT backBufferFormat, DXGI_FORMAT d
 // Configure les ressources qui ne dépendent pas du périphérique Direct3D.
 void DX::DeviceResources::CreateDeviceIndependentResources()
 {
+	// Les actifs sont lus directement dans le dossier d'installation du package.
+	std::wstring installedLocation(Windows::ApplicationModel::Package::Current->InstalledLocation->Path->Data());
+	m_assetLoader = std::make_unique<AssetLoader>(installedLocation + L"\\", c_assetLoaderThreadCount);
+
+	// Si le package contient l'archive d'actifs, elle est consultée avant les fichiers séparés.
+	m_assetLoader->MountArchive(L"Assets\\Assets.pak");
 }
 
 // Configure le périphérique Direct3D et stocke les handles dans ce périphérique et son contexte.
@@ -140,22 +146,30 @@ void DX::DeviceResources::CreateDeviceResources()
 	DX::ThrowIfFailed(m_d3dDevice->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_commandQueue)));
 	NAME_D3D12_OBJECT(m_commandQueue);
 
-	// Créez les tas du descripteur pour les affichages de cible de rendu et les affichages de stencil de profondeur.
-	D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc = {};
-	rtvHeapDesc.NumDescriptors = c_frameCount;
-	rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-	rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-	DX::ThrowIfFailed(m_d3dDevice->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&m_rtvHeap)));
-	NAME_D3D12_OBJECT(m_rtvHeap);
+	// Créez l'allocateur qui place les ressources dans de grands tas.
+	m_heapAllocator = std::make_unique<HeapAllocator>(m_d3dDevice.Get(), c_heapSize);
+
+	// Créez le cache des états de pipeline. Ses blobs sont conservés dans le dossier de cache local de l'application.
+	std::wstring localCacheFolder(Windows::Storage::ApplicationData::Current->LocalCacheFolder->Path->Data());
+	m_pipelineStateCache = std::make_unique<PipelineStateCache>(m_d3dDevice.Get(), m_dxgiFactory.Get(), localCacheFolder + L"\\PipelineCache.bin", c_pipelineCacheThreadCount);
 
-	m_rtvDescriptorSize = m_d3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+	// Créez la file de copie et l'anneau de chargement utilisés pour envoyer les ressources vers le GPU.
+	m_uploadQueue = std::make_unique<UploadQueue>(m_d3dDevice.Get(), c_uploadRingSize);
 
-	D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc = {};
-	dsvHeapDesc.NumDescriptors = 1;
-	dsvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
-	dsvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-	ThrowIfFailed(m_d3dDevice->CreateDescriptorHeap(&dsvHeapDesc, IID_PPV_ARGS(&m_dsvHeap)));
-	NAME_D3D12_OBJECT(m_dsvHeap);
+	// Créez les tas du descripteur pour les affichages de cible de rendu et les affichages de stencil de profondeur,
+	// avec de la place pour les cibles de rendu intermédiaires, et réservez-y celles de la chaîne de permutation.
+	m_rtvHeap = std::make_unique<DescriptorHeap>(m_d3dDevice.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_RTV, c_frameCount + 16, 0, L"m_rtvHeap");
+	m_dsvHeap = std::make_unique<DescriptorHeap>(m_d3dDevice.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 4, 0, L"m_dsvHeap");
+	m_rtvDescriptors = m_rtvHeap->AllocatePersistent(c_frameCount);
+	m_dsvDescriptor = m_dsvHeap->AllocatePersistent(1);
+
+	// Créez le tas du descripteur visible par les nuanceurs, partagé par tous les convertisseurs.
+	m_cbvSrvUavHeap = std::make_unique<DescriptorHeap>(
+		m_d3dDevice.Get(),
+		D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
+		c_persistentDescriptorCount,
+		c_transientDescriptorCount,
+		L"m_cbvSrvUavHeap");
 
 	for (UINT n = 0; n < c_frameCount; n++)
 	{
@@ -165,14 +179,12 @@ void DX::DeviceResources::CreateDeviceResources()
 	}
 
 	// Créez les objets de synchronisation.
-	DX::ThrowIfFailed(m_d3dDevice->CreateFence(m_fenceValues[m_currentFrame], D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence)));
-	m_fenceValues[m_currentFrame]++;
+	DX::ThrowIfFailed(m_d3dDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence)));
+	NAME_D3D12_OBJECT(m_fence);
 
-	m_fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-	if (m_fenceEvent == nullptr)
-	{
-		DX::ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
-	}
+	// Le planificateur signale l'isolation à chaque frame, et attend le GPU et la chaîne de permutation.
+	m_frameBackend = std::make_unique<D3D12FrameBackend>(m_commandQueue.Get(), m_fence.Get());
+	m_frameScheduler = std::make_unique<FrameScheduler>(*m_frameBackend, c_frameCount, c_frameCount, c_frameLatency);
 }
 
 // Ces ressources doivent être recréées chaque fois que la taille de la fenêtre est modifiée.
@@ -181,11 +193,11 @@ void DX::DeviceResources::CreateWindowSizeDependentResources()
 	// Attendez la fin du travail GPU en attente.
 	WaitForGpu();
 
-	// Effacez le précédent contenu spécifique à la taille de la fenêtre, puis mettez à jour les valeurs d'isolation suivies.
+	// Effacez le précédent contenu spécifique à la taille de la fenêtre.
 	for (UINT n = 0; n < c_frameCount; n++)
 	{
+		m_resourceStates.Unregister(m_renderTargets[n].Get());
 		m_renderTargets[n] = nullptr;
-		m_fenceValues[n] = m_fenceValues[m_currentFrame];
 	}
 
 	UpdateRenderTargetSize();
@@ -205,7 +217,7 @@ void DX::DeviceResources::CreateWindowSizeDependentResources()
 	if (m_swapChain != nullptr)
 	{
 		// Si la chaîne de permutation existe déjà, la redimensionner.
-		HRESULT hr = m_swapChain->ResizeBuffers(c_frameCount, backBufferWidth, backBufferHeight, m_backBufferFormat, 0);
+		HRESULT hr = m_swapChain->ResizeBuffers(c_frameCount, backBufferWidth, backBufferHeight, m_backBufferFormat, DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT);
 
 		if (hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET)
 		{
@@ -235,7 +247,7 @@ void DX::DeviceResources::CreateWindowSizeDependentResources()
 		swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
 		swapChainDesc.BufferCount = c_frameCount;					// Utilisez la triple mise en mémoire tampon pour réduire la latence.
 		swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;	// Toutes les applications universelles Windows doivent utiliser _FLIP_ SwapEffects
-		swapChainDesc.Flags = 0;
+		swapChainDesc.Flags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;	// Permet d'attendre la chaîne de permutation au début de chaque frame.
 		swapChainDesc.Scaling = scaling;
 		swapChainDesc.AlphaMode = DXGI_ALPHA_MODE_IGNORE;
 
@@ -251,6 +263,7 @@ void DX::DeviceResources::CreateWindowSizeDependentResources()
 			);
 
 		DX::ThrowIfFailed(swapChain.As(&m_swapChain));
+		m_frameBackend->SetSwapChain(m_swapChain.Get());
 	}
 
 	// Définir l'orientation appropriée pour la chaîne de permutation et générer des
@@ -286,12 +299,13 @@ void DX::DeviceResources::CreateWindowSizeDependentResources()
 	// Créez des vues de cible de rendu de la mémoire tampon d'arrière-plan de la chaîne de permutation.
 	{
 		m_currentFrame = m_swapChain->GetCurrentBackBufferIndex();
-		CD3DX12_CPU_DESCRIPTOR_HANDLE rtvDescriptor(m_rtvHeap->GetCPUDescriptorHandleForHeapStart());
+		CD3DX12_CPU_DESCRIPTOR_HANDLE rtvDescriptor(m_rtvDescriptors.cpuHandle);
 		for (UINT n = 0; n < c_frameCount; n++)
 		{
 			DX::ThrowIfFailed(m_swapChain->GetBuffer(n, IID_PPV_ARGS(&m_renderTargets[n])));
 			m_d3dDevice->CreateRenderTargetView(m_renderTargets[n].Get(), nullptr, rtvDescriptor);
-			rtvDescriptor.Offset(m_rtvDescriptorSize);
+			m_resourceStates.Register(m_renderTargets[n].Get(), D3D12_RESOURCE_STATE_PRESENT);
+			rtvDescriptor.Offset(m_rtvHeap->GetDescriptorSize());
 
 			WCHAR name[25];
 			if (swprintf_s(name, L"m_renderTargets[%u]", n) > 0)
@@ -301,32 +315,35 @@ void DX::DeviceResources::CreateWindowSizeDependentResources()
 		}
 	}
 
-	// Créez un stencil de profondeur et un affichage.
+	// Créez un stencil de profondeur et un affichage. Le GPU est inactif, la mémoire de l'ancien peut donc être rendue.
 	{
-		D3D12_HEAP_PROPERTIES depthHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+		if (m_depthStencil)
+		{
+			m_resourceStates.Unregister(m_depthStencil.Get());
+			m_heapAllocator->ReleaseResource(m_depthStencil.Get());
+			m_depthStencil = nullptr;
+		}
 
 		D3D12_RESOURCE_DESC depthResourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(m_depthBufferFormat, backBufferWidth, backBufferHeight, 1, 1);
 		depthResourceDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
 
 		CD3DX12_CLEAR_VALUE depthOptimizedClearValue(m_depthBufferFormat, 1.0f, 0);
 
-		ThrowIfFailed(m_d3dDevice->CreateCommittedResource(
-			&depthHeapProperties,
-			D3D12_HEAP_FLAG_NONE,
-			&depthResourceDesc,
+		m_depthStencil = m_heapAllocator->CreateResource(
+			D3D12_HEAP_TYPE_DEFAULT,
+			depthResourceDesc,
 			D3D12_RESOURCE_STATE_DEPTH_WRITE,
-			&depthOptimizedClearValue,
-			IID_PPV_ARGS(&m_depthStencil)
-			));
+			&depthOptimizedClearValue);
 
 		NAME_D3D12_OBJECT(m_depthStencil);
+		m_resourceStates.Register(m_depthStencil.Get(), D3D12_RESOURCE_STATE_DEPTH_WRITE);
 
 		D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
 		dsvDesc.Format = m_depthBufferFormat;
 		dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
 		dsvDesc.Flags = D3D12_DSV_FLAG_NONE;
 
-		m_d3dDevice->CreateDepthStencilView(m_depthStencil.Get(), &dsvDesc, m_dsvHeap->GetCPUDescriptorHandleForHeapStart());
+		m_d3dDevice->CreateDepthStencilView(m_depthStencil.Get(), &dsvDesc, m_dsvDescriptor.cpuHandle);
 	}
 
 	// Définir la fenêtre d'affichage de rendu 3D de manière à ce qu'elle cible la totalité de la fenêtre.
@@ -477,36 +494,31 @@ void DX::DeviceResources::Present()
 // Attendez l'achèvement du travail GPU en attente.
 void DX::DeviceResources::WaitForGpu()
 {
-	// Planifiez une commande de signalisation dans la file d'attente.
-	DX::ThrowIfFailed(m_commandQueue->Signal(m_fence.Get(), m_fenceValues[m_currentFrame]));
-
-	// Patientez jusqu'à ce que l'isolation soit franchie.
-	DX::ThrowIfFailed(m_fence->SetEventOnCompletion(m_fenceValues[m_currentFrame], m_fenceEvent));
-	WaitForSingleObjectEx(m_fenceEvent, INFINITE, FALSE);
+	m_frameScheduler->WaitForIdle();
+}
 
-	// Incrémentez la valeur d'isolation du frame actuel.
-	m_fenceValues[m_currentFrame]++;
+// Attendez que la chaîne de permutation puisse accepter une nouvelle frame. À appeler avant le travail UC de la frame,
+// pour que les entrées lues pendant la mise à jour soient aussi récentes que possible à l'affichage.
+void DX::DeviceResources::BeginFrame()
+{
+	m_frameScheduler->BeginFrame();
 }
 
 // Préparez le rendu du frame suivant.
 void DX::DeviceResources::MoveToNextFrame()
 {
-	// Planifiez une commande de signalisation dans la file d'attente.
-	const UINT64 currentFenceValue = m_fenceValues[m_currentFrame];
-	DX::ThrowIfFailed(m_commandQueue->Signal(m_fence.Get(), currentFenceValue));
+	// Signalez la fin de cette frame, puis attendez que le GPU ait assez avancé pour en commencer une autre.
+	const UINT64 currentFenceValue = m_frameScheduler->GetCurrentFenceValue();
+	m_frameScheduler->EndFrame();
+
+	// Les descripteurs transitoires de cette frame seront libres une fois cette valeur atteinte.
+	m_cbvSrvUavHeap->Submit(currentFenceValue);
 
 	// Avancez l'index de frame.
 	m_currentFrame = m_swapChain->GetCurrentBackBufferIndex();
 
-	// Vérifiez si le prochain frame est prêt à démarrer.
-	if (m_fence->GetCompletedValue() < m_fenceValues[m_currentFrame])
-	{
-		DX::ThrowIfFailed(m_fence->SetEventOnCompletion(m_fenceValues[m_currentFrame], m_fenceEvent));
-		WaitForSingleObjectEx(m_fenceEvent, INFINITE, FALSE);
-	}
-
-	// Définissez la valeur d'isolation du frame suivant.
-	m_fenceValues[m_currentFrame] = currentFenceValue + 1;
+	// Rendez les descripteurs que le GPU a fini de lire.
+	m_cbvSrvUavHeap->Retire(m_fence->GetCompletedValue());
 }
 
 // Cette méthode détermine la rotation entre l'orientation native du périphérique d'affichage et
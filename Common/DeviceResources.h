@@ -1,8 +1,23 @@
 ﻿#pragma once
 
+#include "UploadQueue.h"
+#include "HeapAllocator.h"
+#include "DescriptorHeap.h"
+#include "ResourceBarriers.h"
+#include "D3D12FrameBackend.h"
+#include "AssetLoader.h"
+#include "PipelineStateCache.h"
+
 namespace DX
 {
 	static const UINT c_frameCount = 3;		// Utilisez la triple mise en mémoire tampon.
+	static const UINT c_frameLatency = 2;	// Frames que la chaîne de permutation peut mettre en file avant que BeginFrame ne bloque.
+	static const UINT64 c_uploadRingSize = 4 * 1024 * 1024;	// Taille de l'anneau de chargement partagé, en octets.
+	static const UINT64 c_heapSize = 32 * 1024 * 1024;		// Taille des tas dans lesquels les ressources sont placées.
+	static const UINT c_persistentDescriptorCount = 1024;	// Descripteurs CBV/SRV/UAV qui vivent plus d'une frame.
+	static const UINT c_transientDescriptorCount = 4096;	// Descripteurs CBV/SRV/UAV par frame, partagés en anneau.
+	static const UINT c_assetLoaderThreadCount = 2;			// Threads qui projettent les actifs et exécutent les travaux qui en dépendent.
+	static const UINT c_pipelineCacheThreadCount = 2;		// Threads qui créent les états de pipeline en arrière-plan.
 
 	// Contrôle toutes les ressources du périphérique DirectX.
 	class DeviceResources
@@ -14,9 +29,16 @@ namespace DX
 		void SetCurrentOrientation(Windows::Graphics::Display::DisplayOrientations currentOrientation);
 		void SetDpi(float dpi);
 		void ValidateDevice();
+		void BeginFrame();
 		void Present();
 		void WaitForGpu();
 
+		// Rythme des frames. Le nombre de frames en vol est limité à c_frameCount.
+		void SetFramesInFlight(UINT frames)									{ m_frameScheduler->SetFramesInFlight(frames); }
+		void SetFrameLatency(UINT frames)									{ m_frameScheduler->SetFrameLatency(frames); }
+		const FrameStats&			GetLastFrameStats() const			{ return m_frameScheduler->GetLastFrameStats(); }
+		const FrameStatsTotals&		GetFrameStatsTotals() const			{ return m_frameScheduler->GetStatsTotals(); }
+
 		// Taille de la cible de rendu, en pixels.
 		Windows::Foundation::Size	GetOutputSize() const				{ return m_outputSize; }
 
@@ -33,19 +55,29 @@ namespace DX
 		ID3D12Resource*				GetDepthStencil() const				{ return m_depthStencil.Get(); }
 		ID3D12CommandQueue*			GetCommandQueue() const				{ return m_commandQueue.Get(); }
 		ID3D12CommandAllocator*		GetCommandAllocator() const			{ return m_commandAllocators[m_currentFrame].Get(); }
+		UploadQueue*				GetUploadQueue() const				{ return m_uploadQueue.get(); }
+		HeapAllocator*				GetHeapAllocator() const			{ return m_heapAllocator.get(); }
+		DescriptorHeap*				GetCbvSrvUavHeap() const			{ return m_cbvSrvUavHeap.get(); }
+		ResourceStateRegistry&		GetResourceStates()					{ return m_resourceStates; }
+		AssetLoader*				GetAssetLoader() const				{ return m_assetLoader.get(); }
+		PipelineStateCache*			GetPipelineStateCache() const		{ return m_pipelineStateCache.get(); }
 		DXGI_FORMAT					GetBackBufferFormat() const			{ return m_backBufferFormat; }
 		DXGI_FORMAT					GetDepthBufferFormat() const		{ return m_depthBufferFormat; }
 		D3D12_VIEWPORT				GetScreenViewport() const			{ return m_screenViewport; }
 		DirectX::XMFLOAT4X4			GetOrientationTransform3D() const	{ return m_orientationTransform3D; }
 		UINT						GetCurrentFrameIndex() const		{ return m_currentFrame; }
 
+		// Isolation de la file de commandes. La valeur courante est celle qui sera signalée une fois le travail de cette frame terminé.
+		ID3D12Fence*				GetFence() const					{ return m_fence.Get(); }
+		UINT64						GetCurrentFenceValue() const		{ return m_frameScheduler->GetCurrentFenceValue(); }
+
 		CD3DX12_CPU_DESCRIPTOR_HANDLE GetRenderTargetView() const
 		{
-			return CD3DX12_CPU_DESCRIPTOR_HANDLE(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(), m_currentFrame, m_rtvDescriptorSize);
+			return CD3DX12_CPU_DESCRIPTOR_HANDLE(m_rtvDescriptors.cpuHandle, m_currentFrame, m_rtvHeap->GetDescriptorSize());
 		}
 		CD3DX12_CPU_DESCRIPTOR_HANDLE GetDepthStencilView() const
 		{
-			return CD3DX12_CPU_DESCRIPTOR_HANDLE(m_dsvHeap->GetCPUDescriptorHandleForHeapStart());
+			return m_dsvDescriptor.cpuHandle;
 		}
 
 	private:
@@ -65,20 +97,29 @@ namespace DX
 		Microsoft::WRL::ComPtr<IDXGISwapChain3>			m_swapChain;
 		Microsoft::WRL::ComPtr<ID3D12Resource>			m_renderTargets[c_frameCount];
 		Microsoft::WRL::ComPtr<ID3D12Resource>			m_depthStencil;
-		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>	m_rtvHeap;
-		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>	m_dsvHeap;
+		std::unique_ptr<DescriptorHeap>					m_rtvHeap;
+		std::unique_ptr<DescriptorHeap>					m_dsvHeap;
+		std::unique_ptr<DescriptorHeap>					m_cbvSrvUavHeap;
+		DescriptorAllocation							m_rtvDescriptors;
+		DescriptorAllocation							m_dsvDescriptor;
+		ResourceStateRegistry							m_resourceStates;	// État des cibles de rendu et du stencil de profondeur entre les frames.
 		Microsoft::WRL::ComPtr<ID3D12CommandQueue>		m_commandQueue;
 		Microsoft::WRL::ComPtr<ID3D12CommandAllocator>	m_commandAllocators[c_frameCount];
+		std::unique_ptr<UploadQueue>					m_uploadQueue;
+		std::unique_ptr<HeapAllocator>					m_heapAllocator;
+		std::unique_ptr<PipelineStateCache>				m_pipelineStateCache;
 		DXGI_FORMAT										m_backBufferFormat;
 		DXGI_FORMAT										m_depthBufferFormat;
 		D3D12_VIEWPORT									m_screenViewport;
-		UINT											m_rtvDescriptorSize;
 		bool											m_deviceRemoved;
 
+		// Chargement des actifs, indépendant du périphérique.
+		std::unique_ptr<AssetLoader>					m_assetLoader;
+
 		// Synchronisation UC/GPU.
 		Microsoft::WRL::ComPtr<ID3D12Fence>				m_fence;
-		UINT64											m_fenceValues[c_frameCount];
-		HANDLE											m_fenceEvent;
+		std::unique_ptr<D3D12FrameBackend>				m_frameBackend;
+		std::unique_ptr<FrameScheduler>					m_frameScheduler;
 
 		// Référence à la fenêtre mise en cache.
 		Platform::Agile<Windows::UI::Core::CoreWindow>	m_window;
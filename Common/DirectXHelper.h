@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include <ppltasks.h>	// Pour create_task
+#include "AssetLoader.h"
 
 namespace DX
 {
@@ -13,24 +14,23 @@ namespace DX
 		}
 	}
 
-	// Fonction qui lit les données d'un fichier binaire de manière asynchrone.
-	inline Concurrency::task<std::vector<byte>> ReadDataAsync(const std::wstring& filename)
+	// Retourne une tâche qui se termine en même temps qu'une requête du chargeur d'actifs, et qui en
+	// reprend l'exception en cas d'échec.
+	inline Concurrency::task<void> WhenLoaded(AssetLoader& loader, const AssetHandle& request)
 	{
-		using namespace Windows::Storage;
-		using namespace Concurrency;
-
-		auto folder = Windows::ApplicationModel::Package::Current->InstalledLocation;
-
-		return create_task(folder->GetFileAsync(Platform::StringReference(filename.c_str()))).then([](StorageFile^ file)
-		{
-			return FileIO::ReadBufferAsync(file);
-		}).then([](Streams::IBuffer^ fileBuffer) -> std::vector<byte>
+		Concurrency::task_completion_event<void> completion;
+		loader.OnComplete(request, [completion](const AssetRequest& completed)
 		{
-			std::vector<byte> returnBuffer;
-			returnBuffer.resize(fileBuffer->Length);
-			Streams::DataReader::FromBuffer(fileBuffer)->ReadBytes(Platform::ArrayReference<byte>(returnBuffer.data(), fileBuffer->Length));
-			return returnBuffer;
+			if (completed.GetException())
+			{
+				completion.set_exception(completed.GetException());
+			}
+			else
+			{
+				completion.set();
+			}
 		});
+		return Concurrency::create_task(completion);
 	}
 
 	// Convertit une longueur en pixels indépendants du périphérique (DIP) en longueur en pixels physiques.
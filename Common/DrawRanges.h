@@ -0,0 +1,49 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace DX
+{
+	// Plage contiguë d'appels de dessin enregistrée par un même thread.
+	struct DrawRange
+	{
+		uint32_t start;
+		uint32_t count;
+	};
+
+	// Répartit drawCount dessins en plages disjointes et ordonnées, une par thread, sans dépasser
+	// maxRanges. Chaque plage contient au moins minDrawsPerRange dessins (sauf s'il y en a moins
+	// au total), car une liste de commandes de plus coûte plus cher que quelques dessins.
+	inline std::vector<DrawRange> SplitDrawRanges(uint32_t drawCount, uint32_t maxRanges, uint32_t minDrawsPerRange)
+	{
+		std::vector<DrawRange> ranges;
+		if (drawCount == 0 || maxRanges == 0)
+		{
+			return ranges;
+		}
+
+		uint32_t rangeCount = minDrawsPerRange > 0 ? drawCount / minDrawsPerRange : drawCount;
+		if (rangeCount > maxRanges)
+		{
+			rangeCount = maxRanges;
+		}
+		if (rangeCount == 0)
+		{
+			rangeCount = 1;
+		}
+
+		// Les premières plages reçoivent un dessin de plus quand la division ne tombe pas juste.
+		uint32_t perRange = drawCount / rangeCount;
+		uint32_t extra = drawCount % rangeCount;
+		uint32_t start = 0;
+		ranges.reserve(rangeCount);
+		for (uint32_t i = 0; i < rangeCount; i++)
+		{
+			uint32_t count = perRange + (i < extra ? 1 : 0);
+			ranges.push_back({ start, count });
+			start += count;
+		}
+		return ranges;
+	}
+}
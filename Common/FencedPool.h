@@ -0,0 +1,45 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+namespace DX
+{
+	// Réserve d'objets que le GPU utilise encore pendant un certain temps après leur soumission
+	// (allocateurs de commandes, pages de mémoire de chargement, etc.). Chaque objet libéré est
+	// étiqueté avec la valeur d'isolation qui sera signalée une fois le GPU terminé, et il n'est
+	// redonné qu'une fois cette valeur atteinte. Ne dépend pas de D3D12, la valeur d'isolation
+	// complétée est fournie par l'appelant.
+	template <typename T>
+	class FencedPool
+	{
+	public:
+		// Retourne un objet que le GPU a fini d'utiliser. Retourne false s'il n'y en a aucun,
+		// auquel cas l'appelant doit en créer un nouveau.
+		bool Acquire(uint64_t completedFenceValue, T& item)
+		{
+			if (m_pending.empty() || m_pending.front().first > completedFenceValue)
+			{
+				return false;
+			}
+			item = std::move(m_pending.front().second);
+			m_pending.pop_front();
+			return true;
+		}
+
+		// Rend un objet à la réserve. Il pourra être réutilisé une fois que l'isolation aura atteint fenceValue.
+		void Release(T item, uint64_t fenceValue)
+		{
+			// Les valeurs d'isolation ne font qu'augmenter, donc la file reste triée.
+			m_pending.emplace_back(fenceValue, std::move(item));
+		}
+
+		size_t GetCount() const { return m_pending.size(); }
+		void Clear() { m_pending.clear(); }
+
+	private:
+		std::deque<std::pair<uint64_t, T>> m_pending;
+	};
+}
@@ -0,0 +1,170 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace DX
+{
+	// Ce dont le planificateur de frames a besoin du GPU et de la chaîne de permutation. Un backend D3D12 s'appuie
+	// sur une isolation et sur l'objet d'attente de la chaîne de permutation ; un backend simulé permet de mesurer
+	// les compromis latence/débit sans GPU.
+	class FrameSchedulerBackend
+	{
+	public:
+		virtual ~FrameSchedulerBackend() {}
+
+		virtual uint64_t GetCompletedFenceValue() = 0;
+		virtual void SignalFence(uint64_t value) = 0;
+		virtual void WaitForFence(uint64_t value) = 0;
+
+		// Bloque jusqu'à ce que la chaîne de permutation accepte une nouvelle frame sans dépasser la latence voulue.
+		virtual void WaitForFrameLatency() = 0;
+		virtual void SetFrameLatency(uint32_t frames) = 0;
+
+		// Temps en secondes, pour les statistiques.
+		virtual double GetTime() = 0;
+	};
+
+	// Temps passés par l'UC à attendre pendant une frame, en secondes.
+	struct FrameStats
+	{
+		double		cpuWait;		// Attente de l'isolation, parce que le GPU avait trop de frames en retard.
+		double		latencyWait;	// Attente de la chaîne de permutation, pour tenir la latence voulue.
+		double		frameTime;		// Entre le début de cette frame et celui de la précédente.
+		bool		gpuStarved;		// Le GPU avait terminé tout le travail soumis quand la frame a commencé : il attend l'UC.
+	};
+
+	// Cumul des statistiques depuis le dernier ResetStats.
+	struct FrameStatsTotals
+	{
+		uint64_t	frameCount;
+		uint64_t	gpuStarvedCount;
+		double		cpuWait;
+		double		latencyWait;
+		double		frameTime;
+	};
+
+	// Rythme les frames : BeginFrame attend la chaîne de permutation, EndFrame signale l'isolation de la frame
+	// soumise puis attend que le GPU ait assez avancé pour qu'au plus framesInFlight frames soient en cours,
+	// en comptant celle que l'UC va enregistrer. Avec une seule frame en vol, l'UC et le GPU ne se chevauchent
+	// jamais ; avec trois, l'UC peut avoir deux frames d'avance. Une frame qui n'a rien soumis (EndFrame n'a pas
+	// été appelé) continue au BeginFrame suivant, sans attendre la chaîne de permutation une seconde fois : rien
+	// n'a été présenté depuis, l'attente ne se terminerait qu'à l'expiration de son délai.
+	// Ne dépend pas de D3D12.
+	class FrameScheduler
+	{
+	public:
+		FrameScheduler(FrameSchedulerBackend& backend, uint32_t maxFramesInFlight, uint32_t framesInFlight, uint32_t frameLatency) :
+			m_backend(backend),
+			m_signaled(maxFramesInFlight, 0),
+			m_framesInFlight(1),
+			m_frameLatency(frameLatency),
+			m_frameIndex(0),
+			m_nextFenceValue(1),
+			m_lastSignaledValue(0),
+			m_endedSinceWait(true),
+			m_frameStart(0.0),
+			m_currentStats(),
+			m_lastStats(),
+			m_totals()
+		{
+			SetFramesInFlight(framesInFlight);
+			m_backend.SetFrameLatency(frameLatency);
+		}
+
+		void SetFramesInFlight(uint32_t frames)
+		{
+			uint32_t maxFrames = static_cast<uint32_t>(m_signaled.size());
+			m_framesInFlight = frames < 1 ? 1 : (frames > maxFrames ? maxFrames : frames);
+		}
+
+		void SetFrameLatency(uint32_t frames)
+		{
+			m_frameLatency = frames < 1 ? 1 : frames;
+			m_backend.SetFrameLatency(m_frameLatency);
+		}
+
+		uint32_t GetFramesInFlight() const	{ return m_framesInFlight; }
+		uint32_t GetFrameLatency() const	{ return m_frameLatency; }
+
+		// À appeler avant tout travail UC de la frame, pour que ce travail ne prenne pas de retard sur l'affichage.
+		void BeginFrame()
+		{
+			if (!m_endedSinceWait)
+			{
+				return;
+			}
+			m_endedSinceWait = false;
+
+			double start = m_backend.GetTime();
+			m_backend.WaitForFrameLatency();
+			double now = m_backend.GetTime();
+
+			m_currentStats = FrameStats();
+			m_currentStats.latencyWait = now - start;
+			m_currentStats.frameTime = m_frameStart > 0.0 ? now - m_frameStart : 0.0;
+			m_currentStats.gpuStarved = m_lastSignaledValue > 0 && m_backend.GetCompletedFenceValue() >= m_lastSignaledValue;
+			m_frameStart = now;
+		}
+
+		// À appeler une fois le travail de la frame soumis. La valeur signalée est GetCurrentFenceValue.
+		void EndFrame()
+		{
+			uint64_t value = m_nextFenceValue++;
+			m_backend.SignalFence(value);
+			m_lastSignaledValue = value;
+			m_signaled[m_frameIndex % m_signaled.size()] = value;
+			m_frameIndex++;
+			m_endedSinceWait = true;
+
+			// Attendez la frame qui doit être terminée pour que la suivante puisse commencer.
+			double start = m_backend.GetTime();
+			if (m_frameIndex >= m_framesInFlight)
+			{
+				uint64_t wanted = m_signaled[(m_frameIndex - m_framesInFlight) % m_signaled.size()];
+				if (m_backend.GetCompletedFenceValue() < wanted)
+				{
+					m_backend.WaitForFence(wanted);
+				}
+			}
+			m_currentStats.cpuWait = m_backend.GetTime() - start;
+
+			m_lastStats = m_currentStats;
+			m_totals.frameCount++;
+			m_totals.gpuStarvedCount += m_currentStats.gpuStarved ? 1 : 0;
+			m_totals.cpuWait += m_currentStats.cpuWait;
+			m_totals.latencyWait += m_currentStats.latencyWait;
+			m_totals.frameTime += m_currentStats.frameTime;
+		}
+
+		// Attend la fin de tout le travail soumis au GPU.
+		void WaitForIdle()
+		{
+			uint64_t value = m_nextFenceValue++;
+			m_backend.SignalFence(value);
+			m_backend.WaitForFence(value);
+			m_lastSignaledValue = value;
+		}
+
+		// Valeur que l'isolation atteindra une fois le travail de la frame en cours terminé.
+		uint64_t GetCurrentFenceValue() const			{ return m_nextFenceValue; }
+
+		const FrameStats& GetLastFrameStats() const		{ return m_lastStats; }
+		const FrameStatsTotals& GetStatsTotals() const	{ return m_totals; }
+		void ResetStats()								{ m_totals = FrameStatsTotals(); }
+
+	private:
+		FrameSchedulerBackend&	m_backend;
+		std::vector<uint64_t>	m_signaled;			// Valeurs signalées par les dernières frames, en anneau.
+		uint32_t				m_framesInFlight;
+		uint32_t				m_frameLatency;
+		uint64_t				m_frameIndex;
+		uint64_t				m_nextFenceValue;
+		uint64_t				m_lastSignaledValue;
+		bool					m_endedSinceWait;	// Une frame a été soumise depuis la dernière attente de la chaîne de permutation.
+		double					m_frameStart;
+		FrameStats				m_currentStats;
+		FrameStats				m_lastStats;
+		FrameStatsTotals		m_totals;
+	};
+}
@@ -0,0 +1,93 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <map>
+
+namespace DX
+{
+	// Allocateur de plages contiguës dans un espace d'index [0, capacity), par exemple les emplacements d'un tas
+	// de descripteurs. Les plages libres sont gardées triées par index ; une allocation prend la première assez
+	// grande, et une plage libérée est fusionnée avec ses voisines. Ne dépend pas de D3D12.
+	class FreeListAllocator
+	{
+	public:
+		explicit FreeListAllocator(uint32_t capacity = 0) :
+			m_capacity(capacity),
+			m_freeCount(capacity)
+		{
+			if (capacity > 0)
+			{
+				m_freeRanges[0] = capacity;
+			}
+		}
+
+		// Réserve count index consécutifs. Retourne false si aucune plage libre n'est assez grande.
+		bool Allocate(uint32_t count, uint32_t& index)
+		{
+			for (auto range = m_freeRanges.begin(); range != m_freeRanges.end(); ++range)
+			{
+				if (range->second < count)
+				{
+					continue;
+				}
+				index = range->first;
+				uint32_t remaining = range->second - count;
+				m_freeRanges.erase(range);
+				if (remaining > 0)
+				{
+					m_freeRanges[index + count] = remaining;
+				}
+				m_freeCount -= count;
+				return true;
+			}
+			return false;
+		}
+
+		// Rend une plage retournée par Allocate.
+		void Free(uint32_t index, uint32_t count)
+		{
+			if (count == 0)
+			{
+				return;
+			}
+			m_freeCount += count;
+
+			// Fusionnez avec la plage libre qui suit, puis avec celle qui précède.
+			auto next = m_freeRanges.lower_bound(index);
+			if (next != m_freeRanges.end() && next->first == index + count)
+			{
+				count += next->second;
+				next = m_freeRanges.erase(next);
+			}
+			if (next != m_freeRanges.begin())
+			{
+				auto previous = std::prev(next);
+				if (previous->first + previous->second == index)
+				{
+					previous->second += count;
+					return;
+				}
+			}
+			m_freeRanges[index] = count;
+		}
+
+		uint32_t GetCapacity() const	{ return m_capacity; }
+		uint32_t GetFreeCount() const	{ return m_freeCount; }
+
+		uint32_t GetLargestFreeRange() const
+		{
+			uint32_t largest = 0;
+			for (auto& range : m_freeRanges)
+			{
+				largest = range.second > largest ? range.second : largest;
+			}
+			return largest;
+		}
+
+	private:
+		uint32_t						m_capacity;
+		uint32_t						m_freeCount;
+		std::map<uint32_t, uint32_t>	m_freeRanges;	// Premier index, nombre d'index.
+	};
+}
@@ -0,0 +1,186 @@
+﻿#include "pch.h"
+#include "HeapAllocator.h"
+#include "DirectXHelper.h"
+
+using namespace Microsoft::WRL;
+
+DX::HeapAllocator::HeapAllocator(ID3D12Device* device, UINT64 heapSize) :
+	m_device(device),
+	m_heapSize(heapSize)
+{
+}
+
+ComPtr<ID3D12Resource> DX::HeapAllocator::CreateResource(
+	D3D12_HEAP_TYPE heapType,
+	const D3D12_RESOURCE_DESC& desc,
+	D3D12_RESOURCE_STATES initialState,
+	const D3D12_CLEAR_VALUE* clearValue)
+{
+	Category category = GetCategory(desc);
+	D3D12_RESOURCE_ALLOCATION_INFO info = m_device->GetResourceAllocationInfo(0, 1, &desc);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	ComPtr<ID3D12Resource> resource;
+	bool placeable =
+		heapType >= D3D12_HEAP_TYPE_DEFAULT && heapType <= D3D12_HEAP_TYPE_READBACK &&
+		(heapType == D3D12_HEAP_TYPE_DEFAULT || category == Buffers) &&
+		info.SizeInBytes <= m_heapSize / 2;
+
+	if (!placeable)
+	{
+		CD3DX12_HEAP_PROPERTIES heapProperties(heapType);
+		DX::ThrowIfFailed(m_device->CreateCommittedResource(
+			&heapProperties,
+			D3D12_HEAP_FLAG_NONE,
+			&desc,
+			initialState,
+			clearValue,
+			IID_PPV_ARGS(&resource)));
+		m_placements[resource.Get()] = Placement{ nullptr, 0, 0 };
+		return resource;
+	}
+
+	// Cherchez de la place dans les tas existants, du plus ancien au plus récent, avant d'en créer un.
+	UINT pool = (heapType - D3D12_HEAP_TYPE_DEFAULT) * CategoryCount + category;
+	Heap* heap = nullptr;
+	UINT64 offset = 0;
+	for (auto& candidate : m_pools[pool])
+	{
+		if (candidate->allocator.Allocate(info.SizeInBytes, info.Alignment, offset))
+		{
+			heap = candidate.get();
+			break;
+		}
+	}
+	if (heap == nullptr)
+	{
+		heap = CreateHeap(heapType, category);
+		if (!heap->allocator.Allocate(info.SizeInBytes, info.Alignment, offset))
+		{
+			DX::ThrowIfFailed(E_OUTOFMEMORY);
+		}
+	}
+
+	HRESULT hr = m_device->CreatePlacedResource(heap->heap.Get(), offset, &desc, initialState, clearValue, IID_PPV_ARGS(&resource));
+	if (FAILED(hr))
+	{
+		heap->allocator.Free(offset);
+		DX::ThrowIfFailed(hr);
+	}
+
+	m_placements[resource.Get()] = Placement{ heap, pool, offset };
+	return resource;
+}
+
+void DX::HeapAllocator::ReleaseResource(ID3D12Resource* resource)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto placement = m_placements.find(resource);
+	if (placement == m_placements.end())
+	{
+		return;
+	}
+	Heap* heap = placement->second.heap;
+	UINT pool = placement->second.pool;
+	UINT64 offset = placement->second.offset;
+	m_placements.erase(placement);
+	if (heap == nullptr)
+	{
+		return;
+	}
+
+	heap->allocator.Free(offset);
+
+	// Gardez toujours un tas par catégorie, mais rendez les autres dès qu'ils sont vides.
+	auto& heaps = m_pools[pool];
+	if (heap->allocator.IsEmpty() && heaps.size() > 1)
+	{
+		for (auto it = heaps.begin(); it != heaps.end(); ++it)
+		{
+			if (it->get() == heap)
+			{
+				heaps.erase(it);
+				break;
+			}
+		}
+	}
+}
+
+DX::HeapAllocatorStats DX::HeapAllocator::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	HeapAllocatorStats stats = {};
+	UINT64 freeBytes = 0;
+	float weightedFragmentation = 0.0f;
+	for (auto& heaps : m_pools)
+	{
+		for (auto& heap : heaps)
+		{
+			BuddyAllocatorStats heapStats = heap->allocator.GetStats();
+			UINT64 heapFreeBytes = heapStats.capacity - heapStats.allocatedBytes;
+			stats.heapCount++;
+			stats.heapBytes += heapStats.capacity;
+			stats.allocatedBytes += heapStats.allocatedBytes;
+			stats.requestedBytes += heapStats.requestedBytes;
+			stats.placedCount += heapStats.allocationCount;
+			if (heapStats.largestFreeBlock > stats.largestFreeBlock)
+			{
+				stats.largestFreeBlock = heapStats.largestFreeBlock;
+			}
+			freeBytes += heapFreeBytes;
+			weightedFragmentation += heapStats.GetExternalFragmentation() * static_cast<float>(heapFreeBytes);
+		}
+	}
+	stats.committedCount = static_cast<UINT>(m_placements.size()) - stats.placedCount;
+	stats.externalFragmentation = freeBytes == 0 ? 0.0f : weightedFragmentation / static_cast<float>(freeBytes);
+	return stats;
+}
+
+// Catégorie de tas exigée par le niveau 1 de gestion des ressources.
+DX::HeapAllocator::Category DX::HeapAllocator::GetCategory(const D3D12_RESOURCE_DESC& desc)
+{
+	if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+	{
+		return Buffers;
+	}
+	if (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
+	{
+		return RenderTargets;
+	}
+	return Textures;
+}
+
+DX::HeapAllocator::Heap* DX::HeapAllocator::CreateHeap(D3D12_HEAP_TYPE heapType, Category category)
+{
+	static const D3D12_HEAP_FLAGS categoryFlags[CategoryCount] =
+	{
+		D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+		D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES,
+		D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES,
+	};
+
+	std::unique_ptr<Heap> heap(new Heap(m_heapSize));
+
+	// Les cibles de rendu multiéchantillonnées exigent un alignement de 4 Mo, le tas doit donc l'être aussi.
+	// La taille est celle de l'allocateur, arrondie à une puissance de deux.
+	CD3DX12_HEAP_DESC heapDesc(
+		heap->allocator.GetCapacity(),
+		heapType,
+		category == RenderTargets ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
+		categoryFlags[category]);
+
+	DX::ThrowIfFailed(m_device->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap->heap)));
+
+	WCHAR name[32];
+	if (swprintf_s(name, L"HeapAllocator[%u][%u]", static_cast<UINT>(heapType), static_cast<UINT>(category)) > 0)
+	{
+		DX::SetName(heap->heap.Get(), name);
+	}
+
+	UINT pool = (heapType - D3D12_HEAP_TYPE_DEFAULT) * CategoryCount + category;
+	m_pools[pool].push_back(std::move(heap));
+	return m_pools[pool].back().get();
+}
@@ -0,0 +1,82 @@
+﻿#pragma once
+
+#include "BuddyAllocator.h"
+#include <mutex>
+#include <unordered_map>
+
+namespace DX
+{
+	// Statistiques de toutes les catégories de tas réunies.
+	struct HeapAllocatorStats
+	{
+		UINT	heapCount;
+		UINT64	heapBytes;				// Mémoire réservée dans des ID3D12Heap.
+		UINT64	allocatedBytes;			// Blocs occupés par des ressources placées.
+		UINT64	requestedBytes;			// Taille réellement demandée par ces ressources.
+		UINT64	largestFreeBlock;		// Plus grande ressource qui peut encore être placée sans nouveau tas.
+		UINT	placedCount;
+		UINT	committedCount;			// Ressources trop grandes ou non plaçables, créées à part.
+		float	externalFragmentation;	// Moyenne des tas, pondérée par leur espace libre.
+	};
+
+	// Crée les ressources comme ressources placées dans de grands ID3D12Heap plutôt que comme ressources
+	// validées (CreateCommittedResource), ce qui évite une allocation noyau et un alignement de 64 Ko
+	// pour chacune. Chaque tas est découpé par un BuddyAllocator.
+	//
+	// Les tas sont séparés par type (par défaut, chargement, relecture) et par catégorie de ressource
+	// (mémoires tampons, textures, cibles de rendu et stencils de profondeur), puisque le niveau 1 de
+	// gestion des ressources interdit de les mélanger. Une ressource plus grande que la moitié d'un tas,
+	// ou une texture hors du tas par défaut, est simplement créée comme ressource validée.
+	class HeapAllocator
+	{
+	public:
+		HeapAllocator(ID3D12Device* device, UINT64 heapSize);
+
+		Microsoft::WRL::ComPtr<ID3D12Resource> CreateResource(
+			D3D12_HEAP_TYPE heapType,
+			const D3D12_RESOURCE_DESC& desc,
+			D3D12_RESOURCE_STATES initialState,
+			const D3D12_CLEAR_VALUE* clearValue);
+
+		// Rend la mémoire d'une ressource créée par CreateResource. Le GPU doit avoir fini de l'utiliser,
+		// et l'appelant doit relâcher ses propres références juste après.
+		void ReleaseResource(ID3D12Resource* resource);
+
+		HeapAllocatorStats GetStats() const;
+
+	private:
+		enum Category
+		{
+			Buffers,
+			Textures,
+			RenderTargets,
+			CategoryCount
+		};
+
+		struct Heap
+		{
+			Heap(UINT64 size) : allocator(size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT) {}
+
+			Microsoft::WRL::ComPtr<ID3D12Heap>	heap;
+			BuddyAllocator						allocator;
+		};
+
+		struct Placement
+		{
+			Heap*	heap;		// nullptr pour une ressource validée.
+			UINT	pool;
+			UINT64	offset;
+		};
+
+		static const UINT c_heapTypeCount = 3;
+
+		static Category GetCategory(const D3D12_RESOURCE_DESC& desc);
+		Heap* CreateHeap(D3D12_HEAP_TYPE heapType, Category category);
+
+		Microsoft::WRL::ComPtr<ID3D12Device>			m_device;
+		UINT64											m_heapSize;
+		mutable std::mutex								m_mutex;
+		std::vector<std::unique_ptr<Heap>>				m_pools[c_heapTypeCount * CategoryCount];
+		std::unordered_map<ID3D12Resource*, Placement>	m_placements;
+	};
+}
@@ -0,0 +1,182 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace DX
+{
+	// Compression LZ77 simple, dans l'esprit des blocs LZ4 : une suite de séquences formées de littéraux
+	// suivis d'une copie depuis les 64 derniers Kio. La décompression ne fait que des copies d'octets, elle
+	// est donc assez rapide pour se faire au chargement. Ne dépend que de la bibliothèque standard.
+	//
+	// Séquence : un jeton (4 bits de nombre de littéraux, 4 bits de longueur de copie moins 4), les octets
+	// d'extension des littéraux, les littéraux, le décalage sur 2 octets, puis les octets d'extension de la
+	// copie. Un champ de 4 bits à 15 se prolonge par des octets ajoutés tant qu'ils valent 255. La dernière
+	// séquence n'a que des littéraux.
+	namespace Lz
+	{
+		static const size_t c_minMatch = 4;
+		static const size_t c_maxOffset = 65535;
+		static const uint32_t c_hashBits = 14;
+
+		inline uint32_t Read32(const uint8_t* p)
+		{
+			uint32_t value;
+			memcpy(&value, p, sizeof(value));
+			return value;
+		}
+
+		inline uint32_t Hash(uint32_t value)
+		{
+			return (value * 2654435761u) >> (32 - c_hashBits);
+		}
+
+		inline void WriteLength(std::vector<uint8_t>& out, size_t length)
+		{
+			while (length >= 255)
+			{
+				out.push_back(255);
+				length -= 255;
+			}
+			out.push_back(static_cast<uint8_t>(length));
+		}
+
+		inline void WriteSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalCount, size_t offset, size_t matchLength)
+		{
+			size_t matchCode = matchLength == 0 ? 0 : matchLength - c_minMatch;
+			uint8_t token = static_cast<uint8_t>(((literalCount < 15 ? literalCount : 15) << 4) | (matchCode < 15 ? matchCode : 15));
+			out.push_back(token);
+			if (literalCount >= 15)
+			{
+				WriteLength(out, literalCount - 15);
+			}
+			out.insert(out.end(), literals, literals + literalCount);
+			if (matchLength == 0)
+			{
+				return;
+			}
+			out.push_back(static_cast<uint8_t>(offset & 0xFF));
+			out.push_back(static_cast<uint8_t>(offset >> 8));
+			if (matchCode >= 15)
+			{
+				WriteLength(out, matchCode - 15);
+			}
+		}
+
+		inline bool ReadLength(const uint8_t*& in, const uint8_t* end, size_t& length)
+		{
+			uint8_t byte;
+			do
+			{
+				if (in == end)
+				{
+					return false;
+				}
+				byte = *in++;
+				length += byte;
+			} while (byte == 255);
+			return true;
+		}
+	}
+
+	// Compresse size octets de source. Le résultat peut être plus gros que l'entrée pour des données
+	// incompressibles ; c'est à l'appelant de garder alors la version non compressée.
+	inline std::vector<uint8_t> LzCompress(const uint8_t* source, size_t size)
+	{
+		std::vector<uint8_t> out;
+		out.reserve(size / 2 + 16);
+
+		std::vector<uint32_t> table(size_t(1) << Lz::c_hashBits, UINT32_MAX);
+		size_t anchor = 0;
+		size_t position = 0;
+		while (size >= Lz::c_minMatch && position <= size - Lz::c_minMatch)
+		{
+			uint32_t value = Lz::Read32(source + position);
+			uint32_t& slot = table[Lz::Hash(value)];
+			size_t candidate = slot;
+			slot = static_cast<uint32_t>(position);
+
+			if (candidate == UINT32_MAX || position - candidate > Lz::c_maxOffset || Lz::Read32(source + candidate) != value)
+			{
+				position++;
+				continue;
+			}
+
+			size_t length = Lz::c_minMatch;
+			while (position + length < size && source[candidate + length] == source[position + length])
+			{
+				length++;
+			}
+
+			Lz::WriteSequence(out, source + anchor, position - anchor, position - candidate, length);
+			position += length;
+			anchor = position;
+		}
+
+		Lz::WriteSequence(out, source + anchor, size - anchor, 0, 0);
+		return out;
+	}
+
+	// Décompresse source dans destination, qui doit faire exactement la taille d'origine. Retourne false
+	// si les données sont corrompues ou ne correspondent pas à cette taille.
+	inline bool LzDecompress(const uint8_t* source, size_t sourceSize, uint8_t* destination, size_t size)
+	{
+		const uint8_t* in = source;
+		const uint8_t* inEnd = source + sourceSize;
+		size_t written = 0;
+
+		while (in < inEnd)
+		{
+			uint8_t token = *in++;
+
+			size_t literalCount = token >> 4;
+			if (literalCount == 15 && !Lz::ReadLength(in, inEnd, literalCount))
+			{
+				return false;
+			}
+			if (literalCount > static_cast<size_t>(inEnd - in) || literalCount > size - written)
+			{
+				return false;
+			}
+			memcpy(destination + written, in, literalCount);
+			in += literalCount;
+			written += literalCount;
+
+			// La dernière séquence s'arrête après ses littéraux.
+			if (in == inEnd)
+			{
+				break;
+			}
+
+			if (inEnd - in < 2)
+			{
+				return false;
+			}
+			size_t offset = in[0] | (size_t(in[1]) << 8);
+			in += 2;
+			size_t length = token & 0x0F;
+			if (length == 15 && !Lz::ReadLength(in, inEnd, length))
+			{
+				return false;
+			}
+			length += Lz::c_minMatch;
+			if (offset == 0 || offset > written || length > size - written)
+			{
+				return false;
+			}
+
+			// Copie octet par octet : la source et la destination se chevauchent quand offset < length.
+			const uint8_t* from = destination + written - offset;
+			uint8_t* to = destination + written;
+			for (size_t i = 0; i < length; i++)
+			{
+				to[i] = from[i];
+			}
+			written += length;
+		}
+
+		return written == size;
+	}
+}
@@ -0,0 +1,184 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace DX
+{
+	// Encode un texte large en UTF-8. Sous Windows, wchar_t est en UTF-16 ; les paires de substitution
+	// ne sont pas recombinées, ce qui suffit pour les noms de fichiers d'actifs.
+	inline std::string WideToUtf8(const std::wstring& text)
+	{
+		std::string result;
+		result.reserve(text.size());
+		for (wchar_t c : text)
+		{
+			uint32_t code = static_cast<uint32_t>(c);
+			if (code < 0x80)
+			{
+				result += static_cast<char>(code);
+			}
+			else if (code < 0x800)
+			{
+				result += static_cast<char>(0xC0 | (code >> 6));
+				result += static_cast<char>(0x80 | (code & 0x3F));
+			}
+			else if (code < 0x10000)
+			{
+				result += static_cast<char>(0xE0 | (code >> 12));
+				result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+				result += static_cast<char>(0x80 | (code & 0x3F));
+			}
+			else
+			{
+				result += static_cast<char>(0xF0 | (code >> 18));
+				result += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+				result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+				result += static_cast<char>(0x80 | (code & 0x3F));
+			}
+		}
+		return result;
+	}
+
+	// Fichier projeté en mémoire en lecture seule. Le contenu reste accessible tant que l'objet existe,
+	// sans copie : les pages sont lues à la demande par le système. Sous Windows, passe par les variantes
+	// « FromApp » des API de projection, les seules permises aux applications UWP ; ailleurs, par mmap.
+	class MappedFile
+	{
+	public:
+		// Projette le fichier path. Retourne nullptr en cas d'échec, et place dans error le code du système
+		// (GetLastError sous Windows, errno ailleurs).
+		static std::shared_ptr<MappedFile> Open(const std::wstring& path, uint32_t& error)
+		{
+			std::shared_ptr<MappedFile> file(new MappedFile());
+			error = file->Map(path);
+			if (error != 0)
+			{
+				return nullptr;
+			}
+			return file;
+		}
+
+		~MappedFile()
+		{
+			Unmap();
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		const uint8_t*	GetData() const	{ return m_data; }
+		size_t			GetSize() const	{ return m_size; }
+
+	private:
+		MappedFile() :
+			m_data(nullptr),
+			m_size(0)
+		{
+		}
+
+#if defined(_WIN32)
+		uint32_t Map(const std::wstring& path)
+		{
+			HANDLE file = CreateFile2(path.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+			{
+				return GetLastError();
+			}
+
+			uint32_t error = 0;
+			LARGE_INTEGER size = {};
+			if (!GetFileSizeEx(file, &size))
+			{
+				error = GetLastError();
+			}
+			else if (size.QuadPart > 0)
+			{
+				// Une projection garde sa propre référence au fichier, le handle peut donc être fermé ensuite.
+				HANDLE mapping = CreateFileMappingFromApp(file, nullptr, PAGE_READONLY, 0, nullptr);
+				if (mapping == nullptr)
+				{
+					error = GetLastError();
+				}
+				else
+				{
+					m_data = static_cast<const uint8_t*>(MapViewOfFileFromApp(mapping, FILE_MAP_READ, 0, 0));
+					if (m_data == nullptr)
+					{
+						error = GetLastError();
+					}
+					else
+					{
+						m_size = static_cast<size_t>(size.QuadPart);
+					}
+					CloseHandle(mapping);
+				}
+			}
+			CloseHandle(file);
+			return error;
+		}
+
+		void Unmap()
+		{
+			if (m_data != nullptr)
+			{
+				UnmapViewOfFile(m_data);
+			}
+		}
+#else
+		uint32_t Map(const std::wstring& path)
+		{
+			int fd = open(WideToUtf8(path).c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0)
+			{
+				return static_cast<uint32_t>(errno);
+			}
+
+			uint32_t error = 0;
+			struct stat info = {};
+			if (fstat(fd, &info) != 0)
+			{
+				error = static_cast<uint32_t>(errno);
+			}
+			else if (info.st_size > 0)
+			{
+				void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+				if (data == MAP_FAILED)
+				{
+					error = static_cast<uint32_t>(errno);
+				}
+				else
+				{
+					m_data = static_cast<const uint8_t*>(data);
+					m_size = static_cast<size_t>(info.st_size);
+				}
+			}
+			close(fd);
+			return error;
+		}
+
+		void Unmap()
+		{
+			if (m_data != nullptr)
+			{
+				munmap(const_cast<uint8_t*>(m_data), m_size);
+			}
+		}
+#endif
+
+		const uint8_t*	m_data;
+		size_t			m_size;
+	};
+}
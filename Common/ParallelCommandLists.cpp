@@ -0,0 +1,71 @@
+﻿#include "pch.h"
+#include "ParallelCommandLists.h"
+#include "DirectXHelper.h"
+
+using namespace Microsoft::WRL;
+
+DX::ParallelCommandLists::ParallelCommandLists(ID3D12Device* device, D3D12_COMMAND_LIST_TYPE type) :
+	m_device(device),
+	m_type(type),
+	m_activeCount(0),
+	m_allocatorCount(0)
+{
+}
+
+void DX::ParallelCommandLists::Begin(UINT listCount, UINT64 completedFenceValue, ID3D12PipelineState* initialState)
+{
+	m_activeCount = listCount;
+	m_activeAllocators.resize(listCount);
+
+	for (UINT i = 0; i < listCount; i++)
+	{
+		// Réutilisez un allocateur que le GPU a fini de lire, sinon créez-en un.
+		ComPtr<ID3D12CommandAllocator>& allocator = m_activeAllocators[i];
+		if (m_allocatorPool.Acquire(completedFenceValue, allocator))
+		{
+			DX::ThrowIfFailed(allocator->Reset());
+		}
+		else
+		{
+			DX::ThrowIfFailed(m_device->CreateCommandAllocator(m_type, IID_PPV_ARGS(&allocator)));
+			m_allocatorCount++;
+		}
+
+		// Une liste peut être réinitialisée dès qu'elle a été soumise, donc elles sont conservées d'une frame à l'autre.
+		if (i < m_lists.size())
+		{
+			DX::ThrowIfFailed(m_lists[i]->Reset(allocator.Get(), initialState));
+		}
+		else
+		{
+			ComPtr<ID3D12GraphicsCommandList> list;
+			DX::ThrowIfFailed(m_device->CreateCommandList(0, m_type, allocator.Get(), initialState, IID_PPV_ARGS(&list)));
+
+			WCHAR name[40];
+			if (swprintf_s(name, L"ParallelCommandLists[%u]", i) > 0)
+			{
+				DX::SetName(list.Get(), name);
+			}
+			m_lists.push_back(list);
+		}
+	}
+}
+
+void DX::ParallelCommandLists::Submit(ID3D12CommandQueue* queue, UINT64 fenceValue)
+{
+	m_submitList.clear();
+	for (UINT i = 0; i < m_activeCount; i++)
+	{
+		DX::ThrowIfFailed(m_lists[i]->Close());
+		m_submitList.push_back(m_lists[i].Get());
+	}
+	queue->ExecuteCommandLists(static_cast<UINT>(m_submitList.size()), m_submitList.data());
+
+	// Les allocateurs ne pourront être réinitialisés qu'une fois que le GPU aura exécuté ces listes.
+	for (UINT i = 0; i < m_activeCount; i++)
+	{
+		m_allocatorPool.Release(std::move(m_activeAllocators[i]), fenceValue);
+	}
+	m_activeAllocators.clear();
+	m_activeCount = 0;
+}
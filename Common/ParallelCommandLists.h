@@ -0,0 +1,38 @@
+﻿#pragma once
+
+#include "FencedPool.h"
+
+namespace DX
+{
+	// Enregistre une frame dans plusieurs listes de commandes, une par thread, puis les soumet
+	// toutes dans l'ordre avec un seul ExecuteCommandLists. Chaque liste a son propre allocateur,
+	// car un allocateur ne peut servir qu'à une liste à la fois. Les allocateurs sont recyclés
+	// à l'aide de l'isolation de DeviceResources, on n'en crée donc que ce que le GPU a en vol.
+	class ParallelCommandLists
+	{
+	public:
+		ParallelCommandLists(ID3D12Device* device, D3D12_COMMAND_LIST_TYPE type = D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+		// Prépare listCount listes ouvertes. À appeler depuis un seul thread, avant que les threads de travail
+		// n'enregistrent chacun dans leur liste.
+		void Begin(UINT listCount, UINT64 completedFenceValue, ID3D12PipelineState* initialState);
+
+		// Ferme les listes et les soumet dans l'ordre. fenceValue doit être la valeur que la file signalera
+		// une fois ce travail terminé.
+		void Submit(ID3D12CommandQueue* queue, UINT64 fenceValue);
+
+		ID3D12GraphicsCommandList*	GetList(UINT index) const	{ return m_lists[index].Get(); }
+		UINT						GetListCount() const		{ return m_activeCount; }
+		size_t						GetAllocatorCount() const	{ return m_allocatorCount; }
+
+	private:
+		Microsoft::WRL::ComPtr<ID3D12Device>										m_device;
+		D3D12_COMMAND_LIST_TYPE														m_type;
+		std::vector<Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>>				m_lists;
+		std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>>					m_activeAllocators;
+		std::vector<ID3D12CommandList*>												m_submitList;
+		FencedPool<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>>					m_allocatorPool;
+		UINT																		m_activeCount;
+		size_t																		m_allocatorCount;
+	};
+}
@@ -0,0 +1,287 @@
+﻿#pragma once
+
+#include "MappedFile.h"
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace DX
+{
+	// Hachage FNV-1a 64 bits construit au fur et à mesure, pour former la clé d'un état de pipeline.
+	// AddValue hache la représentation mémoire : ne l'utiliser que pour des types sans octets de remplissage.
+	class PipelineKeyHasher
+	{
+	public:
+		PipelineKeyHasher() : m_hash(14695981039346656037ull) {}
+
+		void Add(const void* data, size_t size)
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			for (size_t i = 0; i < size; i++)
+			{
+				m_hash = (m_hash ^ bytes[i]) * 1099511628211ull;
+			}
+		}
+
+		template <typename T>
+		void AddValue(const T& value)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Seuls les types simples peuvent être hachés octet par octet.");
+			Add(&value, sizeof(value));
+		}
+
+		// Hache aussi le terminateur, pour que « ab » + « c » ne donne pas la même clé que « a » + « bc ».
+		void AddString(const char* text)
+		{
+			Add(text, text == nullptr ? 0 : strlen(text) + 1);
+		}
+
+		uint64_t Get() const { return m_hash; }
+
+	private:
+		uint64_t m_hash;
+	};
+
+	// Blobs d'états de pipeline compilés, indexés par clé et conservés d'une exécution à l'autre. Les blobs
+	// ne sont valides que pour le pilote qui les a produits : deviceTag identifie l'adaptateur et la version
+	// du pilote, et un fichier écrit avec une autre étiquette est ignoré. Ne dépend pas de D3D12.
+	//
+	// Fichier : un en-tête (magic, version, nombre d'entrées, étiquette, somme de contrôle de la suite), puis
+	// pour chaque entrée la clé, la taille et les octets du blob. Tout est en petit-boutiste.
+	class PipelineCacheStore
+	{
+	public:
+		static const uint32_t c_magic = 0x434F5350;	// « PSOC »
+		static const uint32_t c_version = 1;
+
+		typedef std::shared_ptr<const std::vector<uint8_t>> Blob;
+
+		explicit PipelineCacheStore(uint64_t deviceTag) :
+			m_deviceTag(deviceTag),
+			m_generation(0),
+			m_savedGeneration(0)
+		{
+		}
+
+		// Retourne le blob de key, ou nullptr s'il n'y en a pas.
+		Blob Find(uint64_t key) const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto entry = m_entries.find(key);
+			return entry == m_entries.end() ? nullptr : entry->second;
+		}
+
+		void Put(uint64_t key, const void* data, size_t size)
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			Blob blob = std::make_shared<const std::vector<uint8_t>>(bytes, bytes + size);
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_entries[key] = std::move(blob);
+			m_generation++;
+		}
+
+		// Retire un blob que le pilote a refusé.
+		void Remove(uint64_t key)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_entries.erase(key) != 0)
+			{
+				m_generation++;
+			}
+		}
+
+		size_t GetCount() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_entries.size();
+		}
+
+		bool IsDirty() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_generation != m_savedGeneration;
+		}
+
+		std::vector<uint8_t> Serialize() const
+		{
+			uint64_t generation;
+			return Serialize(generation);
+		}
+
+		// Remplace le contenu par celui de data. Retourne false, et laisse le magasin vide, si les données sont
+		// corrompues ou proviennent d'un autre pilote.
+		bool Deserialize(const uint8_t* data, size_t size)
+		{
+			std::unordered_map<uint64_t, Blob> entries;
+			bool valid = Parse(data, size, entries);
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_entries.swap(entries);
+			m_generation++;
+			m_savedGeneration = m_generation;
+			return valid;
+		}
+
+		bool LoadFile(const std::wstring& path)
+		{
+			uint32_t error = 0;
+			std::shared_ptr<MappedFile> file = MappedFile::Open(path, error);
+			if (file == nullptr)
+			{
+				return false;
+			}
+			return Deserialize(file->GetData(), file->GetSize());
+		}
+
+		// Écrit le magasin dans un fichier temporaire, puis le renomme, pour qu'une interruption ne laisse
+		// jamais un fichier à moitié écrit. Un Put fait pendant l'écriture n'est pas dans le fichier : le
+		// magasin reste alors modifié, et le prochain SaveFile l'écrira.
+		bool SaveFile(const std::wstring& path)
+		{
+			uint64_t generation;
+			std::vector<uint8_t> data = Serialize(generation);
+			std::wstring temporaryPath = path + L".tmp";
+
+#if defined(_WIN32)
+			FILE* file = nullptr;
+			if (_wfopen_s(&file, temporaryPath.c_str(), L"wb") != 0)
+			{
+				file = nullptr;
+			}
+#else
+			FILE* file = fopen(WideToUtf8(temporaryPath).c_str(), "wb");
+#endif
+			if (file == nullptr)
+			{
+				return false;
+			}
+			bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+			written = fclose(file) == 0 && written;
+
+#if defined(_WIN32)
+			written = written && MoveFileExW(temporaryPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+			written = written && rename(WideToUtf8(temporaryPath).c_str(), WideToUtf8(path).c_str()) == 0;
+#endif
+			if (written)
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (generation > m_savedGeneration)
+				{
+					m_savedGeneration = generation;
+				}
+			}
+			return written;
+		}
+
+	private:
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t entryCount;
+			uint32_t reserved;
+			uint64_t deviceTag;
+			uint64_t checksum;
+		};
+
+		// Sérialise le contenu, et donne la génération qu'il représente, lue sous le même verrou.
+		std::vector<uint8_t> Serialize(uint64_t& generation) const
+		{
+			std::vector<uint8_t> payload;
+			uint32_t count;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				generation = m_generation;
+				count = static_cast<uint32_t>(m_entries.size());
+				for (const auto& entry : m_entries)
+				{
+					uint64_t size = entry.second->size();
+					Append(payload, &entry.first, sizeof(entry.first));
+					Append(payload, &size, sizeof(size));
+					Append(payload, entry.second->data(), entry.second->size());
+				}
+			}
+
+			Header header = {};
+			header.magic = c_magic;
+			header.version = c_version;
+			header.entryCount = count;
+			header.deviceTag = m_deviceTag;
+			header.checksum = Checksum(payload.data(), payload.size());
+
+			std::vector<uint8_t> file;
+			file.reserve(sizeof(header) + payload.size());
+			Append(file, &header, sizeof(header));
+			file.insert(file.end(), payload.begin(), payload.end());
+			return file;
+		}
+
+		static void Append(std::vector<uint8_t>& out, const void* data, size_t size)
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			out.insert(out.end(), bytes, bytes + size);
+		}
+
+		static uint64_t Checksum(const uint8_t* data, size_t size)
+		{
+			PipelineKeyHasher hasher;
+			hasher.Add(data, size);
+			return hasher.Get();
+		}
+
+		bool Parse(const uint8_t* data, size_t size, std::unordered_map<uint64_t, Blob>& entries) const
+		{
+			Header header;
+			if (size < sizeof(header))
+			{
+				return false;
+			}
+			memcpy(&header, data, sizeof(header));
+			if (header.magic != c_magic || header.version != c_version || header.deviceTag != m_deviceTag ||
+				header.checksum != Checksum(data + sizeof(header), size - sizeof(header)))
+			{
+				return false;
+			}
+
+			size_t position = sizeof(header);
+			for (uint32_t i = 0; i < header.entryCount; i++)
+			{
+				uint64_t key;
+				uint64_t blobSize;
+				if (size - position < sizeof(key) + sizeof(blobSize))
+				{
+					entries.clear();
+					return false;
+				}
+				memcpy(&key, data + position, sizeof(key));
+				memcpy(&blobSize, data + position + sizeof(key), sizeof(blobSize));
+				position += sizeof(key) + sizeof(blobSize);
+				if (blobSize > size - position)
+				{
+					entries.clear();
+					return false;
+				}
+				entries[key] = std::make_shared<const std::vector<uint8_t>>(data + position, data + position + blobSize);
+				position += static_cast<size_t>(blobSize);
+			}
+
+			// Un nombre d'entrées trop petit laisserait des octets non lus : l'en-tête est alors corrompu.
+			if (position != size)
+			{
+				entries.clear();
+				return false;
+			}
+			return true;
+		}
+
+		mutable std::mutex						m_mutex;
+		uint64_t								m_deviceTag;
+		std::unordered_map<uint64_t, Blob>		m_entries;
+		uint64_t								m_generation;		// Augmente à chaque modification du contenu.
+		uint64_t								m_savedGeneration;	// Génération du dernier contenu lu ou écrit dans un fichier.
+	};
+}
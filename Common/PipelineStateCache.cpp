@@ -0,0 +1,340 @@
+﻿#include "pch.h"
+#include "PipelineStateCache.h"
+#include "DirectXHelper.h"
+
+using namespace Microsoft::WRL;
+
+namespace
+{
+	void HashShader(DX::PipelineKeyHasher& hasher, const D3D12_SHADER_BYTECODE& shader)
+	{
+		hasher.AddValue(static_cast<uint64_t>(shader.BytecodeLength));
+		hasher.Add(shader.pShaderBytecode, shader.BytecodeLength);
+	}
+
+	const D3D12_SHADER_BYTECODE& GetShader(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, int index)
+	{
+		const D3D12_SHADER_BYTECODE* shaders[] = { &desc.VS, &desc.PS, &desc.DS, &desc.HS, &desc.GS };
+		return *shaders[index];
+	}
+}
+
+DX::PipelineStateCache::PipelineStateCache(ID3D12Device* device, IDXGIFactory4* factory, const std::wstring& path, size_t threadCount) :
+	m_device(device),
+	m_path(path),
+	m_store(ComputeDeviceTag(device, factory)),
+	m_compiled(0),
+	m_loadedFromCache(0),
+	m_rejectedBlobs(0),
+	m_pool(threadCount)
+{
+	// Un fichier absent, corrompu ou écrit par un autre pilote laisse simplement le cache vide.
+	m_store.LoadFile(m_path);
+}
+
+DX::PipelineStateCache::~PipelineStateCache()
+{
+	m_pool.WaitIdle();
+	Save();
+}
+
+// Les blobs ne sont valides que pour un adaptateur et une version de pilote donnés.
+uint64_t DX::PipelineStateCache::ComputeDeviceTag(ID3D12Device* device, IDXGIFactory4* factory)
+{
+	PipelineKeyHasher hasher;
+	ComPtr<IDXGIAdapter1> adapter;
+	if (SUCCEEDED(factory->EnumAdapterByLuid(device->GetAdapterLuid(), IID_PPV_ARGS(&adapter))))
+	{
+		DXGI_ADAPTER_DESC1 desc;
+		if (SUCCEEDED(adapter->GetDesc1(&desc)))
+		{
+			hasher.AddValue(desc.VendorId);
+			hasher.AddValue(desc.DeviceId);
+			hasher.AddValue(desc.SubSysId);
+			hasher.AddValue(desc.Revision);
+		}
+
+		LARGE_INTEGER driverVersion = {};
+		if (SUCCEEDED(adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &driverVersion)))
+		{
+			hasher.AddValue(driverVersion.QuadPart);
+		}
+	}
+	return hasher.Get();
+}
+
+void DX::PipelineStateCache::RegisterRootSignature(ID3D12RootSignature* rootSignature, const void* serialized, size_t size)
+{
+	PipelineKeyHasher hasher;
+	hasher.Add(serialized, size);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_rootSignatureKeys[rootSignature] = hasher.Get();
+}
+
+// Hache chaque champ séparément : plusieurs structures de la description contiennent des octets de
+// remplissage, dont le contenu n'est pas défini.
+UINT64 DX::PipelineStateCache::ComputeKey(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+{
+	PipelineKeyHasher hasher;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto rootSignature = m_rootSignatureKeys.find(desc.pRootSignature);
+		if (rootSignature != m_rootSignatureKeys.end())
+		{
+			hasher.AddValue(rootSignature->second);
+		}
+		else
+		{
+			hasher.AddValue(reinterpret_cast<uintptr_t>(desc.pRootSignature));
+		}
+	}
+
+	for (int i = 0; i < 5; i++)
+	{
+		HashShader(hasher, GetShader(desc, i));
+	}
+
+	hasher.AddValue(desc.StreamOutput.NumEntries);
+	hasher.AddValue(desc.StreamOutput.RasterizedStream);
+
+	hasher.AddValue(desc.BlendState.AlphaToCoverageEnable);
+	hasher.AddValue(desc.BlendState.IndependentBlendEnable);
+	for (const D3D12_RENDER_TARGET_BLEND_DESC& target : desc.BlendState.RenderTarget)
+	{
+		hasher.AddValue(target.BlendEnable);
+		hasher.AddValue(target.LogicOpEnable);
+		hasher.AddValue(target.SrcBlend);
+		hasher.AddValue(target.DestBlend);
+		hasher.AddValue(target.BlendOp);
+		hasher.AddValue(target.SrcBlendAlpha);
+		hasher.AddValue(target.DestBlendAlpha);
+		hasher.AddValue(target.BlendOpAlpha);
+		hasher.AddValue(target.LogicOp);
+		hasher.AddValue(target.RenderTargetWriteMask);
+	}
+
+	hasher.AddValue(desc.SampleMask);
+	hasher.AddValue(desc.RasterizerState);	// Uniquement des champs de 4 octets, sans remplissage.
+
+	const D3D12_DEPTH_STENCIL_DESC& depthStencil = desc.DepthStencilState;
+	hasher.AddValue(depthStencil.DepthEnable);
+	hasher.AddValue(depthStencil.DepthWriteMask);
+	hasher.AddValue(depthStencil.DepthFunc);
+	hasher.AddValue(depthStencil.StencilEnable);
+	hasher.AddValue(depthStencil.StencilReadMask);
+	hasher.AddValue(depthStencil.StencilWriteMask);
+	hasher.AddValue(depthStencil.FrontFace);
+	hasher.AddValue(depthStencil.BackFace);
+
+	hasher.AddValue(desc.InputLayout.NumElements);
+	for (UINT i = 0; i < desc.InputLayout.NumElements; i++)
+	{
+		const D3D12_INPUT_ELEMENT_DESC& element = desc.InputLayout.pInputElementDescs[i];
+		hasher.AddString(element.SemanticName);
+		hasher.AddValue(element.SemanticIndex);
+		hasher.AddValue(element.Format);
+		hasher.AddValue(element.InputSlot);
+		hasher.AddValue(element.AlignedByteOffset);
+		hasher.AddValue(element.InputSlotClass);
+		hasher.AddValue(element.InstanceDataStepRate);
+	}
+
+	hasher.AddValue(desc.IBStripCutValue);
+	hasher.AddValue(desc.PrimitiveTopologyType);
+	hasher.AddValue(desc.NumRenderTargets);
+	hasher.AddValue(desc.RTVFormats);
+	hasher.AddValue(desc.DSVFormat);
+	hasher.AddValue(desc.SampleDesc);
+	hasher.AddValue(desc.NodeMask);
+	hasher.AddValue(desc.Flags);
+	return hasher.Get();
+}
+
+std::shared_ptr<DX::PipelineStateCache::DescCopy> DX::PipelineStateCache::CopyDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+{
+	if (desc.StreamOutput.NumEntries != 0)
+	{
+		DX::ThrowIfFailed(E_INVALIDARG);
+	}
+
+	auto copy = std::make_shared<DescCopy>();
+	copy->desc = desc;
+	copy->desc.CachedPSO = {};
+	copy->rootSignature = desc.pRootSignature;
+
+	D3D12_SHADER_BYTECODE* shaders[] = { &copy->desc.VS, &copy->desc.PS, &copy->desc.DS, &copy->desc.HS, &copy->desc.GS };
+	for (int i = 0; i < 5; i++)
+	{
+		const D3D12_SHADER_BYTECODE& source = GetShader(desc, i);
+		const uint8_t* bytes = static_cast<const uint8_t*>(source.pShaderBytecode);
+		copy->shaders[i].assign(bytes, bytes + source.BytecodeLength);
+		*shaders[i] = { copy->shaders[i].data(), copy->shaders[i].size() };
+	}
+
+	// Les noms de sémantique sont copiés en entier avant d'y pointer, le vecteur ne bouge plus ensuite.
+	const UINT elementCount = desc.InputLayout.NumElements;
+	copy->inputElements.assign(desc.InputLayout.pInputElementDescs, desc.InputLayout.pInputElementDescs + elementCount);
+	copy->semanticNames.reserve(elementCount);
+	for (UINT i = 0; i < elementCount; i++)
+	{
+		copy->semanticNames.emplace_back(desc.InputLayout.pInputElementDescs[i].SemanticName);
+	}
+	for (UINT i = 0; i < elementCount; i++)
+	{
+		copy->inputElements[i].SemanticName = copy->semanticNames[i].c_str();
+	}
+	copy->desc.InputLayout = { copy->inputElements.data(), elementCount };
+	return copy;
+}
+
+UINT64 DX::PipelineStateCache::Prewarm(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+{
+	UINT64 key = ComputeKey(desc);
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_entries.find(key) != m_entries.end())
+		{
+			return key;
+		}
+	}
+
+	// La copie se fait avant de réserver l'entrée : si elle lève une exception, aucune entrée ne reste à jamais
+	// en attente, ce qui bloquerait GetOrCreate et laisserait TryGet retourner nullptr pour toujours.
+	std::shared_ptr<DescCopy> copy = CopyDesc(desc);
+
+	std::shared_ptr<Entry> entry;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		std::shared_ptr<Entry>& slot = m_entries[key];
+		if (slot != nullptr)
+		{
+			return key;
+		}
+		slot = std::make_shared<Entry>();
+		slot->result = S_OK;
+		slot->ready = false;
+		entry = slot;
+	}
+
+	m_pool.Submit([this, key, copy, entry]()
+	{
+		ComPtr<ID3D12PipelineState> pipelineState;
+		HRESULT result = Compile(key, copy->desc, pipelineState);
+		Complete(entry, result, pipelineState);
+	});
+	return key;
+}
+
+ID3D12PipelineState* DX::PipelineStateCache::TryGet(UINT64 key)
+{
+	HRESULT result;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto entry = m_entries.find(key);
+		if (entry == m_entries.end() || !entry->second->ready)
+		{
+			return nullptr;
+		}
+		if (SUCCEEDED(entry->second->result))
+		{
+			return entry->second->pipelineState.Get();
+		}
+		result = entry->second->result;
+	}
+	DX::ThrowIfFailed(result);
+	return nullptr;
+}
+
+ComPtr<ID3D12PipelineState> DX::PipelineStateCache::GetOrCreate(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+{
+	UINT64 key = ComputeKey(desc);
+
+	std::shared_ptr<Entry> entry;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		std::shared_ptr<Entry>& slot = m_entries[key];
+		if (slot != nullptr)
+		{
+			// Déjà créé, ou en cours de création sur un autre thread : on attend son résultat.
+			entry = slot;
+			m_readyCondition.wait(lock, [&entry]() { return entry->ready; });
+			DX::ThrowIfFailed(entry->result);
+			return entry->pipelineState;
+		}
+		slot = std::make_shared<Entry>();
+		slot->result = S_OK;
+		slot->ready = false;
+		entry = slot;
+	}
+
+	ComPtr<ID3D12PipelineState> pipelineState;
+	HRESULT result = Compile(key, desc, pipelineState);
+	Complete(entry, result, pipelineState);
+	DX::ThrowIfFailed(result);
+	return pipelineState;
+}
+
+HRESULT DX::PipelineStateCache::Compile(UINT64 key, D3D12_GRAPHICS_PIPELINE_STATE_DESC desc, ComPtr<ID3D12PipelineState>& pipelineState)
+{
+	PipelineCacheStore::Blob blob = m_store.Find(key);
+	if (blob != nullptr)
+	{
+		desc.CachedPSO = { blob->data(), blob->size() };
+		if (SUCCEEDED(m_device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pipelineState))))
+		{
+			m_loadedFromCache++;
+			return S_OK;
+		}
+
+		// Le pilote refuse le blob (pilote mis à jour, ou description différente malgré la même clé) :
+		// il est retiré, et l'état est compilé normalement.
+		m_store.Remove(key);
+		m_rejectedBlobs++;
+	}
+
+	desc.CachedPSO = {};
+	HRESULT result = m_device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pipelineState));
+	if (FAILED(result))
+	{
+		return result;
+	}
+	m_compiled++;
+
+	ComPtr<ID3DBlob> cachedBlob;
+	if (SUCCEEDED(pipelineState->GetCachedBlob(&cachedBlob)))
+	{
+		m_store.Put(key, cachedBlob->GetBufferPointer(), cachedBlob->GetBufferSize());
+	}
+	return S_OK;
+}
+
+void DX::PipelineStateCache::Complete(const std::shared_ptr<Entry>& entry, HRESULT result, ComPtr<ID3D12PipelineState> pipelineState)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		entry->pipelineState = pipelineState;
+		entry->result = result;
+		entry->ready = true;
+	}
+	m_readyCondition.notify_all();
+}
+
+bool DX::PipelineStateCache::Save()
+{
+	if (!m_store.IsDirty())
+	{
+		return true;
+	}
+	return m_store.SaveFile(m_path);
+}
+
+DX::PipelineStateCacheStats DX::PipelineStateCache::GetStats() const
+{
+	PipelineStateCacheStats stats;
+	stats.compiled = m_compiled;
+	stats.loadedFromCache = m_loadedFromCache;
+	stats.rejectedBlobs = m_rejectedBlobs;
+	return stats;
+}
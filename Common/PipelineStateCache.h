@@ -0,0 +1,89 @@
+﻿#pragma once
+
+#include "PipelineCacheStore.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <condition_variable>
+
+namespace DX
+{
+	struct PipelineStateCacheStats
+	{
+		UINT compiled;			// États compilés à partir des nuanceurs.
+		UINT loadedFromCache;	// États recréés à partir d'un blob enregistré.
+		UINT rejectedBlobs;		// Blobs refusés par le pilote, puis recompilés.
+	};
+
+	// Cache des états de pipeline graphique, indexé par un hachage de toute la description (nuanceurs,
+	// disposition d'entrée, états fixes, formats, et signature racine). Les blobs compilés sont enregistrés
+	// dans un fichier et redonnés au pilote à l'exécution suivante, ce qui évite la plus grande partie du
+	// coût de compilation.
+	//
+	// Prewarm lance la création en arrière-plan et retourne tout de suite ; TryGet ne bloque jamais et
+	// retourne nullptr tant que l'état n'est pas prêt, le rendu peut donc sauter ce qui en dépend plutôt
+	// que d'attendre. GetOrCreate bloque, pour les cas où l'état est nécessaire immédiatement.
+	class PipelineStateCache
+	{
+	public:
+		PipelineStateCache(ID3D12Device* device, IDXGIFactory4* factory, const std::wstring& path, size_t threadCount);
+		~PipelineStateCache();
+
+		// Associe une signature racine à son blob sérialisé, pour que la clé des états qui l'utilisent reste
+		// la même d'une exécution à l'autre. Sans cela, la clé dépend de l'adresse de la signature, et les
+		// blobs enregistrés ne servent plus à l'exécution suivante.
+		void RegisterRootSignature(ID3D12RootSignature* rootSignature, const void* serialized, size_t size);
+
+		UINT64 ComputeKey(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+
+		// Copie desc et crée l'état en arrière-plan. Les pointeurs de desc n'ont pas besoin de rester valides
+		// après l'appel. La sortie de flux n'est pas prise en charge.
+		UINT64 Prewarm(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+
+		// Retourne l'état de key s'il est prêt, nullptr sinon. Lève l'erreur de création s'il a échoué.
+		ID3D12PipelineState* TryGet(UINT64 key);
+
+		Microsoft::WRL::ComPtr<ID3D12PipelineState> GetOrCreate(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+
+		// Enregistre les blobs s'il y en a de nouveaux. Retourne false si l'écriture a échoué.
+		bool Save();
+
+		PipelineStateCacheStats GetStats() const;
+
+	private:
+		struct Entry
+		{
+			Microsoft::WRL::ComPtr<ID3D12PipelineState>	pipelineState;
+			HRESULT										result;
+			bool										ready;
+		};
+
+		// Copie d'une description et de tout ce vers quoi elle pointe.
+		struct DescCopy
+		{
+			D3D12_GRAPHICS_PIPELINE_STATE_DESC			desc;
+			std::vector<uint8_t>						shaders[5];
+			std::vector<D3D12_INPUT_ELEMENT_DESC>		inputElements;
+			std::vector<std::string>					semanticNames;
+			Microsoft::WRL::ComPtr<ID3D12RootSignature>	rootSignature;
+		};
+
+		static uint64_t ComputeDeviceTag(ID3D12Device* device, IDXGIFactory4* factory);
+		static std::shared_ptr<DescCopy> CopyDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+		HRESULT Compile(UINT64 key, D3D12_GRAPHICS_PIPELINE_STATE_DESC desc, Microsoft::WRL::ComPtr<ID3D12PipelineState>& pipelineState);
+		void Complete(const std::shared_ptr<Entry>& entry, HRESULT result, Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState);
+
+		Microsoft::WRL::ComPtr<ID3D12Device>						m_device;
+		std::wstring												m_path;
+		PipelineCacheStore											m_store;
+		std::mutex													m_mutex;
+		std::condition_variable										m_readyCondition;
+		std::unordered_map<UINT64, std::shared_ptr<Entry>>			m_entries;
+		std::unordered_map<ID3D12RootSignature*, UINT64>			m_rootSignatureKeys;
+		std::atomic<UINT>											m_compiled;
+		std::atomic<UINT>											m_loadedFromCache;
+		std::atomic<UINT>											m_rejectedBlobs;
+
+		// Déclarée en dernier, pour que ses threads s'arrêtent avant la destruction du reste.
+		ThreadPool													m_pool;
+	};
+}
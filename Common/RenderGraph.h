@@ -0,0 +1,443 @@
+﻿#pragma once
+
+#include "ResourceStateTracker.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+namespace DX
+{
+	// Graphe de rendu d'une frame. Les passes sont déclarées dans l'ordre d'exécution, avec les ressources
+	// virtuelles qu'elles lisent et écrivent, puis Compile :
+	// - élimine les passes dont rien ne lit le résultat (une passe est gardée si elle écrit une ressource
+	//   importée, si elle a des effets de bord, ou si une passe gardée lit ce qu'elle écrit) ;
+	// - calcule la durée de vie des ressources transitoires et leur place dans une mémoire commune, deux
+	//   ressources qui ne vivent pas en même temps pouvant partager les mêmes octets ;
+	// - note, pour chaque passe, l'état voulu de chaque ressource, et où démarrer une transition scindée quand
+	//   une passe au moins sépare une utilisation de la suivante.
+	// Les barrières elles-mêmes sont confiées à Execute, à un ResourceStateTracker : c'est lui qui connaît l'état
+	// courant des ressources et n'émet que les transitions nécessaires.
+	// Une écriture qui conserve le contenu précédent (dessiner par-dessus un effacement) doit aussi être déclarée
+	// comme une lecture. Ne dépend pas de D3D12 : les ressources et les états sont opaques.
+	class RenderGraph
+	{
+	public:
+		typedef std::function<void()> PassCallback;
+		typedef std::function<void(uint32_t pass)> BarrierCallback;
+
+		static const uint32_t c_invalid = ~0u;
+
+		RenderGraph() :
+			m_transientMemorySize(0)
+		{
+		}
+
+		// Oublie la frame précédente, en gardant la mémoire des tableaux.
+		void Reset()
+		{
+			m_resources.clear();
+			m_passes.clear();
+			m_order.clear();
+			m_transientMemorySize = 0;
+		}
+
+		// Ressource qui existe hors du graphe (mémoire tampon d'arrière-plan, stencil de profondeur). Son état au
+		// début de la frame vient du suivi passé à Execute. Le graphe la laisse dans finalState, ou dans l'état
+		// de sa dernière utilisation si finalState vaut c_invalid.
+		uint32_t ImportResource(const char* name, void* resource, uint32_t finalState = c_invalid)
+		{
+			Resource imported = {};
+			imported.name = name;
+			imported.resource = resource;
+			imported.imported = true;
+			imported.finalState = finalState;
+			m_resources.push_back(imported);
+			return static_cast<uint32_t>(m_resources.size() - 1);
+		}
+
+		// Ressource qui ne vit que le temps de quelques passes. Après Compile, l'appelant la crée à
+		// GetTransientOffset dans une mémoire de GetTransientMemorySize octets, dans l'état GetInitialState,
+		// puis la donne au graphe avec SetTransientResource.
+		uint32_t CreateTransient(const char* name, uint64_t size, uint64_t alignment)
+		{
+			Resource transient = {};
+			transient.name = name;
+			transient.size = size;
+			transient.alignment = alignment;
+			m_resources.push_back(transient);
+			return static_cast<uint32_t>(m_resources.size() - 1);
+		}
+
+		uint32_t AddPass(const char* name, PassCallback execute)
+		{
+			Pass pass;
+			pass.name = name;
+			pass.execute = std::move(execute);
+			m_passes.push_back(std::move(pass));
+			return static_cast<uint32_t>(m_passes.size() - 1);
+		}
+
+		void Read(uint32_t pass, uint32_t resource, uint32_t state)	{ m_passes[pass].uses.push_back(Use{ resource, state, false }); }
+		void Write(uint32_t pass, uint32_t resource, uint32_t state)	{ m_passes[pass].uses.push_back(Use{ resource, state, true }); }
+		void SetSideEffects(uint32_t pass)								{ m_passes[pass].sideEffects = true; }
+
+		void Compile()
+		{
+			CullPasses();
+			ComputeLifetimes();
+			PlaceTransients();
+			ComputeStates();
+		}
+
+		void SetTransientResource(uint32_t resource, void* pointer) { m_resources[resource].resource = pointer; }
+
+		// Exécute les passes gardées dans l'ordre. Avant chaque passe, les états qu'elle veut sont demandés au
+		// suivi, et flush est appelé s'il en résulte des barrières, pour que l'appelant les émette. Les
+		// transitions vers l'état final des ressources importées restent en attente dans le suivi, à émettre
+		// avec le reste de la liste (CommitResourceStates).
+		void Execute(ResourceStateTracker& tracker, const BarrierCallback& flush)
+		{
+			for (const Resource& resource : m_resources)
+			{
+				if (!resource.imported && resource.firstUse != c_invalid)
+				{
+					tracker.Track(resource.resource, resource.initialState);
+				}
+			}
+
+			for (uint32_t pass : m_order)
+			{
+				const Pass& current = m_passes[pass];
+				for (const auto& alias : current.aliasing)
+				{
+					tracker.Alias(m_resources[alias.first].resource, m_resources[alias.second].resource);
+				}
+				for (const StateUse& use : current.states)
+				{
+					tracker.Transition(m_resources[use.resource].resource, use.state);
+				}
+				for (const StateUse& use : current.splitBegins)
+				{
+					tracker.BeginTransition(m_resources[use.resource].resource, use.state);
+				}
+				if (tracker.HasPendingBarriers())
+				{
+					flush(pass);
+				}
+				current.execute();
+			}
+
+			for (const Resource& resource : m_resources)
+			{
+				if (resource.imported && resource.finalState != c_invalid && resource.firstUse != c_invalid)
+				{
+					tracker.Transition(resource.resource, resource.finalState);
+				}
+			}
+		}
+
+		bool IsPassCulled(uint32_t pass) const						{ return !m_passes[pass].alive; }
+		const std::vector<uint32_t>& GetPassOrder() const			{ return m_order; }
+		const char* GetPassName(uint32_t pass) const				{ return m_passes[pass].name; }
+		uint64_t GetTransientMemorySize() const						{ return m_transientMemorySize; }
+		uint64_t GetTransientOffset(uint32_t resource) const		{ return m_resources[resource].offset; }
+		uint32_t GetInitialState(uint32_t resource) const			{ return m_resources[resource].initialState; }
+
+		// Positions dans GetPassOrder de la première et de la dernière passe qui utilisent la ressource,
+		// ou c_invalid si aucune passe gardée ne l'utilise.
+		uint32_t GetFirstUse(uint32_t resource) const				{ return m_resources[resource].firstUse; }
+		uint32_t GetLastUse(uint32_t resource) const				{ return m_resources[resource].lastUse; }
+
+	private:
+		struct Use
+		{
+			uint32_t	resource;
+			uint32_t	state;
+			bool		write;
+		};
+
+		// État voulu pour une ressource, calculé par Compile. La ressource est un index, les pointeurs ne sont
+		// connus qu'à Execute.
+		struct StateUse
+		{
+			uint32_t	resource;
+			uint32_t	state;
+		};
+
+		struct Pass
+		{
+			Pass() : name(nullptr), sideEffects(false), alive(false) {}
+
+			const char*									name;
+			PassCallback								execute;
+			std::vector<Use>							uses;
+			bool										sideEffects;
+			bool										alive;
+			std::vector<StateUse>						states;			// Un par ressource utilisée.
+			std::vector<StateUse>						splitBegins;	// Transitions à démarrer avant cette passe.
+			std::vector<std::pair<uint32_t, uint32_t>>	aliasing;
+		};
+
+		struct Resource
+		{
+			const char*	name;
+			void*		resource;
+			bool		imported;
+			uint32_t	initialState;
+			uint32_t	finalState;
+			uint64_t	size;
+			uint64_t	alignment;
+			uint64_t	offset;
+			uint32_t	firstUse;
+			uint32_t	lastUse;
+			uint32_t	lastPass;	// Position de la dernière passe qui l'a utilisée pendant la compilation.
+		};
+
+		void CullPasses()
+		{
+			std::vector<uint32_t> worklist;
+			for (uint32_t pass = 0; pass < m_passes.size(); pass++)
+			{
+				Pass& current = m_passes[pass];
+				current.alive = current.sideEffects;
+				for (const Use& use : current.uses)
+				{
+					current.alive |= use.write && m_resources[use.resource].imported;
+				}
+				if (current.alive)
+				{
+					worklist.push_back(pass);
+				}
+			}
+
+			// Remontez des passes gardées vers les passes qui écrivent ce qu'elles lisent. Une écriture qui ne lit
+			// pas la ressource remplace tout son contenu : les écritures plus anciennes ne sont alors plus utiles.
+			while (!worklist.empty())
+			{
+				uint32_t pass = worklist.back();
+				worklist.pop_back();
+				for (const Use& use : m_passes[pass].uses)
+				{
+					if (use.write)
+					{
+						continue;
+					}
+					for (uint32_t writer = pass; writer-- > 0; )
+					{
+						if (!Writes(m_passes[writer], use.resource))
+						{
+							continue;
+						}
+						if (!m_passes[writer].alive)
+						{
+							m_passes[writer].alive = true;
+							worklist.push_back(writer);
+						}
+						if (!Reads(m_passes[writer], use.resource))
+						{
+							break;
+						}
+					}
+				}
+			}
+
+			for (uint32_t pass = 0; pass < m_passes.size(); pass++)
+			{
+				if (m_passes[pass].alive)
+				{
+					m_order.push_back(pass);
+				}
+			}
+		}
+
+		void ComputeLifetimes()
+		{
+			for (Resource& resource : m_resources)
+			{
+				resource.firstUse = c_invalid;
+				resource.lastUse = c_invalid;
+			}
+			for (uint32_t position = 0; position < m_order.size(); position++)
+			{
+				for (const Use& use : m_passes[m_order[position]].uses)
+				{
+					Resource& resource = m_resources[use.resource];
+					if (resource.firstUse == c_invalid)
+					{
+						resource.firstUse = position;
+						resource.initialState = UseState(m_passes[m_order[position]], use.resource);
+					}
+					resource.lastUse = position;
+				}
+			}
+		}
+
+		// Place les ressources transitoires, les plus grandes d'abord, au plus petit offset qui ne chevauche
+		// aucune ressource déjà placée dont la durée de vie recoupe la sienne.
+		void PlaceTransients()
+		{
+			std::vector<uint32_t> transients;
+			for (uint32_t resource = 0; resource < m_resources.size(); resource++)
+			{
+				if (!m_resources[resource].imported && m_resources[resource].firstUse != c_invalid)
+				{
+					transients.push_back(resource);
+				}
+			}
+			std::sort(transients.begin(), transients.end(), [this](uint32_t a, uint32_t b)
+			{
+				return m_resources[a].size > m_resources[b].size || (m_resources[a].size == m_resources[b].size && a < b);
+			});
+
+			std::vector<std::pair<uint64_t, uint64_t>> conflicts;
+			for (size_t placed = 0; placed < transients.size(); placed++)
+			{
+				Resource& resource = m_resources[transients[placed]];
+				conflicts.clear();
+				for (size_t other = 0; other < placed; other++)
+				{
+					const Resource& existing = m_resources[transients[other]];
+					if (existing.firstUse <= resource.lastUse && resource.firstUse <= existing.lastUse)
+					{
+						conflicts.emplace_back(existing.offset, existing.offset + existing.size);
+					}
+				}
+				std::sort(conflicts.begin(), conflicts.end());
+
+				uint64_t alignment = resource.alignment > 0 ? resource.alignment : 1;
+				uint64_t offset = 0;
+				for (const auto& conflict : conflicts)
+				{
+					if (offset + resource.size <= conflict.first)
+					{
+						break;
+					}
+					if (conflict.second > offset)
+					{
+						offset = (conflict.second + alignment - 1) / alignment * alignment;
+					}
+				}
+				resource.offset = offset;
+				if (offset + resource.size > m_transientMemorySize)
+				{
+					m_transientMemorySize = offset + resource.size;
+				}
+			}
+
+			// Une ressource qui reprend de la mémoire utilisée plus tôt dans la frame a besoin d'une barrière d'alias
+			// avant sa première passe ; la dernière ressource à avoir occupé ces octets suffit comme « avant ».
+			for (uint32_t resource : transients)
+			{
+				const Resource& after = m_resources[resource];
+				uint32_t before = c_invalid;
+				for (uint32_t other : transients)
+				{
+					const Resource& candidate = m_resources[other];
+					bool overlaps = candidate.offset < after.offset + after.size && after.offset < candidate.offset + candidate.size;
+					if (other != resource && overlaps && candidate.lastUse < after.firstUse &&
+						(before == c_invalid || candidate.lastUse > m_resources[before].lastUse))
+					{
+						before = other;
+					}
+				}
+				if (before != c_invalid)
+				{
+					m_passes[m_order[after.firstUse]].aliasing.emplace_back(before, resource);
+				}
+			}
+		}
+
+		void ComputeStates()
+		{
+			for (Resource& resource : m_resources)
+			{
+				resource.lastPass = c_invalid;
+			}
+
+			for (uint32_t position = 0; position < m_order.size(); position++)
+			{
+				Pass& pass = m_passes[m_order[position]];
+				for (size_t i = 0; i < pass.uses.size(); i++)
+				{
+					uint32_t index = pass.uses[i].resource;
+					if (HasEarlierUse(pass, i))
+					{
+						continue;
+					}
+
+					// Le suivi dira à l'exécution s'il faut vraiment une transition ; s'il y a du travail depuis la
+					// dernière utilisation, elle peut commencer juste après.
+					Resource& resource = m_resources[index];
+					uint32_t wanted = UseState(pass, index);
+					pass.states.push_back(StateUse{ index, wanted });
+					if (resource.lastPass != c_invalid && resource.lastPass + 1 < position)
+					{
+						m_passes[m_order[resource.lastPass + 1]].splitBegins.push_back(StateUse{ index, wanted });
+					}
+					resource.lastPass = position;
+				}
+			}
+		}
+
+		// État voulu par une passe pour une ressource : celui de l'écriture s'il y en a une, sinon la combinaison des lectures.
+		uint32_t UseState(const Pass& pass, uint32_t resource) const
+		{
+			uint32_t readState = 0;
+			for (const Use& use : pass.uses)
+			{
+				if (use.resource != resource)
+				{
+					continue;
+				}
+				if (use.write)
+				{
+					return use.state;
+				}
+				readState |= use.state;
+			}
+			return readState;
+		}
+
+		static bool Writes(const Pass& pass, uint32_t resource)
+		{
+			for (const Use& use : pass.uses)
+			{
+				if (use.write && use.resource == resource)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		static bool Reads(const Pass& pass, uint32_t resource)
+		{
+			for (const Use& use : pass.uses)
+			{
+				if (!use.write && use.resource == resource)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		static bool HasEarlierUse(const Pass& pass, size_t use)
+		{
+			for (size_t i = 0; i < use; i++)
+			{
+				if (pass.uses[i].resource == pass.uses[use].resource)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		std::vector<Resource>		m_resources;
+		std::vector<Pass>			m_passes;
+		std::vector<uint32_t>		m_order;
+		uint64_t					m_transientMemorySize;
+	};
+}
@@ -0,0 +1,61 @@
+﻿#pragma once
+
+#include "ResourceStateTracker.h"
+
+namespace DX
+{
+	// États D3D12 en lecture seule, qu'une ressource peut occuper en même temps.
+	static const uint32_t c_readOnlyResourceStates =
+		D3D12_RESOURCE_STATE_GENERIC_READ |
+		D3D12_RESOURCE_STATE_DEPTH_READ |
+		D3D12_RESOURCE_STATE_RESOLVE_SOURCE;
+
+	// Ajoute des transitions à un lot de barrières D3D12.
+	inline void AppendTransitionBarriers(const std::vector<StateTransition>& transitions, std::vector<D3D12_RESOURCE_BARRIER>& barriers)
+	{
+		for (const StateTransition& transition : transitions)
+		{
+			D3D12_RESOURCE_BARRIER_FLAGS flags =
+				transition.split == TransitionSplit::Begin ? D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY :
+				transition.split == TransitionSplit::End ? D3D12_RESOURCE_BARRIER_FLAG_END_ONLY :
+				D3D12_RESOURCE_BARRIER_FLAG_NONE;
+
+			barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+				static_cast<ID3D12Resource*>(transition.resource),
+				static_cast<D3D12_RESOURCE_STATES>(transition.before),
+				static_cast<D3D12_RESOURCE_STATES>(transition.after),
+				D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+				flags));
+		}
+	}
+
+	// Émet les barrières en attente du suivi, alias d'abord, en un seul appel à ResourceBarrier.
+	inline void FlushResourceBarriers(ResourceStateTracker& tracker, ID3D12GraphicsCommandList* commandList)
+	{
+		if (!tracker.HasPendingBarriers())
+		{
+			return;
+		}
+
+		const std::vector<std::pair<void*, void*>>& aliasing = tracker.GetPendingAliasing();
+		const std::vector<StateTransition>& transitions = tracker.GetPendingTransitions();
+		std::vector<D3D12_RESOURCE_BARRIER> barriers;
+		barriers.reserve(aliasing.size() + transitions.size());
+		for (const auto& alias : aliasing)
+		{
+			barriers.push_back(CD3DX12_RESOURCE_BARRIER::Aliasing(static_cast<ID3D12Resource*>(alias.first), static_cast<ID3D12Resource*>(alias.second)));
+		}
+		AppendTransitionBarriers(transitions, barriers);
+		commandList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+		tracker.ClearPendingTransitions();
+	}
+
+	// Termine les transitions scindées encore ouvertes, émet le dernier lot et publie l'état final des ressources.
+	// À appeler une fois l'enregistrement de la liste terminé, dans l'ordre de soumission des listes.
+	inline void CommitResourceStates(ResourceStateTracker& tracker, ID3D12GraphicsCommandList* commandList)
+	{
+		tracker.EndSplitTransitions();
+		FlushResourceBarriers(tracker, commandList);
+		tracker.Commit();
+	}
+}
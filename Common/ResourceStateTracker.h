@@ -0,0 +1,247 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace DX
+{
+	// Partie d'une transition scindée : Begin démarre la transition dès que possible, End l'attend juste avant
+	// la première utilisation, ce qui laisse au GPU le temps de la faire pendant le travail intermédiaire.
+	enum class TransitionSplit
+	{
+		None,
+		Begin,
+		End
+	};
+
+	// Transition d'une ressource entre deux états, telle que produite par un ResourceStateTracker.
+	struct StateTransition
+	{
+		void*			resource;
+		uint32_t		before;
+		uint32_t		after;
+		TransitionSplit	split;
+	};
+
+	// État connu de chaque ressource entre deux listes de commandes. Les ressources qui n'y sont pas inscrites
+	// ne sont pas suivies. readOnlyStates regroupe les états en lecture seule, qui peuvent être combinés.
+	// Ne dépend pas de D3D12, les ressources et les états sont opaques.
+	class ResourceStateRegistry
+	{
+	public:
+		explicit ResourceStateRegistry(uint32_t readOnlyStates) :
+			m_readOnlyStates(readOnlyStates)
+		{
+		}
+
+		void Register(void* resource, uint32_t state)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_states[resource] = state;
+		}
+
+		void Unregister(void* resource)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_states.erase(resource);
+		}
+
+		bool GetState(void* resource, uint32_t& state) const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto found = m_states.find(resource);
+			if (found == m_states.end())
+			{
+				return false;
+			}
+			state = found->second;
+			return true;
+		}
+
+		void SetState(void* resource, uint32_t state)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto found = m_states.find(resource);
+			if (found != m_states.end())
+			{
+				found->second = state;
+			}
+		}
+
+		uint32_t GetReadOnlyStates() const { return m_readOnlyStates; }
+
+	private:
+		uint32_t							m_readOnlyStates;
+		mutable std::mutex					m_mutex;
+		std::unordered_map<void*, uint32_t>	m_states;
+	};
+
+	// Suit l'état des ressources pendant l'enregistrement d'une liste de commandes. Transition ne produit une
+	// transition que si l'état change vraiment, et les transitions s'accumulent jusqu'à ce que l'appelant les
+	// émette en un seul lot, juste avant un dessin ou un dispatch. Plusieurs transitions de la même ressource
+	// dans un même lot sont fusionnées en une seule. Les barrières d'alias d'un lot passent avant ses transitions.
+	//
+	// L'état d'une ressource à sa première utilisation dans la liste est pris dans le registre, et Commit y
+	// écrit les états finaux. Les listes qui partagent des ressources doivent donc être validées dans l'ordre
+	// de soumission. Les sous-ressources ne sont pas suivies séparément.
+	class ResourceStateTracker
+	{
+	public:
+		explicit ResourceStateTracker(ResourceStateRegistry& registry) :
+			m_registry(registry)
+		{
+		}
+
+		// Demande que la ressource soit dans l'état voulu pour la prochaine commande.
+		void Transition(void* resource, uint32_t state)
+		{
+			ResourceState* current = GetResourceState(resource);
+			if (current == nullptr)
+			{
+				return;
+			}
+
+			// Terminez d'abord une transition scindée en cours sur cette ressource.
+			if (current->splitInFlight)
+			{
+				m_pending.push_back(StateTransition{ resource, current->splitBefore, current->state, TransitionSplit::End });
+				current->splitInFlight = false;
+			}
+			if (IsSatisfiedBy(current->state, state))
+			{
+				return;
+			}
+
+			auto batched = m_batched.find(resource);
+			if (batched != m_batched.end())
+			{
+				// La ressource a déjà une transition dans ce lot : changez simplement sa destination, ou retirez-la
+				// si la ressource revient à son état de départ.
+				size_t index = batched->second;
+				m_pending[index].after = state;
+				if (m_pending[index].before == state)
+				{
+					m_pending.erase(m_pending.begin() + index);
+					m_batched.erase(batched);
+					for (auto& entry : m_batched)
+					{
+						entry.second -= entry.second > index ? 1 : 0;
+					}
+				}
+			}
+			else
+			{
+				m_batched[resource] = m_pending.size();
+				m_pending.push_back(StateTransition{ resource, current->state, state, TransitionSplit::None });
+			}
+			current->state = state;
+		}
+
+		// Démarre une transition scindée vers state. La ressource ne doit plus être utilisée avant le
+		// Transition vers le même état qui la termine. Ne fait rien si l'état actuel convient déjà.
+		void BeginTransition(void* resource, uint32_t state)
+		{
+			ResourceState* current = GetResourceState(resource);
+			if (current == nullptr || current->splitInFlight || IsSatisfiedBy(current->state, state) || m_batched.count(resource) != 0)
+			{
+				return;
+			}
+			m_pending.push_back(StateTransition{ resource, current->state, state, TransitionSplit::Begin });
+			current->splitBefore = current->state;
+			current->state = state;
+			current->splitInFlight = true;
+		}
+
+		// Termine les transitions scindées encore ouvertes ; à appeler avant le dernier lot de la liste.
+		void EndSplitTransitions()
+		{
+			for (auto& entry : m_states)
+			{
+				if (entry.second.splitInFlight)
+				{
+					m_pending.push_back(StateTransition{ entry.first, entry.second.splitBefore, entry.second.state, TransitionSplit::End });
+					entry.second.splitInFlight = false;
+				}
+			}
+		}
+
+		// Suit une ressource absente du registre, à partir de state, le temps de cette liste seulement. Sert aux
+		// ressources transitoires d'un graphe de rendu, créées pour la frame dans un état connu.
+		void Track(void* resource, uint32_t state)
+		{
+			m_states[resource] = ResourceState{ state, state, false };
+		}
+
+		// Ajoute au lot une barrière d'alias : after reprend la mémoire de before, qui peut être nul.
+		void Alias(void* before, void* after)
+		{
+			m_pendingAliasing.emplace_back(before, after);
+		}
+
+		const std::vector<StateTransition>& GetPendingTransitions() const				{ return m_pending; }
+		const std::vector<std::pair<void*, void*>>& GetPendingAliasing() const		{ return m_pendingAliasing; }
+		bool HasPendingBarriers() const	{ return !m_pending.empty() || !m_pendingAliasing.empty(); }
+
+		// À appeler une fois les barrières en attente émises dans la liste de commandes.
+		void ClearPendingTransitions()
+		{
+			m_pending.clear();
+			m_pendingAliasing.clear();
+			m_batched.clear();
+		}
+
+		// Publie l'état final des ressources dans le registre, pour les listes suivantes.
+		void Commit()
+		{
+			for (auto& entry : m_states)
+			{
+				m_registry.SetState(entry.first, entry.second.state);
+			}
+			m_states.clear();
+		}
+
+	private:
+		struct ResourceState
+		{
+			uint32_t	state;
+			uint32_t	splitBefore;
+			bool		splitInFlight;
+		};
+
+		ResourceState* GetResourceState(void* resource)
+		{
+			auto found = m_states.find(resource);
+			if (found != m_states.end())
+			{
+				return &found->second;
+			}
+			uint32_t state = 0;
+			if (!m_registry.GetState(resource, state))
+			{
+				return nullptr;
+			}
+			return &(m_states[resource] = ResourceState{ state, state, false });
+		}
+
+		// Une ressource dans une combinaison d'états en lecture peut déjà servir pour n'importe lequel d'entre eux.
+		bool IsSatisfiedBy(uint32_t current, uint32_t wanted) const
+		{
+			if (current == wanted)
+			{
+				return true;
+			}
+			uint32_t readOnly = m_registry.GetReadOnlyStates();
+			return wanted != 0 && (current & ~readOnly) == 0 && (current & wanted) == wanted;
+		}
+
+		ResourceStateRegistry&						m_registry;
+		std::unordered_map<void*, ResourceState>	m_states;
+		std::vector<StateTransition>				m_pending;
+		std::vector<std::pair<void*, void*>>		m_pendingAliasing;
+		std::unordered_map<void*, size_t>			m_batched;	// Index dans m_pending des transitions simples de ce lot.
+	};
+}
@@ -0,0 +1,91 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+namespace DX
+{
+	// Allocateur circulaire pour une mémoire tampon que le GPU lit de façon asynchrone (mémoire de
+	// chargement, constantes par frame, etc.). Les allocations sont groupées en lots : Submit étiquette
+	// tout ce qui a été alloué depuis le lot précédent avec une valeur d'isolation, et Retire libère les
+	// lots dont l'isolation a été atteinte. Ne dépend pas de D3D12, l'appelant fournit les valeurs.
+	//
+	// Les positions de tête et de queue ne font qu'augmenter ; l'offset dans la mémoire tampon est la
+	// position modulo la capacité. Une allocation qui ne tient pas avant la fin saute au début.
+	class RingAllocator
+	{
+	public:
+		explicit RingAllocator(uint64_t capacity = 0) :
+			m_capacity(capacity),
+			m_head(0),
+			m_tail(0)
+		{
+		}
+
+		// Réserve size octets alignés sur alignment (une puissance de deux, qui doit diviser la capacité).
+		// Retourne false s'il n'y a pas assez d'espace libre pour le moment.
+		bool Allocate(uint64_t size, uint64_t alignment, uint64_t& offset)
+		{
+			if (size > m_capacity)
+			{
+				return false;
+			}
+
+			// Quand l'anneau est vide, repartez du début pour que toute la capacité soit disponible.
+			if (m_batches.empty() && m_head == m_tail)
+			{
+				m_head = m_tail = (m_head + m_capacity - 1) / m_capacity * m_capacity;
+			}
+
+			uint64_t position = (m_head + alignment - 1) & ~(alignment - 1);
+			uint64_t start = position % m_capacity;
+			if (start + size > m_capacity)
+			{
+				// Pas assez de place avant la fin, sautez au début de la mémoire tampon.
+				position += m_capacity - start;
+				start = 0;
+			}
+			if (position + size - m_tail > m_capacity)
+			{
+				return false;
+			}
+
+			m_head = position + size;
+			offset = start;
+			return true;
+		}
+
+		// Tout ce qui a été alloué depuis le dernier appel sera libéré quand l'isolation atteindra fenceValue.
+		void Submit(uint64_t fenceValue)
+		{
+			if (!m_batches.empty() && m_batches.back().second == m_head)
+			{
+				return;
+			}
+			m_batches.emplace_back(fenceValue, m_head);
+		}
+
+		// Libère les lots que le GPU a fini de lire.
+		void Retire(uint64_t completedFenceValue)
+		{
+			while (!m_batches.empty() && m_batches.front().first <= completedFenceValue)
+			{
+				m_tail = m_batches.front().second;
+				m_batches.pop_front();
+			}
+		}
+
+		// Valeur d'isolation du plus ancien lot encore utilisé par le GPU, ou 0 s'il n'y en a aucun.
+		uint64_t GetOldestFenceValue() const { return m_batches.empty() ? 0 : m_batches.front().first; }
+
+		uint64_t GetCapacity() const	{ return m_capacity; }
+		uint64_t GetUsed() const		{ return m_head - m_tail; }
+
+	private:
+		uint64_t									m_capacity;
+		uint64_t									m_head;
+		uint64_t									m_tail;
+		std::deque<std::pair<uint64_t, uint64_t>>	m_batches;	// Valeur d'isolation, position de tête à la soumission.
+	};
+}
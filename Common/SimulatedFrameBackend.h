@@ -0,0 +1,137 @@
+﻿#pragma once
+
+#include "FrameScheduler.h"
+#include <deque>
+
+namespace DX
+{
+	// Backend de FrameScheduler sans GPU, sur une horloge virtuelle. Chaque frame signalée occupe le GPU pendant
+	// gpuFrameTime, après les précédentes ; elle est ensuite affichée à la synchronisation verticale suivante (ou
+	// immédiatement si vsyncInterval vaut 0), une frame par synchronisation. La chaîne de permutation accepte une
+	// nouvelle frame tant que moins de frameLatency frames attendent leur affichage. Les attentes font avancer
+	// l'horloge, et le travail UC est simulé par AdvanceCpu.
+	class SimulatedFrameBackend : public FrameSchedulerBackend
+	{
+	public:
+		SimulatedFrameBackend(double gpuFrameTime, double vsyncInterval) :
+			m_gpuFrameTime(gpuFrameTime),
+			m_vsyncInterval(vsyncInterval),
+			m_now(0.0),
+			m_gpuFree(0.0),
+			m_gpuBusy(0.0),
+			m_lastDisplay(0.0),
+			m_frameLatency(1),
+			m_frameStart(0.0),
+			m_displayedCount(0),
+			m_totalLatency(0.0),
+			m_retiredValue(0)
+		{
+		}
+
+		void SetGpuFrameTime(double seconds)	{ m_gpuFrameTime = seconds; }
+		void AdvanceCpu(double seconds)			{ m_now += seconds; }
+
+		uint64_t GetCompletedFenceValue() override
+		{
+			uint64_t completed = 0;
+			for (const Frame& frame : m_frames)
+			{
+				if (frame.gpuEnd <= m_now)
+				{
+					completed = frame.value;
+				}
+			}
+			return completed > m_retiredValue ? completed : m_retiredValue;
+		}
+
+		void SignalFence(uint64_t value) override
+		{
+			Frame frame;
+			frame.value = value;
+			frame.cpuStart = m_frameStart;
+			double gpuStart = m_now > m_gpuFree ? m_now : m_gpuFree;
+			frame.gpuEnd = gpuStart + m_gpuFrameTime;
+			m_gpuBusy += m_gpuFrameTime;
+			m_gpuFree = frame.gpuEnd;
+
+			// Une frame par synchronisation verticale, à la première qui suit la fin du travail GPU.
+			frame.display = frame.gpuEnd;
+			if (m_vsyncInterval > 0.0)
+			{
+				double vsync = static_cast<double>(static_cast<uint64_t>(frame.gpuEnd / m_vsyncInterval) + 1) * m_vsyncInterval;
+				double next = m_lastDisplay + m_vsyncInterval;
+				frame.display = vsync > next ? vsync : next;
+			}
+			m_lastDisplay = frame.display;
+			m_frames.push_back(frame);
+		}
+
+		void WaitForFence(uint64_t value) override
+		{
+			for (const Frame& frame : m_frames)
+			{
+				if (frame.value >= value)
+				{
+					m_now = frame.gpuEnd > m_now ? frame.gpuEnd : m_now;
+					break;
+				}
+			}
+			Retire();
+		}
+
+		void WaitForFrameLatency() override
+		{
+			Retire();
+			while (m_frames.size() >= m_frameLatency)
+			{
+				m_now = m_frames.front().display > m_now ? m_frames.front().display : m_now;
+				Retire();
+			}
+			m_frameStart = m_now;
+		}
+
+		void SetFrameLatency(uint32_t frames) override	{ m_frameLatency = frames; }
+		double GetTime() override						{ return m_now; }
+
+		// Part du temps écoulé pendant laquelle le GPU travaillait.
+		double GetGpuUtilization() const				{ return m_now > 0.0 ? m_gpuBusy / m_now : 0.0; }
+
+		// Temps moyen entre le début d'une frame sur l'UC et son affichage.
+		double GetAverageLatency() const				{ return m_displayedCount > 0 ? m_totalLatency / m_displayedCount : 0.0; }
+		uint64_t GetDisplayedCount() const				{ return m_displayedCount; }
+
+	private:
+		struct Frame
+		{
+			uint64_t	value;
+			double		cpuStart;
+			double		gpuEnd;
+			double		display;
+		};
+
+		// Oublie les frames déjà affichées.
+		void Retire()
+		{
+			while (!m_frames.empty() && m_frames.front().display <= m_now)
+			{
+				m_retiredValue = m_frames.front().value;
+				m_totalLatency += m_frames.front().display - m_frames.front().cpuStart;
+				m_displayedCount++;
+				m_frames.pop_front();
+			}
+		}
+
+		double				m_gpuFrameTime;
+		double				m_vsyncInterval;
+		double				m_now;
+		double				m_gpuFree;
+		double				m_gpuBusy;
+		double				m_lastDisplay;
+		uint32_t			m_frameLatency;
+		double				m_frameStart;
+		uint64_t			m_displayedCount;
+		double				m_totalLatency;
+		uint64_t			m_retiredValue;
+		std::deque<Frame>	m_frames;		// Frames soumises et pas encore affichées.
+	};
+}
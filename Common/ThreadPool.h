@@ -0,0 +1,105 @@
+﻿#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DX
+{
+	// Réserve de threads de travail qui exécutent des tâches dans l'ordre où elles sont soumises.
+	// Ne dépend que de la bibliothèque standard. Le destructeur termine les tâches déjà soumises
+	// avant de joindre les threads.
+	class ThreadPool
+	{
+	public:
+		explicit ThreadPool(size_t threadCount) :
+			m_active(0),
+			m_stopping(false)
+		{
+			if (threadCount == 0)
+			{
+				threadCount = 1;
+			}
+			m_threads.reserve(threadCount);
+			for (size_t i = 0; i < threadCount; i++)
+			{
+				m_threads.emplace_back([this]() { WorkerLoop(); });
+			}
+		}
+
+		~ThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_stopping = true;
+			}
+			m_wake.notify_all();
+			for (auto& thread : m_threads)
+			{
+				thread.join();
+			}
+		}
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		void Submit(std::function<void()> task)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_tasks.push_back(std::move(task));
+			}
+			m_wake.notify_one();
+		}
+
+		// Bloque jusqu'à ce que la file soit vide et qu'aucune tâche ne soit en cours.
+		void WaitIdle()
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_idle.wait(lock, [this]() { return m_tasks.empty() && m_active == 0; });
+		}
+
+		size_t GetThreadCount() const { return m_threads.size(); }
+
+	private:
+		void WorkerLoop()
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			for (;;)
+			{
+				m_wake.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+				if (m_tasks.empty())
+				{
+					return;
+				}
+
+				std::function<void()> task = std::move(m_tasks.front());
+				m_tasks.pop_front();
+				m_active++;
+				lock.unlock();
+
+				// Les tâches sont responsables de leurs propres exceptions ; une exception qui
+				// s'échappe ici terminerait le processus, comme pour un std::thread.
+				task();
+
+				lock.lock();
+				m_active--;
+				if (m_tasks.empty() && m_active == 0)
+				{
+					m_idle.notify_all();
+				}
+			}
+		}
+
+		std::vector<std::thread>			m_threads;
+		std::deque<std::function<void()>>	m_tasks;
+		std::mutex							m_mutex;
+		std::condition_variable				m_wake;
+		std::condition_variable				m_idle;
+		size_t								m_active;
+		bool								m_stopping;
+	};
+}
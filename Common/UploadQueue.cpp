@@ -0,0 +1,191 @@
+﻿#include "pch.h"
+#include "UploadQueue.h"
+#include "DirectXHelper.h"
+
+using namespace Microsoft::WRL;
+
+DX::UploadQueue::UploadQueue(ID3D12Device* device, UINT64 capacity) :
+	m_device(device),
+	m_mappedUploadBuffer(nullptr),
+	m_ring(capacity),
+	m_nextFenceValue(1),
+	m_fenceEvent(0),
+	m_recording(false)
+{
+	// Créez la file de copie. Elle s'exécute en parallèle de la file graphique.
+	D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+	queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+	queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+	DX::ThrowIfFailed(m_device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_copyQueue)));
+	NAME_D3D12_OBJECT(m_copyQueue);
+
+	// Créez la mémoire tampon de chargement. Elle reste mappée pendant toute sa durée de vie.
+	CD3DX12_HEAP_PROPERTIES uploadHeapProperties(D3D12_HEAP_TYPE_UPLOAD);
+	CD3DX12_RESOURCE_DESC uploadBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(capacity);
+	DX::ThrowIfFailed(m_device->CreateCommittedResource(
+		&uploadHeapProperties,
+		D3D12_HEAP_FLAG_NONE,
+		&uploadBufferDesc,
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&m_uploadBuffer)));
+	NAME_D3D12_OBJECT(m_uploadBuffer);
+
+	CD3DX12_RANGE readRange(0, 0);		// Nous n'avons pas l'intention de lire cette ressource sur l'UC.
+	DX::ThrowIfFailed(m_uploadBuffer->Map(0, &readRange, reinterpret_cast<void**>(&m_mappedUploadBuffer)));
+
+	DX::ThrowIfFailed(m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence)));
+	NAME_D3D12_OBJECT(m_fence);
+
+	m_fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+	if (m_fenceEvent == nullptr)
+	{
+		DX::ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+	}
+}
+
+DX::UploadQueue::~UploadQueue()
+{
+	// Attendez la fin des copies en cours avant de libérer la mémoire qu'elles lisent.
+	SubmitBatch();
+	if (m_fence->GetCompletedValue() < m_nextFenceValue - 1)
+	{
+		DX::ThrowIfFailed(m_fence->SetEventOnCompletion(m_nextFenceValue - 1, m_fenceEvent));
+		WaitForSingleObjectEx(m_fenceEvent, INFINITE, FALSE);
+	}
+
+	m_uploadBuffer->Unmap(0, nullptr);
+	m_mappedUploadBuffer = nullptr;
+	CloseHandle(m_fenceEvent);
+}
+
+void DX::UploadQueue::UploadBuffer(ID3D12Resource* destination, UINT64 destinationOffset, const void* data, UINT64 size)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	Retire();
+	BeginBatch();
+
+	// Les chargements trop gros pour l'anneau obtiennent leur propre ressource de chargement.
+	if (size > m_ring.GetCapacity())
+	{
+		ComPtr<ID3D12Resource> upload;
+		CD3DX12_HEAP_PROPERTIES uploadHeapProperties(D3D12_HEAP_TYPE_UPLOAD);
+		CD3DX12_RESOURCE_DESC uploadBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+		DX::ThrowIfFailed(m_device->CreateCommittedResource(
+			&uploadHeapProperties,
+			D3D12_HEAP_FLAG_NONE,
+			&uploadBufferDesc,
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			nullptr,
+			IID_PPV_ARGS(&upload)));
+
+		void* mapped = nullptr;
+		CD3DX12_RANGE readRange(0, 0);
+		DX::ThrowIfFailed(upload->Map(0, &readRange, &mapped));
+		memcpy(mapped, data, static_cast<size_t>(size));
+		upload->Unmap(0, nullptr);
+
+		m_commandList->CopyBufferRegion(destination, destinationOffset, upload.Get(), 0, size);
+		m_oversized.Release(upload, m_nextFenceValue);
+		return;
+	}
+
+	UINT64 offset = 0;
+	while (!m_ring.Allocate(size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, offset))
+	{
+		WaitForSpace();
+	}
+	memcpy(m_mappedUploadBuffer + offset, data, static_cast<size_t>(size));
+	m_commandList->CopyBufferRegion(destination, destinationOffset, m_uploadBuffer.Get(), offset, size);
+}
+
+UINT64 DX::UploadQueue::Flush()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return SubmitBatch();
+}
+
+void DX::UploadQueue::WaitOnGpu(ID3D12CommandQueue* queue, UINT64 fenceValue) const
+{
+	DX::ThrowIfFailed(queue->Wait(m_fence.Get(), fenceValue));
+}
+
+// Ouvre une liste de commandes pour le prochain lot de copies, si ce n'est pas déjà fait.
+void DX::UploadQueue::BeginBatch()
+{
+	if (m_recording)
+	{
+		return;
+	}
+
+	if (m_allocatorPool.Acquire(m_fence->GetCompletedValue(), m_commandAllocator))
+	{
+		DX::ThrowIfFailed(m_commandAllocator->Reset());
+	}
+	else
+	{
+		DX::ThrowIfFailed(m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&m_commandAllocator)));
+	}
+
+	if (m_commandList == nullptr)
+	{
+		DX::ThrowIfFailed(m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, m_commandAllocator.Get(), nullptr, IID_PPV_ARGS(&m_commandList)));
+		NAME_D3D12_OBJECT(m_commandList);
+	}
+	else
+	{
+		DX::ThrowIfFailed(m_commandList->Reset(m_commandAllocator.Get(), nullptr));
+	}
+	m_recording = true;
+}
+
+// Soumet le lot en cours d'enregistrement, et retourne la valeur d'isolation qui sera signalée à la fin.
+UINT64 DX::UploadQueue::SubmitBatch()
+{
+	if (!m_recording)
+	{
+		// Rien de nouveau : les copies précédentes seront terminées à la dernière valeur signalée.
+		return m_nextFenceValue - 1;
+	}
+
+	DX::ThrowIfFailed(m_commandList->Close());
+	ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
+	m_copyQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+
+	UINT64 fenceValue = m_nextFenceValue++;
+	DX::ThrowIfFailed(m_copyQueue->Signal(m_fence.Get(), fenceValue));
+
+	m_ring.Submit(fenceValue);
+	m_allocatorPool.Release(m_commandAllocator, fenceValue);
+	m_commandAllocator = nullptr;
+	m_recording = false;
+	return fenceValue;
+}
+
+// Libère l'espace de l'anneau et les ressources temporaires dont les copies sont terminées.
+void DX::UploadQueue::Retire()
+{
+	UINT64 completed = m_fence->GetCompletedValue();
+	m_ring.Retire(completed);
+
+	ComPtr<ID3D12Resource> finished;
+	while (m_oversized.Acquire(completed, finished))
+	{
+		finished = nullptr;
+	}
+}
+
+// L'anneau est plein : soumettez ce qui a été enregistré, puis attendez que la plus ancienne copie se termine.
+void DX::UploadQueue::WaitForSpace()
+{
+	SubmitBatch();
+
+	UINT64 oldest = m_ring.GetOldestFenceValue();
+	if (oldest != 0 && m_fence->GetCompletedValue() < oldest)
+	{
+		DX::ThrowIfFailed(m_fence->SetEventOnCompletion(oldest, m_fenceEvent));
+		WaitForSingleObjectEx(m_fenceEvent, INFINITE, FALSE);
+	}
+	Retire();
+	BeginBatch();
+}
@@ -0,0 +1,63 @@
+﻿#pragma once
+
+#include "RingAllocator.h"
+#include "FencedPool.h"
+#include <mutex>
+
+namespace DX
+{
+	// Charge des données vers des ressources GPU sur une file de copie dédiée. Les données passent par
+	// une mémoire tampon de chargement persistante, mappée une seule fois et partagée en anneau, au lieu
+	// de créer une ressource de chargement à chaque fois. Flush soumet les copies et retourne une valeur
+	// d'isolation ; le rendu peut alors attendre cette valeur sur le GPU (WaitOnGpu) plutôt que de
+	// bloquer l'UC jusqu'à ce que tout le GPU soit inactif.
+	//
+	// Les ressources de destination doivent être créées dans l'état D3D12_RESOURCE_STATE_COMMON : une file
+	// de copie ne peut pas faire de transitions, et les mémoires tampons sont promues implicitement vers
+	// l'état de lecture voulu lors de leur première utilisation sur la file graphique.
+	class UploadQueue
+	{
+	public:
+		UploadQueue(ID3D12Device* device, UINT64 capacity);
+		~UploadQueue();
+
+		// Copie size octets de data vers destination, à destinationOffset. Les données sont copiées
+		// immédiatement, le pointeur peut donc être libéré au retour de l'appel.
+		void UploadBuffer(ID3D12Resource* destination, UINT64 destinationOffset, const void* data, UINT64 size);
+
+		// Soumet les copies en attente, et retourne la valeur d'isolation qui sera signalée une fois terminées.
+		UINT64 Flush();
+
+		// Fait attendre queue, sur le GPU, que les copies jusqu'à fenceValue soient terminées.
+		void WaitOnGpu(ID3D12CommandQueue* queue, UINT64 fenceValue) const;
+
+		bool IsComplete(UINT64 fenceValue) const	{ return m_fence->GetCompletedValue() >= fenceValue; }
+		ID3D12CommandQueue*	GetCommandQueue() const	{ return m_copyQueue.Get(); }
+		ID3D12Fence*		GetFence() const		{ return m_fence.Get(); }
+
+	private:
+		void BeginBatch();
+		UINT64 SubmitBatch();
+		void Retire();
+		void WaitForSpace();
+
+		Microsoft::WRL::ComPtr<ID3D12Device>										m_device;
+		Microsoft::WRL::ComPtr<ID3D12CommandQueue>									m_copyQueue;
+		Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>							m_commandList;
+		Microsoft::WRL::ComPtr<ID3D12CommandAllocator>								m_commandAllocator;
+		FencedPool<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>>					m_allocatorPool;
+		Microsoft::WRL::ComPtr<ID3D12Resource>										m_uploadBuffer;
+		UINT8*																		m_mappedUploadBuffer;
+		RingAllocator																m_ring;
+
+		// Les chargements plus gros que l'anneau passent par une ressource temporaire, conservée jusqu'à la fin de la copie.
+		FencedPool<Microsoft::WRL::ComPtr<ID3D12Resource>>							m_oversized;
+
+		// Synchronisation de la file de copie.
+		Microsoft::WRL::ComPtr<ID3D12Fence>											m_fence;
+		UINT64																		m_nextFenceValue;
+		HANDLE																		m_fenceEvent;
+		bool																		m_recording;
+		std::mutex																	m_mutex;
+	};
+}
@@ -3,6 +3,8 @@
 
 #include "..\Common\DirectXHelper.h"
 #include <ppltasks.h>
+#include <ppl.h>
+#include <thread>
 #include <synchapi.h>
 
 using namespace TestApp;
@@ -24,8 +26,20 @@ Sample3DSceneRenderer::Sample3DSceneRenderer(const std::shared_ptr<DX::DeviceRes
 	m_angle(0),
 	m_tracking(false),
 	m_mappedConstantBuffer(nullptr),
-	m_deviceResources(deviceResources)
+	m_pipelineStateKey(0),
+	m_renderGraph(),
+	m_cbvDescriptors(),
+	m_deviceResources(deviceResources),
+	m_drawCount(1),
+	m_workerCount(1)
 {
+	// Un thread d'enregistrement par cœur.
+	unsigned int cores = std::thread::hardware_concurrency();
+	if (cores > 1)
+	{
+		m_workerCount = cores;
+	}
+
 	LoadState();
 	ZeroMemory(&m_constantBufferData, sizeof(m_constantBufferData));
 
@@ -37,6 +51,15 @@ Sample3DSceneRenderer::~Sample3DSceneRenderer()
 {
 	m_constantBuffer->Unmap(0, nullptr);
 	m_mappedConstantBuffer = nullptr;
+
+	// Rendez la mémoire des mémoires tampons aux tas de l'allocateur.
+	DX::HeapAllocator* heapAllocator = m_deviceResources->GetHeapAllocator();
+	heapAllocator->ReleaseResource(m_vertexBuffer.Get());
+	heapAllocator->ReleaseResource(m_indexBuffer.Get());
+	heapAllocator->ReleaseResource(m_constantBuffer.Get());
+
+	// Les descripteurs ne seront réutilisés qu'une fois la frame en cours terminée.
+	m_deviceResources->GetCbvSrvUavHeap()->FreePersistent(m_cbvDescriptors, m_deviceResources->GetCurrentFenceValue());
 }
 
 void Sample3DSceneRenderer::CreateDeviceDependentResources()
@@ -66,19 +89,21 @@ void Sample3DSceneRenderer::CreateDeviceDependentResources()
 		DX::ThrowIfFailed(D3D12SerializeRootSignature(&descRootSignature, D3D_ROOT_SIGNATURE_VERSION_1, pSignature.GetAddressOf(), pError.GetAddressOf()));
 		DX::ThrowIfFailed(d3dDevice->CreateRootSignature(0, pSignature->GetBufferPointer(), pSignature->GetBufferSize(), IID_PPV_ARGS(&m_rootSignature)));
         NAME_D3D12_OBJECT(m_rootSignature);
+
+		// La clé des états de pipeline qui utilisent cette signature reste ainsi la même d'une exécution à l'autre.
+		m_deviceResources->GetPipelineStateCache()->RegisterRootSignature(m_rootSignature.Get(), pSignature->GetBufferPointer(), pSignature->GetBufferSize());
 	}
 
-	// Chargez les nuanceurs de manière asynchrone.
-	auto createVSTask = DX::ReadDataAsync(L"SampleVertexShader.cso").then([this](std::vector<byte>& fileData) {
-		m_vertexShader = fileData;
-	});
+	// Listes de commandes utilisées par Render, une par thread d'enregistrement.
+	m_commandLists = std::make_unique<DX::ParallelCommandLists>(d3dDevice);
 
-	auto createPSTask = DX::ReadDataAsync(L"SamplePixelShader.cso").then([this](std::vector<byte>& fileData) {
-		m_pixelShader = fileData;
-	});
+	// Chargez les nuanceurs de manière asynchrone. Les fichiers sont projetés en mémoire et lus sur place, sans copie.
+	DX::AssetLoader* assetLoader = m_deviceResources->GetAssetLoader();
+	DX::AssetHandle vertexShader = assetLoader->Load(L"SampleVertexShader.cso");
+	DX::AssetHandle pixelShader = assetLoader->Load(L"SamplePixelShader.cso");
 
 	// Créez l'état du pipeline, une fois les nuanceurs chargés.
-	auto createPipelineStateTask = (createPSTask && createVSTask).then([this]() {
+	DX::AssetHandle createPipelineState = assetLoader->Then({ vertexShader, pixelShader }, [this, vertexShader, pixelShader]() {
 
 		static const D3D12_INPUT_ELEMENT_DESC inputLayout[] =
 		{
@@ -89,8 +114,8 @@ void Sample3DSceneRenderer::CreateDeviceDependentResources()
 		D3D12_GRAPHICS_PIPELINE_STATE_DESC state = {};
 		state.InputLayout = { inputLayout, _countof(inputLayout) };
 		state.pRootSignature = m_rootSignature.Get();
-        state.VS = CD3DX12_SHADER_BYTECODE(&m_vertexShader[0], m_vertexShader.size());
-        state.PS = CD3DX12_SHADER_BYTECODE(&m_pixelShader[0], m_pixelShader.size());
+		state.VS = CD3DX12_SHADER_BYTECODE(vertexShader->GetView().data, vertexShader->GetView().size);
+		state.PS = CD3DX12_SHADER_BYTECODE(pixelShader->GetView().data, pixelShader->GetView().size);
 		state.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
 		state.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
 		state.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
@@ -101,20 +126,17 @@ void Sample3DSceneRenderer::CreateDeviceDependentResources()
 		state.DSVFormat = m_deviceResources->GetDepthBufferFormat();
 		state.SampleDesc.Count = 1;
 
-		DX::ThrowIfFailed(m_deviceResources->GetD3DDevice()->CreateGraphicsPipelineState(&state, IID_PPV_ARGS(&m_pipelineState)));
-
-		// Les données du nuanceur peuvent être supprimées une fois que l'état du pipeline est créé.
-		m_vertexShader.clear();
-		m_pixelShader.clear();
+		// Le cache copie la description et crée l'état en arrière-plan, à partir du blob enregistré s'il en a un.
+		// Les fichiers des nuanceurs sont libérés avec la dernière requête qui les référence.
+		m_pipelineStateKey = m_deviceResources->GetPipelineStateCache()->Prewarm(state);
 	});
+	auto createPipelineStateTask = DX::WhenLoaded(*assetLoader, createPipelineState);
 
 	// Créez et chargez les ressources de la géométrie de cube vers le GPU.
 	auto createAssetsTask = createPipelineStateTask.then([this]() {
 		auto d3dDevice = m_deviceResources->GetD3DDevice();
-
-		// Créez une liste de commandes.
-		DX::ThrowIfFailed(d3dDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_deviceResources->GetCommandAllocator(), m_pipelineState.Get(), IID_PPV_ARGS(&m_commandList)));
-        NAME_D3D12_OBJECT(m_commandList);
+		DX::UploadQueue* uploadQueue = m_deviceResources->GetUploadQueue();
+		DX::HeapAllocator* heapAllocator = m_deviceResources->GetHeapAllocator();
 
 		// Vertex du cube. Chaque vertex a une position et une couleur.
 		VertexPositionColor cubeVertices[] =
@@ -131,44 +153,15 @@ void Sample3DSceneRenderer::CreateDeviceDependentResources()
 
 		const UINT vertexBufferSize = sizeof(cubeVertices);
 
-		// Créez la ressource de mémoire tampon vertex dans le tas par défaut du GPU pour y copier les données de vertex à l'aide du tas de chargement.
-		// La ressource de chargement ne doit pas être libérée tant que le GPU n'a pas fini de l'utiliser.
-		Microsoft::WRL::ComPtr<ID3D12Resource> vertexBufferUpload;
-
-		CD3DX12_HEAP_PROPERTIES defaultHeapProperties(D3D12_HEAP_TYPE_DEFAULT);
+		// Créez la ressource de mémoire tampon vertex dans le tas par défaut du GPU. Elle est créée dans l'état COMMON, car
+		// la file de copie ne peut pas faire de transition ; elle sera promue en lecture à sa première utilisation.
 		CD3DX12_RESOURCE_DESC vertexBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize);
-		DX::ThrowIfFailed(d3dDevice->CreateCommittedResource(
-			&defaultHeapProperties,
-			D3D12_HEAP_FLAG_NONE,
-			&vertexBufferDesc,
-			D3D12_RESOURCE_STATE_COPY_DEST,
-			nullptr,
-			IID_PPV_ARGS(&m_vertexBuffer)));
-
-		CD3DX12_HEAP_PROPERTIES uploadHeapProperties(D3D12_HEAP_TYPE_UPLOAD);
-		DX::ThrowIfFailed(d3dDevice->CreateCommittedResource(
-			&uploadHeapProperties,
-			D3D12_HEAP_FLAG_NONE,
-			&vertexBufferDesc,
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&vertexBufferUpload)));
+		m_vertexBuffer = heapAllocator->CreateResource(D3D12_HEAP_TYPE_DEFAULT, vertexBufferDesc, D3D12_RESOURCE_STATE_COMMON, nullptr);
 
         NAME_D3D12_OBJECT(m_vertexBuffer);
 
-		// Chargez la mémoire tampon vertex vers le GPU.
-		{
-			D3D12_SUBRESOURCE_DATA vertexData = {};
-			vertexData.pData = reinterpret_cast<BYTE*>(cubeVertices);
-			vertexData.RowPitch = vertexBufferSize;
-			vertexData.SlicePitch = vertexData.RowPitch;
-
-			UpdateSubresources(m_commandList.Get(), m_vertexBuffer.Get(), vertexBufferUpload.Get(), 0, 0, 1, &vertexData);
-
-			CD3DX12_RESOURCE_BARRIER vertexBufferResourceBarrier =
-				CD3DX12_RESOURCE_BARRIER::Transition(m_vertexBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
-			m_commandList->ResourceBarrier(1, &vertexBufferResourceBarrier);
-		}
+		// Chargez la mémoire tampon vertex vers le GPU, à travers l'anneau de chargement partagé.
+		uploadQueue->UploadBuffer(m_vertexBuffer.Get(), 0, cubeVertices, vertexBufferSize);
 
 		// Chargez les index de maillage. Chaque trio d'index représente un triangle à afficher à l'écran.
 		// Par exemple : 0,2,1 signifie que les vertex avec les index 0, 2 et 1 de la mémoire tampon vertex composent le
@@ -196,70 +189,26 @@ void Sample3DSceneRenderer::CreateDeviceDependentResources()
 
 		const UINT indexBufferSize = sizeof(cubeIndices);
 
-		// Créez la ressource de mémoire tampon d'index dans le tas par défaut du GPU pour y copier les données d'index à l'aide du tas de chargement.
-		// La ressource de chargement ne doit pas être libérée tant que le GPU n'a pas fini de l'utiliser.
-		Microsoft::WRL::ComPtr<ID3D12Resource> indexBufferUpload;
-
+		// Créez la ressource de mémoire tampon d'index dans le tas par défaut du GPU, puis chargez les index de la même façon.
 		CD3DX12_RESOURCE_DESC indexBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(indexBufferSize);
-		DX::ThrowIfFailed(d3dDevice->CreateCommittedResource(
-			&defaultHeapProperties,
-			D3D12_HEAP_FLAG_NONE,
-			&indexBufferDesc,
-			D3D12_RESOURCE_STATE_COPY_DEST,
-			nullptr,
-			IID_PPV_ARGS(&m_indexBuffer)));
-
-		DX::ThrowIfFailed(d3dDevice->CreateCommittedResource(
-			&uploadHeapProperties,
-			D3D12_HEAP_FLAG_NONE,
-			&indexBufferDesc,
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&indexBufferUpload)));
+		m_indexBuffer = heapAllocator->CreateResource(D3D12_HEAP_TYPE_DEFAULT, indexBufferDesc, D3D12_RESOURCE_STATE_COMMON, nullptr);
 
 		NAME_D3D12_OBJECT(m_indexBuffer);
 
-		// Chargez la mémoire tampon d'index vers le GPU.
-		{
-			D3D12_SUBRESOURCE_DATA indexData = {};
-			indexData.pData = reinterpret_cast<BYTE*>(cubeIndices);
-			indexData.RowPitch = indexBufferSize;
-			indexData.SlicePitch = indexData.RowPitch;
+		uploadQueue->UploadBuffer(m_indexBuffer.Get(), 0, cubeIndices, indexBufferSize);
 
-			UpdateSubresources(m_commandList.Get(), m_indexBuffer.Get(), indexBufferUpload.Get(), 0, 0, 1, &indexData);
-
-			CD3DX12_RESOURCE_BARRIER indexBufferResourceBarrier =
-				CD3DX12_RESOURCE_BARRIER::Transition(m_indexBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_INDEX_BUFFER);
-			m_commandList->ResourceBarrier(1, &indexBufferResourceBarrier);
-		}
-
-		// Créez un tas du descripteur pour les mémoires tampons constantes.
-		{
-			D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
-			heapDesc.NumDescriptors = DX::c_frameCount;
-			heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-			// Cet indicateur signale que ce tas du descripteur peut être lié au pipeline et que les descripteurs qu'il contient peuvent être référencés par une table racine.
-			heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-			DX::ThrowIfFailed(d3dDevice->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&m_cbvHeap)));
-
-            NAME_D3D12_OBJECT(m_cbvHeap);
-		}
+		// Réservez un descripteur par frame pour les mémoires tampons constantes dans le tas partagé visible par les nuanceurs.
+		DX::DescriptorHeap* descriptorHeap = m_deviceResources->GetCbvSrvUavHeap();
+		m_cbvDescriptors = descriptorHeap->AllocatePersistent(DX::c_frameCount);
 
 		CD3DX12_RESOURCE_DESC constantBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(DX::c_frameCount * c_alignedConstantBufferSize);
-		DX::ThrowIfFailed(d3dDevice->CreateCommittedResource(
-			&uploadHeapProperties,
-			D3D12_HEAP_FLAG_NONE,
-			&constantBufferDesc,
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&m_constantBuffer)));
+		m_constantBuffer = heapAllocator->CreateResource(D3D12_HEAP_TYPE_UPLOAD, constantBufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr);
 
         NAME_D3D12_OBJECT(m_constantBuffer);
 
 		// Créez des vues de mémoire tampon constante pour accéder à la mémoire tampon de chargement.
 		D3D12_GPU_VIRTUAL_ADDRESS cbvGpuAddress = m_constantBuffer->GetGPUVirtualAddress();
-		CD3DX12_CPU_DESCRIPTOR_HANDLE cbvCpuHandle(m_cbvHeap->GetCPUDescriptorHandleForHeapStart());
-		m_cbvDescriptorSize = d3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+		CD3DX12_CPU_DESCRIPTOR_HANDLE cbvCpuHandle(m_cbvDescriptors.cpuHandle);
 
 		for (int n = 0; n < DX::c_frameCount; n++)
 		{
@@ -269,7 +218,7 @@ void Sample3DSceneRenderer::CreateDeviceDependentResources()
 			d3dDevice->CreateConstantBufferView(&desc, cbvCpuHandle);
 
 			cbvGpuAddress += desc.SizeInBytes;
-			cbvCpuHandle.Offset(m_cbvDescriptorSize);
+			cbvCpuHandle.Offset(descriptorHeap->GetDescriptorSize());
 		}
 
 		// Mappez les mémoires tampons constantes.
@@ -278,10 +227,8 @@ void Sample3DSceneRenderer::CreateDeviceDependentResources()
 		ZeroMemory(m_mappedConstantBuffer, DX::c_frameCount * c_alignedConstantBufferSize);
 		// Nous n'annulons pas le mappage de ceci tant que l'application n'est pas fermée. Il est possible de conserver le mappage des éléments pendant la durée de vie de la ressource.
 
-		// Fermez la liste de commandes et exécutez-la pour démarrer la copie de la mémoire tampon vertex/d'index dans le tas par défaut du GPU.
-		DX::ThrowIfFailed(m_commandList->Close());
-		ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
-		m_deviceResources->GetCommandQueue()->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+		// Soumettez les copies de la mémoire tampon vertex/d'index sur la file de copie.
+		UINT64 uploadFenceValue = uploadQueue->Flush();
 
 		// Créez des vues de mémoire tampon vertex/d'index.
 		m_vertexBufferView.BufferLocation = m_vertexBuffer->GetGPUVirtualAddress();
@@ -292,8 +239,9 @@ void Sample3DSceneRenderer::CreateDeviceDependentResources()
 		m_indexBufferView.SizeInBytes = sizeof(cubeIndices);
 		m_indexBufferView.Format = DXGI_FORMAT_R16_UINT;
 
-		// Attendez la fin de l'exécution de la liste de commandes ; les mémoires tampons vertex/d'index doivent être chargées vers le GPU avant que les ressources de chargement ne soient hors de portée.
-		m_deviceResources->WaitForGpu();
+		// Plutôt que de bloquer l'UC jusqu'à la fin des copies, la file graphique attendra sur le GPU qu'elles soient
+		// terminées avant d'exécuter le premier rendu qui lit ces mémoires tampons.
+		uploadQueue->WaitOnGpu(m_deviceResources->GetCommandQueue(), uploadFenceValue);
 	});
 
 	createAssetsTask.then([this]() {
@@ -437,57 +385,110 @@ bool Sample3DSceneRenderer::Render()
 		return false;
 	}
 
-	DX::ThrowIfFailed(m_deviceResources->GetCommandAllocator()->Reset());
+	// L'état du pipeline est créé en arrière-plan. Tant qu'il n'est pas prêt, la frame est sautée plutôt que d'attendre.
+	ID3D12PipelineState* pipelineState = m_deviceResources->GetPipelineStateCache()->TryGet(m_pipelineStateKey);
+	if (pipelineState == nullptr)
+	{
+		return false;
+	}
+
+	// Les dessins sont répartis entre plusieurs listes de commandes enregistrées en parallèle. Une liste
+	// d'ouverture et une liste de fermeture s'occupent des transitions et de l'effacement, et le tout est
+	// soumis dans l'ordre en un seul appel.
+	std::vector<DX::DrawRange> ranges = DX::SplitDrawRanges(m_drawCount, m_workerCount, c_minDrawsPerList);
+	const UINT rangeCount = static_cast<UINT>(ranges.size());
+	m_commandLists->Begin(rangeCount + 2, m_deviceResources->GetFence()->GetCompletedValue(), pipelineState);
 
-	// La liste de commandes peut être réinitialisée à tout moment après l'appel de ExecuteCommandList().
-	DX::ThrowIfFailed(m_commandList->Reset(m_deviceResources->GetCommandAllocator(), m_pipelineState.Get()));
+	ID3D12GraphicsCommandList* prologue = m_commandLists->GetList(0);
+	ID3D12GraphicsCommandList* epilogue = m_commandLists->GetList(rangeCount + 1);
 
-	PIXBeginEvent(m_commandList.Get(), 0, L"Draw the cube");
+	// Décrivez la frame sous forme de graphe : les passes déclarent ce qu'elles lisent et écrivent, et le graphe
+	// en déduit les passes utiles et l'état voulu avant chacune. La mémoire tampon d'arrière-plan doit finir
+	// dans l'état de présentation ; le stencil de profondeur reste dans l'état de sa dernière utilisation.
+	m_renderGraph.Reset();
+	uint32_t backBuffer = m_renderGraph.ImportResource("BackBuffer", m_deviceResources->GetRenderTarget(), D3D12_RESOURCE_STATE_PRESENT);
+	uint32_t depth = m_renderGraph.ImportResource("DepthStencil", m_deviceResources->GetDepthStencil());
+
+	uint32_t clearPass = m_renderGraph.AddPass("Clear", [this, prologue]()
 	{
-		// Définissez la signature racine des graphismes et les tas du descripteur à utiliser par ce frame.
-		m_commandList->SetGraphicsRootSignature(m_rootSignature.Get());
-		ID3D12DescriptorHeap* ppHeaps[] = { m_cbvHeap.Get() };
-		m_commandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
-
-		// Liez la mémoire tampon constante du frame actif au pipeline.
-		CD3DX12_GPU_DESCRIPTOR_HANDLE gpuHandle(m_cbvHeap->GetGPUDescriptorHandleForHeapStart(), m_deviceResources->GetCurrentFrameIndex(), m_cbvDescriptorSize);
-		m_commandList->SetGraphicsRootDescriptorTable(0, gpuHandle);
-
-		// Définissez la fenêtre d'affichage et le rectangle ciseaux.
-		D3D12_VIEWPORT viewport = m_deviceResources->GetScreenViewport();
-		m_commandList->RSSetViewports(1, &viewport);
-		m_commandList->RSSetScissorRects(1, &m_scissorRect);
-
-		// Indiquez que cette ressource doit être utilisée comme cible de rendu.
-		CD3DX12_RESOURCE_BARRIER renderTargetResourceBarrier =
-			CD3DX12_RESOURCE_BARRIER::Transition(m_deviceResources->GetRenderTarget(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
-		m_commandList->ResourceBarrier(1, &renderTargetResourceBarrier);
-
-		// Enregistrez les commandes de dessin.
+		PIXBeginEvent(prologue, 0, L"Clear");
 		D3D12_CPU_DESCRIPTOR_HANDLE renderTargetView = m_deviceResources->GetRenderTargetView();
 		D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView = m_deviceResources->GetDepthStencilView();
-		m_commandList->ClearRenderTargetView(renderTargetView, DirectX::Colors::CornflowerBlue, 0, nullptr);
-		m_commandList->ClearDepthStencilView(depthStencilView, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+		prologue->ClearRenderTargetView(renderTargetView, DirectX::Colors::CornflowerBlue, 0, nullptr);
+		prologue->ClearDepthStencilView(depthStencilView, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+		PIXEndEvent(prologue);
+	});
+	m_renderGraph.Write(clearPass, backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_renderGraph.Write(clearPass, depth, D3D12_RESOURCE_STATE_DEPTH_WRITE);
 
-		m_commandList->OMSetRenderTargets(1, &renderTargetView, false, &depthStencilView);
+	uint32_t cubesPass = m_renderGraph.AddPass("Cubes", [this, &ranges, rangeCount]()
+	{
+		// Chaque thread n'écrit que dans sa propre liste, aucune synchronisation n'est donc nécessaire.
+		parallel_for(0u, rangeCount, [this, &ranges](UINT i)
+		{
+			ID3D12GraphicsCommandList* commandList = m_commandLists->GetList(i + 1);
+			PIXBeginEvent(commandList, 0, L"Draw the cubes");
+			SetDrawState(commandList);
+			RecordDraws(commandList, ranges[i]);
+			PIXEndEvent(commandList);
+		});
+	});
+	m_renderGraph.Read(cubesPass, backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_renderGraph.Write(cubesPass, backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_renderGraph.Read(cubesPass, depth, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+	m_renderGraph.Write(cubesPass, depth, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+
+	m_renderGraph.Compile();
+
+	// Le suivi part de l'état laissé par la frame précédente et n'émet que les transitions nécessaires. Les passes
+	// s'enregistrent avant les listes des threads de travail ; leurs barrières vont donc dans la liste d'ouverture,
+	// et celles qui mènent aux états finaux dans la liste de fermeture, qui publie ensuite ces états.
+	DX::ResourceStateTracker stateTracker(m_deviceResources->GetResourceStates());
+	m_renderGraph.Execute(stateTracker, [&stateTracker, prologue](uint32_t)
+	{
+		DX::FlushResourceBarriers(stateTracker, prologue);
+	});
+	DX::CommitResourceStates(stateTracker, epilogue);
 
-		m_commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-		m_commandList->IASetVertexBuffers(0, 1, &m_vertexBufferView);
-		m_commandList->IASetIndexBuffer(&m_indexBufferView);
-		m_commandList->DrawIndexedInstanced(36, 1, 0, 0, 0);
+	// Exécutez les listes de commandes.
+	m_commandLists->Submit(m_deviceResources->GetCommandQueue(), m_deviceResources->GetCurrentFenceValue());
 
-		// Indique que la cible de rendu va maintenant être utilisée pour signaler la fin de l'exécution de la liste de commandes.
-		CD3DX12_RESOURCE_BARRIER presentResourceBarrier =
-			CD3DX12_RESOURCE_BARRIER::Transition(m_deviceResources->GetRenderTarget(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
-		m_commandList->ResourceBarrier(1, &presentResourceBarrier);
-	}
-	PIXEndEvent(m_commandList.Get());
+	return true;
+}
 
-	DX::ThrowIfFailed(m_commandList->Close());
+// L'état du pipeline n'est pas hérité d'une liste de commandes à l'autre, chaque liste doit donc le définir.
+void Sample3DSceneRenderer::SetDrawState(ID3D12GraphicsCommandList* commandList)
+{
+	// Définissez la signature racine des graphismes et les tas du descripteur à utiliser par ce frame.
+	commandList->SetGraphicsRootSignature(m_rootSignature.Get());
+	DX::DescriptorHeap* descriptorHeap = m_deviceResources->GetCbvSrvUavHeap();
+	ID3D12DescriptorHeap* ppHeaps[] = { descriptorHeap->GetHeap() };
+	commandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
 
-	// Exécutez la liste de commandes.
-	ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
-	m_deviceResources->GetCommandQueue()->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+	// Liez la mémoire tampon constante du frame actif au pipeline.
+	CD3DX12_GPU_DESCRIPTOR_HANDLE gpuHandle(m_cbvDescriptors.gpuHandle, m_deviceResources->GetCurrentFrameIndex(), descriptorHeap->GetDescriptorSize());
+	commandList->SetGraphicsRootDescriptorTable(0, gpuHandle);
 
-	return true;
+	// Définissez la fenêtre d'affichage et le rectangle ciseaux.
+	D3D12_VIEWPORT viewport = m_deviceResources->GetScreenViewport();
+	commandList->RSSetViewports(1, &viewport);
+	commandList->RSSetScissorRects(1, &m_scissorRect);
+
+	D3D12_CPU_DESCRIPTOR_HANDLE renderTargetView = m_deviceResources->GetRenderTargetView();
+	D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView = m_deviceResources->GetDepthStencilView();
+	commandList->OMSetRenderTargets(1, &renderTargetView, false, &depthStencilView);
+
+	commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	commandList->IASetVertexBuffers(0, 1, &m_vertexBufferView);
+	commandList->IASetIndexBuffer(&m_indexBufferView);
+}
+
+// Enregistrez les commandes de dessin d'une plage de la scène.
+void Sample3DSceneRenderer::RecordDraws(ID3D12GraphicsCommandList* commandList, const DX::DrawRange& range)
+{
+	// Le nuanceur n'a pas de données par instance : tous les dessins sont le cube, avec la matrice de modèle de la frame.
+	for (UINT i = 0; i < range.count; i++)
+	{
+		commandList->DrawIndexedInstanced(36, 1, 0, 0, 0);
+	}
 }
@@ -3,6 +3,9 @@
 #include "..\Common\DeviceResources.h"
 #include "ShaderStructures.h"
 #include "..\Common\StepTimer.h"
+#include "..\Common\ParallelCommandLists.h"
+#include "..\Common\DrawRanges.h"
+#include "..\Common\RenderGraph.h"
 
 namespace TestApp
 {
@@ -26,36 +29,46 @@ namespace TestApp
 	private:
 		void LoadState();
 		void Rotate(float radians);
+		void SetDrawState(ID3D12GraphicsCommandList* commandList);
+		void RecordDraws(ID3D12GraphicsCommandList* commandList, const DX::DrawRange& range);
 
 	private:
 		// Les mémoires tampons constantes doivent être alignées sur 256 octets.
 		static const UINT c_alignedConstantBufferSize = (sizeof(ModelViewProjectionConstantBuffer) + 255) & ~255;
 
+		// En dessous de ce nombre de dessins, une liste de commandes de plus coûte plus qu'elle ne rapporte.
+		static const UINT c_minDrawsPerList = 64;
+
 		// Pointeur mis en cache vers les ressources du périphérique.
 		std::shared_ptr<DX::DeviceResources> m_deviceResources;
 
 		// Ressources Direct3D pour la géométrie de cube.
-		Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>	m_commandList;
+		std::unique_ptr<DX::ParallelCommandLists>			m_commandLists;
 		Microsoft::WRL::ComPtr<ID3D12RootSignature>			m_rootSignature;
-		Microsoft::WRL::ComPtr<ID3D12PipelineState>			m_pipelineState;
-		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>		m_cbvHeap;
+		UINT64												m_pipelineStateKey;	// Clé de l'état du pipeline dans le cache de DeviceResources.
 		Microsoft::WRL::ComPtr<ID3D12Resource>				m_vertexBuffer;
 		Microsoft::WRL::ComPtr<ID3D12Resource>				m_indexBuffer;
 		Microsoft::WRL::ComPtr<ID3D12Resource>				m_constantBuffer;
 		ModelViewProjectionConstantBuffer					m_constantBufferData;
 		UINT8*												m_mappedConstantBuffer;
-		UINT												m_cbvDescriptorSize;
 		D3D12_RECT											m_scissorRect;
-		std::vector<byte>									m_vertexShader;
-		std::vector<byte>									m_pixelShader;
 		D3D12_VERTEX_BUFFER_VIEW							m_vertexBufferView;
 		D3D12_INDEX_BUFFER_VIEW								m_indexBufferView;
+		DX::DescriptorAllocation							m_cbvDescriptors;
+
+		// Graphe de la frame, reconstruit à chaque rendu.
+		DX::RenderGraph										m_renderGraph;
 
 		// Variables utilisées avec la boucle de rendu.
 		bool	m_loadingComplete;
 		float	m_radiansPerSecond;
 		float	m_angle;
 		bool	m_tracking;
+
+		// Nombre de dessins de la scène, et nombre maximal de threads qui les enregistrent. La scène n'a qu'un
+		// cube : sous 2 × c_minDrawsPerList dessins, tout s'enregistre dans une seule liste.
+		UINT	m_drawCount;
+		UINT	m_workerCount;
 	};
 }
 
@@ -0,0 +1,171 @@
+#include "ClockMapper.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace TestApp;
+
+///////////////////////////////////////////
+
+// Residuals under this many nanoseconds are never outliers, so a near perfect fit doesn't
+// throw out pairs over a few nanoseconds of rounding.
+static const double minOutlierThreshold = 1000;
+
+// How many scaled median absolute deviations off the line a pair may be.
+static const double outlierDeviations = 3;
+
+static double median(double* values, uint32_t count) {
+	std::nth_element(values, values + count / 2, values + count);
+	return values[count / 2];
+}
+
+// Least squares over the pairs marked as inliers. With one pair, or pairs all at the same
+// camera time, there's only an offset to find.
+static void fitLine(const double* x, const double* y, const bool* inlier, uint32_t count, double* outA, double* outB) {
+	double   sumX = 0, sumY = 0;
+	uint32_t used = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		if (!inlier[i]) continue;
+		sumX += x[i];
+		sumY += y[i];
+		used += 1;
+	}
+	double meanX = sumX / used, meanY = sumY / used;
+	double sumXX = 0, sumXY = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		if (!inlier[i]) continue;
+		sumXX += (x[i] - meanX) * (x[i] - meanX);
+		sumXY += (x[i] - meanX) * (y[i] - meanY);
+	}
+	*outB = sumXX > 0 ? sumXY / sumXX : 0;
+	*outA = meanY - *outB * meanX;
+}
+
+///////////////////////////////////////////
+
+ClockMapper::ClockMapper() {
+	reset();
+}
+
+void ClockMapper::reset() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_pairCount = 0;
+	m_fit       = { 0, 0, 1.0 };
+	m_stats     = {};
+}
+
+bool ClockMapper::addPair(uint64_t cameraTime, XrTime xrTime) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_pairCount > 0) {
+		uint32_t newest = (uint32_t)((m_pairCount - 1) % windowCapacity);
+		if (cameraTime <= m_cameraTimes[newest] || xrTime <= m_xrTimes[newest])
+			return false;
+	}
+
+	uint32_t slot = (uint32_t)(m_pairCount % windowCapacity);
+	m_cameraTimes[slot] = cameraTime;
+	m_xrTimes[slot]     = xrTime;
+	m_pairCount += 1;
+	refit();
+	return true;
+}
+
+///////////////////////////////////////////
+
+// Fits y = a + b * x, where x is camera time and y is how far XrTime is ahead of camera
+// time, both relative to the newest pair. Fitting the difference keeps b down in the parts
+// per million, instead of next to 1.
+void ClockMapper::refit() {
+	const uint32_t count  = m_pairCount < windowCapacity ? (uint32_t)m_pairCount : windowCapacity;
+	const uint32_t newest = (uint32_t)((m_pairCount - 1) % windowCapacity);
+	const uint64_t cameraOrigin = m_cameraTimes[newest];
+	const XrTime   xrOrigin     = m_xrTimes[newest];
+
+	double x[windowCapacity] = {}, y[windowCapacity] = {}, residuals[windowCapacity] = {};
+	bool   inlier[windowCapacity] = {};
+	for (uint32_t i = 0; i < count; i++) {
+		double cameraDelta = -(double)(cameraOrigin - m_cameraTimes[i]);
+		double xrDelta     = -(double)(xrOrigin - m_xrTimes[i]);
+		x[i]      = cameraDelta;
+		y[i]      = xrDelta - cameraDelta;
+		inlier[i] = true;
+	}
+
+	double   a, b;
+	uint32_t inliers = count;
+	fitLine(x, y, inlier, count, &a, &b);
+	for (int32_t pass = 0; pass < 3 && count >= 3; pass++) {
+		// Judge every pair against the median absolute deviation from the line, so pairs
+		// dropped by an earlier pass can come back in
+		double deviations[windowCapacity];
+		for (uint32_t i = 0; i < count; i++)
+			residuals[i] = y[i] - (a + b * x[i]);
+		for (uint32_t i = 0; i < count; i++)
+			deviations[i] = residuals[i];
+		double center = median(deviations, count);
+		for (uint32_t i = 0; i < count; i++)
+			deviations[i] = std::fabs(residuals[i] - center);
+		double threshold = std::max(outlierDeviations * 1.4826 * median(deviations, count), minOutlierThreshold);
+
+		uint32_t kept    = 0;
+		bool     changed = false;
+		bool     keep[windowCapacity];
+		for (uint32_t i = 0; i < count; i++) {
+			keep[i]  = std::fabs(residuals[i] - center) <= threshold;
+			changed |= keep[i] != inlier[i];
+			kept    += keep[i] ? 1 : 0;
+		}
+		// Never fit to fewer than two pairs, the line would mean nothing
+		if (!changed || kept < 2)
+			break;
+		for (uint32_t i = 0; i < count; i++)
+			inlier[i] = keep[i];
+		inliers = kept;
+		fitLine(x, y, inlier, count, &a, &b);
+	}
+
+	// The fit is a + b * x ahead of camera time, so at the origin XrTime is xrOrigin + a
+	m_fit.cameraOrigin = cameraOrigin;
+	m_fit.xrOrigin     = xrOrigin + (XrTime)std::llround(a);
+	m_fit.slope        = 1.0 + b;
+
+	double sumSquares = 0, maxResidual = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		if (!inlier[i]) continue;
+		double residual = std::fabs(y[i] - (a + b * x[i]));
+		sumSquares += residual * residual;
+		maxResidual = std::max(maxResidual, residual);
+	}
+	m_stats.pairs       = m_pairCount;
+	m_stats.windowSize  = count;
+	m_stats.inliers     = inliers;
+	m_stats.offset      = (double)(m_fit.xrOrigin - (XrTime)cameraOrigin);
+	m_stats.driftPpm    = b * 1e6;
+	m_stats.rmsResidual = std::sqrt(sumSquares / inliers);
+	m_stats.maxResidual = maxResidual;
+}
+
+///////////////////////////////////////////
+
+bool ClockMapper::isValid() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_pairCount > 0;
+}
+
+XrTime ClockMapper::toXrTime(uint64_t cameraTime) const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	double delta = cameraTime >= m_fit.cameraOrigin
+		?  (double)(cameraTime - m_fit.cameraOrigin)
+		: -(double)(m_fit.cameraOrigin - cameraTime);
+	return m_fit.xrOrigin + (XrTime)std::llround(delta * m_fit.slope);
+}
+
+uint64_t ClockMapper::toCameraTime(XrTime xrTime) const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	int64_t delta = (int64_t)std::llround((double)(xrTime - m_fit.xrOrigin) / m_fit.slope);
+	return m_fit.cameraOrigin + (uint64_t)delta;
+}
+
+ClockMapperStats ClockMapper::getStats() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <openxr/openxr.h>
+#include <mutex>
+#include <stdint.h>
+
+namespace TestApp
+{
+	// How well the current fit explains the pairs it was made from.
+	struct ClockMapperStats {
+		uint64_t pairs;         // Pairs added since the last reset
+		uint32_t windowSize;    // Pairs in the window the fit came from
+		uint32_t inliers;       // Of those, the ones the fit kept
+		double   offset;        // XrTime minus camera time at the newest pair, in nanoseconds
+		double   driftPpm;      // How much faster the XrTime clock runs, in parts per million
+		double   rmsResidual;   // Over the inliers, in nanoseconds
+		double   maxResidual;   // Largest absolute residual over the inliers, in nanoseconds
+	};
+
+	///////////////////////////////////////////
+
+	// Maps between the camera's clock (CameraFrame::timestamp, nanoseconds) and XrTime.
+	// Both count nanoseconds, but from different origins, and two oscillators never quite
+	// agree on the length of a second, so a fixed offset drifts by milliseconds over a long
+	// session. This fits xr = offset + slope * camera over a sliding window of pairs instead.
+	//
+	// A pair is both clocks read at the same moment, e.g. the steady clock next to
+	// xrConvertWin32PerformanceCounterToTimeKHR. Reads are never quite simultaneous, and a
+	// thread can get preempted between the two, so the fit is done by least squares, and
+	// then again without the pairs that sit more than a few median absolute deviations off
+	// the line. Pairs can come in at any rate, once a second is plenty.
+	//
+	// Converting takes the lock, but is otherwise a multiply and an add either way, so
+	// it's fine to do for every frame. Until there's a pair, times go through unchanged, and
+	// until there are two, the slope is 1.
+	class ClockMapper final {
+
+	public:
+		static const uint32_t windowCapacity = 64;
+
+		ClockMapper();
+
+		// Adds a pair and refits. Pairs must come in order; one that doesn't is ignored.
+		bool addPair(uint64_t cameraTime, XrTime xrTime);
+		void reset();
+
+		bool     isValid() const;
+		XrTime   toXrTime(uint64_t cameraTime) const;
+		uint64_t toCameraTime(XrTime xrTime) const;
+
+		ClockMapperStats getStats() const;
+
+	private:
+		void refit();
+
+		// The fit is kept relative to the newest pair, so deltas stay small enough for a
+		// double to hold them to well under a nanosecond.
+		struct Fit {
+			uint64_t cameraOrigin;
+			XrTime   xrOrigin;
+			double   slope;
+		};
+
+		mutable std::mutex m_mutex;
+		uint64_t           m_cameraTimes[windowCapacity];
+		XrTime             m_xrTimes[windowCapacity];
+		uint64_t           m_pairCount;
+		Fit                m_fit;
+		ClockMapperStats   m_stats;
+	};
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "../VuforiaEngine/Driver/Driver.h"
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace TestApp
+{
+	const uint32_t frameBufferAlignment = 4096; // Page aligned, so buffers can be handed to DMA or mapped as is
+	const uint32_t frameStrideAlignment = 64;   // Rows start on a cache line
+
+	// Bytes between rows, for the first plane of a frame in this mode.
+	inline uint32_t getFrameStride(const VuforiaDriver::CameraMode& mode) {
+		uint32_t rowBytes = 0;
+		switch (mode.format) {
+		case VuforiaDriver::PixelFormat::YUYV:     rowBytes = mode.width * 2; break;
+		case VuforiaDriver::PixelFormat::NV12:
+		case VuforiaDriver::PixelFormat::NV21:     rowBytes = mode.width;     break;
+		case VuforiaDriver::PixelFormat::RGB888:   rowBytes = mode.width * 3; break;
+		case VuforiaDriver::PixelFormat::RGBA8888: rowBytes = mode.width * 4; break;
+		default: return 0;
+		}
+		return (rowBytes + frameStrideAlignment - 1) & ~(frameStrideAlignment - 1);
+	}
+
+	// Bytes a whole frame takes, every plane included. The interleaved chroma plane of the
+	// 4:2:0 formats follows the luma plane, with the same stride.
+	inline uint32_t getFrameSize(const VuforiaDriver::CameraMode& mode) {
+		uint32_t stride = getFrameStride(mode);
+		if (mode.format == VuforiaDriver::PixelFormat::NV12 || mode.format == VuforiaDriver::PixelFormat::NV21)
+			return stride * mode.height + stride * ((mode.height + 1) / 2);
+		return stride * mode.height;
+	}
+
+	struct FrameBufferPoolStats {
+		uint64_t allocations; // Buffers allocated by configure(), over the pool's lifetime
+		uint64_t acquired;
+		uint64_t exhausted;   // Acquires that came back empty, because every buffer was in use
+		uint32_t inUse;
+		uint32_t highWater;   // Most buffers ever in use at once
+	};
+
+	///////////////////////////////////////////
+
+	// Page aligned frame buffers for a camera, sized from its CameraMode, so capture doesn't
+	// allocate 4 MB every frame at 1080p. Every buffer gets allocated by configure(), before
+	// capture starts, and capture itself never allocates: when they're all in use, acquire()
+	// comes back empty and the frame is skipped.
+	//
+	// Capture acquires a buffer and fills it, and whoever last holds the frame releases it:
+	// the delivery thread once onNewCameraFrame returns (the engine copies what it keeps
+	// before then), or capture itself if the frame gets dropped. Both can happen on
+	// different threads.
+	class FrameBufferPool {
+
+	public:
+		FrameBufferPool() : m_bufferSize(0), m_stride(0), m_allocations(0), m_acquired(0), m_exhausted(0), m_inUse(0), m_highWater(0) {}
+		~FrameBufferPool() {
+			for (Block& block : m_blocks)
+				freeBuffer(block.data);
+		}
+
+		FrameBufferPool(const FrameBufferPool&) = delete;
+		FrameBufferPool& operator=(const FrameBufferPool&) = delete;
+
+		///////////////////////////////////////////
+
+		// Allocates maxBuffers buffers sized for mode. Free buffers of another size are let go
+		// right away, and those still in use when they come back. Returns false for a mode with
+		// no known layout, or if the buffers couldn't be allocated.
+		bool configure(const VuforiaDriver::CameraMode& mode, uint32_t maxBuffers) {
+			return configure(getFrameSize(mode), getFrameStride(mode), maxBuffers);
+		}
+
+		// Same, for buffers that aren't camera frames, with their own size and stride.
+		bool configure(uint32_t size, uint32_t stride, uint32_t maxBuffers) {
+			if (size == 0 || maxBuffers == 0)
+				return false;
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stride = stride;
+			if (size != m_bufferSize) {
+				m_bufferSize = size;
+				for (Block& block : m_blocks)
+					block.retired = true;
+			}
+
+			// Let go of what's free and no longer wanted, then top up to maxBuffers
+			uint32_t current = 0;
+			for (size_t i = 0; i < m_blocks.size(); ) {
+				Block& block = m_blocks[i];
+				if (!block.inUse && (block.retired || current >= maxBuffers)) {
+					freeBuffer(block.data);
+					block = m_blocks.back();
+					m_blocks.pop_back();
+					continue;
+				}
+				if (!block.retired)
+					current++;
+				i++;
+			}
+			m_blocks.reserve(m_blocks.size() + (maxBuffers - (current < maxBuffers ? current : maxBuffers)));
+			for (; current < maxBuffers; current++) {
+				Block block;
+				block.data    = static_cast<uint8_t*>(::operator new(m_bufferSize, std::align_val_t(frameBufferAlignment), std::nothrow));
+				block.inUse   = false;
+				block.retired = false;
+				if (block.data == nullptr)
+					return false;
+				m_allocations++;
+				m_blocks.push_back(block);
+			}
+			return true;
+		}
+
+		// A buffer of getBufferSize() bytes, or nullptr if they're all in use.
+		uint8_t* acquire() {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_acquired++;
+
+			for (Block& block : m_blocks) {
+				if (block.inUse || block.retired)
+					continue;
+				block.inUse = true;
+				m_inUse++;
+				if (m_inUse > m_highWater)
+					m_highWater = m_inUse;
+				return block.data;
+			}
+			m_exhausted++;
+			return nullptr;
+		}
+
+		// Hands a buffer from acquire() back. Anything else is ignored.
+		void release(const uint8_t* buffer) {
+			if (buffer == nullptr)
+				return;
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (size_t i = 0; i < m_blocks.size(); i++) {
+				Block& block = m_blocks[i];
+				if (block.data != buffer || !block.inUse)
+					continue;
+
+				m_inUse--;
+				block.inUse = false;
+				if (block.retired) {
+					freeBuffer(block.data);
+					m_blocks[i] = m_blocks.back();
+					m_blocks.pop_back();
+				}
+				return;
+			}
+		}
+
+		///////////////////////////////////////////
+
+		uint32_t getBufferSize() const { return m_bufferSize; }
+		uint32_t getStride() const     { return m_stride; }
+
+		FrameBufferPoolStats getStats() {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			FrameBufferPoolStats stats;
+			stats.allocations = m_allocations;
+			stats.acquired    = m_acquired;
+			stats.exhausted   = m_exhausted;
+			stats.inUse       = m_inUse;
+			stats.highWater   = m_highWater;
+			return stats;
+		}
+
+	private:
+		struct Block {
+			uint8_t* data;
+			bool     inUse;
+			bool     retired; // From an older configure(), freed once it comes back
+		};
+
+		static void freeBuffer(uint8_t* data) {
+			::operator delete(data, std::align_val_t(frameBufferAlignment));
+		}
+
+		std::mutex         m_mutex;
+		std::vector<Block> m_blocks;
+		uint32_t           m_bufferSize;
+		uint32_t           m_stride;
+
+		uint64_t           m_allocations;
+		uint64_t           m_acquired;
+		uint64_t           m_exhausted;
+		uint32_t           m_inUse;
+		uint32_t           m_highWater;
+	};
+}
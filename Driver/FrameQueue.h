@@ -0,0 +1,255 @@
+#pragma once
+
+#include "../VuforiaEngine/Driver/Driver.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace TestApp
+{
+	// What the producer does when the queue is full.
+	enum class FrameDropPolicy {
+		DropOldest, // Replace the oldest queued frame, so the consumer always gets the freshest ones
+		DropNewest, // Discard the incoming frame, so the consumer sees an unbroken but stale sequence
+		Block,      // Wait for the consumer to make room. The only policy that can stall the producer.
+	};
+
+	enum class FramePushResult {
+		Queued,
+		QueuedDroppedOldest, // Queued, and the oldest frame came back out through `dropped`
+		DroppedNewest,       // Not queued, the caller still owns the frame
+		Closed,
+	};
+
+	struct QueuedFrame {
+		VuforiaDriver::CameraFrame frame;
+		uint64_t                   queuedTime; // Steady clock nanoseconds, when it went in
+	};
+
+	struct FrameQueueCounters {
+		uint64_t pushed;
+		uint64_t delivered;
+		uint64_t droppedOldest;
+		uint64_t droppedNewest;
+		uint32_t depth;            // Frames waiting right now
+		uint32_t maxDepth;
+		uint64_t totalLatency;     // Nanoseconds between push and pop, summed over delivered frames
+		uint64_t maxLatency;
+	};
+
+	// Told about every frame a camera delivers, on the delivery thread, just before the engine
+	// gets it. Lets the driver's other parts, like its pose tracker, follow the camera.
+	class CameraFrameObserver {
+	public:
+		virtual void onCameraFrame(const VuforiaDriver::CameraFrame& frame) = 0;
+
+	protected:
+		~CameraFrameObserver() {}
+	};
+
+	inline uint64_t frameQueueNow() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	///////////////////////////////////////////
+
+	// Bounded single-producer / single-consumer ring between a camera's capture thread and
+	// the thread that hands frames to the engine, so a slow consumer can't back up capture.
+	// Only the frame descriptions are queued; buffers stay where the producer put them.
+	//
+	// Every slot carries a sequence number (as in Vyukov's bounded queue): a slot at ring
+	// position p is free for the producer when its sequence is p, and ready for the
+	// consumer when it's p + 1. The consumer claims a frame by advancing the read position
+	// with a compare-exchange, which is also how the producer drops the oldest frame. So
+	// under DropOldest and DropNewest, push never waits on the consumer. In the rare case
+	// where the consumer is still copying the slot the producer wants, the incoming frame is
+	// dropped rather than waiting for it.
+	class FrameQueue {
+
+	public:
+		// capacity is rounded up to a power of two.
+		FrameQueue(uint32_t capacity, FrameDropPolicy policy) :
+			m_policy(policy),
+			m_mask(roundUpToPowerOfTwo(capacity) - 1),
+			m_slots(m_mask + 1),
+			m_write(0),
+			m_read(0),
+			m_closed(false),
+			m_consumerWaiting(false),
+			m_pushed(0), m_delivered(0), m_droppedOldest(0), m_droppedNewest(0),
+			m_maxDepth(0), m_totalLatency(0), m_maxLatency(0) {
+			for (uint32_t i = 0; i <= m_mask; i++)
+				m_slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		FrameQueue(const FrameQueue&) = delete;
+		FrameQueue& operator=(const FrameQueue&) = delete;
+
+		///////////////////////////////////////////
+
+		// Producer side. When the oldest frame is dropped to make room, it comes back through
+		// dropped, so its buffer can be recycled.
+		FramePushResult push(const VuforiaDriver::CameraFrame& frame, QueuedFrame* dropped = nullptr) {
+			if (m_closed.load(std::memory_order_acquire))
+				return FramePushResult::Closed;
+
+			uint64_t position = m_write;
+			Slot&    slot     = m_slots[position & m_mask];
+			FramePushResult result = FramePushResult::Queued;
+
+			if (slot.sequence.load(std::memory_order_acquire) != position) {
+				if (m_policy == FrameDropPolicy::Block) {
+					while (slot.sequence.load(std::memory_order_acquire) != position) {
+						if (m_closed.load(std::memory_order_acquire))
+							return FramePushResult::Closed;
+						std::this_thread::yield();
+					}
+				} else if (m_policy == FrameDropPolicy::DropOldest && dropOldest(position, dropped)) {
+					result = FramePushResult::QueuedDroppedOldest;
+				} else {
+					m_droppedNewest.fetch_add(1, std::memory_order_relaxed);
+					return FramePushResult::DroppedNewest;
+				}
+			}
+
+			slot.item.frame      = frame;
+			slot.item.queuedTime = frameQueueNow();
+			slot.sequence.store(position + 1, std::memory_order_release);
+			m_write = position + 1;
+			m_pushed.fetch_add(1, std::memory_order_relaxed);
+
+			uint32_t depth = static_cast<uint32_t>(position + 1 - m_read.load(std::memory_order_relaxed));
+			if (depth > m_maxDepth.load(std::memory_order_relaxed))
+				m_maxDepth.store(depth, std::memory_order_relaxed);
+
+			// Only pay for a wakeup when the consumer is actually asleep
+			if (m_consumerWaiting.load(std::memory_order_seq_cst))
+				m_readyCondition.notify_one();
+			return result;
+		}
+
+		///////////////////////////////////////////
+
+		// Consumer side. Returns false right away if nothing is queued.
+		bool tryPop(QueuedFrame& out) {
+			for (;;) {
+				uint64_t position = m_read.load(std::memory_order_acquire);
+				Slot&    slot     = m_slots[position & m_mask];
+				if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+					// Either nothing is queued, or the producer dropped this frame and reused its slot
+					if (m_read.load(std::memory_order_acquire) == position)
+						return false;
+					continue;
+				}
+
+				// The producer may have dropped this frame in the meantime, in which case try the next one
+				if (!m_read.compare_exchange_weak(position, position + 1, std::memory_order_acq_rel))
+					continue;
+
+				out = slot.item;
+				slot.sequence.store(position + m_mask + 1, std::memory_order_release);
+
+				uint64_t latency = frameQueueNow() - out.queuedTime;
+				m_delivered.fetch_add(1, std::memory_order_relaxed);
+				m_totalLatency.fetch_add(latency, std::memory_order_relaxed);
+				if (latency > m_maxLatency.load(std::memory_order_relaxed))
+					m_maxLatency.store(latency, std::memory_order_relaxed);
+				return true;
+			}
+		}
+
+		// Waits up to timeout for a frame. Returns false on timeout, or once the queue is closed
+		// and empty.
+		bool pop(QueuedFrame& out, std::chrono::milliseconds timeout) {
+			auto deadline = std::chrono::steady_clock::now() + timeout;
+			while (!tryPop(out)) {
+				if (m_closed.load(std::memory_order_acquire) || std::chrono::steady_clock::now() >= deadline)
+					return false;
+
+				// The producer notifies without taking the lock, so a wakeup can slip between the
+				// check and the wait; the short wait bounds how long that can delay a frame.
+				std::unique_lock<std::mutex> lock(m_waitMutex);
+				m_consumerWaiting.store(true, std::memory_order_seq_cst);
+				m_readyCondition.wait_for(lock, std::chrono::milliseconds(1));
+				m_consumerWaiting.store(false, std::memory_order_relaxed);
+			}
+			return true;
+		}
+
+		///////////////////////////////////////////
+
+		// Wakes both sides up for good. Frames still queued can be drained with tryPop.
+		void close() {
+			m_closed.store(true, std::memory_order_release);
+			m_readyCondition.notify_all();
+		}
+
+		FrameQueueCounters getCounters() const {
+			FrameQueueCounters counters;
+			counters.pushed        = m_pushed.load(std::memory_order_relaxed);
+			counters.delivered     = m_delivered.load(std::memory_order_relaxed);
+			counters.droppedOldest = m_droppedOldest.load(std::memory_order_relaxed);
+			counters.droppedNewest = m_droppedNewest.load(std::memory_order_relaxed);
+			counters.depth         = static_cast<uint32_t>(counters.pushed - counters.delivered - counters.droppedOldest);
+			counters.maxDepth      = m_maxDepth.load(std::memory_order_relaxed);
+			counters.totalLatency  = m_totalLatency.load(std::memory_order_relaxed);
+			counters.maxLatency    = m_maxLatency.load(std::memory_order_relaxed);
+			return counters;
+		}
+
+		uint32_t        getCapacity() const { return m_mask + 1; }
+		FrameDropPolicy getPolicy() const   { return m_policy; }
+
+	private:
+		struct Slot {
+			std::atomic<uint64_t> sequence;
+			QueuedFrame           item;
+
+			Slot() : sequence(0), item() {}
+		};
+
+		static uint32_t roundUpToPowerOfTwo(uint32_t value) {
+			uint32_t size = 1;
+			while (size < value)
+				size <<= 1;
+			return size;
+		}
+
+		// Claims the oldest queued frame, if the consumer hasn't already, so its slot can take the
+		// frame at position. Returns false if the slot is still busy.
+		bool dropOldest(uint64_t position, QueuedFrame* dropped) {
+			uint64_t oldest = position - (m_mask + 1);
+			uint64_t read   = oldest;
+			if (!m_read.compare_exchange_strong(read, oldest + 1, std::memory_order_acq_rel))
+				return false;
+
+			// The slot at oldest is the one at position, and it's now the producer's
+			if (dropped != nullptr)
+				*dropped = m_slots[position & m_mask].item;
+			m_droppedOldest.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		FrameDropPolicy         m_policy;
+		uint32_t                m_mask;
+		std::vector<Slot>       m_slots;
+		uint64_t                m_write; // Only touched by the producer
+		std::atomic<uint64_t>   m_read;
+		std::atomic<bool>       m_closed;
+
+		std::atomic<bool>       m_consumerWaiting;
+		std::mutex              m_waitMutex;
+		std::condition_variable m_readyCondition;
+
+		std::atomic<uint64_t>   m_pushed;
+		std::atomic<uint64_t>   m_delivered;
+		std::atomic<uint64_t>   m_droppedOldest;
+		std::atomic<uint64_t>   m_droppedNewest;
+		std::atomic<uint32_t>   m_maxDepth;
+		std::atomic<uint64_t>   m_totalLatency;
+		std::atomic<uint64_t>   m_maxLatency;
+	};
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "../VuforiaEngine/Driver/Driver.h"
+#include "../Common/MappedFile.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace TestApp
+{
+	// On-disk layout of a recorded camera stream, little-endian:
+	//   header, frame pixels (each starting on a c_frameRecordingAlignment boundary), frame index.
+	// Pixels are aligned to a page so a mapped frame can be handed to the engine as is.
+	const uint32_t c_frameRecordingMagic = 0x43524656; // "VFRC"
+	const uint32_t c_frameRecordingVersion = 1;
+	const uint32_t c_frameRecordingAlignment = 4096;
+
+	struct FrameRecordingHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t frameCount;
+		uint32_t stride;
+		uint32_t width;
+		uint32_t height;
+		uint32_t fps;
+		int32_t  format;      // VuforiaDriver::PixelFormat
+		uint64_t indexOffset; // Where the FrameRecordingEntry array starts
+		uint64_t fileSize;
+	};
+
+	struct FrameRecordingEntry {
+		uint64_t timestamp;    // End of exposure, in nanoseconds on the recording clock
+		uint64_t exposureTime; // Nanoseconds
+		uint64_t offset;       // Of the pixels, from the start of the file
+		uint32_t size;         // Of the pixels, in bytes
+		uint32_t reserved;
+		VuforiaDriver::CameraIntrinsics intrinsics; // Per frame, since focus and zoom can change them
+	};
+
+	static_assert(sizeof(FrameRecordingHeader) == 48, "The header is part of the file format");
+	static_assert(sizeof(FrameRecordingEntry) == 80, "Index entries are part of the file format");
+
+	///////////////////////////////////////////
+
+	// A recording opened with a single memory mapping. Frame pixels are read in place.
+	class FrameRecording {
+
+	public:
+		// Returns nullptr if the file can't be mapped, or isn't a valid recording.
+		static std::shared_ptr<FrameRecording> open(const std::wstring& path) {
+			uint32_t error = 0;
+			std::shared_ptr<DX::MappedFile> file = DX::MappedFile::Open(path, error);
+			if (file == nullptr)
+				return nullptr;
+
+			std::shared_ptr<FrameRecording> recording(new FrameRecording(file));
+			if (!recording->validate())
+				return nullptr;
+			return recording;
+		}
+
+		uint32_t getFrameCount() const { return m_header.frameCount; }
+		uint32_t getStride() const     { return m_header.stride; }
+
+		VuforiaDriver::CameraMode getMode() const {
+			VuforiaDriver::CameraMode mode;
+			mode.width  = m_header.width;
+			mode.height = m_header.height;
+			mode.fps    = m_header.fps;
+			mode.format = static_cast<VuforiaDriver::PixelFormat>(m_header.format);
+			return mode;
+		}
+
+		FrameRecordingEntry getEntry(uint32_t index) const {
+			FrameRecordingEntry entry;
+			memcpy(&entry, m_file->GetData() + m_header.indexOffset + uint64_t(index) * sizeof(entry), sizeof(entry));
+			return entry;
+		}
+
+		const uint8_t* getPixels(const FrameRecordingEntry& entry) const {
+			return m_file->GetData() + entry.offset;
+		}
+
+	private:
+		explicit FrameRecording(std::shared_ptr<DX::MappedFile> file) : m_file(std::move(file)), m_header() {}
+
+		bool validate() {
+			uint64_t size = m_file->GetSize();
+			if (size < sizeof(m_header))
+				return false;
+			memcpy(&m_header, m_file->GetData(), sizeof(m_header));
+			if (m_header.magic != c_frameRecordingMagic || m_header.version != c_frameRecordingVersion ||
+				m_header.fileSize != size || m_header.frameCount == 0 || m_header.indexOffset > size ||
+				m_header.frameCount > (size - m_header.indexOffset) / sizeof(FrameRecordingEntry))
+				return false;
+
+			uint64_t previous = 0;
+			for (uint32_t i = 0; i < m_header.frameCount; i++) {
+				FrameRecordingEntry entry = getEntry(i);
+				if (entry.offset > size || entry.size > size - entry.offset || (i > 0 && entry.timestamp < previous))
+					return false;
+				previous = entry.timestamp;
+			}
+			return true;
+		}
+
+		std::shared_ptr<DX::MappedFile> m_file;
+		FrameRecordingHeader            m_header;
+	};
+
+	///////////////////////////////////////////
+
+	// Writes a recording one frame at a time. Used by capture tools, and to make synthetic
+	// recordings for benchmarks.
+	class FrameRecordingWriter {
+
+	public:
+		FrameRecordingWriter() : m_file(nullptr), m_header(), m_offset(0) {}
+		~FrameRecordingWriter() { if (m_file != nullptr) fclose(m_file); }
+
+		FrameRecordingWriter(const FrameRecordingWriter&) = delete;
+		FrameRecordingWriter& operator=(const FrameRecordingWriter&) = delete;
+
+		bool open(const std::wstring& path, const VuforiaDriver::CameraMode& mode, uint32_t stride) {
+#if defined(_WIN32)
+			if (_wfopen_s(&m_file, path.c_str(), L"wb") != 0)
+				m_file = nullptr;
+#else
+			m_file = fopen(DX::WideToUtf8(path).c_str(), "wb");
+#endif
+			if (m_file == nullptr)
+				return false;
+
+			m_header         = {};
+			m_header.magic   = c_frameRecordingMagic;
+			m_header.version = c_frameRecordingVersion;
+			m_header.stride  = stride;
+			m_header.width   = mode.width;
+			m_header.height  = mode.height;
+			m_header.fps     = mode.fps;
+			m_header.format  = static_cast<int32_t>(mode.format);
+			m_entries.clear();
+
+			// The real header goes in once the index is written
+			m_offset = 0;
+			return write(&m_header, sizeof(m_header));
+		}
+
+		bool addFrame(uint64_t timestamp, uint64_t exposureTime, const VuforiaDriver::CameraIntrinsics& intrinsics, const uint8_t* pixels, uint32_t size) {
+			if (m_file == nullptr || !pad(c_frameRecordingAlignment))
+				return false;
+
+			FrameRecordingEntry entry = {};
+			entry.timestamp    = timestamp;
+			entry.exposureTime = exposureTime;
+			entry.offset       = m_offset;
+			entry.size         = size;
+			entry.intrinsics   = intrinsics;
+			m_entries.push_back(entry);
+			return write(pixels, size);
+		}
+
+		bool finish() {
+			if (m_file == nullptr || !pad(sizeof(uint64_t)))
+				return false;
+
+			m_header.frameCount  = static_cast<uint32_t>(m_entries.size());
+			m_header.indexOffset = m_offset;
+			m_header.fileSize    = m_offset + m_entries.size() * sizeof(FrameRecordingEntry);
+			bool ok = write(m_entries.data(), m_entries.size() * sizeof(FrameRecordingEntry)) &&
+				fseek(m_file, 0, SEEK_SET) == 0 &&
+				fwrite(&m_header, sizeof(m_header), 1, m_file) == 1;
+			ok = fclose(m_file) == 0 && ok;
+			m_file = nullptr;
+			return ok;
+		}
+
+	private:
+		bool write(const void* data, size_t size) {
+			if (size > 0 && fwrite(data, 1, size, m_file) != size)
+				return false;
+			m_offset += size;
+			return true;
+		}
+
+		bool pad(uint64_t alignment) {
+			static const uint8_t zeros[c_frameRecordingAlignment] = {};
+			uint64_t padding = (alignment - m_offset % alignment) % alignment;
+			return write(zeros, static_cast<size_t>(padding));
+		}
+
+		FILE*                            m_file;
+		FrameRecordingHeader             m_header;
+		std::vector<FrameRecordingEntry> m_entries;
+		uint64_t                         m_offset;
+	};
+}
@@ -0,0 +1,424 @@
+#include "ImagePyramid.h"
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define IMAGE_PYRAMID_X86
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#define IMAGE_PYRAMID_AVX2
+	#else
+		#define IMAGE_PYRAMID_AVX2 __attribute__((target("avx2")))
+	#endif
+#elif defined(_M_ARM) || defined(_M_ARM64) || defined(__ARM_NEON)
+	#define IMAGE_PYRAMID_NEON
+	#include <arm_neon.h>
+#endif
+
+using namespace TestApp;
+using namespace VuforiaDriver;
+
+// Level 0 rows are copied out of the frame this many at a time, few enough that the levels
+// below get made from them while they're still in cache.
+const uint32_t pyramidStripRows = 16;
+
+///////////////////////////////////////////
+// Scalar reference kernels
+///////////////////////////////////////////
+
+static void boxRowScalar(const uint8_t* src0, const uint8_t* src1, uint8_t* dst, uint32_t width) {
+	for (uint32_t x = 0; x < width; x++)
+		dst[x] = static_cast<uint8_t>((src0[x * 2] + src0[x * 2 + 1] + src1[x * 2] + src1[x * 2 + 1] + 2) >> 2);
+}
+
+// Sums of up to 16 * 255, which a uint16_t holds with room to spare for the row pass.
+static void gaussianColumnsScalar(const uint8_t* const* rows, uint16_t* dst, uint32_t width) {
+	for (uint32_t x = 0; x < width; x++)
+		dst[x] = static_cast<uint16_t>(rows[0][x] + rows[4][x] + 4 * (rows[1][x] + rows[3][x]) + 6 * rows[2][x]);
+}
+
+static inline uint8_t gaussianPixel(const uint16_t* src, uint32_t srcWidth, uint32_t center) {
+	auto at = [&](int32_t x) { return src[x < 0 ? 0 : x >= (int32_t)srcWidth ? srcWidth - 1 : x]; };
+	int32_t c   = static_cast<int32_t>(center);
+	int32_t sum = at(c - 2) + at(c + 2) + 4 * (at(c - 1) + at(c + 1)) + 6 * at(c);
+	return static_cast<uint8_t>((sum + 128) >> 8);
+}
+
+static void gaussianRowScalar(const uint16_t* src, uint32_t srcWidth, uint8_t* dst, uint32_t width) {
+	for (uint32_t x = 0; x < width; x++)
+		dst[x] = gaussianPixel(src, srcWidth, x * 2);
+}
+
+///////////////////////////////////////////
+// SSE2 and AVX2 kernels
+///////////////////////////////////////////
+
+#ifdef IMAGE_PYRAMID_X86
+
+// Adds each byte pair into a 16 bit lane.
+static inline __m128i sumBytePairs(__m128i value) {
+	return _mm_add_epi16(_mm_and_si128(value, _mm_set1_epi16(0x00FF)), _mm_srli_epi16(value, 8));
+}
+
+static void boxRowSse2(const uint8_t* src0, const uint8_t* src1, uint8_t* dst, uint32_t width) {
+	const __m128i two = _mm_set1_epi16(2);
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m128i low  = _mm_add_epi16(sumBytePairs(_mm_loadu_si128((const __m128i*)(src0 + x * 2))),      sumBytePairs(_mm_loadu_si128((const __m128i*)(src1 + x * 2))));
+		__m128i high = _mm_add_epi16(sumBytePairs(_mm_loadu_si128((const __m128i*)(src0 + x * 2 + 16))), sumBytePairs(_mm_loadu_si128((const __m128i*)(src1 + x * 2 + 16))));
+		low  = _mm_srli_epi16(_mm_add_epi16(low, two), 2);
+		high = _mm_srli_epi16(_mm_add_epi16(high, two), 2);
+		_mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(low, high));
+	}
+	boxRowScalar(src0 + x * 2, src1 + x * 2, dst + x, width - x);
+}
+
+static inline __m128i gaussianColumns8(__m128i r0, __m128i r1, __m128i r2, __m128i r3, __m128i r4) {
+	__m128i sum = _mm_add_epi16(_mm_add_epi16(r0, r4), _mm_slli_epi16(_mm_add_epi16(r1, r3), 2));
+	return _mm_add_epi16(sum, _mm_add_epi16(_mm_slli_epi16(r2, 2), _mm_slli_epi16(r2, 1)));
+}
+
+static void gaussianColumnsSse2(const uint8_t* const* rows, uint16_t* dst, uint32_t width) {
+	const __m128i zero = _mm_setzero_si128();
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m128i r[5];
+		for (int32_t i = 0; i < 5; i++)
+			r[i] = _mm_loadu_si128((const __m128i*)(rows[i] + x));
+		_mm_storeu_si128((__m128i*)(dst + x), gaussianColumns8(
+			_mm_unpacklo_epi8(r[0], zero), _mm_unpacklo_epi8(r[1], zero), _mm_unpacklo_epi8(r[2], zero), _mm_unpacklo_epi8(r[3], zero), _mm_unpacklo_epi8(r[4], zero)));
+		_mm_storeu_si128((__m128i*)(dst + x + 8), gaussianColumns8(
+			_mm_unpackhi_epi8(r[0], zero), _mm_unpackhi_epi8(r[1], zero), _mm_unpackhi_epi8(r[2], zero), _mm_unpackhi_epi8(r[3], zero), _mm_unpackhi_epi8(r[4], zero)));
+	}
+	const uint8_t* rest[5] = { rows[0] + x, rows[1] + x, rows[2] + x, rows[3] + x, rows[4] + x };
+	gaussianColumnsScalar(rest, dst + x, width - x);
+}
+
+// The 1 4 6 4 1 filter at every one of 8 column sums, rounded down to 8 bits. Only the even
+// ones are wanted, but filtering them all is cheaper than pulling the even ones apart first.
+static inline __m128i gaussianRow8(const uint16_t* src) {
+	__m128i outer  = _mm_add_epi16(_mm_loadu_si128((const __m128i*)(src - 2)), _mm_loadu_si128((const __m128i*)(src + 2)));
+	__m128i inner  = _mm_add_epi16(_mm_loadu_si128((const __m128i*)(src - 1)), _mm_loadu_si128((const __m128i*)(src + 1)));
+	__m128i center = _mm_loadu_si128((const __m128i*)src);
+	__m128i sum    = _mm_add_epi16(_mm_add_epi16(outer, _mm_slli_epi16(inner, 2)), _mm_add_epi16(_mm_slli_epi16(center, 2), _mm_slli_epi16(center, 1)));
+	return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(128)), 8);
+}
+
+static void gaussianRowSse2(const uint16_t* src, uint32_t srcWidth, uint8_t* dst, uint32_t width) {
+	const __m128i even = _mm_set1_epi32(0xFFFF);
+	if (width == 0)
+		return;
+	dst[0] = gaussianPixel(src, srcWidth, 0); // Reaches past the left edge
+	uint32_t x = 1;
+	for (; x + 8 <= width && x * 2 + 18 <= srcWidth; x += 8) {
+		__m128i low  = _mm_and_si128(gaussianRow8(src + x * 2), even);
+		__m128i high = _mm_and_si128(gaussianRow8(src + x * 2 + 8), even);
+		__m128i words = _mm_packs_epi32(low, high);
+		_mm_storel_epi64((__m128i*)(dst + x), _mm_packus_epi16(words, words));
+	}
+	for (; x < width; x++)
+		dst[x] = gaussianPixel(src, srcWidth, x * 2);
+}
+
+IMAGE_PYRAMID_AVX2 static inline __m256i sumBytePairsAvx2(__m256i value) {
+	return _mm256_add_epi16(_mm256_and_si256(value, _mm256_set1_epi16(0x00FF)), _mm256_srli_epi16(value, 8));
+}
+
+IMAGE_PYRAMID_AVX2 static void boxRowAvx2(const uint8_t* src0, const uint8_t* src1, uint8_t* dst, uint32_t width) {
+	const __m256i two = _mm256_set1_epi16(2);
+	uint32_t x = 0;
+	for (; x + 32 <= width; x += 32) {
+		__m256i low  = _mm256_add_epi16(sumBytePairsAvx2(_mm256_loadu_si256((const __m256i*)(src0 + x * 2))),      sumBytePairsAvx2(_mm256_loadu_si256((const __m256i*)(src1 + x * 2))));
+		__m256i high = _mm256_add_epi16(sumBytePairsAvx2(_mm256_loadu_si256((const __m256i*)(src0 + x * 2 + 32))), sumBytePairsAvx2(_mm256_loadu_si256((const __m256i*)(src1 + x * 2 + 32))));
+		low  = _mm256_srli_epi16(_mm256_add_epi16(low, two), 2);
+		high = _mm256_srli_epi16(_mm256_add_epi16(high, two), 2);
+
+		// Packing works within each 128 bit half, so put the quarters back in order after
+		_mm256_storeu_si256((__m256i*)(dst + x), _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8));
+	}
+	boxRowSse2(src0 + x * 2, src1 + x * 2, dst + x, width - x);
+}
+
+IMAGE_PYRAMID_AVX2 static void gaussianColumnsAvx2(const uint8_t* const* rows, uint16_t* dst, uint32_t width) {
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m256i r[5];
+		for (int32_t i = 0; i < 5; i++)
+			r[i] = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(rows[i] + x)));
+		__m256i sum = _mm256_add_epi16(_mm256_add_epi16(r[0], r[4]), _mm256_slli_epi16(_mm256_add_epi16(r[1], r[3]), 2));
+		sum = _mm256_add_epi16(sum, _mm256_add_epi16(_mm256_slli_epi16(r[2], 2), _mm256_slli_epi16(r[2], 1)));
+		_mm256_storeu_si256((__m256i*)(dst + x), sum);
+	}
+	const uint8_t* rest[5] = { rows[0] + x, rows[1] + x, rows[2] + x, rows[3] + x, rows[4] + x };
+	gaussianColumnsSse2(rest, dst + x, width - x);
+}
+
+IMAGE_PYRAMID_AVX2 static inline __m256i gaussianRow16(const uint16_t* src) {
+	__m256i outer  = _mm256_add_epi16(_mm256_loadu_si256((const __m256i*)(src - 2)), _mm256_loadu_si256((const __m256i*)(src + 2)));
+	__m256i inner  = _mm256_add_epi16(_mm256_loadu_si256((const __m256i*)(src - 1)), _mm256_loadu_si256((const __m256i*)(src + 1)));
+	__m256i center = _mm256_loadu_si256((const __m256i*)src);
+	__m256i sum    = _mm256_add_epi16(_mm256_add_epi16(outer, _mm256_slli_epi16(inner, 2)), _mm256_add_epi16(_mm256_slli_epi16(center, 2), _mm256_slli_epi16(center, 1)));
+	return _mm256_srli_epi16(_mm256_add_epi16(sum, _mm256_set1_epi16(128)), 8);
+}
+
+IMAGE_PYRAMID_AVX2 static void gaussianRowAvx2(const uint16_t* src, uint32_t srcWidth, uint8_t* dst, uint32_t width) {
+	const __m256i even = _mm256_set1_epi32(0xFFFF);
+	if (width == 0)
+		return;
+	dst[0] = gaussianPixel(src, srcWidth, 0); // Reaches past the left edge
+	uint32_t x = 1;
+	for (; x + 16 <= width && x * 2 + 34 <= srcWidth; x += 16) {
+		__m256i low   = _mm256_and_si256(gaussianRow16(src + x * 2), even);
+		__m256i high  = _mm256_and_si256(gaussianRow16(src + x * 2 + 16), even);
+		__m256i words = _mm256_permute4x64_epi64(_mm256_packs_epi32(low, high), 0xD8);
+		__m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(words, words), 0x08);
+		_mm_storeu_si128((__m128i*)(dst + x), _mm256_castsi256_si128(bytes));
+	}
+	for (; x + 8 <= width && x * 2 + 18 <= srcWidth; x += 8) {
+		__m128i low   = _mm_and_si128(gaussianRow8(src + x * 2), _mm256_castsi256_si128(even));
+		__m128i high  = _mm_and_si128(gaussianRow8(src + x * 2 + 8), _mm256_castsi256_si128(even));
+		__m128i words = _mm_packs_epi32(low, high);
+		_mm_storel_epi64((__m128i*)(dst + x), _mm_packus_epi16(words, words));
+	}
+	for (; x < width; x++)
+		dst[x] = gaussianPixel(src, srcWidth, x * 2);
+}
+
+#endif
+
+///////////////////////////////////////////
+// NEON kernels
+///////////////////////////////////////////
+
+#ifdef IMAGE_PYRAMID_NEON
+
+static void boxRowNeon(const uint8_t* src0, const uint8_t* src1, uint8_t* dst, uint32_t width) {
+	uint32_t x = 0;
+	for (; x + 8 <= width; x += 8) {
+		uint16x8_t sum = vaddq_u16(vpaddlq_u8(vld1q_u8(src0 + x * 2)), vpaddlq_u8(vld1q_u8(src1 + x * 2)));
+		vst1_u8(dst + x, vrshrn_n_u16(sum, 2));
+	}
+	boxRowScalar(src0 + x * 2, src1 + x * 2, dst + x, width - x);
+}
+
+static void gaussianColumnsNeon(const uint8_t* const* rows, uint16_t* dst, uint32_t width) {
+	const uint8x8_t four = vdup_n_u8(4), six = vdup_n_u8(6);
+	uint32_t x = 0;
+	for (; x + 8 <= width; x += 8) {
+		uint16x8_t sum = vaddl_u8(vld1_u8(rows[0] + x), vld1_u8(rows[4] + x));
+		sum = vmlal_u8(sum, vld1_u8(rows[1] + x), four);
+		sum = vmlal_u8(sum, vld1_u8(rows[3] + x), four);
+		sum = vmlal_u8(sum, vld1_u8(rows[2] + x), six);
+		vst1q_u16(dst + x, sum);
+	}
+	const uint8_t* rest[5] = { rows[0] + x, rows[1] + x, rows[2] + x, rows[3] + x, rows[4] + x };
+	gaussianColumnsScalar(rest, dst + x, width - x);
+}
+
+static void gaussianRowNeon(const uint16_t* src, uint32_t srcWidth, uint8_t* dst, uint32_t width) {
+	if (width == 0)
+		return;
+	dst[0] = gaussianPixel(src, srcWidth, 0); // Reaches past the left edge
+	uint32_t x = 1;
+	for (; x + 8 <= width && x * 2 + 18 <= srcWidth; x += 8) {
+		// Loading in pairs splits the even columns from the odd ones
+		uint16x8x2_t before = vld2q_u16(src + x * 2 - 2);
+		uint16x8x2_t center = vld2q_u16(src + x * 2);
+		uint16x8x2_t after  = vld2q_u16(src + x * 2 + 2);
+		uint16x8_t   sum    = vaddq_u16(before.val[0], after.val[0]);
+		sum = vaddq_u16(sum, vshlq_n_u16(vaddq_u16(before.val[1], center.val[1]), 2));
+		sum = vmlaq_n_u16(sum, center.val[0], 6);
+		vst1_u8(dst + x, vrshrn_n_u16(sum, 8));
+	}
+	for (; x < width; x++)
+		dst[x] = gaussianPixel(src, srcWidth, x * 2);
+}
+
+#endif
+
+///////////////////////////////////////////
+
+ImagePyramidBuilder::ImagePyramidBuilder(uint32_t levelCount, PyramidFilter filter, uint32_t maxPyramids, PixelKernelLevel level) :
+	m_levelCount(levelCount < 1 ? 1 : levelCount > maxPyramidLevels ? maxPyramidLevels : levelCount),
+	m_filter(filter),
+	m_level(PixelKernelLevel::Scalar),
+	m_kernels{ boxRowScalar, gaussianColumnsScalar, gaussianRowScalar },
+	m_maxPyramids(maxPyramids > 0 ? maxPyramids : 1),
+	m_pool(std::make_shared<FrameBufferPool>()),
+	m_converter(0, level),
+	m_width(0),
+	m_height(0),
+	m_layoutLevels(0),
+	m_built(0) {
+
+	// Levels this CPU or build can't run fall back to scalar
+#ifdef IMAGE_PYRAMID_X86
+	if (level == PixelKernelLevel::Sse2 || (level == PixelKernelLevel::Avx2 && getBestPixelKernelLevel() != PixelKernelLevel::Avx2)) {
+		m_level   = PixelKernelLevel::Sse2;
+		m_kernels = { boxRowSse2, gaussianColumnsSse2, gaussianRowSse2 };
+	} else if (level == PixelKernelLevel::Avx2) {
+		m_level   = PixelKernelLevel::Avx2;
+		m_kernels = { boxRowAvx2, gaussianColumnsAvx2, gaussianRowAvx2 };
+	}
+#endif
+#ifdef IMAGE_PYRAMID_NEON
+	if (level == PixelKernelLevel::Neon) {
+		m_level   = PixelKernelLevel::Neon;
+		m_kernels = { boxRowNeon, gaussianColumnsNeon, gaussianRowNeon };
+	}
+#endif
+}
+
+ImagePyramidBuilder::~ImagePyramidBuilder() {
+}
+
+///////////////////////////////////////////
+
+// Works out where each level goes in a buffer, and sizes the pool's buffers to fit them all.
+void ImagePyramidBuilder::layOut(uint32_t width, uint32_t height) {
+	uint64_t offset = 0;
+	m_layoutLevels = 0;
+	for (uint32_t i = 0; i < m_levelCount && width > 0 && height > 0; i++) {
+		PyramidLevel& level = m_layout[i];
+		level.width  = width;
+		level.height = height;
+		level.stride = (width + frameStrideAlignment - 1) & ~(frameStrideAlignment - 1);
+		level.data   = nullptr;
+		m_offsets[i] = offset;
+		offset += static_cast<uint64_t>(level.stride) * height;
+		m_layoutLevels++;
+		width  /= 2;
+		height /= 2;
+	}
+
+	m_width  = m_layout[0].width;
+	m_height = m_layout[0].height;
+	m_columns.resize(m_layout[0].width);
+	if (offset > UINT32_MAX || !m_pool->configure(static_cast<uint32_t>(offset), m_layout[0].stride, m_maxPyramids))
+		m_width = m_height = 0;
+}
+
+// Called once a row of level is written, to make whatever rows of the next level now can be.
+void ImagePyramidBuilder::rowDone(ImagePyramid& pyramid, uint32_t level, uint32_t row) {
+	uint32_t next = level + 1;
+	if (next >= pyramid.m_levelCount)
+		return;
+	const PyramidLevel& src     = pyramid.m_levels[level];
+	const PyramidLevel& dst     = pyramid.m_levels[next];
+	uint8_t*            dstData = const_cast<uint8_t*>(dst.data);
+
+	if (m_filter == PyramidFilter::Box2x2) {
+		if ((row & 1) == 0 || row / 2 >= dst.height)
+			return;
+		uint32_t out = row / 2;
+		m_kernels.boxRow(src.data + static_cast<size_t>(row - 1) * src.stride, src.data + static_cast<size_t>(row) * src.stride, dstData + static_cast<size_t>(out) * dst.stride, dst.width);
+		rowDone(pyramid, next, out);
+		return;
+	}
+
+	// A Gaussian5 row needs the two rows past its center, or the last one at the bottom edge
+	while (m_nextRow[next] < dst.height) {
+		uint32_t out  = m_nextRow[next];
+		uint32_t last = out * 2 + 2 < src.height - 1 ? out * 2 + 2 : src.height - 1;
+		if (last > row)
+			break;
+
+		const uint8_t* rows[5];
+		for (int32_t i = 0; i < 5; i++) {
+			int32_t r = static_cast<int32_t>(out * 2) - 2 + i;
+			r = r < 0 ? 0 : r > static_cast<int32_t>(src.height) - 1 ? static_cast<int32_t>(src.height) - 1 : r;
+			rows[i] = src.data + static_cast<size_t>(r) * src.stride;
+		}
+		m_kernels.gaussianColumns(rows, m_columns.data(), src.width);
+		m_kernels.gaussianRow(m_columns.data(), src.width, dstData + static_cast<size_t>(out) * dst.stride, dst.width);
+		m_nextRow[next] = out + 1;
+		rowDone(pyramid, next, out);
+	}
+}
+
+template<typename FetchRows>
+std::shared_ptr<const ImagePyramid> ImagePyramidBuilder::build(uint32_t width, uint32_t height, uint64_t timestamp, FetchRows fetchRows) {
+	if (width == 0 || height == 0)
+		return nullptr;
+	if (width != m_width || height != m_height)
+		layOut(width, height);
+	if (m_width == 0)
+		return nullptr;
+
+	uint8_t* buffer = m_pool->acquire();
+	if (buffer == nullptr)
+		return nullptr;
+
+	// The pool has to stay around for as long as any pyramid from it does
+	std::shared_ptr<FrameBufferPool> pool = m_pool;
+	std::shared_ptr<ImagePyramid>    pyramid(new ImagePyramid(), [pool](ImagePyramid* released) {
+		pool->release(released->m_buffer);
+		delete released;
+	});
+	pyramid->m_buffer     = buffer;
+	pyramid->m_levelCount = m_layoutLevels;
+	pyramid->m_filter     = m_filter;
+	pyramid->m_timestamp  = timestamp;
+	for (uint32_t i = 0; i < m_layoutLevels; i++) {
+		pyramid->m_levels[i]      = m_layout[i];
+		pyramid->m_levels[i].data = buffer + m_offsets[i];
+		m_nextRow[i]              = 0;
+	}
+
+	const PyramidLevel& top = pyramid->m_levels[0];
+	for (uint32_t row = 0; row < height; row += pyramidStripRows) {
+		uint32_t rows = height - row < pyramidStripRows ? height - row : pyramidStripRows;
+		fetchRows(row, rows, buffer + static_cast<size_t>(row) * top.stride, top.stride);
+		for (uint32_t i = 0; i < rows; i++)
+			rowDone(*pyramid, 0, row + i);
+	}
+
+	m_built++;
+	return pyramid;
+}
+
+std::shared_ptr<const ImagePyramid> ImagePyramidBuilder::build(const uint8_t* gray, uint32_t width, uint32_t height, uint32_t stride, uint64_t timestamp) {
+	if (gray == nullptr || stride < width)
+		return nullptr;
+	return build(width, height, timestamp, [=](uint32_t first, uint32_t count, uint8_t* dst, uint32_t dstStride) {
+		for (uint32_t row = 0; row < count; row++)
+			memcpy(dst + static_cast<size_t>(row) * dstStride, gray + static_cast<size_t>(first + row) * stride, width);
+	});
+}
+
+std::shared_ptr<const ImagePyramid> ImagePyramidBuilder::build(const CameraFrame& frame) {
+	uint32_t pixelBytes = 0;
+	switch (frame.format) {
+	case PixelFormat::YUYV:     pixelBytes = 2; break;
+	case PixelFormat::NV12:
+	case PixelFormat::NV21:     pixelBytes = 1; break;
+	case PixelFormat::RGB888:   pixelBytes = 3; break;
+	case PixelFormat::RGBA8888: pixelBytes = 4; break;
+	default:                    return nullptr;
+	}
+	if (frame.buffer == nullptr || frame.stride < frame.width * pixelBytes || static_cast<uint64_t>(frame.stride) * frame.height > frame.bufferSize)
+		return nullptr;
+
+	// The 4:2:0 luma plane is gray already
+	if (pixelBytes == 1)
+		return build(frame.buffer, frame.width, frame.height, frame.stride, frame.timestamp);
+
+	// Everything else goes through the converter, a strip of rows at a time
+	return build(frame.width, frame.height, frame.timestamp, [&](uint32_t first, uint32_t count, uint8_t* dst, uint32_t dstStride) {
+		CameraFrame strip = frame;
+		strip.buffer     = frame.buffer + static_cast<size_t>(first) * frame.stride;
+		strip.height     = count;
+		strip.bufferSize = frame.stride * count;
+		m_converter.extractGray(strip, dst, dstStride);
+	});
+}
+
+///////////////////////////////////////////
+
+ImagePyramidStats ImagePyramidBuilder::getStats() {
+	FrameBufferPoolStats pool = m_pool->getStats();
+	ImagePyramidStats    stats;
+	stats.built     = m_built;
+	stats.exhausted = pool.exhausted;
+	stats.inUse     = pool.inUse;
+	return stats;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "FrameBufferPool.h"
+#include "PixelConvert.h"
+#include <memory>
+
+namespace TestApp
+{
+	const uint32_t maxPyramidLevels = 8;
+
+	enum class PyramidFilter {
+		Box2x2,    // Each pixel is the rounded average of the 2x2 block under it
+		Gaussian5, // 1 4 6 4 1 in both directions, then every other pixel, with edges repeated
+	};
+
+	struct PyramidLevel {
+		const uint8_t* data;
+		uint32_t       width;
+		uint32_t       height;
+		uint32_t       stride;
+	};
+
+	struct ImagePyramidStats {
+		uint64_t built;
+		uint64_t exhausted; // Builds that got nothing, because every pyramid was still held
+		uint32_t inUse;     // Pyramids held right now
+	};
+
+	///////////////////////////////////////////
+
+	// The gray levels of one camera frame, level 0 being the frame's luma at full size, and
+	// every level after it half the size of the one before, rounded down. A pyramid never
+	// changes once built. It lives in a buffer from its builder's pool, which goes back when
+	// the last shared_ptr to it does, so every consumer of a frame can hold the same one for
+	// as long as they need it.
+	class ImagePyramid final {
+
+	public:
+		uint32_t            getLevelCount() const         { return m_levelCount; }
+		const PyramidLevel& getLevel(uint32_t index) const { return m_levels[index]; }
+		PyramidFilter       getFilter() const             { return m_filter; }
+		uint64_t            getTimestamp() const          { return m_timestamp; }
+
+	private:
+		friend class ImagePyramidBuilder;
+
+		uint8_t*      m_buffer;
+		PyramidLevel  m_levels[maxPyramidLevels];
+		uint32_t      m_levelCount;
+		PyramidFilter m_filter;
+		uint64_t      m_timestamp;
+	};
+
+	///////////////////////////////////////////
+
+	// Builds ImagePyramids from camera frames, in one pass down the frame: each row of a
+	// level is made as soon as the rows it needs from the level above are in, so those are
+	// still in cache, and nothing is read back from memory once it's been written. Level 0
+	// is copied out of the frame, so the pyramid can outlive the camera's buffer.
+	//
+	// Every pyramid's buffer comes from a FrameBufferPool sized for maxPyramids at a time,
+	// allocated again only when the frame size changes. When they're all held, build() comes
+	// back empty instead of allocating. Like PixelConverter, the kernels have SSE2, AVX2 and
+	// NEON versions that match the scalar ones byte for byte.
+	//
+	// build() is for one thread at a time. The pyramids it makes can be read from any number.
+	class ImagePyramidBuilder {
+
+	public:
+		ImagePyramidBuilder(uint32_t levelCount, PyramidFilter filter, uint32_t maxPyramids = 4, PixelKernelLevel level = getBestPixelKernelLevel());
+		~ImagePyramidBuilder();
+
+		ImagePyramidBuilder(const ImagePyramidBuilder&) = delete;
+		ImagePyramidBuilder& operator=(const ImagePyramidBuilder&) = delete;
+
+		// From the luma of a frame in any format. Fewer levels than asked for come out when the
+		// frame is too small to halve that many times. nullptr if every pyramid is held, or the
+		// frame can't be read.
+		std::shared_ptr<const ImagePyramid> build(const VuforiaDriver::CameraFrame& frame);
+
+		// From a gray image.
+		std::shared_ptr<const ImagePyramid> build(const uint8_t* gray, uint32_t width, uint32_t height, uint32_t stride, uint64_t timestamp);
+
+		PixelKernelLevel  getLevel() const { return m_level; }
+		ImagePyramidStats getStats();
+
+		// Row kernels, one set per level. Widths are the output row's, in pixels.
+		struct Kernels {
+			void (*boxRow)(const uint8_t* src0, const uint8_t* src1, uint8_t* dst, uint32_t width);
+			void (*gaussianColumns)(const uint8_t* const* rows, uint16_t* dst, uint32_t width);
+			void (*gaussianRow)(const uint16_t* src, uint32_t srcWidth, uint8_t* dst, uint32_t width);
+		};
+
+	private:
+		// Level 0 rows come from wherever the image is, one strip at a time.
+		template<typename FetchRows>
+		std::shared_ptr<const ImagePyramid> build(uint32_t width, uint32_t height, uint64_t timestamp, FetchRows fetchRows);
+
+		void layOut(uint32_t width, uint32_t height);
+		void rowDone(ImagePyramid& pyramid, uint32_t level, uint32_t row);
+
+		uint32_t                         m_levelCount;
+		PyramidFilter                    m_filter;
+		PixelKernelLevel                 m_level;
+		Kernels                          m_kernels;
+		uint32_t                         m_maxPyramids;
+		std::shared_ptr<FrameBufferPool> m_pool;
+		PixelConverter                   m_converter;
+
+		// Layout for the current frame size
+		uint32_t                         m_width;
+		uint32_t                         m_height;
+		uint32_t                         m_layoutLevels;
+		PyramidLevel                     m_layout[maxPyramidLevels];
+		uint64_t                         m_offsets[maxPyramidLevels]; // Where each level starts in a buffer
+		uint32_t                         m_nextRow[maxPyramidLevels];
+		std::vector<uint16_t>            m_columns; // Gaussian5 vertical sums, one row wide
+		uint64_t                         m_built;
+	};
+}
@@ -0,0 +1,604 @@
+#include "PixelConvert.h"
+#include "RowBands.h"
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define PIXEL_CONVERT_X86
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#define PIXEL_CONVERT_AVX2
+	#else
+		#define PIXEL_CONVERT_AVX2 __attribute__((target("avx2")))
+	#endif
+#elif defined(_M_ARM) || defined(_M_ARM64) || defined(__ARM_NEON)
+	#define PIXEL_CONVERT_NEON
+	#include <arm_neon.h>
+#endif
+
+using namespace TestApp;
+using namespace VuforiaDriver;
+
+// BT.601 video range, with 6 bits of fraction so the SIMD kernels can stay in 16 bit lanes:
+// R = 1.164(Y-16) + 1.596(V-128), G = 1.164(Y-16) - 0.391(U-128) - 0.813(V-128), B = 1.164(Y-16) + 2.018(U-128)
+const int yScale = 75, vToR = 102, uToG = 25, vToG = 52, uToB = 129;
+
+// And back, with 8 bits: Y = (66R + 129G + 25B + 128) / 256 + 16
+const int rToY = 66, gToY = 129, bToY = 25;
+
+static inline uint8_t clampToByte(int value) {
+	return static_cast<uint8_t>(value < 0 ? 0 : value > 255 ? 255 : value);
+}
+
+///////////////////////////////////////////
+// Scalar reference kernels
+///////////////////////////////////////////
+
+static void yuyvToNv12Scalar(const uint8_t* src0, const uint8_t* src1, uint8_t* y0, uint8_t* y1, uint8_t* uv, uint32_t width, bool swapUV) {
+	for (uint32_t x = 0; x + 1 < width; x += 2) {
+		y0[x]     = src0[x * 2];
+		y0[x + 1] = src0[x * 2 + 2];
+		y1[x]     = src1[x * 2];
+		y1[x + 1] = src1[x * 2 + 2];
+
+		uint8_t u = static_cast<uint8_t>((src0[x * 2 + 1] + src1[x * 2 + 1] + 1) >> 1);
+		uint8_t v = static_cast<uint8_t>((src0[x * 2 + 3] + src1[x * 2 + 3] + 1) >> 1);
+		uv[x]     = swapUV ? v : u;
+		uv[x + 1] = swapUV ? u : v;
+	}
+}
+
+static void nv12ToYuyvScalar(const uint8_t* y, const uint8_t* uv, uint8_t* dst, uint32_t width, bool swapUV) {
+	for (uint32_t x = 0; x + 1 < width; x += 2) {
+		dst[x * 2]     = y[x];
+		dst[x * 2 + 1] = uv[x + (swapUV ? 1 : 0)];
+		dst[x * 2 + 2] = y[x + 1];
+		dst[x * 2 + 3] = uv[x + (swapUV ? 0 : 1)];
+	}
+}
+
+static void nv12ToRgbScalar(const uint8_t* y, const uint8_t* uv, uint8_t* dst, uint32_t width, bool swapUV, uint32_t channels) {
+	for (uint32_t x = 0; x < width; x++) {
+		int c = (y[x] - 16) * yScale;
+		int d = uv[(x & ~1u) + (swapUV ? 1 : 0)] - 128;
+		int e = uv[(x & ~1u) + (swapUV ? 0 : 1)] - 128;
+
+		uint8_t* out = dst + x * channels;
+		out[0] = clampToByte((c + vToR * e + 32) >> 6);
+		out[1] = clampToByte((c - uToG * d - vToG * e + 32) >> 6);
+		out[2] = clampToByte((c + uToB * d + 32) >> 6);
+		if (channels == 4)
+			out[3] = 255;
+	}
+}
+
+static void yuyvToGrayScalar(const uint8_t* src, uint8_t* dst, uint32_t width) {
+	for (uint32_t x = 0; x < width; x++)
+		dst[x] = src[x * 2];
+}
+
+static void rgbToGrayScalar(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t channels) {
+	for (uint32_t x = 0; x < width; x++) {
+		const uint8_t* in = src + x * channels;
+		dst[x] = static_cast<uint8_t>(((rToY * in[0] + gToY * in[1] + bToY * in[2] + 128) >> 8) + 16);
+	}
+}
+
+///////////////////////////////////////////
+// SSE2 kernels
+///////////////////////////////////////////
+
+#ifdef PIXEL_CONVERT_X86
+
+static inline __m128i swapBytePairs(__m128i value) {
+	return _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+}
+
+static void yuyvToNv12Sse2(const uint8_t* src0, const uint8_t* src1, uint8_t* y0, uint8_t* y1, uint8_t* uv, uint32_t width, bool swapUV) {
+	const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src0 + x * 2));
+		__m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src0 + x * 2 + 16));
+		__m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src1 + x * 2));
+		__m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src1 + x * 2 + 16));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(y0 + x), _mm_packus_epi16(_mm_and_si128(a0, lowBytes), _mm_and_si128(b0, lowBytes)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(y1 + x), _mm_packus_epi16(_mm_and_si128(a1, lowBytes), _mm_and_si128(b1, lowBytes)));
+
+		__m128i chroma0 = _mm_packus_epi16(_mm_srli_epi16(a0, 8), _mm_srli_epi16(b0, 8));
+		__m128i chroma1 = _mm_packus_epi16(_mm_srli_epi16(a1, 8), _mm_srli_epi16(b1, 8));
+		__m128i chroma  = _mm_avg_epu8(chroma0, chroma1);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(uv + x), swapUV ? swapBytePairs(chroma) : chroma);
+	}
+	yuyvToNv12Scalar(src0 + x * 2, src1 + x * 2, y0 + x, y1 + x, uv + x, width - x, swapUV);
+}
+
+static void nv12ToYuyvSse2(const uint8_t* y, const uint8_t* uv, uint8_t* dst, uint32_t width, bool swapUV) {
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m128i luma   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x));
+		__m128i chroma = _mm_loadu_si128(reinterpret_cast<const __m128i*>(uv + x));
+		if (swapUV)
+			chroma = swapBytePairs(chroma);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 2),      _mm_unpacklo_epi8(luma, chroma));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 2 + 16), _mm_unpackhi_epi8(luma, chroma));
+	}
+	nv12ToYuyvScalar(y + x, uv + x, dst + x * 2, width - x, swapUV);
+}
+
+// R, G and B for 8 pixels, from 8 lumas and the 4 chroma pairs they share, all in 16 bit lanes.
+static inline void yuvToRgb8(__m128i luma, __m128i chroma, bool swapUV, __m128i& r, __m128i& g, __m128i& b) {
+	const __m128i round = _mm_set1_epi16(32);
+
+	__m128i c = _mm_mullo_epi16(_mm_sub_epi16(luma, _mm_set1_epi16(16)), _mm_set1_epi16(yScale));
+	chroma = _mm_sub_epi16(chroma, _mm_set1_epi16(128));
+	__m128i first  = _mm_shufflehi_epi16(_mm_shufflelo_epi16(chroma, _MM_SHUFFLE(2, 2, 0, 0)), _MM_SHUFFLE(2, 2, 0, 0));
+	__m128i second = _mm_shufflehi_epi16(_mm_shufflelo_epi16(chroma, _MM_SHUFFLE(3, 3, 1, 1)), _MM_SHUFFLE(3, 3, 1, 1));
+	__m128i d = swapUV ? second : first;
+	__m128i e = swapUV ? first : second;
+
+	// Only B can saturate, and only when it would come out as 255 anyway
+	r = _mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(c, _mm_mullo_epi16(e, _mm_set1_epi16(vToR))), round), 6);
+	g = _mm_srai_epi16(_mm_adds_epi16(_mm_subs_epi16(_mm_subs_epi16(c, _mm_mullo_epi16(d, _mm_set1_epi16(uToG))), _mm_mullo_epi16(e, _mm_set1_epi16(vToG))), round), 6);
+	b = _mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(c, _mm_mullo_epi16(d, _mm_set1_epi16(uToB))), round), 6);
+}
+
+// Writes 16 pixels from their R, G and B bytes.
+static inline void storeRgb16(uint8_t* dst, __m128i r, __m128i g, __m128i b, uint32_t channels) {
+	const __m128i alpha = _mm_set1_epi8(static_cast<char>(0xFF));
+	__m128i rgLow  = _mm_unpacklo_epi8(r, g), rgHigh = _mm_unpackhi_epi8(r, g);
+	__m128i baLow  = _mm_unpacklo_epi8(b, alpha), baHigh = _mm_unpackhi_epi8(b, alpha);
+	__m128i rgba[4] = {
+		_mm_unpacklo_epi16(rgLow, baLow), _mm_unpackhi_epi16(rgLow, baLow),
+		_mm_unpacklo_epi16(rgHigh, baHigh), _mm_unpackhi_epi16(rgHigh, baHigh),
+	};
+
+	if (channels == 4) {
+		for (int i = 0; i < 4; i++)
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 16), rgba[i]);
+		return;
+	}
+
+	// SSE2 has no byte shuffle, so drop alpha on the way out
+	alignas(16) uint8_t packed[64];
+	for (int i = 0; i < 4; i++)
+		_mm_store_si128(reinterpret_cast<__m128i*>(packed + i * 16), rgba[i]);
+	for (int i = 0; i < 16; i++) {
+		dst[i * 3]     = packed[i * 4];
+		dst[i * 3 + 1] = packed[i * 4 + 1];
+		dst[i * 3 + 2] = packed[i * 4 + 2];
+	}
+}
+
+static void nv12ToRgbSse2(const uint8_t* y, const uint8_t* uv, uint8_t* dst, uint32_t width, bool swapUV, uint32_t channels) {
+	const __m128i zero = _mm_setzero_si128();
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m128i luma   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x));
+		__m128i chroma = _mm_loadu_si128(reinterpret_cast<const __m128i*>(uv + x));
+
+		__m128i r0, g0, b0, r1, g1, b1;
+		yuvToRgb8(_mm_unpacklo_epi8(luma, zero), _mm_unpacklo_epi8(chroma, zero), swapUV, r0, g0, b0);
+		yuvToRgb8(_mm_unpackhi_epi8(luma, zero), _mm_unpackhi_epi8(chroma, zero), swapUV, r1, g1, b1);
+		storeRgb16(dst + x * channels, _mm_packus_epi16(r0, r1), _mm_packus_epi16(g0, g1), _mm_packus_epi16(b0, b1), channels);
+	}
+	nv12ToRgbScalar(y + x, uv + x, dst + x * channels, width - x, swapUV, channels);
+}
+
+static void yuyvToGraySse2(const uint8_t* src, uint8_t* dst, uint32_t width) {
+	const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 2));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 2 + 16));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(_mm_and_si128(a, lowBytes), _mm_and_si128(b, lowBytes)));
+	}
+	yuyvToGrayScalar(src + x * 2, dst + x, width - x);
+}
+
+// Weighted sums of 4 RGBA pixels, as 32 bit lanes.
+static inline __m128i rgbaLuma4(__m128i pixels, __m128i weights) {
+	const __m128i zero = _mm_setzero_si128();
+	__m128i low  = _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), weights);
+	__m128i high = _mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), weights);
+
+	// Each pixel is now R+G in one lane and B in the next, so fold the pairs together
+	low  = _mm_add_epi32(low, _mm_srli_epi64(low, 32));
+	high = _mm_add_epi32(high, _mm_srli_epi64(high, 32));
+	low  = _mm_shuffle_epi32(low, _MM_SHUFFLE(3, 3, 2, 0));
+	high = _mm_shuffle_epi32(high, _MM_SHUFFLE(3, 3, 2, 0));
+	return _mm_unpacklo_epi64(low, high);
+}
+
+// Only RGBA has SIMD here; RGB888 would need byte shuffles SSE2 doesn't have.
+static void rgbToGraySse2(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t channels) {
+	uint32_t x = 0;
+	if (channels == 4) {
+		const __m128i weights = _mm_setr_epi16(rToY, gToY, bToY, 0, rToY, gToY, bToY, 0);
+		const __m128i round   = _mm_set1_epi32(128);
+		const __m128i offset  = _mm_set1_epi16(16);
+		for (; x + 16 <= width; x += 16) {
+			__m128i sums[4];
+			for (int i = 0; i < 4; i++) {
+				__m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (x + i * 4) * 4));
+				sums[i] = _mm_srli_epi32(_mm_add_epi32(rgbaLuma4(pixels, weights), round), 8);
+			}
+			__m128i low  = _mm_add_epi16(_mm_packs_epi32(sums[0], sums[1]), offset);
+			__m128i high = _mm_add_epi16(_mm_packs_epi32(sums[2], sums[3]), offset);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(low, high));
+		}
+	}
+	rgbToGrayScalar(src + x * channels, dst + x, width - x, channels);
+}
+
+///////////////////////////////////////////
+// AVX2 kernels
+///////////////////////////////////////////
+
+// Packs two vectors of 16 bit lanes into bytes, in order, which _mm256_packus_epi16 alone
+// doesn't do since it works within each 128 bit half.
+PIXEL_CONVERT_AVX2 static inline __m256i packBytesInOrder(__m256i a, __m256i b) {
+	return _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+PIXEL_CONVERT_AVX2 static void yuyvToNv12Avx2(const uint8_t* src0, const uint8_t* src1, uint8_t* y0, uint8_t* y1, uint8_t* uv, uint32_t width, bool swapUV) {
+	const __m256i lowBytes = _mm256_set1_epi16(0x00FF);
+	uint32_t x = 0;
+	for (; x + 32 <= width; x += 32) {
+		__m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src0 + x * 2));
+		__m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src0 + x * 2 + 32));
+		__m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src1 + x * 2));
+		__m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src1 + x * 2 + 32));
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(y0 + x), packBytesInOrder(_mm256_and_si256(a0, lowBytes), _mm256_and_si256(b0, lowBytes)));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(y1 + x), packBytesInOrder(_mm256_and_si256(a1, lowBytes), _mm256_and_si256(b1, lowBytes)));
+
+		__m256i chroma0 = packBytesInOrder(_mm256_srli_epi16(a0, 8), _mm256_srli_epi16(b0, 8));
+		__m256i chroma1 = packBytesInOrder(_mm256_srli_epi16(a1, 8), _mm256_srli_epi16(b1, 8));
+		__m256i chroma  = _mm256_avg_epu8(chroma0, chroma1);
+		if (swapUV)
+			chroma = _mm256_or_si256(_mm256_slli_epi16(chroma, 8), _mm256_srli_epi16(chroma, 8));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(uv + x), chroma);
+	}
+	yuyvToNv12Sse2(src0 + x * 2, src1 + x * 2, y0 + x, y1 + x, uv + x, width - x, swapUV);
+}
+
+PIXEL_CONVERT_AVX2 static void nv12ToYuyvAvx2(const uint8_t* y, const uint8_t* uv, uint8_t* dst, uint32_t width, bool swapUV) {
+	uint32_t x = 0;
+	for (; x + 32 <= width; x += 32) {
+		__m256i luma   = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + x));
+		__m256i chroma = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(uv + x));
+		if (swapUV)
+			chroma = _mm256_or_si256(_mm256_slli_epi16(chroma, 8), _mm256_srli_epi16(chroma, 8));
+
+		// The unpacks work within each half, so put the halves back in order
+		__m256i low  = _mm256_unpacklo_epi8(luma, chroma);
+		__m256i high = _mm256_unpackhi_epi8(luma, chroma);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 2),      _mm256_permute2x128_si256(low, high, 0x20));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 2 + 32), _mm256_permute2x128_si256(low, high, 0x31));
+	}
+	nv12ToYuyvSse2(y + x, uv + x, dst + x * 2, width - x, swapUV);
+}
+
+PIXEL_CONVERT_AVX2 static void nv12ToRgbAvx2(const uint8_t* y, const uint8_t* uv, uint8_t* dst, uint32_t width, bool swapUV, uint32_t channels) {
+	const __m256i round = _mm256_set1_epi16(32);
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m256i c = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x)));
+		__m256i chroma = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(uv + x)));
+		c      = _mm256_mullo_epi16(_mm256_sub_epi16(c, _mm256_set1_epi16(16)), _mm256_set1_epi16(yScale));
+		chroma = _mm256_sub_epi16(chroma, _mm256_set1_epi16(128));
+
+		// Each half holds 4 chroma pairs for its 8 pixels, so the shuffles line up without crossing halves
+		__m256i first  = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(chroma, _MM_SHUFFLE(2, 2, 0, 0)), _MM_SHUFFLE(2, 2, 0, 0));
+		__m256i second = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(chroma, _MM_SHUFFLE(3, 3, 1, 1)), _MM_SHUFFLE(3, 3, 1, 1));
+		__m256i d = swapUV ? second : first;
+		__m256i e = swapUV ? first : second;
+
+		__m256i r = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(c, _mm256_mullo_epi16(e, _mm256_set1_epi16(vToR))), round), 6);
+		__m256i g = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_subs_epi16(_mm256_subs_epi16(c, _mm256_mullo_epi16(d, _mm256_set1_epi16(uToG))), _mm256_mullo_epi16(e, _mm256_set1_epi16(vToG))), round), 6);
+		__m256i b = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(c, _mm256_mullo_epi16(d, _mm256_set1_epi16(uToB))), round), 6);
+
+		storeRgb16(dst + x * channels,
+			_mm_packus_epi16(_mm256_castsi256_si128(r), _mm256_extracti128_si256(r, 1)),
+			_mm_packus_epi16(_mm256_castsi256_si128(g), _mm256_extracti128_si256(g, 1)),
+			_mm_packus_epi16(_mm256_castsi256_si128(b), _mm256_extracti128_si256(b, 1)),
+			channels);
+	}
+	nv12ToRgbScalar(y + x, uv + x, dst + x * channels, width - x, swapUV, channels);
+}
+
+PIXEL_CONVERT_AVX2 static void yuyvToGrayAvx2(const uint8_t* src, uint8_t* dst, uint32_t width) {
+	const __m256i lowBytes = _mm256_set1_epi16(0x00FF);
+	uint32_t x = 0;
+	for (; x + 32 <= width; x += 32) {
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 2));
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 2 + 32));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), packBytesInOrder(_mm256_and_si256(a, lowBytes), _mm256_and_si256(b, lowBytes)));
+	}
+	yuyvToGraySse2(src + x * 2, dst + x, width - x);
+}
+
+static bool cpuHasAvx2() {
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+	__cpuidex(info, 7, 0);
+	return osSavesYmm && (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif
+
+///////////////////////////////////////////
+// NEON kernels
+///////////////////////////////////////////
+
+#ifdef PIXEL_CONVERT_NEON
+
+static void yuyvToNv12Neon(const uint8_t* src0, const uint8_t* src1, uint8_t* y0, uint8_t* y1, uint8_t* uv, uint32_t width, bool swapUV) {
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		uint8x16x2_t row0 = vld2q_u8(src0 + x * 2);
+		uint8x16x2_t row1 = vld2q_u8(src1 + x * 2);
+		vst1q_u8(y0 + x, row0.val[0]);
+		vst1q_u8(y1 + x, row1.val[0]);
+
+		uint8x16_t chroma = vrhaddq_u8(row0.val[1], row1.val[1]);
+		vst1q_u8(uv + x, swapUV ? vrev16q_u8(chroma) : chroma);
+	}
+	yuyvToNv12Scalar(src0 + x * 2, src1 + x * 2, y0 + x, y1 + x, uv + x, width - x, swapUV);
+}
+
+static void nv12ToYuyvNeon(const uint8_t* y, const uint8_t* uv, uint8_t* dst, uint32_t width, bool swapUV) {
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		uint8x16x2_t pixels;
+		pixels.val[0] = vld1q_u8(y + x);
+		pixels.val[1] = vld1q_u8(uv + x);
+		if (swapUV)
+			pixels.val[1] = vrev16q_u8(pixels.val[1]);
+		vst2q_u8(dst + x * 2, pixels);
+	}
+	nv12ToYuyvScalar(y + x, uv + x, dst + x * 2, width - x, swapUV);
+}
+
+// R, G and B bytes for 8 pixels, from their lumas and the chroma repeated for each pixel.
+static inline void yuvToRgb8Neon(uint8x8_t luma, uint8x8_t u, uint8x8_t v, uint8x8_t& r, uint8x8_t& g, uint8x8_t& b) {
+	const int16x8_t round = vdupq_n_s16(32);
+	int16x8_t c = vmulq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(luma)), vdupq_n_s16(16)), yScale);
+	int16x8_t d = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(u)), vdupq_n_s16(128));
+	int16x8_t e = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(v)), vdupq_n_s16(128));
+
+	r = vqmovun_s16(vshrq_n_s16(vqaddq_s16(vqaddq_s16(c, vmulq_n_s16(e, vToR)), round), 6));
+	g = vqmovun_s16(vshrq_n_s16(vqaddq_s16(vqsubq_s16(vqsubq_s16(c, vmulq_n_s16(d, uToG)), vmulq_n_s16(e, vToG)), round), 6));
+	b = vqmovun_s16(vshrq_n_s16(vqaddq_s16(vqaddq_s16(c, vmulq_n_s16(d, uToB)), round), 6));
+}
+
+static void nv12ToRgbNeon(const uint8_t* y, const uint8_t* uv, uint8_t* dst, uint32_t width, bool swapUV, uint32_t channels) {
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		uint8x16_t luma   = vld1q_u8(y + x);
+		uint8x8x2_t chroma = vld2_u8(uv + x);
+		uint8x8x2_t u = vzip_u8(chroma.val[swapUV ? 1 : 0], chroma.val[swapUV ? 1 : 0]);
+		uint8x8x2_t v = vzip_u8(chroma.val[swapUV ? 0 : 1], chroma.val[swapUV ? 0 : 1]);
+
+		uint8x8_t r0, g0, b0, r1, g1, b1;
+		yuvToRgb8Neon(vget_low_u8(luma),  u.val[0], v.val[0], r0, g0, b0);
+		yuvToRgb8Neon(vget_high_u8(luma), u.val[1], v.val[1], r1, g1, b1);
+
+		if (channels == 4) {
+			uint8x16x4_t rgba;
+			rgba.val[0] = vcombine_u8(r0, r1);
+			rgba.val[1] = vcombine_u8(g0, g1);
+			rgba.val[2] = vcombine_u8(b0, b1);
+			rgba.val[3] = vdupq_n_u8(255);
+			vst4q_u8(dst + x * 4, rgba);
+		} else {
+			uint8x16x3_t rgb;
+			rgb.val[0] = vcombine_u8(r0, r1);
+			rgb.val[1] = vcombine_u8(g0, g1);
+			rgb.val[2] = vcombine_u8(b0, b1);
+			vst3q_u8(dst + x * 3, rgb);
+		}
+	}
+	nv12ToRgbScalar(y + x, uv + x, dst + x * channels, width - x, swapUV, channels);
+}
+
+static void yuyvToGrayNeon(const uint8_t* src, uint8_t* dst, uint32_t width) {
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16)
+		vst1q_u8(dst + x, vld2q_u8(src + x * 2).val[0]);
+	yuyvToGrayScalar(src + x * 2, dst + x, width - x);
+}
+
+static inline uint8x8_t rgbLuma8Neon(uint8x8_t r, uint8x8_t g, uint8x8_t b) {
+	uint16x8_t sum = vmull_u8(r, vdup_n_u8(rToY));
+	sum = vmlal_u8(sum, g, vdup_n_u8(gToY));
+	sum = vmlal_u8(sum, b, vdup_n_u8(bToY));
+	return vadd_u8(vrshrn_n_u16(sum, 8), vdup_n_u8(16));
+}
+
+static void rgbToGrayNeon(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t channels) {
+	uint32_t x = 0;
+	if (channels == 4) {
+		for (; x + 8 <= width; x += 8) {
+			uint8x8x4_t pixels = vld4_u8(src + x * 4);
+			vst1_u8(dst + x, rgbLuma8Neon(pixels.val[0], pixels.val[1], pixels.val[2]));
+		}
+	} else {
+		for (; x + 8 <= width; x += 8) {
+			uint8x8x3_t pixels = vld3_u8(src + x * 3);
+			vst1_u8(dst + x, rgbLuma8Neon(pixels.val[0], pixels.val[1], pixels.val[2]));
+		}
+	}
+	rgbToGrayScalar(src + x * channels, dst + x, width - x, channels);
+}
+
+#endif
+
+///////////////////////////////////////////
+
+PixelKernelLevel TestApp::getBestPixelKernelLevel() {
+#if defined(PIXEL_CONVERT_X86)
+	static const bool hasAvx2 = cpuHasAvx2();
+	return hasAvx2 ? PixelKernelLevel::Avx2 : PixelKernelLevel::Sse2;
+#elif defined(PIXEL_CONVERT_NEON)
+	return PixelKernelLevel::Neon;
+#else
+	return PixelKernelLevel::Scalar;
+#endif
+}
+
+PixelConverter::PixelConverter(uint32_t threadCount, PixelKernelLevel level) :
+	m_level(PixelKernelLevel::Scalar),
+	m_kernels{ yuyvToNv12Scalar, nv12ToYuyvScalar, nv12ToRgbScalar, yuyvToGrayScalar, rgbToGrayScalar } {
+
+	// Levels this CPU or build can't run fall back to scalar
+#ifdef PIXEL_CONVERT_X86
+	if (level == PixelKernelLevel::Sse2 || (level == PixelKernelLevel::Avx2 && !cpuHasAvx2())) {
+		m_level   = PixelKernelLevel::Sse2;
+		m_kernels = { yuyvToNv12Sse2, nv12ToYuyvSse2, nv12ToRgbSse2, yuyvToGraySse2, rgbToGraySse2 };
+	} else if (level == PixelKernelLevel::Avx2) {
+		m_level   = PixelKernelLevel::Avx2;
+		m_kernels = { yuyvToNv12Avx2, nv12ToYuyvAvx2, nv12ToRgbAvx2, yuyvToGrayAvx2, rgbToGraySse2 };
+	}
+#endif
+#ifdef PIXEL_CONVERT_NEON
+	if (level == PixelKernelLevel::Neon) {
+		m_level   = PixelKernelLevel::Neon;
+		m_kernels = { yuyvToNv12Neon, nv12ToYuyvNeon, nv12ToRgbNeon, yuyvToGrayNeon, rgbToGrayNeon };
+	}
+#endif
+
+	if (threadCount > 0)
+		m_pool = std::make_unique<DX::ThreadPool>(threadCount);
+}
+
+PixelConverter::~PixelConverter() {
+}
+
+///////////////////////////////////////////
+
+static bool isYuv420(PixelFormat format) {
+	return format == PixelFormat::NV12 || format == PixelFormat::NV21;
+}
+
+static uint32_t bytesPerPixel(PixelFormat format) {
+	switch (format) {
+	case PixelFormat::YUYV:     return 2;
+	case PixelFormat::NV12:
+	case PixelFormat::NV21:     return 1;
+	case PixelFormat::RGB888:   return 3;
+	case PixelFormat::RGBA8888: return 4;
+	default:                    return 0;
+	}
+}
+
+// Whether the frame's buffer holds every row, and every plane, its stride says it has.
+static bool hasRoom(const CameraFrame& frame) {
+	// A 4:2:0 chroma row covers an odd width's last pixel with a whole pair
+	uint32_t pixelBytes = bytesPerPixel(frame.format);
+	uint32_t rowBytes   = isYuv420(frame.format) ? frame.width + (frame.width & 1) : frame.width * pixelBytes;
+	if (frame.buffer == nullptr || pixelBytes == 0 || frame.stride < rowBytes)
+		return false;
+	uint64_t rows = frame.height + (isYuv420(frame.format) ? (frame.height + 1) / 2 : 0);
+	return static_cast<uint64_t>(frame.stride) * rows <= frame.bufferSize;
+}
+
+bool PixelConverter::convert(const CameraFrame& src, CameraFrame& dst) {
+	if (src.width != dst.width || src.height != dst.height || !hasRoom(src) || !hasRoom(dst))
+		return false;
+
+	const uint32_t width  = src.width;
+	const uint32_t height = src.height;
+	const uint8_t* in     = src.buffer;
+	uint8_t*       out    = dst.buffer;
+	const uint32_t inStride  = src.stride;
+	const uint32_t outStride = dst.stride;
+	const Kernels& kernels   = m_kernels;
+
+	if (src.format == dst.format) {
+		// Chroma rows hold a whole pair for an odd width's last pixel
+		uint32_t rowBytes    = width * bytesPerPixel(src.format);
+		uint32_t chromaBytes = (width + 1) / 2 * 2;
+		uint32_t rows        = height + (isYuv420(src.format) ? (height + 1) / 2 : 0);
+		runRowBands(m_pool.get(), rows, 1, [=](uint32_t first, uint32_t end) {
+			for (uint32_t row = first; row < end; row++)
+				memcpy(out + static_cast<size_t>(row) * outStride, in + static_cast<size_t>(row) * inStride, row < height ? rowBytes : chromaBytes);
+		});
+		return true;
+	}
+
+	if (src.format == PixelFormat::YUYV && isYuv420(dst.format)) {
+		if (width % 2 != 0)
+			return false;
+		bool     swapUV = dst.format == PixelFormat::NV21;
+		uint8_t* outUV  = out + static_cast<size_t>(outStride) * height;
+		runRowBands(m_pool.get(), height, 2, [=](uint32_t first, uint32_t end) {
+			for (uint32_t row = first; row < end; row += 2) {
+				// An odd last row takes its chroma from itself
+				uint32_t next = row + 1 < height ? row + 1 : row;
+				kernels.yuyvToNv12(
+					in + static_cast<size_t>(row) * inStride, in + static_cast<size_t>(next) * inStride,
+					out + static_cast<size_t>(row) * outStride, out + static_cast<size_t>(next) * outStride,
+					outUV + static_cast<size_t>(row / 2) * outStride, width, swapUV);
+			}
+		});
+		return true;
+	}
+
+	if (isYuv420(src.format) && dst.format == PixelFormat::YUYV) {
+		if (width % 2 != 0)
+			return false;
+		bool           swapUV = src.format == PixelFormat::NV21;
+		const uint8_t* inUV   = in + static_cast<size_t>(inStride) * height;
+		runRowBands(m_pool.get(), height, 2, [=](uint32_t first, uint32_t end) {
+			for (uint32_t row = first; row < end; row++)
+				kernels.nv12ToYuyv(in + static_cast<size_t>(row) * inStride, inUV + static_cast<size_t>(row / 2) * inStride, out + static_cast<size_t>(row) * outStride, width, swapUV);
+		});
+		return true;
+	}
+
+	if (isYuv420(src.format) && (dst.format == PixelFormat::RGB888 || dst.format == PixelFormat::RGBA8888)) {
+		bool           swapUV   = src.format == PixelFormat::NV21;
+		uint32_t       channels = bytesPerPixel(dst.format);
+		const uint8_t* inUV     = in + static_cast<size_t>(inStride) * height;
+		runRowBands(m_pool.get(), height, 2, [=](uint32_t first, uint32_t end) {
+			for (uint32_t row = first; row < end; row++)
+				kernels.nv12ToRgb(in + static_cast<size_t>(row) * inStride, inUV + static_cast<size_t>(row / 2) * inStride, out + static_cast<size_t>(row) * outStride, width, swapUV, channels);
+		});
+		return true;
+	}
+
+	return false;
+}
+
+bool PixelConverter::extractGray(const CameraFrame& src, uint8_t* dst, uint32_t dstStride) {
+	if (!hasRoom(src) || dst == nullptr || dstStride < src.width)
+		return false;
+
+	const uint32_t width    = src.width;
+	const uint8_t* in       = src.buffer;
+	const uint32_t inStride = src.stride;
+	const PixelFormat format   = src.format;
+	const Kernels&    kernels  = m_kernels;
+
+	runRowBands(m_pool.get(), src.height, 1, [=](uint32_t first, uint32_t end) {
+		for (uint32_t row = first; row < end; row++) {
+			const uint8_t* inRow  = in + static_cast<size_t>(row) * inStride;
+			uint8_t*       outRow = dst + static_cast<size_t>(row) * dstStride;
+			if (format == PixelFormat::YUYV)
+				kernels.yuyvToGray(inRow, outRow, width);
+			else if (isYuv420(format))
+				memcpy(outRow, inRow, width);
+			else
+				kernels.rgbToGray(inRow, outRow, width, bytesPerPixel(format));
+		}
+	});
+	return true;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "../VuforiaEngine/Driver/Driver.h"
+#include "../Common/ThreadPool.h"
+#include <memory>
+
+namespace TestApp
+{
+	enum class PixelKernelLevel {
+		Scalar, // Plain C++, the reference every other level must match byte for byte
+		Sse2,
+		Avx2,
+		Neon,
+	};
+
+	// The fastest level this CPU can run.
+	PixelKernelLevel getBestPixelKernelLevel();
+
+	///////////////////////////////////////////
+
+	// Converts camera frames between pixel formats, for drivers that get frames in one format
+	// and hand them to the engine in another, or for showing the camera image in the renderer.
+	// Planes follow the layout FrameBufferPool gives them: for NV12 and NV21, the interleaved
+	// chroma plane starts right after the luma plane, with the same stride.
+	//
+	// Supported conversions are YUYV to NV12/NV21 and back, NV12/NV21 to RGB888/RGBA8888, and
+	// a copy when both formats match. YUV is BT.601 video range, chroma is averaged over the
+	// two rows it covers when going to 4:2:0, and repeated when coming from it. YUYV needs
+	// an even width.
+	//
+	// Frames are cut into bands of rows that run on a thread pool, the calling thread taking
+	// the first band. Kernels have SSE2, AVX2 and NEON versions, picked for the CPU at
+	// construction, which fall back to the scalar one for the last pixels of a row. The
+	// exceptions are on x86: RGB888 to gray is scalar only, and AVX2 uses the SSE2 version
+	// for RGBA8888 to gray.
+	class PixelConverter {
+
+	public:
+		// threadCount extra threads help with each conversion, 0 keeps it all on the calling thread.
+		explicit PixelConverter(uint32_t threadCount, PixelKernelLevel level = getBestPixelKernelLevel());
+		~PixelConverter();
+
+		PixelConverter(const PixelConverter&) = delete;
+		PixelConverter& operator=(const PixelConverter&) = delete;
+
+		// Converts src into dst, which must already have its buffer, bufferSize, stride and
+		// format set, and the same width and height as src. Returns false if the conversion isn't
+		// supported or either buffer is too small.
+		bool convert(const VuforiaDriver::CameraFrame& src, VuforiaDriver::CameraFrame& dst);
+
+		// Writes the luma of src into dst, one byte per pixel. Works from every format.
+		bool extractGray(const VuforiaDriver::CameraFrame& src, uint8_t* dst, uint32_t dstStride);
+
+		PixelKernelLevel getLevel() const { return m_level; }
+
+		// Row kernels, one set per level. Widths are in pixels.
+		struct Kernels {
+			void (*yuyvToNv12)(const uint8_t* src0, const uint8_t* src1, uint8_t* y0, uint8_t* y1, uint8_t* uv, uint32_t width, bool swapUV);
+			void (*nv12ToYuyv)(const uint8_t* y, const uint8_t* uv, uint8_t* dst, uint32_t width, bool swapUV);
+			void (*nv12ToRgb)(const uint8_t* y, const uint8_t* uv, uint8_t* dst, uint32_t width, bool swapUV, uint32_t channels);
+			void (*yuyvToGray)(const uint8_t* src, uint8_t* dst, uint32_t width);
+			void (*rgbToGray)(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t channels);
+		};
+
+	private:
+		PixelKernelLevel                m_level;
+		Kernels                         m_kernels;
+		std::unique_ptr<DX::ThreadPool> m_pool;
+	};
+}
@@ -0,0 +1,232 @@
+#include "ReplayCamera.h"
+
+using namespace TestApp;
+using namespace VuforiaDriver;
+
+///////////////////////////////////////////
+
+ReplayCamera::ReplayCamera(const std::wstring& recordingPath, float speed, bool loop, FrameDropPolicy dropPolicy, uint32_t queueCapacity) :
+	m_recordingPath(recordingPath),
+	m_speed(speed),
+	m_loop(loop),
+	m_dropPolicy(speed > 0 ? dropPolicy : FrameDropPolicy::Block),
+	m_queueCapacity(queueCapacity > 0 ? queueCapacity : 4),
+	m_callback(nullptr),
+	m_observer(nullptr),
+	m_stopRequested(false),
+	m_capturedCount(0),
+	m_deliveredCount(0),
+	m_lastExposureTime(0),
+	m_playbackEnded(false),
+	m_finished(false) {
+}
+
+ReplayCamera::~ReplayCamera() {
+	close();
+}
+
+///////////////////////////////////////////
+
+bool ReplayCamera::open() {
+	if (m_recording == nullptr)
+		m_recording = FrameRecording::open(m_recordingPath);
+	m_capturedCount  = 0;
+	m_deliveredCount = 0;
+	return m_recording != nullptr;
+}
+
+bool ReplayCamera::close() {
+	stop();
+	m_recording = nullptr;
+	return true;
+}
+
+///////////////////////////////////////////
+
+bool ReplayCamera::start(CameraMode cameraMode, CameraCallback* cb) {
+	if (m_recording == nullptr || cb == nullptr || m_thread.joinable())
+		return false;
+
+	// There's only the one recorded mode, and frames can't be resized on the way out
+	CameraMode recorded = m_recording->getMode();
+	if (cameraMode.width != recorded.width || cameraMode.height != recorded.height || cameraMode.format != recorded.format)
+		return false;
+
+	// A loop that takes no time would push the same instant over and over, as fast as it can
+	if (m_loop && m_speed > 0 && getLoopLength() == 0)
+		return false;
+
+	m_callback       = cb;
+	m_stopRequested  = false;
+	m_playbackEnded  = false;
+	m_finished       = false;
+	m_queue          = std::make_unique<FrameQueue>(m_queueCapacity, m_dropPolicy);
+	m_deliveryThread = std::thread(&ReplayCamera::deliveryLoop, this);
+	m_thread         = std::thread(&ReplayCamera::playbackLoop, this);
+	return true;
+}
+
+bool ReplayCamera::stop() {
+	if (!m_thread.joinable())
+		return false;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopRequested = true;
+	}
+	m_stopCondition.notify_all();
+
+	// Closing the queue also frees playback if it's blocked waiting for room
+	m_queue->close();
+	m_thread.join();
+	m_deliveryThread.join();
+	m_callback = nullptr;
+	return true;
+}
+
+void ReplayCamera::setFrameObserver(CameraFrameObserver* observer) {
+	std::lock_guard<std::mutex> lock(m_observerMutex);
+	m_observer = observer;
+}
+
+///////////////////////////////////////////
+
+// Sleeps until time, unless stop() comes first. Returns false if playback should end.
+bool ReplayCamera::waitUntil(std::chrono::steady_clock::time_point time) {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_stopCondition.wait_until(lock, time, [this]() { return m_stopRequested; });
+	return !m_stopRequested;
+}
+
+// How much media time one pass through the recording takes when looping. One frame period
+// is left between the last frame and the first one again: the recorded rate's, or else the
+// average spacing of the recorded frames.
+uint64_t ReplayCamera::getLoopLength() const {
+	const uint32_t frameCount = m_recording->getFrameCount();
+	const uint32_t fps        = m_recording->getMode().fps;
+	const uint64_t firstTime  = m_recording->getEntry(0).timestamp;
+	const uint64_t lastTime   = m_recording->getEntry(frameCount - 1).timestamp;
+
+	uint64_t framePeriod = 0;
+	if (fps > 0)
+		framePeriod = 1000000000ull / fps;
+	else if (frameCount > 1)
+		framePeriod = (lastTime - firstTime) / (frameCount - 1);
+	return lastTime - firstTime + framePeriod;
+}
+
+void ReplayCamera::playbackLoop() {
+	using namespace std::chrono;
+
+	const uint32_t   frameCount = m_recording->getFrameCount();
+	const CameraMode mode       = m_recording->getMode();
+	const uint64_t   firstTime  = m_recording->getEntry(0).timestamp;
+	const uint64_t   loopLength = getLoopLength();
+
+	const steady_clock::time_point startTime = steady_clock::now();
+	const uint64_t startNs = duration_cast<nanoseconds>(startTime.time_since_epoch()).count();
+
+	uint64_t loopOffset = 0;
+	for (;;) {
+		for (uint32_t i = 0; i < frameCount; i++) {
+			FrameRecordingEntry entry = m_recording->getEntry(i);
+			uint64_t mediaTime = loopOffset + (entry.timestamp - firstTime);
+
+			if (m_speed > 0) {
+				auto due = startTime + nanoseconds(static_cast<int64_t>(mediaTime / m_speed));
+				if (!waitUntil(due))
+					return;
+			} else {
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (m_stopRequested)
+					return;
+			}
+
+			CameraFrame frame;
+			frame.timestamp    = startNs + mediaTime;
+			frame.exposureTime = entry.exposureTime;
+			frame.buffer       = const_cast<uint8_t*>(m_recording->getPixels(entry));
+			frame.bufferSize   = entry.size;
+			frame.index        = static_cast<uint32_t>(m_capturedCount);
+			frame.width        = mode.width;
+			frame.height       = mode.height;
+			frame.stride       = m_recording->getStride();
+			frame.format       = mode.format;
+			frame.intrinsics   = entry.intrinsics;
+
+			// Buffers belong to the mapping, so frames dropped along the way need nothing back
+			if (m_queue->push(frame) == FramePushResult::Closed)
+				return;
+			m_capturedCount += 1;
+		}
+
+		if (!m_loop)
+			break;
+		loopOffset += loopLength;
+	}
+
+	// Let delivery finish what's queued, then stop
+	m_playbackEnded = true;
+	m_queue->close();
+}
+
+void ReplayCamera::deliveryLoop() {
+	QueuedFrame item;
+	for (;;) {
+		bool popped = m_queue->pop(item, std::chrono::milliseconds(100));
+
+		// Once stop() has been asked for, what's still queued is dropped, not handed to the engine
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_stopRequested)
+				return;
+		}
+		if (!popped) {
+			if (m_queue->getCounters().depth == 0 && m_playbackEnded)
+				break;
+			continue;
+		}
+
+		m_lastExposureTime = item.frame.exposureTime;
+		{
+			std::lock_guard<std::mutex> lock(m_observerMutex);
+			if (m_observer != nullptr)
+				m_observer->onCameraFrame(item.frame);
+		}
+		m_callback->onNewCameraFrame(&item.frame);
+		m_deliveredCount += 1;
+	}
+	m_finished = true;
+}
+
+///////////////////////////////////////////
+
+uint32_t ReplayCamera::getNumSupportedCameraModes() {
+	return m_recording != nullptr ? 1 : 0;
+}
+
+bool ReplayCamera::getSupportedCameraMode(uint32_t index, CameraMode* cameraMode) {
+	if (m_recording == nullptr || index != 0 || cameraMode == nullptr)
+		return false;
+	*cameraMode = m_recording->getMode();
+	return true;
+}
+
+///////////////////////////////////////////
+
+bool         ReplayCamera::supportsExposureMode(ExposureMode exposureMode) { return exposureMode == ExposureMode::CONTINUOUS_AUTO; }
+ExposureMode ReplayCamera::getExposureMode()                               { return ExposureMode::CONTINUOUS_AUTO; }
+bool         ReplayCamera::setExposureMode(ExposureMode exposureMode)      { return exposureMode == ExposureMode::CONTINUOUS_AUTO; }
+bool         ReplayCamera::supportsExposureValue()                         { return false; }
+uint64_t     ReplayCamera::getExposureValueMin()                           { return 0; }
+uint64_t     ReplayCamera::getExposureValueMax()                           { return 0; }
+uint64_t     ReplayCamera::getExposureValue()                              { return m_lastExposureTime; }
+bool         ReplayCamera::setExposureValue(uint64_t)                      { return false; }
+
+bool      ReplayCamera::supportsFocusMode(FocusMode focusMode) { return focusMode == FocusMode::FIXED; }
+FocusMode ReplayCamera::getFocusMode()                         { return FocusMode::FIXED; }
+bool      ReplayCamera::setFocusMode(FocusMode mode)           { return mode == FocusMode::FIXED; }
+bool      ReplayCamera::supportsFocusValue()                   { return false; }
+float     ReplayCamera::getFocusValueMin()                     { return 0; }
+float     ReplayCamera::getFocusValueMax()                     { return 0; }
+float     ReplayCamera::getFocusValue()                        { return 0; }
+bool      ReplayCamera::setFocusValue(float)                   { return false; }
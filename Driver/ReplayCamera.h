@@ -0,0 +1,108 @@
+#pragma once
+
+#include "FrameRecording.h"
+#include "FrameQueue.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace TestApp
+{
+	// An ExternalCamera that plays a FrameRecording back instead of talking to hardware.
+	// Frames are delivered straight out of the file mapping, without copying, at the
+	// recorded rate scaled by speed. A speed of 0 delivers frames as fast as the callback
+	// takes them, which makes tracking benchmarks deterministic.
+	//
+	// Timestamps keep the recorded spacing, shifted onto the steady clock at start(), so
+	// at a speed of 1 they line up with the real time each frame is delivered. Exposure
+	// time and intrinsics are the recorded ones. The engine must not write into buffers,
+	// since they point into a read-only mapping.
+	//
+	// Playback and delivery run on separate threads with a FrameQueue between them, so a
+	// slow callback costs frames, according to dropPolicy, instead of shifting the timing of
+	// the ones after it. A speed of 0 always blocks, since there's no rate to keep up with.
+	//
+	// Looping needs a loop with some length to it: a single frame recorded without a frame
+	// rate can't be looped at a real-time speed, and start() refuses it.
+	class ReplayCamera final : public VuforiaDriver::ExternalCamera {
+
+	public:
+		ReplayCamera(const std::wstring& recordingPath, float speed, bool loop, FrameDropPolicy dropPolicy, uint32_t queueCapacity);
+		~ReplayCamera();
+
+		bool VUFORIA_DRIVER_CALLING_CONVENTION open() override;
+		bool VUFORIA_DRIVER_CALLING_CONVENTION close() override;
+		bool VUFORIA_DRIVER_CALLING_CONVENTION start(VuforiaDriver::CameraMode cameraMode, VuforiaDriver::CameraCallback* cb) override;
+		bool VUFORIA_DRIVER_CALLING_CONVENTION stop() override;
+
+		uint32_t VUFORIA_DRIVER_CALLING_CONVENTION getNumSupportedCameraModes() override;
+		bool VUFORIA_DRIVER_CALLING_CONVENTION getSupportedCameraMode(uint32_t index, VuforiaDriver::CameraMode* cameraMode) override;
+
+		// Exposure and focus are whatever the recording had, so the only supported modes are
+		// the automatic ones, and nothing can be set manually.
+		bool VUFORIA_DRIVER_CALLING_CONVENTION supportsExposureMode(VuforiaDriver::ExposureMode exposureMode) override;
+		VuforiaDriver::ExposureMode VUFORIA_DRIVER_CALLING_CONVENTION getExposureMode() override;
+		bool VUFORIA_DRIVER_CALLING_CONVENTION setExposureMode(VuforiaDriver::ExposureMode exposureMode) override;
+		bool VUFORIA_DRIVER_CALLING_CONVENTION supportsExposureValue() override;
+		uint64_t VUFORIA_DRIVER_CALLING_CONVENTION getExposureValueMin() override;
+		uint64_t VUFORIA_DRIVER_CALLING_CONVENTION getExposureValueMax() override;
+		uint64_t VUFORIA_DRIVER_CALLING_CONVENTION getExposureValue() override;
+		bool VUFORIA_DRIVER_CALLING_CONVENTION setExposureValue(uint64_t exposureTime) override;
+
+		bool VUFORIA_DRIVER_CALLING_CONVENTION supportsFocusMode(VuforiaDriver::FocusMode focusMode) override;
+		VuforiaDriver::FocusMode VUFORIA_DRIVER_CALLING_CONVENTION getFocusMode() override;
+		bool VUFORIA_DRIVER_CALLING_CONVENTION setFocusMode(VuforiaDriver::FocusMode mode) override;
+		bool VUFORIA_DRIVER_CALLING_CONVENTION supportsFocusValue() override;
+		float VUFORIA_DRIVER_CALLING_CONVENTION getFocusValueMin() override;
+		float VUFORIA_DRIVER_CALLING_CONVENTION getFocusValueMax() override;
+		float VUFORIA_DRIVER_CALLING_CONVENTION getFocusValue() override;
+		bool VUFORIA_DRIVER_CALLING_CONVENTION setFocusValue(float focusValue) override;
+
+		// Frames are delivered on the delivery thread, so let the engine do its processing on its own.
+		bool VUFORIA_DRIVER_CALLING_CONVENTION processFramesOnThread() override { return true; }
+
+		// Also shown every frame, just before the engine gets it. nullptr to stop. Once this
+		// returns, the old observer won't be called again.
+		void setFrameObserver(CameraFrameObserver* observer);
+
+		// Number of frames handed to the callback since open().
+		uint64_t getDeliveredFrameCount() const { return m_deliveredCount; }
+
+		// True once a non-looping playback has delivered its last frame.
+		bool isFinished() const { return m_finished; }
+
+		// Drops, queue depth and latency between playback and delivery, since start().
+		FrameQueueCounters getQueueCounters() const { return m_queue != nullptr ? m_queue->getCounters() : FrameQueueCounters(); }
+
+	private:
+		void playbackLoop();
+		void deliveryLoop();
+		bool waitUntil(std::chrono::steady_clock::time_point time);
+		uint64_t getLoopLength() const;
+
+		std::wstring                     m_recordingPath;
+		double                           m_speed;
+		bool                             m_loop;
+		FrameDropPolicy                  m_dropPolicy;
+		uint32_t                         m_queueCapacity;
+		std::shared_ptr<FrameRecording>  m_recording;
+		VuforiaDriver::CameraCallback*   m_callback;
+
+		std::unique_ptr<FrameQueue>      m_queue;
+		std::thread                      m_thread;
+		std::thread                      m_deliveryThread;
+		std::mutex                       m_mutex;
+		std::mutex                       m_observerMutex;
+		CameraFrameObserver*             m_observer;
+		std::condition_variable          m_stopCondition;
+		bool                             m_stopRequested;
+
+		std::atomic<uint64_t>            m_capturedCount;
+		std::atomic<uint64_t>            m_deliveredCount;
+		std::atomic<uint64_t>            m_lastExposureTime;
+		std::atomic<bool>                m_playbackEnded;
+		std::atomic<bool>                m_finished;
+	};
+}
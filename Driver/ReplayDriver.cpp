@@ -0,0 +1,107 @@
+#include "ReplayDriver.h"
+#include <cstring>
+
+using namespace TestApp;
+
+///////////////////////////////////////////
+
+ReplayDriver::ReplayDriver(const ReplayDriverConfig& config) :
+	m_recordingPath(config.recordingPath != nullptr ? config.recordingPath : L""),
+	m_speed(config.speed),
+	m_loop(config.loop),
+	m_dropPolicy(config.dropPolicy),
+	m_queueCapacity(config.queueCapacity),
+	m_syntheticMode(config.syntheticMode),
+	m_poseConfig(config.pose),
+	m_camera(nullptr),
+	m_tracker(nullptr) {
+}
+
+VuforiaDriver::ExternalCamera* ReplayDriver::createExternalCamera() {
+	if (m_camera != nullptr)
+		return nullptr;
+	if (m_recordingPath.empty())
+		m_camera = new SyntheticCamera(m_syntheticMode, m_dropPolicy, m_queueCapacity);
+	else
+		m_camera = new ReplayCamera(m_recordingPath, m_speed, m_loop, m_dropPolicy, m_queueCapacity);
+	connectCamera(m_tracker);
+	return m_camera;
+}
+
+// ExternalCamera has no virtual destructor, so delete through whichever type createExternalCamera made.
+void ReplayDriver::destroyExternalCamera(VuforiaDriver::ExternalCamera* instance) {
+	if (instance == nullptr || instance != m_camera)
+		return;
+	if (m_recordingPath.empty())
+		delete static_cast<SyntheticCamera*>(instance);
+	else
+		delete static_cast<ReplayCamera*>(instance);
+	m_camera = nullptr;
+}
+
+///////////////////////////////////////////
+
+VuforiaDriver::ExternalPositionalDeviceTracker* ReplayDriver::createExternalPositionalDeviceTracker() {
+	if (m_poseConfig.headHistory == nullptr || m_tracker != nullptr)
+		return nullptr;
+	m_tracker = new XrPoseTracker(m_poseConfig);
+	connectCamera(m_tracker);
+	return m_tracker;
+}
+
+// The camera has to let go of the tracker first, it may be delivering a frame to it.
+void ReplayDriver::destroyExternalPositionalDeviceTracker(VuforiaDriver::ExternalPositionalDeviceTracker* instance) {
+	if (instance == nullptr || instance != m_tracker)
+		return;
+	m_tracker->stop();
+	connectCamera(nullptr);
+	delete m_tracker;
+	m_tracker = nullptr;
+}
+
+uint32_t ReplayDriver::getCapabilities() {
+	if (m_poseConfig.headHistory == nullptr)
+		return VuforiaDriver::Capability::CAMERA_IMAGE;
+	return VuforiaDriver::Capability::CAMERA_IMAGE | VuforiaDriver::Capability::CAMERA_POSE;
+}
+
+void ReplayDriver::connectCamera(CameraFrameObserver* observer) {
+	if (m_camera == nullptr)
+		return;
+	if (m_recordingPath.empty())
+		static_cast<SyntheticCamera*>(m_camera)->setFrameObserver(observer);
+	else
+		static_cast<ReplayCamera*>(m_camera)->setFrameObserver(observer);
+}
+
+///////////////////////////////////////////
+
+extern "C"
+{
+	uint32_t VUFORIA_DRIVER_CALLING_CONVENTION vuforiaDriver_getAPIVersion() {
+		return VuforiaDriver::VUFORIA_DRIVER_API_VERSION;
+	}
+
+	uint32_t VUFORIA_DRIVER_CALLING_CONVENTION vuforiaDriver_getLibraryVersion(char* versionString, const uint32_t maxLen) {
+		const char* version = "ReplayDriver-1.0.0";
+		uint32_t    length  = static_cast<uint32_t>(strlen(version));
+		if (versionString == nullptr || maxLen == 0)
+			return length;
+
+		uint32_t copied = length < maxLen - 1 ? length : maxLen - 1;
+		memcpy(versionString, version, copied);
+		versionString[copied] = '\0';
+		return copied;
+	}
+
+	// userData must point to a ReplayDriverConfig, passed through the engine's driver config.
+	VuforiaDriver::Driver* VUFORIA_DRIVER_CALLING_CONVENTION vuforiaDriver_init(VuforiaDriver::PlatformData*, void* userData) {
+		if (userData == nullptr)
+			return nullptr;
+		return new ReplayDriver(*static_cast<ReplayDriverConfig*>(userData));
+	}
+
+	void VUFORIA_DRIVER_CALLING_CONVENTION vuforiaDriver_deinit(VuforiaDriver::Driver* instance) {
+		delete static_cast<ReplayDriver*>(instance);
+	}
+}
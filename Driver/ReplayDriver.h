@@ -0,0 +1,57 @@
+#pragma once
+
+#include "ReplayCamera.h"
+#include "SyntheticCamera.h"
+#include "XrPoseTracker.h"
+
+namespace TestApp
+{
+	// What the app hands the engine as the driver's userData.
+	struct ReplayDriverConfig {
+		const wchar_t*  recordingPath; // nullptr to get a SyntheticCamera in syntheticMode instead
+		float           speed; // 1 plays at the recorded rate, 0 as fast as frames are consumed
+		bool            loop;
+
+		// What happens to frames when the engine falls behind. See FrameQueue.
+		FrameDropPolicy dropPolicy;
+		uint32_t        queueCapacity; // 0 picks a default
+
+		VuforiaDriver::CameraMode syntheticMode;
+
+		// Camera poses from the app's OpenXR head poses. With no headHistory, the engine
+		// tracks from camera images alone.
+		XrPoseTrackerConfig pose;
+	};
+
+	// Vuforia Driver that feeds the engine a recorded camera stream instead of a device camera,
+	// or a synthetic one when there is no recording. Given the app's head history, it also
+	// hands the engine a pose for every frame, through an XrPoseTracker.
+	class ReplayDriver final : public VuforiaDriver::Driver {
+
+	public:
+		explicit ReplayDriver(const ReplayDriverConfig& config);
+
+		VuforiaDriver::ExternalCamera* VUFORIA_DRIVER_CALLING_CONVENTION createExternalCamera() override;
+		void VUFORIA_DRIVER_CALLING_CONVENTION destroyExternalCamera(VuforiaDriver::ExternalCamera* instance) override;
+
+		VuforiaDriver::ExternalPositionalDeviceTracker* VUFORIA_DRIVER_CALLING_CONVENTION createExternalPositionalDeviceTracker() override;
+		void VUFORIA_DRIVER_CALLING_CONVENTION destroyExternalPositionalDeviceTracker(VuforiaDriver::ExternalPositionalDeviceTracker* instance) override;
+
+		uint32_t VUFORIA_DRIVER_CALLING_CONVENTION getCapabilities() override;
+
+	private:
+		// Points the camera, if there is one, at the tracker, or at nothing.
+		void connectCamera(CameraFrameObserver* observer);
+
+		std::wstring    m_recordingPath;
+		float           m_speed;
+		bool            m_loop;
+		FrameDropPolicy m_dropPolicy;
+		uint32_t        m_queueCapacity;
+		VuforiaDriver::CameraMode m_syntheticMode;
+		XrPoseTrackerConfig       m_poseConfig;
+
+		VuforiaDriver::ExternalCamera* m_camera;
+		XrPoseTracker*                 m_tracker;
+	};
+}
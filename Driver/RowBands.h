@@ -0,0 +1,56 @@
+#pragma once
+
+#include "../Common/ThreadPool.h"
+#include <condition_variable>
+#include <mutex>
+
+namespace TestApp
+{
+	// Rows a band gets at the very least, so small images stay on the calling thread.
+	const uint32_t rowBandMinRows = 64;
+
+	// Splits rows into at most one band per pool thread plus one, each a whole number of units
+	// (row pairs for 4:2:0 images), and runs band(firstRow, endRow) for each. The calling thread
+	// takes the first band, and the call returns once every band is done. With no pool,
+	// everything runs on the calling thread.
+	template<typename BandFunction>
+	void runRowBands(DX::ThreadPool* pool, uint32_t rows, uint32_t rowsPerUnit, BandFunction band) {
+		uint32_t units     = (rows + rowsPerUnit - 1) / rowsPerUnit;
+		uint32_t maxBands  = pool != nullptr ? static_cast<uint32_t>(pool->GetThreadCount()) + 1 : 1;
+		uint32_t bandCount = rows / rowBandMinRows;
+		bandCount = bandCount < 1 ? 1 : bandCount > maxBands ? maxBands : bandCount;
+		if (bandCount == 1) {
+			band(0u, rows);
+			return;
+		}
+
+		std::mutex              mutex;
+		std::condition_variable done;
+		uint32_t                remaining = bandCount - 1;
+
+		auto bandRows = [&](uint32_t index, uint32_t& first, uint32_t& end) {
+			first = units * index / bandCount * rowsPerUnit;
+			end   = units * (index + 1) / bandCount * rowsPerUnit;
+			end   = end < rows ? end : rows;
+		};
+
+		for (uint32_t i = 1; i < bandCount; i++) {
+			pool->Submit([&, i]() {
+				uint32_t first, end;
+				bandRows(i, first, end);
+				band(first, end);
+
+				std::lock_guard<std::mutex> lock(mutex);
+				if (--remaining == 0)
+					done.notify_one();
+			});
+		}
+
+		uint32_t first, end;
+		bandRows(0, first, end);
+		band(first, end);
+
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [&]() { return remaining == 0; });
+	}
+}
@@ -0,0 +1,233 @@
+#include "SyntheticCamera.h"
+#include <cstring>
+
+using namespace TestApp;
+using namespace VuforiaDriver;
+
+///////////////////////////////////////////
+
+SyntheticCamera::SyntheticCamera(const CameraMode& mode, FrameDropPolicy dropPolicy, uint32_t queueCapacity) :
+	m_mode(mode),
+	m_dropPolicy(mode.fps > 0 ? dropPolicy : FrameDropPolicy::Block),
+	m_queueCapacity(queueCapacity > 0 ? queueCapacity : 4),
+	m_open(false),
+	m_callback(nullptr),
+	m_observer(nullptr),
+	m_stopRequested(false),
+	m_deliveredCount(0) {
+}
+
+SyntheticCamera::~SyntheticCamera() {
+	close();
+}
+
+///////////////////////////////////////////
+
+bool SyntheticCamera::open() {
+	m_open           = getFrameSize(m_mode) > 0;
+	m_deliveredCount = 0;
+	return m_open;
+}
+
+bool SyntheticCamera::close() {
+	stop();
+	m_open = false;
+	return true;
+}
+
+///////////////////////////////////////////
+
+bool SyntheticCamera::start(CameraMode cameraMode, CameraCallback* cb) {
+	if (!m_open || cb == nullptr || m_thread.joinable())
+		return false;
+	if (cameraMode.width != m_mode.width || cameraMode.height != m_mode.height || cameraMode.format != m_mode.format)
+		return false;
+
+	// One buffer per queued frame, plus the one being filled and the one being delivered
+	auto queue = std::make_unique<FrameQueue>(m_queueCapacity, m_dropPolicy);
+	if (!m_pool.configure(m_mode, queue->getCapacity() + 2))
+		return false;
+
+	m_callback       = cb;
+	m_stopRequested  = false;
+	m_queue          = std::move(queue);
+	m_deliveryThread = std::thread(&SyntheticCamera::deliveryLoop, this);
+	m_thread         = std::thread(&SyntheticCamera::captureLoop, this);
+	return true;
+}
+
+bool SyntheticCamera::stop() {
+	if (!m_thread.joinable())
+		return false;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopRequested = true;
+	}
+	m_stopCondition.notify_all();
+	m_queue->close();
+	m_thread.join();
+	m_deliveryThread.join();
+
+	// Whatever delivery didn't get to still holds a buffer
+	QueuedFrame item;
+	while (m_queue->tryPop(item))
+		m_pool.release(item.frame.buffer);
+	m_callback = nullptr;
+	return true;
+}
+
+void SyntheticCamera::setFrameObserver(CameraFrameObserver* observer) {
+	std::lock_guard<std::mutex> lock(m_observerMutex);
+	m_observer = observer;
+}
+
+///////////////////////////////////////////
+
+void SyntheticCamera::captureLoop() {
+	using namespace std::chrono;
+
+	const steady_clock::time_point startTime = steady_clock::now();
+	const uint64_t startNs  = duration_cast<nanoseconds>(startTime.time_since_epoch()).count();
+	const uint64_t period   = m_mode.fps > 0 ? 1000000000ull / m_mode.fps : 0;
+	const float    focal    = static_cast<float>(m_mode.width);
+
+	for (uint32_t index = 0; ; index++) {
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			if (period > 0)
+				m_stopCondition.wait_until(lock, startTime + nanoseconds(period * index), [this]() { return m_stopRequested; });
+			if (m_stopRequested)
+				return;
+		}
+
+		// Every buffer is still out, so this frame never happened
+		uint8_t* buffer = m_pool.acquire();
+		if (buffer == nullptr)
+			continue;
+		fillFrame(buffer, index);
+
+		CameraFrame frame;
+		frame.timestamp    = period > 0 ? startNs + period * index : frameQueueNow();
+		frame.exposureTime = period;
+		frame.buffer       = buffer;
+		frame.bufferSize   = m_pool.getBufferSize();
+		frame.index        = index;
+		frame.width        = m_mode.width;
+		frame.height       = m_mode.height;
+		frame.stride       = m_pool.getStride();
+		frame.format       = m_mode.format;
+		frame.intrinsics.focalLengthX    = focal;
+		frame.intrinsics.focalLengthY    = focal;
+		frame.intrinsics.principalPointX = m_mode.width  * 0.5f;
+		frame.intrinsics.principalPointY = m_mode.height * 0.5f;
+
+		QueuedFrame dropped;
+		switch (m_queue->push(frame, &dropped)) {
+		case FramePushResult::Queued: break;
+		case FramePushResult::QueuedDroppedOldest: m_pool.release(dropped.frame.buffer); break;
+		case FramePushResult::DroppedNewest:       m_pool.release(buffer);               break;
+		case FramePushResult::Closed:              m_pool.release(buffer);               return;
+		}
+	}
+}
+
+void SyntheticCamera::deliveryLoop() {
+	QueuedFrame item;
+	for (;;) {
+		if (!m_queue->pop(item, std::chrono::milliseconds(100))) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_stopRequested)
+				return;
+			continue;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_observerMutex);
+			if (m_observer != nullptr)
+				m_observer->onCameraFrame(item.frame);
+		}
+
+		// The engine copies whatever it keeps before returning, so the buffer is free again
+		m_callback->onNewCameraFrame(&item.frame);
+		m_pool.release(item.frame.buffer);
+		m_deliveredCount += 1;
+	}
+}
+
+///////////////////////////////////////////
+
+// Diagonal bands that move one pixel right each frame, in mid gray chroma.
+void SyntheticCamera::fillFrame(uint8_t* buffer, uint32_t frameIndex) {
+	const uint32_t stride = m_pool.getStride();
+	const uint32_t width  = m_mode.width;
+	const uint32_t height = m_mode.height;
+
+	for (uint32_t y = 0; y < height; y++) {
+		uint8_t* row = buffer + static_cast<size_t>(y) * stride;
+		uint32_t shade = y + frameIndex;
+		switch (m_mode.format) {
+		case PixelFormat::YUYV:
+			for (uint32_t x = 0; x < width; x += 2) {
+				row[x * 2 + 0] = static_cast<uint8_t>(shade + x);
+				row[x * 2 + 1] = 128;
+				row[x * 2 + 2] = static_cast<uint8_t>(shade + x + 1);
+				row[x * 2 + 3] = 128;
+			}
+			break;
+		case PixelFormat::NV12:
+		case PixelFormat::NV21:
+			for (uint32_t x = 0; x < width; x++)
+				row[x] = static_cast<uint8_t>(shade + x);
+			break;
+		case PixelFormat::RGB888:
+			for (uint32_t x = 0; x < width; x++)
+				row[x * 3 + 0] = row[x * 3 + 1] = row[x * 3 + 2] = static_cast<uint8_t>(shade + x);
+			break;
+		case PixelFormat::RGBA8888:
+			for (uint32_t x = 0; x < width; x++) {
+				row[x * 4 + 0] = row[x * 4 + 1] = row[x * 4 + 2] = static_cast<uint8_t>(shade + x);
+				row[x * 4 + 3] = 255;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	// The chroma plane of the 4:2:0 formats stays gray
+	if (m_mode.format == PixelFormat::NV12 || m_mode.format == PixelFormat::NV21)
+		memset(buffer + static_cast<size_t>(height) * stride, 128, static_cast<size_t>(stride) * ((height + 1) / 2));
+}
+
+///////////////////////////////////////////
+
+uint32_t SyntheticCamera::getNumSupportedCameraModes() {
+	return m_open ? 1 : 0;
+}
+
+bool SyntheticCamera::getSupportedCameraMode(uint32_t index, CameraMode* cameraMode) {
+	if (!m_open || index != 0 || cameraMode == nullptr)
+		return false;
+	*cameraMode = m_mode;
+	return true;
+}
+
+///////////////////////////////////////////
+
+bool         SyntheticCamera::supportsExposureMode(ExposureMode exposureMode) { return exposureMode == ExposureMode::CONTINUOUS_AUTO; }
+ExposureMode SyntheticCamera::getExposureMode()                               { return ExposureMode::CONTINUOUS_AUTO; }
+bool         SyntheticCamera::setExposureMode(ExposureMode exposureMode)      { return exposureMode == ExposureMode::CONTINUOUS_AUTO; }
+bool         SyntheticCamera::supportsExposureValue()                         { return false; }
+uint64_t     SyntheticCamera::getExposureValueMin()                           { return 0; }
+uint64_t     SyntheticCamera::getExposureValueMax()                           { return 0; }
+uint64_t     SyntheticCamera::getExposureValue()                              { return m_mode.fps > 0 ? 1000000000ull / m_mode.fps : 0; }
+bool         SyntheticCamera::setExposureValue(uint64_t)                      { return false; }
+
+bool      SyntheticCamera::supportsFocusMode(FocusMode focusMode) { return focusMode == FocusMode::FIXED; }
+FocusMode SyntheticCamera::getFocusMode()                         { return FocusMode::FIXED; }
+bool      SyntheticCamera::setFocusMode(FocusMode mode)           { return mode == FocusMode::FIXED; }
+bool      SyntheticCamera::supportsFocusValue()                   { return false; }
+float     SyntheticCamera::getFocusValueMin()                     { return 0; }
+float     SyntheticCamera::getFocusValueMax()                     { return 0; }
+float     SyntheticCamera::getFocusValue()                        { return 0; }
+bool      SyntheticCamera::setFocusValue(float)                   { return false; }
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "FrameBufferPool.h"
+#include "FrameQueue.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace TestApp
+{
+	// An ExternalCamera that makes its frames up: a gradient that scrolls one step per frame,
+	// in whatever mode it was created with. Good for exercising the engine and the capture
+	// path without a device or a recording.
+	//
+	// It captures the way a real camera driver should: into buffers from a FrameBufferPool,
+	// through a FrameQueue to a delivery thread, with each buffer going back to the pool once
+	// the engine is done with it, or as soon as the frame is dropped. Once the pool has
+	// warmed up, capture doesn't allocate at all. A mode with an fps of 0 delivers frames as
+	// fast as the callback takes them.
+	class SyntheticCamera final : public VuforiaDriver::ExternalCamera {
+
+	public:
+		SyntheticCamera(const VuforiaDriver::CameraMode& mode, FrameDropPolicy dropPolicy, uint32_t queueCapacity);
+		~SyntheticCamera();
+
+		bool VUFORIA_DRIVER_CALLING_CONVENTION open() override;
+		bool VUFORIA_DRIVER_CALLING_CONVENTION close() override;
+		bool VUFORIA_DRIVER_CALLING_CONVENTION start(VuforiaDriver::CameraMode cameraMode, VuforiaDriver::CameraCallback* cb) override;
+		bool VUFORIA_DRIVER_CALLING_CONVENTION stop() override;
+
+		uint32_t VUFORIA_DRIVER_CALLING_CONVENTION getNumSupportedCameraModes() override;
+		bool VUFORIA_DRIVER_CALLING_CONVENTION getSupportedCameraMode(uint32_t index, VuforiaDriver::CameraMode* cameraMode) override;
+
+		// There's no sensor, so exposure and focus are fixed.
+		bool VUFORIA_DRIVER_CALLING_CONVENTION supportsExposureMode(VuforiaDriver::ExposureMode exposureMode) override;
+		VuforiaDriver::ExposureMode VUFORIA_DRIVER_CALLING_CONVENTION getExposureMode() override;
+		bool VUFORIA_DRIVER_CALLING_CONVENTION setExposureMode(VuforiaDriver::ExposureMode exposureMode) override;
+		bool VUFORIA_DRIVER_CALLING_CONVENTION supportsExposureValue() override;
+		uint64_t VUFORIA_DRIVER_CALLING_CONVENTION getExposureValueMin() override;
+		uint64_t VUFORIA_DRIVER_CALLING_CONVENTION getExposureValueMax() override;
+		uint64_t VUFORIA_DRIVER_CALLING_CONVENTION getExposureValue() override;
+		bool VUFORIA_DRIVER_CALLING_CONVENTION setExposureValue(uint64_t exposureTime) override;
+
+		bool VUFORIA_DRIVER_CALLING_CONVENTION supportsFocusMode(VuforiaDriver::FocusMode focusMode) override;
+		VuforiaDriver::FocusMode VUFORIA_DRIVER_CALLING_CONVENTION getFocusMode() override;
+		bool VUFORIA_DRIVER_CALLING_CONVENTION setFocusMode(VuforiaDriver::FocusMode mode) override;
+		bool VUFORIA_DRIVER_CALLING_CONVENTION supportsFocusValue() override;
+		float VUFORIA_DRIVER_CALLING_CONVENTION getFocusValueMin() override;
+		float VUFORIA_DRIVER_CALLING_CONVENTION getFocusValueMax() override;
+		float VUFORIA_DRIVER_CALLING_CONVENTION getFocusValue() override;
+		bool VUFORIA_DRIVER_CALLING_CONVENTION setFocusValue(float focusValue) override;
+
+		// Frames are delivered on the delivery thread, so let the engine do its processing on its own.
+		bool VUFORIA_DRIVER_CALLING_CONVENTION processFramesOnThread() override { return true; }
+
+		// Also shown every frame, just before the engine gets it. nullptr to stop. Once this
+		// returns, the old observer won't be called again.
+		void setFrameObserver(CameraFrameObserver* observer);
+
+		uint64_t getDeliveredFrameCount() const { return m_deliveredCount; }
+
+		FrameQueueCounters   getQueueCounters() const { return m_queue != nullptr ? m_queue->getCounters() : FrameQueueCounters(); }
+		FrameBufferPoolStats getBufferStats()         { return m_pool.getStats(); }
+
+	private:
+		void captureLoop();
+		void deliveryLoop();
+		void fillFrame(uint8_t* buffer, uint32_t frameIndex);
+
+		VuforiaDriver::CameraMode        m_mode;
+		FrameDropPolicy                  m_dropPolicy;
+		uint32_t                         m_queueCapacity;
+		bool                             m_open;
+		VuforiaDriver::CameraCallback*   m_callback;
+
+		FrameBufferPool                  m_pool;
+		std::unique_ptr<FrameQueue>      m_queue;
+		std::thread                      m_thread;
+		std::thread                      m_deliveryThread;
+		std::mutex                       m_mutex;
+		std::mutex                       m_observerMutex;
+		CameraFrameObserver*             m_observer;
+		std::condition_variable          m_stopCondition;
+		bool                             m_stopRequested;
+
+		std::atomic<uint64_t>            m_deliveredCount;
+	};
+}
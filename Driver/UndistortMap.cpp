@@ -0,0 +1,408 @@
+#include "UndistortMap.h"
+#include "RowBands.h"
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define UNDISTORT_SSE2
+	#include <emmintrin.h>
+#elif defined(_M_ARM) || defined(_M_ARM64) || defined(__ARM_NEON)
+	#define UNDISTORT_NEON
+	#include <arm_neon.h>
+#endif
+
+using namespace TestApp;
+using namespace VuforiaDriver;
+
+// Bilinear weights go from 0 to weightOne, so a weighted pair of bytes still fits a signed
+// 16 bit lane, and the final blend of two of them a 32 bit one.
+const int weightBits = 7;
+const int weightOne  = 1 << weightBits;
+
+///////////////////////////////////////////
+
+UndistortMap::UndistortMap(uint32_t width, uint32_t height, const CameraIntrinsics& intrinsics) :
+	m_width(width),
+	m_height(height),
+	m_intrinsics(intrinsics),
+	m_entries(static_cast<size_t>(width) * height) {
+}
+
+std::shared_ptr<const UndistortMap> UndistortMap::build(uint32_t width, uint32_t height, const CameraIntrinsics& intrinsics, DX::ThreadPool* pool) {
+	if (width < 2 || height < 2 || intrinsics.focalLengthX == 0 || intrinsics.focalLengthY == 0)
+		return nullptr;
+
+	std::shared_ptr<UndistortMap> map(new UndistortMap(width, height, intrinsics));
+
+	const float  fx = intrinsics.focalLengthX,    fy = intrinsics.focalLengthY;
+	const float  cx = intrinsics.principalPointX, cy = intrinsics.principalPointY;
+
+	// The struct is packed, so copy the coefficients out rather than point into it
+	float k[8];
+	for (int i = 0; i < 8; i++)
+		k[i] = intrinsics.distortionCoefficients[i];
+
+	// Positions clamp so the 2x2 neighbourhood stays inside, and anything more than half a
+	// pixel out is left to the fill value
+	const int64_t maxX = (static_cast<int64_t>(width - 1) << 16) - 1;
+	const int64_t maxY = (static_cast<int64_t>(height - 1) << 16) - 1;
+
+	UndistortMapEntry* entries = map->m_entries.data();
+	runRowBands(pool, height, 1, [&](uint32_t first, uint32_t end) {
+		for (uint32_t row = first; row < end; row++) {
+			float y = (row - cy) / fy;
+			UndistortMapEntry* out = entries + static_cast<size_t>(row) * width;
+			for (uint32_t column = 0; column < width; column++) {
+				float x  = (column - cx) / fx;
+				float r2 = x * x + y * y;
+				float r4 = r2 * r2, r6 = r4 * r2;
+				float radial = (1 + k[0] * r2 + k[1] * r4 + k[4] * r6) / (1 + k[5] * r2 + k[6] * r4 + k[7] * r6);
+				float xd = x * radial + 2 * k[2] * x * y + k[3] * (r2 + 2 * x * x);
+				float yd = y * radial + k[2] * (r2 + 2 * y * y) + 2 * k[3] * x * y;
+
+				float sx = fx * xd + cx;
+				float sy = fy * yd + cy;
+				if (!(sx >= -0.5f && sy >= -0.5f && sx <= width - 0.5f && sy <= height - 0.5f)) {
+					out[column].x = undistortMapOutside;
+					out[column].y = 0;
+					continue;
+				}
+
+				int64_t fixedX = static_cast<int64_t>(sx * 65536.0f + 0.5f);
+				int64_t fixedY = static_cast<int64_t>(sy * 65536.0f + 0.5f);
+				out[column].x = static_cast<int32_t>(fixedX < 0 ? 0 : fixedX > maxX ? maxX : fixedX);
+				out[column].y = static_cast<int32_t>(fixedY < 0 ? 0 : fixedY > maxY ? maxY : fixedY);
+			}
+		}
+	});
+	return map;
+}
+
+bool UndistortMap::matches(uint32_t width, uint32_t height, const CameraIntrinsics& intrinsics) const {
+	return width == m_width && height == m_height && memcmp(&intrinsics, &m_intrinsics, sizeof(CameraIntrinsics)) == 0;
+}
+
+CameraIntrinsics UndistortMap::getOutputIntrinsics() const {
+	CameraIntrinsics output = m_intrinsics;
+	for (int i = 0; i < 8; i++)
+		output.distortionCoefficients[i] = 0;
+	return output;
+}
+
+///////////////////////////////////////////
+// Scalar reference kernels
+///////////////////////////////////////////
+
+static inline int blend(int a, int b, int weight) {
+	return a * (weightOne - weight) + b * weight;
+}
+
+static inline int sampleWeight(int32_t fixed) {
+	return (fixed >> (16 - weightBits)) & (weightOne - 1);
+}
+
+static void remapGrayScalar(const uint8_t* src, uint32_t srcStride, const UndistortMapEntry* map, uint8_t* dst, uint32_t width, uint8_t fill) {
+	for (uint32_t x = 0; x < width; x++) {
+		if (map[x].x == undistortMapOutside) {
+			dst[x] = fill;
+			continue;
+		}
+		const uint8_t* p = src + static_cast<size_t>(map[x].y >> 16) * srcStride + (map[x].x >> 16);
+		int wx = sampleWeight(map[x].x), wy = sampleWeight(map[x].y);
+		int top    = blend(p[0], p[1], wx);
+		int bottom = blend(p[srcStride], p[srcStride + 1], wx);
+		dst[x] = static_cast<uint8_t>((blend(top, bottom, wy) + (1 << (2 * weightBits - 1))) >> (2 * weightBits));
+	}
+}
+
+static void remapRgbaScalar(const uint8_t* src, uint32_t srcStride, const UndistortMapEntry* map, uint8_t* dst, uint32_t width, uint8_t fill) {
+	for (uint32_t x = 0; x < width; x++) {
+		uint8_t* out = dst + x * 4;
+		if (map[x].x == undistortMapOutside) {
+			out[0] = out[1] = out[2] = out[3] = fill;
+			continue;
+		}
+		const uint8_t* p = src + static_cast<size_t>(map[x].y >> 16) * srcStride + (map[x].x >> 16) * 4;
+		int wx = sampleWeight(map[x].x), wy = sampleWeight(map[x].y);
+		for (int channel = 0; channel < 4; channel++) {
+			int top    = blend(p[channel], p[channel + 4], wx);
+			int bottom = blend(p[srcStride + channel], p[srcStride + channel + 4], wx);
+			out[channel] = static_cast<uint8_t>((blend(top, bottom, wy) + (1 << (2 * weightBits - 1))) >> (2 * weightBits));
+		}
+	}
+}
+
+// The top and bottom pairs of bytes around a gray pixel, or fill for both if it's outside.
+static inline void fetchGrayPairs(const uint8_t* src, uint32_t srcStride, const UndistortMapEntry& entry, uint8_t fill, uint16_t& top, uint16_t& bottom) {
+	if (entry.x == undistortMapOutside) {
+		top = bottom = static_cast<uint16_t>(fill * 0x0101);
+		return;
+	}
+	const uint8_t* p = src + static_cast<size_t>(entry.y >> 16) * srcStride + (entry.x >> 16);
+	memcpy(&top, p, 2);
+	memcpy(&bottom, p + srcStride, 2);
+}
+
+///////////////////////////////////////////
+// SSE2 kernels
+///////////////////////////////////////////
+
+#ifdef UNDISTORT_SSE2
+
+// Lane indices have to be constants, hence the template.
+template<int lane>
+static inline void insertGrayPairs(const uint8_t* src, uint32_t srcStride, const UndistortMapEntry* map, uint8_t fill, __m128i& top, __m128i& bottom) {
+	uint16_t topPair, bottomPair;
+	fetchGrayPairs(src, srcStride, map[lane], fill, topPair, bottomPair);
+	top    = _mm_insert_epi16(top, topPair, lane);
+	bottom = _mm_insert_epi16(bottom, bottomPair, lane);
+}
+
+// Weights of 4 entries, as 32 bit lanes. Outside entries come out as 0, which is harmless.
+static inline void weights4(const UndistortMapEntry* map, __m128i& weightX, __m128i& weightY) {
+	const __m128i mask = _mm_set1_epi32(weightOne - 1);
+	__m128i first  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(map));
+	__m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(map + 2));
+	__m128i low    = _mm_unpacklo_epi32(first, second);
+	__m128i high   = _mm_unpackhi_epi32(first, second);
+	weightX = _mm_and_si128(_mm_srai_epi32(_mm_unpacklo_epi32(low, high), 16 - weightBits), mask);
+	weightY = _mm_and_si128(_mm_srai_epi32(_mm_unpackhi_epi32(low, high), 16 - weightBits), mask);
+}
+
+static void remapGraySse2(const uint8_t* src, uint32_t srcStride, const UndistortMapEntry* map, uint8_t* dst, uint32_t width, uint8_t fill) {
+	const __m128i zero  = _mm_setzero_si128();
+	const __m128i one   = _mm_set1_epi16(weightOne);
+	const __m128i round = _mm_set1_epi32(1 << (2 * weightBits - 1));
+
+	uint32_t x = 0;
+	for (; x + 8 <= width; x += 8) {
+		const UndistortMapEntry* entries = map + x;
+
+		// Plain loads put each pixel's top and bottom pairs in a lane, no gathers involved
+		__m128i t = zero, b = zero;
+		insertGrayPairs<0>(src, srcStride, entries, fill, t, b);
+		insertGrayPairs<1>(src, srcStride, entries, fill, t, b);
+		insertGrayPairs<2>(src, srcStride, entries, fill, t, b);
+		insertGrayPairs<3>(src, srcStride, entries, fill, t, b);
+		insertGrayPairs<4>(src, srcStride, entries, fill, t, b);
+		insertGrayPairs<5>(src, srcStride, entries, fill, t, b);
+		insertGrayPairs<6>(src, srcStride, entries, fill, t, b);
+		insertGrayPairs<7>(src, srcStride, entries, fill, t, b);
+
+		__m128i wx0, wy0, wx1, wy1;
+		weights4(entries, wx0, wy0);
+		weights4(entries + 4, wx1, wy1);
+		__m128i wx = _mm_packs_epi32(wx0, wx1);
+		__m128i wy = _mm_packs_epi32(wy0, wy1);
+		__m128i pairX[2] = { _mm_unpacklo_epi16(_mm_sub_epi16(one, wx), wx), _mm_unpackhi_epi16(_mm_sub_epi16(one, wx), wx) };
+		__m128i pairY[2] = { _mm_unpacklo_epi16(_mm_sub_epi16(one, wy), wy), _mm_unpackhi_epi16(_mm_sub_epi16(one, wy), wy) };
+
+		// Horizontal blends, each pixel's pair of bytes against its pair of weights
+		__m128i topBlend    = _mm_packs_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(t, zero), pairX[0]), _mm_madd_epi16(_mm_unpackhi_epi8(t, zero), pairX[1]));
+		__m128i bottomBlend = _mm_packs_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(b, zero), pairX[0]), _mm_madd_epi16(_mm_unpackhi_epi8(b, zero), pairX[1]));
+
+		// Then vertical ones, top against bottom
+		__m128i low  = _mm_madd_epi16(_mm_unpacklo_epi16(topBlend, bottomBlend), pairY[0]);
+		__m128i high = _mm_madd_epi16(_mm_unpackhi_epi16(topBlend, bottomBlend), pairY[1]);
+		low  = _mm_srai_epi32(_mm_add_epi32(low, round), 2 * weightBits);
+		high = _mm_srai_epi32(_mm_add_epi32(high, round), 2 * weightBits);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(_mm_packs_epi32(low, high), zero));
+	}
+	remapGrayScalar(src, srcStride, map + x, dst + x, width - x, fill);
+}
+
+static void remapRgbaSse2(const uint8_t* src, uint32_t srcStride, const UndistortMapEntry* map, uint8_t* dst, uint32_t width, uint8_t fill) {
+	const __m128i zero  = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi32(1 << (2 * weightBits - 1));
+
+	uint32_t x = 0;
+	for (; x < width; x++) {
+		if (map[x].x == undistortMapOutside) {
+			memset(dst + x * 4, fill, 4);
+			continue;
+		}
+		const uint8_t* p = src + static_cast<size_t>(map[x].y >> 16) * srcStride + (map[x].x >> 16) * 4;
+		int wx = sampleWeight(map[x].x), wy = sampleWeight(map[x].y);
+		__m128i pairX = _mm_set1_epi32((wx << 16) | (weightOne - wx));
+		__m128i pairY = _mm_set1_epi32((wy << 16) | (weightOne - wy));
+
+		// Interleave each pixel with its right neighbour channel by channel, r0 r1 g0 g1 ...
+		__m128i t = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+		__m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p + srcStride));
+		t = _mm_unpacklo_epi8(_mm_unpacklo_epi8(t, _mm_srli_si128(t, 4)), zero);
+		b = _mm_unpacklo_epi8(_mm_unpacklo_epi8(b, _mm_srli_si128(b, 4)), zero);
+
+		__m128i topBlend    = _mm_packs_epi32(_mm_madd_epi16(t, pairX), zero);
+		__m128i bottomBlend = _mm_packs_epi32(_mm_madd_epi16(b, pairX), zero);
+		__m128i result = _mm_madd_epi16(_mm_unpacklo_epi16(topBlend, bottomBlend), pairY);
+		result = _mm_srai_epi32(_mm_add_epi32(result, round), 2 * weightBits);
+		result = _mm_packus_epi16(_mm_packs_epi32(result, zero), zero);
+
+		int32_t pixel = _mm_cvtsi128_si32(result);
+		memcpy(dst + x * 4, &pixel, 4);
+	}
+}
+
+#endif
+
+///////////////////////////////////////////
+// NEON kernels
+///////////////////////////////////////////
+
+#ifdef UNDISTORT_NEON
+
+template<int lane>
+static inline void insertGrayPairs(const uint8_t* src, uint32_t srcStride, const UndistortMapEntry* map, uint8_t fill, uint16x8_t& top, uint16x8_t& bottom, uint8x8_t& weightX, uint8x8_t& weightY) {
+	uint16_t topPair, bottomPair;
+	fetchGrayPairs(src, srcStride, map[lane], fill, topPair, bottomPair);
+	top     = vsetq_lane_u16(topPair, top, lane);
+	bottom  = vsetq_lane_u16(bottomPair, bottom, lane);
+	weightX = vset_lane_u8(static_cast<uint8_t>(sampleWeight(map[lane].x)), weightX, lane);
+	weightY = vset_lane_u8(static_cast<uint8_t>(sampleWeight(map[lane].y)), weightY, lane);
+}
+
+static void remapGrayNeon(const uint8_t* src, uint32_t srcStride, const UndistortMapEntry* map, uint8_t* dst, uint32_t width, uint8_t fill) {
+	const uint8x8_t one = vdup_n_u8(weightOne);
+
+	uint32_t x = 0;
+	for (; x + 8 <= width; x += 8) {
+		const UndistortMapEntry* entries = map + x;
+		uint16x8_t top = vdupq_n_u16(0), bottom = vdupq_n_u16(0);
+		uint8x8_t  wx  = vdup_n_u8(0),   wy     = vdup_n_u8(0);
+		insertGrayPairs<0>(src, srcStride, entries, fill, top, bottom, wx, wy);
+		insertGrayPairs<1>(src, srcStride, entries, fill, top, bottom, wx, wy);
+		insertGrayPairs<2>(src, srcStride, entries, fill, top, bottom, wx, wy);
+		insertGrayPairs<3>(src, srcStride, entries, fill, top, bottom, wx, wy);
+		insertGrayPairs<4>(src, srcStride, entries, fill, top, bottom, wx, wy);
+		insertGrayPairs<5>(src, srcStride, entries, fill, top, bottom, wx, wy);
+		insertGrayPairs<6>(src, srcStride, entries, fill, top, bottom, wx, wy);
+		insertGrayPairs<7>(src, srcStride, entries, fill, top, bottom, wx, wy);
+
+		// Split each pair into its left and right bytes
+		uint8x8x2_t t = vuzp_u8(vget_low_u8(vreinterpretq_u8_u16(top)),    vget_high_u8(vreinterpretq_u8_u16(top)));
+		uint8x8x2_t b = vuzp_u8(vget_low_u8(vreinterpretq_u8_u16(bottom)), vget_high_u8(vreinterpretq_u8_u16(bottom)));
+
+		uint16x8_t topBlend    = vmlal_u8(vmull_u8(t.val[0], vsub_u8(one, wx)), t.val[1], wx);
+		uint16x8_t bottomBlend = vmlal_u8(vmull_u8(b.val[0], vsub_u8(one, wx)), b.val[1], wx);
+
+		uint16x8_t wy16 = vmovl_u8(wy), inverse16 = vmovl_u8(vsub_u8(one, wy));
+		uint32x4_t low  = vmlal_u16(vmull_u16(vget_low_u16(topBlend),  vget_low_u16(inverse16)),  vget_low_u16(bottomBlend),  vget_low_u16(wy16));
+		uint32x4_t high = vmlal_u16(vmull_u16(vget_high_u16(topBlend), vget_high_u16(inverse16)), vget_high_u16(bottomBlend), vget_high_u16(wy16));
+		vst1_u8(dst + x, vmovn_u16(vcombine_u16(vrshrn_n_u32(low, 2 * weightBits), vrshrn_n_u32(high, 2 * weightBits))));
+	}
+	remapGrayScalar(src, srcStride, map + x, dst + x, width - x, fill);
+}
+
+static void remapRgbaNeon(const uint8_t* src, uint32_t srcStride, const UndistortMapEntry* map, uint8_t* dst, uint32_t width, uint8_t fill) {
+	for (uint32_t x = 0; x < width; x++) {
+		if (map[x].x == undistortMapOutside) {
+			memset(dst + x * 4, fill, 4);
+			continue;
+		}
+		const uint8_t* p = src + static_cast<size_t>(map[x].y >> 16) * srcStride + (map[x].x >> 16) * 4;
+		int wx = sampleWeight(map[x].x), wy = sampleWeight(map[x].y);
+
+		// The low half of each blend holds the pixel's 4 channels
+		uint8x8_t  t = vld1_u8(p), b = vld1_u8(p + srcStride);
+		uint16x8_t topBlend    = vmlal_u8(vmull_u8(t, vdup_n_u8(static_cast<uint8_t>(weightOne - wx))), vext_u8(t, t, 4), vdup_n_u8(static_cast<uint8_t>(wx)));
+		uint16x8_t bottomBlend = vmlal_u8(vmull_u8(b, vdup_n_u8(static_cast<uint8_t>(weightOne - wx))), vext_u8(b, b, 4), vdup_n_u8(static_cast<uint8_t>(wx)));
+
+		uint32x4_t result = vmlal_u16(vmull_u16(vget_low_u16(topBlend), vdup_n_u16(static_cast<uint16_t>(weightOne - wy))), vget_low_u16(bottomBlend), vdup_n_u16(static_cast<uint16_t>(wy)));
+		uint16x4_t narrow = vrshrn_n_u32(result, 2 * weightBits);
+		uint8x8_t  pixel  = vmovn_u16(vcombine_u16(narrow, narrow));
+		vst1_lane_u32(reinterpret_cast<uint32_t*>(dst + x * 4), vreinterpret_u32_u8(pixel), 0);
+	}
+}
+
+#endif
+
+///////////////////////////////////////////
+
+Undistorter::Undistorter(uint32_t threadCount, PixelKernelLevel level, uint32_t cacheCapacity) :
+	m_level(PixelKernelLevel::Scalar),
+	m_kernels{ remapGrayScalar, remapRgbaScalar },
+	m_cacheCapacity(cacheCapacity > 0 ? cacheCapacity : 1),
+	m_stats() {
+
+#ifdef UNDISTORT_SSE2
+	if (level == PixelKernelLevel::Sse2 || level == PixelKernelLevel::Avx2) {
+		m_level   = PixelKernelLevel::Sse2;
+		m_kernels = { remapGraySse2, remapRgbaSse2 };
+	}
+#endif
+#ifdef UNDISTORT_NEON
+	if (level == PixelKernelLevel::Neon) {
+		m_level   = PixelKernelLevel::Neon;
+		m_kernels = { remapGrayNeon, remapRgbaNeon };
+	}
+#endif
+
+	if (threadCount > 0)
+		m_pool = std::make_unique<DX::ThreadPool>(threadCount);
+}
+
+Undistorter::~Undistorter() {
+}
+
+///////////////////////////////////////////
+
+std::shared_ptr<const UndistortMap> Undistorter::getMap(uint32_t width, uint32_t height, const CameraIntrinsics& intrinsics) {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (size_t i = 0; i < m_maps.size(); i++) {
+			if (!m_maps[i]->matches(width, height, intrinsics))
+				continue;
+			std::shared_ptr<const UndistortMap> map = m_maps[i];
+			m_maps.erase(m_maps.begin() + i);
+			m_maps.insert(m_maps.begin(), map);
+			m_stats.mapHits++;
+			return map;
+		}
+	}
+
+	// Built outside the lock, since it takes a while; two threads missing at once both build it
+	std::shared_ptr<const UndistortMap> map = UndistortMap::build(width, height, intrinsics, m_pool.get());
+	if (map == nullptr)
+		return nullptr;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_stats.mapBuilds++;
+	m_maps.insert(m_maps.begin(), map);
+	if (m_maps.size() > m_cacheCapacity)
+		m_maps.pop_back();
+	return map;
+}
+
+void Undistorter::remap(const UndistortMap& map, const uint8_t* src, uint32_t srcStride, uint8_t* dst, uint32_t dstStride, uint32_t channels, uint8_t fill) {
+	const uint32_t width  = map.getWidth();
+	auto           kernel = channels == 4 ? m_kernels.remapRgba : m_kernels.remapGray;
+	runRowBands(m_pool.get(), map.getHeight(), 1, [&](uint32_t first, uint32_t end) {
+		for (uint32_t row = first; row < end; row++)
+			kernel(src, srcStride, map.getRow(row), dst + static_cast<size_t>(row) * dstStride, width, fill);
+	});
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_stats.frames++;
+}
+
+bool Undistorter::undistort(const CameraFrame& src, uint8_t* dst, uint32_t dstStride, uint8_t fill) {
+	uint32_t channels = 0;
+	if (src.format == PixelFormat::NV12 || src.format == PixelFormat::NV21)
+		channels = 1;
+	else if (src.format == PixelFormat::RGBA8888)
+		channels = 4;
+	if (channels == 0 || src.buffer == nullptr || dst == nullptr || src.stride < src.width * channels || dstStride < src.width * channels)
+		return false;
+	if (static_cast<uint64_t>(src.stride) * src.height > src.bufferSize)
+		return false;
+
+	std::shared_ptr<const UndistortMap> map = getMap(src.width, src.height, src.intrinsics);
+	if (map == nullptr)
+		return false;
+	remap(*map, src.buffer, src.stride, dst, dstStride, channels, fill);
+	return true;
+}
+
+UndistorterStats Undistorter::getStats() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats;
+}
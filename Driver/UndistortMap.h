@@ -0,0 +1,107 @@
+#pragma once
+
+#include "PixelConvert.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace TestApp
+{
+	// Where an undistorted pixel comes from in the camera image, in 16.16 fixed point. The
+	// 2x2 neighbourhood it's sampled from is always inside the image.
+	struct UndistortMapEntry {
+		int32_t x;
+		int32_t y;
+	};
+
+	// Marks an entry whose pixel falls outside the camera image, and gets the fill value.
+	const int32_t undistortMapOutside = INT32_MIN;
+
+	///////////////////////////////////////////
+
+	// Remap table that undoes the lens distortion described by a CameraIntrinsics, for one
+	// image size. The undistorted image keeps the same focal length and principal point, with
+	// no distortion (see getOutputIntrinsics), so overlays can project with a plain pinhole.
+	//
+	// Coefficients are in the order the driver API gives them, [k1, k2, p1, p2, k3, k4, k5,
+	// k6]: radial (1 + k1 r^2 + k2 r^4 + k3 r^6) / (1 + k4 r^2 + k5 r^4 + k6 r^6), plus tangential
+	// p1 and p2, the same rational model OpenCV uses.
+	class UndistortMap {
+
+	public:
+		// nullptr without a focal length, or for an image under 2x2.
+		static std::shared_ptr<const UndistortMap> build(uint32_t width, uint32_t height, const VuforiaDriver::CameraIntrinsics& intrinsics, DX::ThreadPool* pool = nullptr);
+
+		bool matches(uint32_t width, uint32_t height, const VuforiaDriver::CameraIntrinsics& intrinsics) const;
+
+		uint32_t getWidth() const  { return m_width; }
+		uint32_t getHeight() const { return m_height; }
+		const VuforiaDriver::CameraIntrinsics& getIntrinsics() const { return m_intrinsics; }
+		VuforiaDriver::CameraIntrinsics getOutputIntrinsics() const;
+
+		const UndistortMapEntry* getRow(uint32_t row) const { return m_entries.data() + static_cast<size_t>(row) * m_width; }
+
+	private:
+		UndistortMap(uint32_t width, uint32_t height, const VuforiaDriver::CameraIntrinsics& intrinsics);
+
+		uint32_t                        m_width;
+		uint32_t                        m_height;
+		VuforiaDriver::CameraIntrinsics m_intrinsics;
+		std::vector<UndistortMapEntry>  m_entries;
+	};
+
+	struct UndistorterStats {
+		uint64_t frames;
+		uint64_t mapBuilds;
+		uint64_t mapHits;
+	};
+
+	///////////////////////////////////////////
+
+	// Undistorts camera frames at camera rate. Maps are built the first time a size and set of
+	// intrinsics shows up, and kept for the few most recent ones, since intrinsics only change
+	// when the camera mode or focus does.
+	//
+	// Sampling is bilinear with 7 bit weights. Each row kernel fetches its 2x2 neighbourhoods
+	// with plain loads and does the blending in SSE2 or NEON, since gathers cost more than they
+	// save here; AVX2 uses the SSE2 kernels. Rows run in bands on a thread pool, as in
+	// PixelConverter.
+	class Undistorter {
+
+	public:
+		explicit Undistorter(uint32_t threadCount, PixelKernelLevel level = getBestPixelKernelLevel(), uint32_t cacheCapacity = 4);
+		~Undistorter();
+
+		Undistorter(const Undistorter&) = delete;
+		Undistorter& operator=(const Undistorter&) = delete;
+
+		// Undistorts the luma of an NV12 or NV21 frame into dst as gray, or an RGBA8888 frame into
+		// dst as RGBA, using the frame's own intrinsics. Pixels with nothing behind them get fill.
+		bool undistort(const VuforiaDriver::CameraFrame& src, uint8_t* dst, uint32_t dstStride, uint8_t fill = 0);
+
+		// Same, for any 1 or 4 channel image of the map's size.
+		void remap(const UndistortMap& map, const uint8_t* src, uint32_t srcStride, uint8_t* dst, uint32_t dstStride, uint32_t channels, uint8_t fill = 0);
+
+		std::shared_ptr<const UndistortMap> getMap(uint32_t width, uint32_t height, const VuforiaDriver::CameraIntrinsics& intrinsics);
+
+		PixelKernelLevel getLevel() const { return m_level; }
+		UndistorterStats getStats();
+
+		// Row kernels, one set per level.
+		struct Kernels {
+			void (*remapGray)(const uint8_t* src, uint32_t srcStride, const UndistortMapEntry* map, uint8_t* dst, uint32_t width, uint8_t fill);
+			void (*remapRgba)(const uint8_t* src, uint32_t srcStride, const UndistortMapEntry* map, uint8_t* dst, uint32_t width, uint8_t fill);
+		};
+
+	private:
+		PixelKernelLevel                                 m_level;
+		Kernels                                          m_kernels;
+		uint32_t                                         m_cacheCapacity;
+
+		std::mutex                                       m_mutex;
+		std::vector<std::shared_ptr<const UndistortMap>> m_maps; // Most recently used first
+		UndistorterStats                                 m_stats;
+
+		std::unique_ptr<DX::ThreadPool>                  m_pool;
+	};
+}
@@ -0,0 +1,246 @@
+#include "XrPoseTracker.h"
+
+using namespace TestApp;
+using namespace VuforiaDriver;
+
+///////////////////////////////////////////
+
+PoseAlignment TestApp::alignHeadPose(const pose_history_t& history, XrTime time, bool hold, XrPosef* outPose) {
+	if (pose_history_sample(history, time, outPose))
+		return PoseAlignment::Interpolated;
+
+	// Sampling fails for times before, after, or in a gap inside the history. Only the
+	// newest pose can still be followed by one that covers time.
+	pose_sample_t newest;
+	if (!pose_history_newest(history, &newest) || time <= newest.time)
+		return PoseAlignment::Missing;
+	if (!hold)
+		return PoseAlignment::Waiting;
+	if (time - newest.time > pose_history_max_gap)
+		return PoseAlignment::Missing;
+	*outPose = newest.pose;
+	return PoseAlignment::Held;
+}
+
+///////////////////////////////////////////
+
+static XrVector3f rotateVector(const XrQuaternionf& q, const XrVector3f& v) {
+	// v + 2w(u x v) + 2u x (u x v), where u is the vector part of q
+	XrVector3f t = {
+		2 * (q.y * v.z - q.z * v.y),
+		2 * (q.z * v.x - q.x * v.z),
+		2 * (q.x * v.y - q.y * v.x) };
+	return {
+		v.x + q.w * t.x + (q.y * t.z - q.z * t.y),
+		v.y + q.w * t.y + (q.z * t.x - q.x * t.z),
+		v.z + q.w * t.z + (q.x * t.y - q.y * t.x) };
+}
+
+XrPosef TestApp::composePoses(const XrPosef& a, const XrPosef& b) {
+	const XrQuaternionf& qa = a.orientation;
+	const XrQuaternionf& qb = b.orientation;
+
+	XrPosef result;
+	result.orientation = {
+		qa.w * qb.x + qa.x * qb.w + qa.y * qb.z - qa.z * qb.y,
+		qa.w * qb.y - qa.x * qb.z + qa.y * qb.w + qa.z * qb.x,
+		qa.w * qb.z + qa.x * qb.y - qa.y * qb.x + qa.z * qb.w,
+		qa.w * qb.w - qa.x * qb.x - qa.y * qb.y - qa.z * qb.z };
+
+	XrVector3f offset = rotateVector(qa, b.position);
+	result.position = { a.position.x + offset.x, a.position.y + offset.y, a.position.z + offset.z };
+	return result;
+}
+
+Pose TestApp::makeCameraPose(const XrPosef& worldFromCamera, uint64_t timestamp, PoseValidity validity) {
+	const XrQuaternionf& q = worldFromCamera.orientation;
+	const float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+	const float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+	const float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+	// OpenXR cameras look down -z with y up, the engine's look down +z with y down, so the
+	// y and z columns flip. That's a half turn around x, so it stays a proper rotation.
+	const float rotation[9] = {
+		1 - 2 * (yy + zz), -(2 * (xy - wz)),    -(2 * (xz + wy)),
+		2 * (xy + wz),     -(1 - 2 * (xx + zz)), -(2 * (yz - wx)),
+		2 * (xz - wy),     -(2 * (yz + wx)),    -(1 - 2 * (xx + yy)) };
+
+	// Pose is packed, so fill it one element at a time
+	Pose pose = {};
+	pose.timestamp          = timestamp;
+	pose.translationData[0] = worldFromCamera.position.x;
+	pose.translationData[1] = worldFromCamera.position.y;
+	pose.translationData[2] = worldFromCamera.position.z;
+	for (int32_t i = 0; i < 9; i++)
+		pose.rotationData[i] = rotation[i];
+	pose.reason           = PoseReason::VALID;
+	pose.coordinateSystem = PoseCoordSystem::CAMERA;
+	pose.validity         = validity;
+	return pose;
+}
+
+///////////////////////////////////////////
+
+XrPoseTracker::XrPoseTracker(const XrPoseTrackerConfig& config) :
+	m_history(config.headHistory),
+	m_headFromCamera(config.headFromCamera),
+	m_toXrTime(config.toXrTime),
+	m_now(config.now),
+	m_maxLatency(config.maxLatency > 0 ? config.maxLatency : 20000000),
+	m_open(false),
+	m_callback(nullptr),
+	m_stopRequested(false),
+	m_stats() {
+}
+
+XrPoseTracker::~XrPoseTracker() {
+	close();
+}
+
+///////////////////////////////////////////
+
+bool XrPoseTracker::open() {
+	m_open = m_history != nullptr;
+	return m_open;
+}
+
+bool XrPoseTracker::close() {
+	stop();
+	m_open = false;
+	return true;
+}
+
+///////////////////////////////////////////
+
+bool XrPoseTracker::start(PoseCallback* cb, AnchorCallback*) {
+	if (!m_open || cb == nullptr || m_thread.joinable())
+		return false;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pending.clear();
+		m_stopRequested = false;
+		m_stats         = {};
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_deliveryMutex);
+		m_callback = cb;
+	}
+	m_thread = std::thread(&XrPoseTracker::poseLoop, this);
+	return true;
+}
+
+bool XrPoseTracker::stop() {
+	if (!m_thread.joinable())
+		return false;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopRequested = true;
+	}
+	m_wakeup.notify_all();
+	m_thread.join();
+
+	// Once this returns, the camera can't get a pose out either
+	std::lock_guard<std::mutex> lock(m_deliveryMutex);
+	m_callback = nullptr;
+	return true;
+}
+
+bool XrPoseTracker::resetTracking() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_stats.missing += m_pending.size();
+	m_pending.clear();
+	return true;
+}
+
+///////////////////////////////////////////
+
+void XrPoseTracker::onCameraFrame(const CameraFrame& frame) {
+	PendingPose request = { frame.timestamp, now() };
+
+	// Frames usually come in after the history has passed them, so try right here on the
+	// camera's thread first, which gets the pose to the engine before its frame.
+	std::lock_guard<std::mutex> delivery(m_deliveryMutex);
+	if (m_callback == nullptr)
+		return;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stats.frames += 1;
+		if (!m_pending.empty()) {
+			m_pending.push_back(request);
+			m_wakeup.notify_one();
+			return;
+		}
+	}
+	if (tryDeliver(request, false))
+		return;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_pending.push_back(request);
+	m_wakeup.notify_one();
+}
+
+void XrPoseTracker::poseLoop() {
+	for (;;) {
+		PendingPose request;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wakeup.wait(lock, [this]() { return m_stopRequested || !m_pending.empty(); });
+			if (m_stopRequested)
+				return;
+			request = m_pending.front();
+		}
+
+		// Head poses come in from the frame loop without telling anyone, so poll for them
+		bool late = now() - request.arrivalTime >= m_maxLatency;
+		{
+			std::lock_guard<std::mutex> delivery(m_deliveryMutex);
+			if (tryDeliver(request, late)) {
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (!m_pending.empty() && m_pending.front().timestamp == request.timestamp)
+					m_pending.pop_front();
+				continue;
+			}
+		}
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_wakeup.wait_for(lock, std::chrono::milliseconds(1), [this]() { return m_stopRequested; });
+	}
+}
+
+// Looks the request up in the history and sends its pose. Returns false if the history
+// hasn't reached it yet and it isn't late, so it should wait. Called with m_deliveryMutex held.
+bool XrPoseTracker::tryDeliver(const PendingPose& request, bool late) {
+	XrTime        time      = m_toXrTime ? m_toXrTime(request.timestamp) : (XrTime)request.timestamp;
+	XrPosef       headPose;
+	PoseAlignment alignment = alignHeadPose(*m_history, time, late, &headPose);
+	if (alignment == PoseAlignment::Waiting)
+		return false;
+
+	if (alignment != PoseAlignment::Missing) {
+		PoseValidity validity = alignment == PoseAlignment::Interpolated ? PoseValidity::VALID : PoseValidity::UNRELIABLE;
+		Pose         pose     = makeCameraPose(composePoses(headPose, m_headFromCamera), request.timestamp, validity);
+		m_callback->onNewPose(&pose);
+	}
+
+	uint64_t latency = now() - request.arrivalTime;
+	std::lock_guard<std::mutex> lock(m_mutex);
+	switch (alignment) {
+	case PoseAlignment::Interpolated: m_stats.interpolated += 1; break;
+	case PoseAlignment::Held:         m_stats.held         += 1; break;
+	default:                          m_stats.missing      += 1; break;
+	}
+	if (alignment != PoseAlignment::Missing) {
+		m_stats.totalLatency += latency;
+		if (latency > m_stats.maxLatency)
+			m_stats.maxLatency = latency;
+	}
+	return true;
+}
+
+uint64_t XrPoseTracker::now() const {
+	return m_now ? m_now() : frameQueueNow();
+}
+
+XrPoseTrackerStats XrPoseTracker::getStats() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "../xr_pose_history.h"
+#include "FrameQueue.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace TestApp
+{
+	// Where the tracker gets head poses from, and how it lines them up with camera frames.
+	struct XrPoseTrackerConfig {
+		// Head (VIEW space) poses relative to the app's space, pushed by the frame loop.
+		// nullptr means there's no pose source, and the driver only offers camera images.
+		const pose_history_t* headHistory;
+
+		// Where the camera sits on the head, as a pose relative to the VIEW space, in OpenXR
+		// axes (x right, y up, looking down -z). Identity if the camera is at the eyes.
+		XrPosef headFromCamera;
+
+		// Turns a CameraFrame timestamp into an XrTime, usually through a ClockMapper. Empty
+		// when both are on the same clock.
+		std::function<XrTime(uint64_t)> toXrTime;
+
+		// Current time on the camera's clock, in nanoseconds. Empty uses the steady clock,
+		// which is what the cameras stamp their frames with.
+		std::function<uint64_t()> now;
+
+		// How long a frame may wait for the head history to reach its timestamp before the
+		// newest head pose is sent in its place, in nanoseconds. 0 picks a default.
+		uint64_t maxLatency;
+	};
+
+	// How a camera timestamp lined up with the head history.
+	enum class PoseAlignment {
+		Interpolated, // Between two head poses
+		Waiting,      // Newer than the newest head pose, which may still catch up
+		Held,         // Newer than the newest head pose, which stands in for it
+		Missing,      // Older than the history, or in a gap where tracking was lost
+	};
+
+	struct XrPoseTrackerStats {
+		uint64_t frames;       // Camera frames seen while started
+		uint64_t interpolated; // Poses delivered from between two head poses
+		uint64_t held;         // Poses delivered late, from the newest head pose, as UNRELIABLE
+		uint64_t missing;      // Frames that got no pose at all
+		uint64_t totalLatency; // Nanoseconds between a frame arriving and its pose going out, summed
+		uint64_t maxLatency;
+	};
+
+	///////////////////////////////////////////
+
+	// Finds the head pose at time. When the history hasn't reached time yet, the answer is
+	// Waiting, unless hold is set, in which case the newest pose is used if it's no further
+	// back than pose_history_max_gap.
+	PoseAlignment alignHeadPose(const pose_history_t& history, XrTime time, bool hold, XrPosef* outPose);
+
+	// a then b, so composing world-from-head with head-from-camera gives world-from-camera.
+	XrPosef composePoses(const XrPosef& a, const XrPosef& b);
+
+	// Builds the driver's Pose from the camera's pose in OpenXR axes. The rotation is turned
+	// into the camera convention the engine expects (x right, y down, looking down +z), and
+	// written row-major. Both it and the translation are camera-to-world, and the world keeps
+	// the app space's axes.
+	VuforiaDriver::Pose makeCameraPose(const XrPosef& worldFromCamera, uint64_t timestamp, VuforiaDriver::PoseValidity validity);
+
+	///////////////////////////////////////////
+
+	// An ExternalPositionalDeviceTracker that doesn't track anything itself: it takes the
+	// head poses OpenXR already gives the frame loop, and hands the engine the camera's pose
+	// at the exact time of each camera frame.
+	//
+	// The camera tells it about frames through CameraFrameObserver. Since the frame loop
+	// pushes head poses at the predicted display time, the history is normally ahead of the
+	// camera, and the pose goes out right away, before the frame itself. Otherwise the frame
+	// waits on the pose thread until the history reaches it, for at most maxLatency, after
+	// which the newest head pose is sent instead, marked UNRELIABLE. Poses always go out in
+	// frame order.
+	class XrPoseTracker final : public VuforiaDriver::ExternalPositionalDeviceTracker, public CameraFrameObserver {
+
+	public:
+		explicit XrPoseTracker(const XrPoseTrackerConfig& config);
+		~XrPoseTracker();
+
+		bool VUFORIA_DRIVER_CALLING_CONVENTION open() override;
+		bool VUFORIA_DRIVER_CALLING_CONVENTION close() override;
+		bool VUFORIA_DRIVER_CALLING_CONVENTION start(VuforiaDriver::PoseCallback* cb, VuforiaDriver::AnchorCallback* anchorCb = nullptr) override;
+		bool VUFORIA_DRIVER_CALLING_CONVENTION stop() override;
+
+		// OpenXR owns the world, so there's nothing to reset beyond frames still waiting.
+		bool VUFORIA_DRIVER_CALLING_CONVENTION resetTracking() override;
+
+		void onCameraFrame(const VuforiaDriver::CameraFrame& frame) override;
+
+		XrPoseTrackerStats getStats();
+
+	private:
+		struct PendingPose {
+			uint64_t timestamp;
+			uint64_t arrivalTime;
+		};
+
+		void     poseLoop();
+		bool     tryDeliver(const PendingPose& request, bool late);
+		uint64_t now() const;
+
+		const pose_history_t*            m_history;
+		XrPosef                          m_headFromCamera;
+		std::function<XrTime(uint64_t)>  m_toXrTime;
+		std::function<uint64_t()>        m_now;
+		uint64_t                         m_maxLatency;
+		bool                             m_open;
+
+		// Held while a pose is being delivered, so poses go out one at a time, in order.
+		std::mutex                       m_deliveryMutex;
+		VuforiaDriver::PoseCallback*     m_callback;
+
+		std::thread                      m_thread;
+		std::mutex                       m_mutex;
+		std::condition_variable          m_wakeup;
+		std::deque<PendingPose>          m_pending;
+		bool                             m_stopRequested;
+		XrPoseTrackerStats               m_stats;
+	};
+}
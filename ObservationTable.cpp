@@ -0,0 +1,58 @@
+#include "ObservationTable.h"
+
+using namespace TestApp;
+
+static const VuMatrix44F identityPose = { {
+	1.0f, 0.0f, 0.0f, 0.0f,
+	0.0f, 1.0f, 0.0f, 0.0f,
+	0.0f, 0.0f, 1.0f, 0.0f,
+	0.0f, 0.0f, 0.0f, 1.0f,
+} };
+
+///////////////////////////////////////////
+
+void ObservationTable::clear() {
+	for (int32_t observerId : m_observerIds) {
+		if (observerId >= 0 && observerId < (int32_t)m_poseRows.size())
+			m_poseRows[observerId] = 0;
+	}
+	m_observerIds.clear();
+	m_types.clear();
+	m_poseStatuses.clear();
+	m_poses.clear();
+}
+
+void ObservationTable::reserve(uint32_t rows) {
+	m_observerIds.reserve(rows);
+	m_types.reserve(rows);
+	m_poseStatuses.reserve(rows);
+	m_poses.reserve(rows);
+}
+
+void ObservationTable::add(int32_t observerId, VuObservationType type, const VuPoseInfo* poseInfo) {
+	int32_t row = (int32_t)m_observerIds.size();
+	m_observerIds.push_back(observerId);
+	m_types.push_back(type);
+	m_poseStatuses.push_back(poseInfo ? poseInfo->poseStatus : VU_OBSERVATION_POSE_STATUS_NO_POSE);
+	m_poses.push_back(poseInfo ? poseInfo->pose : identityPose);
+
+	if (m_poseStatuses.back() == VU_OBSERVATION_POSE_STATUS_NO_POSE || observerId < 0 || observerId >= maxIndexedObserverId)
+		return;
+	if (observerId >= (int32_t)m_poseRows.size())
+		m_poseRows.resize(observerId + 1, 0);
+
+	// An observer has one observation with a pose per state, but keep the first if there are more
+	if (m_poseRows[observerId] == 0)
+		m_poseRows[observerId] = row + 1;
+}
+
+int32_t ObservationTable::findPose(int32_t observerId) const {
+	if (observerId >= 0 && observerId < maxIndexedObserverId)
+		return observerId < (int32_t)m_poseRows.size() ? m_poseRows[observerId] - 1 : -1;
+
+	for (uint32_t row = 0; row < getSize(); row++) {
+		if (m_observerIds[row] == observerId && m_poseStatuses[row] != VU_OBSERVATION_POSE_STATUS_NO_POSE)
+			return (int32_t)row;
+	}
+	return -1;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "VuforiaEngine/VuforiaEngine.h"
+#include <vector>
+
+namespace TestApp
+{
+	// Observer ids below this are looked up directly. The engine hands them out from 1 up,
+	// so only apps with thousands of observers ever go past it, and those get a scan instead.
+	const int32_t maxIndexedObserverId = 4096;
+
+	// Every observation of one engine state, one array per field, so code that only wants
+	// the poses of tracked targets walks two contiguous arrays instead of chasing handles.
+	// Row i of each array is the same observation. Rows are in the engine's order.
+	//
+	// Made to be refilled every frame: clear() keeps every array's capacity, so once the
+	// table has seen the most observations it will ever hold, filling it allocates nothing.
+	class ObservationTable final {
+
+	public:
+		void clear();
+		void reserve(uint32_t rows);
+
+		// Observations without a pose get VU_OBSERVATION_POSE_STATUS_NO_POSE and an identity pose.
+		void add(int32_t observerId, VuObservationType type, const VuPoseInfo* poseInfo);
+
+		uint32_t                       getSize() const         { return (uint32_t)m_observerIds.size(); }
+		const int32_t*                 getObserverIds() const  { return m_observerIds.data(); }
+		const VuObservationType*       getTypes() const        { return m_types.data(); }
+		const VuObservationPoseStatus* getPoseStatuses() const { return m_poseStatuses.data(); }
+		const VuMatrix44F*             getPoses() const        { return m_poses.data(); }
+
+		// Row of the observer's observation with a pose status other than NO_POSE, or -1 if it
+		// has none in this state.
+		int32_t findPose(int32_t observerId) const;
+
+	private:
+		std::vector<int32_t>                 m_observerIds;
+		std::vector<VuObservationType>       m_types;
+		std::vector<VuObservationPoseStatus> m_poseStatuses;
+		std::vector<VuMatrix44F>             m_poses;
+
+		// Pose row + 1 for each observer id, 0 for none. Only the ids in the table are set,
+		// and clear() resets just those.
+		std::vector<int32_t>                 m_poseRows;
+	};
+
+	///////////////////////////////////////////
+
+	// Where the tables get filled from, so a stand-in can replace the engine. One virtual
+	// call per frame, not per observation.
+	class ObservationSource {
+	public:
+		virtual ~ObservationSource() {}
+
+		// Refills table with the observations of the newest state. False if there's no state,
+		// in which case the table is left empty.
+		virtual bool read(ObservationTable& table) = 0;
+	};
+}
@@ -23,6 +23,8 @@ TestAppMain::TestAppMain()
 // Cre et initialise les convertisseurs.
 void TestAppMain::CreateRenderers(const std::shared_ptr<DX::DeviceResources>& deviceResources)
 {
+	m_deviceResources = deviceResources;
+
 	// TODO: remplacez ceci par l'initialisation du contenu de votre application.
 	m_sceneRenderer = std::unique_ptr<Sample3DSceneRenderer>(new Sample3DSceneRenderer(deviceResources));
 
@@ -32,6 +34,12 @@ void TestAppMain::CreateRenderers(const std::shared_ptr<DX::DeviceResources>& de
 // Met  jour l'tat de l'application une fois par frame.
 void TestAppMain::Update()
 {
+	// Attendez que la chane de permutation accepte une nouvelle frame avant de lire les entres.
+	if (m_deviceResources)
+	{
+		m_deviceResources->BeginFrame();
+	}
+
 	// Mettre  jour les objets de scne.
 	m_timer.Tick([&]()
 	{
@@ -72,6 +80,9 @@ void TestAppMain::OnSuspending()
 
 	m_sceneRenderer->SaveState();
 
+	// Les tats de pipeline compils pendant cette excution seront recrs bien plus vite  la suivante.
+	m_deviceResources->GetPipelineStateCache()->Save();
+
 	// Si votre application utilise les allocations de mmoire vido, qui sont faciles  recrer,
 	// librez la mmoire pour la mettre  disposition des autres applications.
 }
@@ -25,6 +25,9 @@ namespace TestApp
 		void OnDeviceRemoved();
 
 	private:
+		// Pointeur mis en cache vers les ressources du périphérique.
+		std::shared_ptr<DX::DeviceResources> m_deviceResources;
+
 		// TODO: remplacez par vos propres convertisseurs de contenu.
 		std::unique_ptr<Sample3DSceneRenderer> m_sceneRenderer;
 
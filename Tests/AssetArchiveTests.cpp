@@ -0,0 +1,241 @@
+#include "Common/AssetLoader.h"
+#include "TestCheck.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+///////////////////////////////////////////
+
+// Archives are made with the real Tools/AssetPacker, built alongside the tests
+static const char*    fileDirectory = "AssetArchiveTests.files";
+static const wchar_t* rootPath      = L"AssetArchiveTests.files/";
+
+static std::string filePath(const std::string& name) {
+	return std::string(fileDirectory) + "/" + name;
+}
+
+static void writeFile(const std::string& name, const std::vector<uint8_t>& contents) {
+	std::ofstream file(filePath(name), std::ios::binary);
+	file.write((const char*)contents.data(), (std::streamsize)contents.size());
+}
+
+static std::vector<uint8_t> readFile(const std::string& name) {
+	std::ifstream file(filePath(name), std::ios::binary);
+	return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static bool pack(const std::string& arguments) {
+	std::string command = std::string("\"") + ASSET_PACKER_PATH + "\" " + arguments + " > /dev/null";
+	return std::system(command.c_str()) == 0;
+}
+
+// Repeating runs of a few symbols, something like text or vertex data
+static std::vector<uint8_t> compressible(size_t size) {
+	std::vector<uint8_t> data(size);
+	for (size_t i = 0; i < size; i++)
+		data[i] = (uint8_t)(((i * i) >> 7) & 0x1f);
+	return data;
+}
+
+static std::vector<uint8_t> noise(size_t size, uint32_t seed) {
+	std::mt19937         random(seed);
+	std::vector<uint8_t> data(size);
+	for (uint8_t& byte : data)
+		byte = (uint8_t)random();
+	return data;
+}
+
+///////////////////////////////////////////
+
+// Round trips of random inputs, from noise to long runs. The reference is the input itself.
+static void fuzzRoundTrips() {
+	std::mt19937 random(1);
+	uint32_t     mismatches = 0;
+	for (int32_t round = 0; round < 3000; round++) {
+		size_t               size = random() % (round < 100 ? 70000 : 3000);
+		std::vector<uint8_t> data(size);
+		uint32_t             mode = random() % 4;
+		for (size_t i = 0; i < size; i++) {
+			switch (mode) {
+			case 0:  data[i] = (uint8_t)random(); break;
+			case 1:  data[i] = (uint8_t)(i % 7); break;
+			case 2:  data[i] = (uint8_t)(random() % 3); break;
+			default: data[i] = i > 10 && random() % 5 != 0 ? data[i - 1 - random() % 10] : (uint8_t)random(); break;
+			}
+		}
+
+		std::vector<uint8_t> compressed = DX::LzCompress(data.data(), size);
+		std::vector<uint8_t> decompressed(size);
+		if (!DX::LzDecompress(compressed.data(), compressed.size(), decompressed.data(), size) || decompressed != data)
+			mismatches++;
+	}
+	CHECK(mismatches == 0);
+}
+
+// Corrupted and truncated inputs must fail or decode something, but never write past the
+// end of the destination. Guard bytes after it catch that without a sanitizer.
+static void fuzzDamagedInputs() {
+	std::mt19937         random(2);
+	std::vector<uint8_t> data       = compressible(20000);
+	std::vector<uint8_t> compressed = DX::LzCompress(data.data(), data.size());
+	const size_t         guard      = 64;
+	uint32_t             overruns = 0, truncationsAccepted = 0;
+	for (int32_t round = 0; round < 2000; round++) {
+		std::vector<uint8_t> damaged = compressed;
+		if (round % 2 == 0)
+			damaged[random() % damaged.size()] ^= (uint8_t)(1 + random() % 255);
+		else
+			damaged.resize(random() % damaged.size());
+
+		std::vector<uint8_t> destination(data.size() + guard, 0xCD);
+		bool decoded = DX::LzDecompress(damaged.data(), damaged.size(), destination.data(), data.size());
+		for (size_t i = data.size(); i < destination.size(); i++)
+			overruns += destination[i] != 0xCD ? 1 : 0;
+		truncationsAccepted += round % 2 == 1 && decoded ? 1 : 0;
+	}
+	CHECK(overruns == 0);
+	CHECK(truncationsAccepted == 0);
+
+	// The wrong size is caught too
+	std::vector<uint8_t> destination(data.size() + 1);
+	CHECK(!DX::LzDecompress(compressed.data(), compressed.size(), destination.data(), data.size() + 1));
+	CHECK(!DX::LzDecompress(compressed.data(), compressed.size(), destination.data(), data.size() - 1));
+}
+
+static void testNamesIgnoreCaseAndSlashes() {
+	const char* name = "Shaders/Text.BIN";
+	uint64_t    hash = DX::AssetArchiveHash(name, std::strlen(name));
+	CHECK(DX::AssetArchiveHash(L"shaders\\text.bin") == hash);
+	CHECK(DX::AssetArchiveHash(L"SHADERS/TEXT.BIN") == hash);
+	CHECK(DX::AssetArchiveHash(L"shaders/text.bin2") != hash);
+}
+
+static void testLoadsFromAPackedArchive() {
+	std::vector<uint8_t> text  = compressible(1 << 20);
+	std::vector<uint8_t> blob  = noise(100000, 3);
+	std::vector<uint8_t> loose = noise(777, 4);
+	writeFile("text.bin", text);
+	writeFile("blob.bin", blob);
+	writeFile("empty.bin", {});
+	writeFile("loose.bin", loose);
+	CHECK(pack(filePath("Assets.pak") + " " + filePath("text.bin") + "=Shaders/Text.BIN " + filePath("blob.bin") + " " + filePath("empty.bin")));
+
+	DX::AssetLoader loader(rootPath, 2);
+	CHECK(loader.MountArchive(L"Assets.pak"));
+	CHECK(!loader.MountArchive(L"loose.bin"));
+	CHECK(!loader.MountArchive(L"missing.pak"));
+
+	DX::AssetHandle textAsset  = loader.Load(L"shaders\\text.bin");
+	DX::AssetHandle blobAsset  = loader.Load(L"blob.bin");
+	DX::AssetHandle emptyAsset = loader.Load(L"empty.bin");
+	DX::AssetHandle looseAsset = loader.Load(L"loose.bin");
+	loader.Wait(loader.Then({ textAsset, blobAsset, emptyAsset, looseAsset }, []() {}));
+
+	const DX::AssetView& textView = textAsset->GetView();
+	const DX::AssetView& blobView = blobAsset->GetView();
+	CHECK(textView.size == text.size() && std::memcmp(textView.data, text.data(), text.size()) == 0);
+	CHECK(blobView.size == blob.size() && std::memcmp(blobView.data, blob.data(), blob.size()) == 0);
+	CHECK(emptyAsset->GetView().IsValid() && emptyAsset->GetView().size == 0);
+	CHECK(looseAsset->GetView().size == loose.size());
+
+	// Noise is stored as is, in place and aligned for a copy to the GPU
+	CHECK((uintptr_t)blobView.data % DX::c_assetArchiveAlignment == 0);
+
+	DX::AssetLoaderStats stats = loader.GetStats();
+	CHECK(stats.archiveHits == 3);
+	CHECK(stats.filesMapped == 1);
+
+	// The packer only keeps the compressed copy when it saves something
+	uint32_t error = 0;
+	std::shared_ptr<DX::AssetArchive> archive = DX::AssetArchive::Open(L"AssetArchiveTests.files/Assets.pak", error);
+	CHECK(archive != nullptr && archive->GetEntryCount() == 3);
+	if (archive != nullptr) {
+		const DX::AssetArchiveEntry* textEntry = archive->Find(L"Shaders/Text.bin");
+		const DX::AssetArchiveEntry* blobEntry = archive->Find(L"blob.bin");
+		CHECK(textEntry != nullptr && archive->IsCompressed(*textEntry) && textEntry->storedSize < text.size() / 2);
+		CHECK(blobEntry != nullptr && !archive->IsCompressed(*blobEntry));
+		CHECK(archive->Find(L"loose.bin") == nullptr);
+	}
+}
+
+static void testDamagedArchivesAreRejected() {
+	std::vector<uint8_t> archive = readFile("Assets.pak");
+	CHECK(archive.size() > 64);
+
+	std::vector<uint8_t> badMagic = archive;
+	badMagic[0] ^= 0xFF;
+	writeFile("BadMagic.pak", badMagic);
+
+	std::vector<uint8_t> truncated(archive.begin(), archive.begin() + archive.size() / 2);
+	writeFile("Truncated.pak", truncated);
+
+	// Entries out of order can't be binary searched
+	std::vector<uint8_t> unsorted = archive;
+	std::swap_ranges(unsorted.begin() + 64, unsorted.begin() + 64 + sizeof(DX::AssetArchiveEntry), unsorted.begin() + 64 + sizeof(DX::AssetArchiveEntry));
+	writeFile("Unsorted.pak", unsorted);
+
+	for (const wchar_t* name : { L"BadMagic.pak", L"Truncated.pak", L"Unsorted.pak" }) {
+		uint32_t error = ~0u;
+		CHECK(DX::AssetArchive::Open(std::wstring(rootPath) + name, error) == nullptr);
+		CHECK(error == 0);
+	}
+
+	// A compressed entry with damaged data fails its load instead of handing out garbage
+	std::vector<uint8_t> damaged = archive;
+	uint32_t openError = 0;
+	std::shared_ptr<DX::AssetArchive> original = DX::AssetArchive::Open(L"AssetArchiveTests.files/Assets.pak", openError);
+	const DX::AssetArchiveEntry* textEntry = original ? original->Find(L"shaders/text.bin") : nullptr;
+	CHECK(textEntry != nullptr);
+	if (textEntry == nullptr)
+		return;
+	damaged[(size_t)(textEntry->offset + textEntry->storedSize) - 1] ^= 0x55;
+	damaged[(size_t)textEntry->offset] = 0xFF;
+	writeFile("Damaged.pak", damaged);
+
+	DX::AssetLoader loader(rootPath, 1);
+	CHECK(loader.MountArchive(L"Damaged.pak"));
+	bool failed = false;
+	try {
+		loader.Wait(loader.Load(L"shaders/text.bin"));
+	} catch (const DX::AssetLoadError& loadError) {
+		failed = loadError.GetError() == 0;
+	}
+	CHECK(failed);
+}
+
+static void reportCodecSpeed() {
+	std::vector<uint8_t> data = compressible(16 << 20);
+	auto start = std::chrono::steady_clock::now();
+	std::vector<uint8_t> compressed = DX::LzCompress(data.data(), data.size());
+	double compress = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::vector<uint8_t> decompressed(data.size());
+	start = std::chrono::steady_clock::now();
+	bool   decoded    = DX::LzDecompress(compressed.data(), compressed.size(), decompressed.data(), decompressed.size());
+	double decompress = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	CHECK(decoded && decompressed == data);
+
+	double megabytes = (double)data.size() / (1 << 20);
+	std::printf("LzCodec, 16MB at %.1f:1: compress %.0f MB/s, decompress %.0f MB/s\n",
+		(double)data.size() / (double)compressed.size(), megabytes / compress, megabytes / decompress);
+}
+
+int main() {
+	std::filesystem::remove_all(fileDirectory);
+	std::filesystem::create_directories(fileDirectory);
+
+	fuzzRoundTrips();
+	fuzzDamagedInputs();
+	testNamesIgnoreCaseAndSlashes();
+	testLoadsFromAPackedArchive();
+	testDamagedArchivesAreRejected();
+	reportCodecSpeed();
+
+	std::filesystem::remove_all(fileDirectory);
+	return testResult("AssetArchiveTests");
+}
@@ -0,0 +1,171 @@
+#include "Common/AssetLoader.h"
+#include "TestCheck.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+///////////////////////////////////////////
+
+// Files are written next to the test executable, where ctest runs it
+static const char*    fileDirectory = "AssetLoaderTests.files";
+static const wchar_t* rootPath      = L"AssetLoaderTests.files/";
+
+static std::vector<uint8_t> fileContents(uint32_t seed, size_t size) {
+	std::vector<uint8_t> contents(size);
+	for (size_t i = 0; i < size; i++)
+		contents[i] = (uint8_t)(i * 31 + seed);
+	return contents;
+}
+
+static void writeFile(const std::string& name, const std::vector<uint8_t>& contents) {
+	std::ofstream file(std::string(fileDirectory) + "/" + name, std::ios::binary);
+	file.write((const char*)contents.data(), (std::streamsize)contents.size());
+}
+
+static bool viewMatches(const DX::AssetView& view, const std::vector<uint8_t>& contents) {
+	return view.IsValid() && view.size == contents.size() &&
+		(contents.empty() || std::memcmp(view.data, contents.data(), contents.size()) == 0);
+}
+
+///////////////////////////////////////////
+
+static void testWorkRunsAfterItsLoads() {
+	DX::AssetLoader loader(rootPath, 4);
+	DX::AssetHandle a = loader.Load(L"a.bin");
+	DX::AssetHandle b = loader.Load(L"b.bin");
+
+	bool sawBoth = false;
+	DX::AssetHandle both = loader.Then({ a, b }, [&]() {
+		sawBoth = a->IsDone() && b->IsDone() &&
+			viewMatches(a->GetView(), fileContents(1, 100000)) && viewMatches(b->GetView(), fileContents(2, 5000));
+	});
+	loader.Wait(both);
+	CHECK(sawBoth);
+
+	// Loads that depend on other requests wait for them too
+	std::atomic<bool> firstDone(false);
+	DX::AssetHandle first  = loader.Then({}, [&]() { std::this_thread::sleep_for(std::chrono::milliseconds(5)); firstDone = true; });
+	DX::AssetHandle second = loader.Load(L"a.bin", { first });
+	bool            inOrder = false;
+	loader.Wait(loader.Then({ second }, [&]() { inOrder = firstDone.load(); }));
+	CHECK(inOrder);
+
+	// A 1000 deep chain, which must not need a thread per level
+	DX::AssetHandle previous = loader.Load(L"b.bin");
+	uint32_t        count    = 0;
+	for (int32_t i = 0; i < 1000; i++)
+		previous = loader.Then({ previous }, [&count]() { count++; });
+	loader.Wait(previous);
+	CHECK(count == 1000);
+}
+
+static void testEmptyAndMissingFiles() {
+	DX::AssetLoader loader(rootPath, 2);
+	DX::AssetHandle empty = loader.Load(L"empty.bin");
+	loader.Wait(empty);
+	CHECK(empty->GetView().IsValid() && empty->GetView().size == 0);
+
+	// The failure skips the work that depends on it, and goes on to every dependent
+	DX::AssetHandle missing   = loader.Load(L"missing.bin");
+	bool            ran       = false;
+	DX::AssetHandle dependent = loader.Then({ missing, empty }, [&ran]() { ran = true; });
+	uint32_t        error     = 0;
+	try {
+		loader.Wait(dependent);
+	} catch (const DX::AssetLoadError& loadError) {
+		error = loadError.GetError();
+		CHECK(loadError.GetName() == L"missing.bin");
+	}
+	CHECK(!ran);
+	CHECK(error == ENOENT);
+
+	// Callbacks still get called on requests that are done, with the exception
+	bool failed = false;
+	loader.OnComplete(dependent, [&failed](const DX::AssetRequest& request) { failed = request.GetException() != nullptr; });
+	CHECK(failed);
+}
+
+// The pool's task for a request holds on to it until the task returns, a little after Wait
+// does. With one thread, waiting for one more request makes sure the earlier ones are gone.
+static void drain(DX::AssetLoader& loader) {
+	loader.Wait(loader.Then({}, []() {}));
+}
+
+static void testMappingsLiveAsLongAsTheirViews() {
+	DX::AssetLoader loader(rootPath, 1);
+	DX::AssetHandle first = loader.Load(L"a.bin");
+	loader.Wait(first);
+	DX::AssetHandle again = loader.Load(L"a.bin");
+	loader.Wait(again);
+	CHECK(loader.GetStats().filesMapped == 1 && loader.GetStats().cacheHits == 1);
+	CHECK(first->GetView().data == again->GetView().data);
+
+	// Once every view is gone the file is unmapped, and the next load maps it again
+	first.reset();
+	again.reset();
+	drain(loader);
+	DX::AssetHandle later = loader.Load(L"a.bin");
+	loader.Wait(later);
+	CHECK(loader.GetStats().filesMapped == 2 && loader.GetStats().cacheHits == 1);
+	CHECK(loader.GetStats().bytesMapped == 2 * 100000);
+
+	// A view kept by itself keeps the mapping going after its request is gone
+	DX::AssetView view = later->GetView();
+	later.reset();
+	CHECK(viewMatches(view, fileContents(1, 100000)));
+}
+
+// Mapping and touching every page, against reading each file into memory and copying it
+static void reportLoadTime() {
+	const int32_t fileCount = 16;
+	const size_t  fileSize  = 4 << 20;
+	for (int32_t i = 0; i < fileCount; i++)
+		writeFile("large" + std::to_string(i) + ".bin", fileContents(i, fileSize));
+
+	DX::AssetLoader              loader(rootPath, 4);
+	std::atomic<uint64_t>        checksum(0);
+	std::vector<DX::AssetHandle> touched;
+	auto start = std::chrono::steady_clock::now();
+	for (int32_t i = 0; i < fileCount; i++) {
+		DX::AssetHandle file = loader.Load(L"large" + std::to_wstring(i) + L".bin");
+		touched.push_back(loader.Then({ file }, [file, &checksum]() {
+			uint64_t sum = 0;
+			for (size_t offset = 0; offset < file->GetView().size; offset += 4096)
+				sum += file->GetView().data[offset];
+			checksum += sum;
+		}));
+	}
+	loader.Wait(loader.Then(touched, []() {}));
+	double mapped = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	for (int32_t i = 0; i < fileCount; i++) {
+		std::ifstream        file(std::string(fileDirectory) + "/large" + std::to_string(i) + ".bin", std::ios::binary);
+		std::vector<uint8_t> contents(fileSize);
+		file.read((char*)contents.data(), (std::streamsize)fileSize);
+		std::vector<uint8_t> copy = contents;
+		checksum += copy[0];
+	}
+	double copied = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::printf("AssetLoader, %d files of 4MB from the page cache: %.2f ms mapped, %.2f ms read and copied\n", fileCount, mapped, copied);
+}
+
+int main() {
+	std::filesystem::remove_all(fileDirectory);
+	std::filesystem::create_directories(fileDirectory);
+	writeFile("a.bin", fileContents(1, 100000));
+	writeFile("b.bin", fileContents(2, 5000));
+	writeFile("empty.bin", {});
+
+	testWorkRunsAfterItsLoads();
+	testEmptyAndMissingFiles();
+	testMappingsLiveAsLongAsTheirViews();
+	reportLoadTime();
+
+	std::filesystem::remove_all(fileDirectory);
+	return testResult("AssetLoaderTests");
+}
@@ -0,0 +1,122 @@
+#include "Common/BuddyAllocator.h"
+#include "TestCheck.h"
+#include <chrono>
+#include <iterator>
+#include <map>
+#include <random>
+
+///////////////////////////////////////////
+
+static const uint64_t heapSize  = 64ull << 20; // What the heap suballocator uses for a block
+static const uint64_t pageSize  = 64ull << 10; // D3D12's default placement alignment
+static const uint64_t msaaAlign = 4ull << 20;  // D3D12's MSAA placement alignment
+
+///////////////////////////////////////////
+
+// Random allocations and frees of buffer and texture sized blocks, checked against a
+// plain map of what's live: nothing overlaps, everything is aligned and inside the heap,
+// and the stats agree with the map the whole way through.
+static void fuzzAgainstLiveMap() {
+	std::mt19937_64 random(7);
+	uint32_t misplaced = 0, overlapping = 0, wrongStats = 0;
+	for (int32_t round = 0; round < 5; round++) {
+		DX::BuddyAllocator             allocator(heapSize, pageSize);
+		std::map<uint64_t, uint64_t>   live; // Offset, end
+		uint64_t                       requested = 0;
+		std::map<uint64_t, uint64_t>   sizes;
+		for (int32_t i = 0; i < 20000; i++) {
+			if (live.empty() || random() % 3 != 0) {
+				uint64_t size      = 1 + random() % (random() % 8 == 0 ? (8ull << 20) : (256ull << 10));
+				uint64_t alignment = random() % 10 == 0 ? msaaAlign : pageSize;
+				uint64_t offset;
+				if (allocator.Allocate(size, alignment, offset)) {
+					if (offset % alignment != 0 || offset + size > heapSize)
+						misplaced++;
+					auto next = live.lower_bound(offset);
+					if (next != live.end() && offset + size > next->first)
+						overlapping++;
+					if (next != live.begin() && std::prev(next)->second > offset)
+						overlapping++;
+					live[offset]  = offset + size;
+					sizes[offset] = size;
+					requested    += size;
+				}
+			} else {
+				auto freed = live.begin();
+				std::advance(freed, random() % live.size());
+				allocator.Free(freed->first);
+				requested -= sizes[freed->first];
+				live.erase(freed);
+			}
+
+			DX::BuddyAllocatorStats stats = allocator.GetStats();
+			if (stats.allocationCount != live.size() || stats.requestedBytes != requested ||
+				stats.allocatedBytes < stats.requestedBytes || stats.allocatedBytes + stats.largestFreeBlock > heapSize)
+				wrongStats++;
+		}
+
+		// With everything freed, it all merges back into the one block it started as
+		for (const auto& allocation : live)
+			allocator.Free(allocation.first);
+		DX::BuddyAllocatorStats stats = allocator.GetStats();
+		CHECK(allocator.IsEmpty());
+		CHECK(stats.freeBlockCount == 1 && stats.largestFreeBlock == heapSize && stats.allocatedBytes == 0);
+	}
+	CHECK(misplaced == 0);
+	CHECK(overlapping == 0);
+	CHECK(wrongStats == 0);
+}
+
+static void testSplitsAndMerges() {
+	DX::BuddyAllocator allocator(1024, 64);
+	uint64_t a, b, c;
+	CHECK(allocator.Allocate(64, 1, a) && a == 0);
+	CHECK(allocator.Allocate(100, 1, b) && b == 128); // Rounded up to 128, after a's buddy
+	CHECK(allocator.Allocate(64, 1, c) && c == 64);
+
+	DX::BuddyAllocatorStats stats = allocator.GetStats();
+	CHECK(stats.allocatedBytes == 256 && stats.requestedBytes == 228);
+	CHECK(stats.largestFreeBlock == 512);
+	CHECK_NEAR(stats.GetInternalFragmentation(), 1.0 - 228.0 / 256.0, 1e-6);
+	CHECK_NEAR(stats.GetExternalFragmentation(), 1.0 - 512.0 / 768.0, 1e-6);
+
+	// Too big for anything that's left, and bigger than the whole heap
+	uint64_t offset;
+	CHECK(!allocator.Allocate(513, 1, offset));
+	CHECK(!allocator.Allocate(2048, 1, offset));
+
+	// a and c are buddies, so freeing both leaves 128 free at 0, next to 256 and 512. Then
+	// b, their buddy, brings it all back together
+	allocator.Free(a);
+	allocator.Free(c);
+	stats = allocator.GetStats();
+	CHECK(stats.freeBlockCount == 3 && stats.largestFreeBlock == 512);
+	allocator.Free(b);
+	stats = allocator.GetStats();
+	CHECK(stats.freeBlockCount == 1 && stats.largestFreeBlock == 1024);
+
+	// Freeing something that isn't allocated does nothing
+	allocator.Free(512);
+	CHECK(allocator.GetStats().freeBlockCount == 1);
+}
+
+static void benchmarkAllocateFree() {
+	DX::BuddyAllocator allocator(heapSize, pageSize);
+	const int32_t      count = 1024, rounds = 200;
+	uint64_t           offsets[count];
+	auto start = std::chrono::steady_clock::now();
+	for (int32_t round = 0; round < rounds; round++) {
+		for (int32_t i = 0; i < count; i++) allocator.Allocate(pageSize, pageSize, offsets[i]);
+		for (int32_t i = 0; i < count; i++) allocator.Free(offsets[i]);
+	}
+	double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (2.0 * count * rounds);
+	std::printf("BuddyAllocator: %.1f ns per allocate or free\n", ns);
+	CHECK(allocator.IsEmpty());
+}
+
+int main() {
+	fuzzAgainstLiveMap();
+	testSplitsAndMerges();
+	benchmarkAllocateFree();
+	return testResult("BuddyAllocatorTests");
+}
@@ -0,0 +1,116 @@
+#include "Driver/ClockMapper.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+using namespace TestApp;
+
+///////////////////////////////////////////
+
+static const uint64_t second = 1000000000ull;
+
+static void testFirstPairs() {
+	ClockMapper mapper;
+	CHECK(!mapper.isValid());
+	CHECK(mapper.toXrTime(123) == 123);
+
+	// One pair gives an offset
+	CHECK(mapper.addPair(1 * second, 5000 * (XrTime)second));
+	CHECK(mapper.isValid());
+	CHECK(mapper.toXrTime(2 * second) == 5001 * (XrTime)second);
+	CHECK(mapper.toCameraTime(5001 * (XrTime)second) == 2 * second);
+
+	// Pairs out of order on either clock are ignored
+	CHECK(!mapper.addPair(999, 1));
+	CHECK(!mapper.addPair(2 * second, 5000 * (XrTime)second));
+	CHECK(mapper.getStats().pairs == 1);
+
+	// Two give the slope, here 100 ppm
+	CHECK(mapper.addPair(11 * second, 5010 * (XrTime)second + 1000000));
+	CHECK(std::fabs(mapper.getStats().driftPpm - 100) < 1e-6);
+	CHECK(mapper.toXrTime(21 * second) == 5020 * (XrTime)second + 2000000);
+
+	mapper.reset();
+	CHECK(!mapper.isValid() && mapper.getStats().pairs == 0);
+}
+
+// Four hours of one pair a second, from a clock 73 ppm fast, each read up to 2us apart and
+// one in ten preempted for 0.3 to 2.3ms. Frame times converted in between must stay within
+// a few microseconds of the truth, and convert back to the nanosecond.
+static void testSkewedJitteredClock() {
+	std::mt19937_64                        random(7);
+	std::uniform_real_distribution<double> jitter(-2000, 2000);
+	std::uniform_real_distribution<double> unit(0, 1);
+	const double ppm    = 73.0;
+	const double offset = 4.2e12;
+	auto truth = [&](double camera) { return offset + camera * (1 + ppm * 1e-6); };
+
+	ClockMapper mapper;
+	uint64_t    start = 123456789000ull;
+	double      worstError = 0;
+	uint32_t    roundTripErrors = 0;
+	for (uint32_t i = 0; i < 4 * 3600; i++) {
+		uint64_t camera = start + i * second + (uint64_t)(unit(random) * 1e6);
+		double   xr     = truth((double)camera) + jitter(random);
+		if (unit(random) < 0.1)
+			xr += 300000 + unit(random) * 2e6;
+		mapper.addPair(camera, (XrTime)std::llround(xr));
+
+		// Once the window is full, check frames from the next second
+		if (i < ClockMapper::windowCapacity)
+			continue;
+		for (int32_t frame = 0; frame < 3; frame++) {
+			uint64_t frameTime = camera + (uint64_t)(unit(random) * 1e9);
+			worstError = std::max(worstError, std::fabs((double)mapper.toXrTime(frameTime) - truth((double)frameTime)));
+			int64_t roundTrip = (int64_t)(mapper.toCameraTime(mapper.toXrTime(frameTime)) - frameTime);
+			roundTripErrors += roundTrip >= -1 && roundTrip <= 1 ? 0 : 1;
+		}
+	}
+
+	ClockMapperStats stats = mapper.getStats();
+	CHECK(worstError < 5000);
+	CHECK(roundTripErrors == 0);
+	CHECK(std::fabs(stats.driftPpm - ppm) < 2);
+	CHECK(stats.maxResidual < 5000);
+	CHECK(stats.windowSize == ClockMapper::windowCapacity);
+	CHECK(stats.inliers > 45 && stats.inliers < ClockMapper::windowCapacity);
+	std::printf("ClockMapper, 4 hours at 73 ppm with jitter and preemption: worst error %.0f ns, drift %.2f ppm, rms residual %.0f ns\n",
+		worstError, stats.driftPpm, stats.rmsResidual);
+}
+
+// When the drift changes, say as the device warms up, the fit follows within a window
+static void testDriftChange() {
+	ClockMapper mapper;
+	XrTime      xr = 1000 * (XrTime)second;
+	for (uint32_t i = 0; i < 200; i++) {
+		double ppm = i < 100 ? 20.0 : -15.0;
+		xr += (XrTime)std::llround(second * (1 + ppm * 1e-6));
+		mapper.addPair((i + 1) * second, xr);
+	}
+	CHECK(std::fabs(mapper.getStats().driftPpm + 15) < 0.01);
+	CHECK(std::llabs(mapper.toXrTime(200 * second + second / 2) - (xr + (XrTime)std::llround(second / 2 * (1 - 15e-6)))) <= 1);
+}
+
+static void reportConversionTime() {
+	ClockMapper mapper;
+	for (uint32_t i = 0; i < 64; i++)
+		mapper.addPair((i + 1) * second, (XrTime)((i + 1) * (second + 50000)));
+	const uint32_t count = 1000000;
+	XrTime         sum   = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < count; i++)
+		sum += mapper.toXrTime(70 * second + i);
+	double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+	CHECK(sum != 0);
+	std::printf("ClockMapper::toXrTime: %.1f ns per call\n", ns);
+}
+
+int main() {
+	testFirstPairs();
+	testSkewedJitteredClock();
+	testDriftChange();
+	reportConversionTime();
+	return testResult("ClockMapperTests");
+}
@@ -0,0 +1,119 @@
+#include "Common/DrawRanges.h"
+#include "Common/FencedPool.h"
+#include "TestCheck.h"
+#include <random>
+#include <vector>
+
+///////////////////////////////////////////
+
+// Concatenated in order, the ranges have to be exactly 0..drawCount-1, since that's the
+// order the lists are submitted in.
+static bool coversEveryDrawInOrder(const std::vector<DX::DrawRange>& ranges, uint32_t drawCount) {
+	uint32_t next = 0;
+	for (const DX::DrawRange& range : ranges) {
+		if (range.start != next || range.count == 0)
+			return false;
+		next += range.count;
+	}
+	return next == drawCount;
+}
+
+static void testSplitCoversEveryDraw() {
+	bool allCovered = true, allBalanced = true, allWithinLimits = true;
+	for (uint32_t drawCount = 1; drawCount < 2000; drawCount += 37) {
+		for (uint32_t maxRanges = 1; maxRanges <= 16; maxRanges++) {
+			std::vector<DX::DrawRange> ranges = DX::SplitDrawRanges(drawCount, maxRanges, 64);
+			allCovered = allCovered && coversEveryDrawInOrder(ranges, drawCount);
+			allWithinLimits = allWithinLimits && ranges.size() <= maxRanges &&
+				(ranges.size() == 1 || ranges.back().count >= 64);
+
+			uint32_t smallest = drawCount, largest = 0;
+			for (const DX::DrawRange& range : ranges) {
+				smallest = range.count < smallest ? range.count : smallest;
+				largest  = range.count > largest  ? range.count : largest;
+			}
+			allBalanced = allBalanced && largest - smallest <= 1;
+		}
+	}
+	CHECK(allCovered);
+	CHECK(allBalanced);
+	CHECK(allWithinLimits);
+
+	// The single cube the sample draws today stays on one list
+	std::vector<DX::DrawRange> one = DX::SplitDrawRanges(1, 8, 64);
+	CHECK(one.size() == 1 && one[0].start == 0 && one[0].count == 1);
+	CHECK(DX::SplitDrawRanges(0, 8, 64).empty());
+	CHECK(DX::SplitDrawRanges(100, 0, 64).empty());
+	CHECK(DX::SplitDrawRanges(10, 4, 0).size() == 4);
+}
+
+///////////////////////////////////////////
+
+// Stands in for the command queue: frames are signalled as they're submitted, and the GPU
+// gets through them some random number of frames later, up to framesInFlight behind.
+struct MockQueue {
+	uint64_t submitted = 0;
+	uint64_t completed = 0;
+
+	uint64_t submit() { return ++submitted; }
+	void     advance(std::mt19937& random, uint64_t framesInFlight) {
+		if (completed < submitted && random() % 2 == 0)
+			completed++;
+		if (submitted - completed > framesInFlight)
+			completed = submitted - framesInFlight;
+	}
+};
+
+struct MockAllocator {
+	uint32_t id;
+	uint64_t busyUntil; // Fence value of the last frame that recorded into it
+};
+
+// What ParallelCommandLists does with its allocators, with the queue mocked out: take
+// one per list from the pool or make a new one, and give them all back tagged with the
+// frame's fence value once it's submitted.
+static void testAllocatorsAreReusedOnlyOnceTheGpuIsDone() {
+	const uint64_t framesInFlight = 3;
+	std::mt19937                       random(3);
+	MockQueue                          queue;
+	DX::FencedPool<MockAllocator>      pool;
+	std::vector<uint64_t>              busyUntil; // By allocator id
+	uint32_t reusedTooEarly = 0, maxLists = 0;
+
+	for (int32_t frame = 0; frame < 5000; frame++) {
+		uint32_t drawCount = 1 + random() % 1000;
+		std::vector<DX::DrawRange> ranges = DX::SplitDrawRanges(drawCount, 8, 64);
+		uint32_t listCount = (uint32_t)ranges.size() + 2;
+		maxLists = listCount > maxLists ? listCount : maxLists;
+
+		std::vector<MockAllocator> active(listCount);
+		for (MockAllocator& allocator : active) {
+			if (pool.Acquire(queue.completed, allocator)) {
+				if (busyUntil[allocator.id] > queue.completed)
+					reusedTooEarly++;
+			} else {
+				allocator.id = (uint32_t)busyUntil.size();
+				busyUntil.push_back(0);
+			}
+		}
+
+		uint64_t fenceValue = queue.submit();
+		for (MockAllocator& allocator : active) {
+			busyUntil[allocator.id] = fenceValue;
+			pool.Release(allocator, fenceValue);
+		}
+		queue.advance(random, framesInFlight);
+	}
+
+	CHECK(reusedTooEarly == 0);
+	// Never more than a frame's worth for each frame the GPU can be behind, and the one
+	// being recorded
+	CHECK(busyUntil.size() <= (framesInFlight + 1) * maxLists);
+	CHECK(pool.GetCount() == busyUntil.size());
+}
+
+int main() {
+	testSplitCoversEveryDraw();
+	testAllocatorsAreReusedOnlyOnceTheGpuIsDone();
+	return testResult("DrawRangesTests");
+}
@@ -0,0 +1,234 @@
+#include "Driver/SyntheticCamera.h"
+#include "TestCheck.h"
+#include <atomic>
+#include <cstdlib>
+#include <vector>
+
+using namespace TestApp;
+using namespace VuforiaDriver;
+
+///////////////////////////////////////////
+
+// Every allocation in the process is counted, to show capture doesn't make any once it's
+// warmed up
+static std::atomic<uint64_t> allocationCount(0);
+
+void* operator new(size_t size) {
+	allocationCount++;
+	void* data = std::malloc(size > 0 ? size : 1);
+	if (data == nullptr)
+		throw std::bad_alloc();
+	return data;
+}
+void operator delete(void* data) noexcept         { std::free(data); }
+void operator delete(void* data, size_t) noexcept { std::free(data); }
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	allocationCount++;
+	void* data = nullptr;
+	return posix_memalign(&data, (size_t)alignment, size > 0 ? size : 1) == 0 ? data : nullptr;
+}
+void operator delete(void* data, std::align_val_t) noexcept { std::free(data); }
+
+static CameraMode makeMode(uint32_t width, uint32_t height, uint32_t fps, PixelFormat format) {
+	CameraMode mode;
+	mode.width  = width;
+	mode.height = height;
+	mode.fps    = fps;
+	mode.format = format;
+	return mode;
+}
+
+// Checks each frame against the pattern SyntheticCamera draws, without allocating
+struct CountingSink : CameraCallback {
+	std::atomic<uint64_t> frames{ 0 };
+	std::atomic<uint32_t> wrong{ 0 };
+	uint32_t              delayUs = 0;
+
+	void VUFORIA_DRIVER_CALLING_CONVENTION onNewCameraFrame(CameraFrame* frame) override {
+		bool aligned = (uintptr_t)frame->buffer % frameBufferAlignment == 0 && frame->stride % frameStrideAlignment == 0;
+		bool drawn   = frame->buffer[0] == (uint8_t)frame->index && frame->buffer[frame->stride] == (uint8_t)(frame->index + 1);
+		wrong += aligned && drawn ? 0 : 1;
+		frames++;
+		if (delayUs > 0)
+			std::this_thread::sleep_for(std::chrono::microseconds(delayUs));
+	}
+};
+
+///////////////////////////////////////////
+
+static void testFrameLayout() {
+	uint32_t wrong = 0;
+	for (uint32_t width = 1; width < 300; width++) {
+		for (uint32_t height : { 1u, 2u, 7u, 48u }) {
+			for (PixelFormat format : { PixelFormat::YUYV, PixelFormat::NV12, PixelFormat::NV21, PixelFormat::RGB888, PixelFormat::RGBA8888 }) {
+				CameraMode mode = makeMode(width, height, 30, format);
+
+				// The smallest multiple of 64 a row fits in, and half height chroma rounded up
+				uint32_t pixelBytes = format == PixelFormat::YUYV ? 2 : format == PixelFormat::RGB888 ? 3 : format == PixelFormat::RGBA8888 ? 4 : 1;
+				uint32_t stride     = 64;
+				while (stride < width * pixelBytes)
+					stride += 64;
+				uint32_t rows = format == PixelFormat::NV12 || format == PixelFormat::NV21 ? height + (height + 1) / 2 : height;
+				wrong += getFrameStride(mode) == stride && getFrameSize(mode) == stride * rows ? 0 : 1;
+			}
+		}
+	}
+	CHECK(wrong == 0);
+	CHECK(getFrameSize(makeMode(64, 48, 30, (PixelFormat)0x7fff)) == 0);
+}
+
+static void testAcquireAndRelease() {
+	FrameBufferPool pool;
+	CHECK(!pool.configure(makeMode(64, 48, 30, (PixelFormat)0x7fff), 2));
+	CHECK(!pool.configure(makeMode(64, 48, 30, PixelFormat::NV12), 0));
+	CHECK(pool.acquire() == nullptr);
+
+	CameraMode small = makeMode(64, 48, 30, PixelFormat::NV12);
+	CHECK(pool.configure(small, 2));
+	CHECK(pool.getBufferSize() == 64 * 48 + 64 * 24 && pool.getStride() == 64);
+	uint8_t* a = pool.acquire();
+	uint8_t* b = pool.acquire();
+	CHECK(a != nullptr && b != nullptr && a != b);
+	CHECK((uintptr_t)a % frameBufferAlignment == 0 && (uintptr_t)b % frameBufferAlignment == 0);
+	CHECK(pool.acquire() == nullptr);
+	CHECK(pool.getStats().exhausted == 2);
+
+	// Releasing something that isn't out changes nothing
+	uint8_t other = 0;
+	pool.release(&other);
+	pool.release(nullptr);
+	CHECK(pool.getStats().inUse == 2);
+
+	// Buffers come back, and get handed out again
+	pool.release(a);
+	pool.release(a);
+	CHECK(pool.getStats().inUse == 1);
+	CHECK(pool.acquire() == a);
+	pool.release(a);
+	pool.release(b);
+
+	// Configuring the same size again keeps the buffers
+	CHECK(pool.configure(small, 2));
+	CHECK(pool.getStats().allocations == 2);
+
+	// A new size retires the old buffers, even the ones still out, which get freed on release
+	uint8_t* held = pool.acquire();
+	CHECK(pool.configure(makeMode(128, 48, 30, PixelFormat::NV12), 2));
+	CHECK(pool.getBufferSize() == 128 * 72);
+	uint8_t* c = pool.acquire();
+	uint8_t* d = pool.acquire();
+	CHECK(c != nullptr && d != nullptr && c != held && d != held);
+	CHECK(pool.acquire() == nullptr);
+	pool.release(held);
+	pool.release(c);
+	pool.release(d);
+
+	FrameBufferPoolStats stats = pool.getStats();
+	CHECK(stats.inUse == 0);
+	CHECK(stats.highWater == 3);
+	CHECK(stats.allocations == 4);
+}
+
+// Capture acquires on one thread while delivery releases on another, and no buffer is ever
+// handed out twice
+static void stressAcrossThreads() {
+	FrameBufferPool pool;
+	CHECK(pool.configure(4096, 64, 4));
+
+	// The pool doesn't clear its buffers, so mark all four free before the first byte means anything
+	uint8_t* buffers[4];
+	for (uint8_t*& buffer : buffers) {
+		buffer = pool.acquire();
+		CHECK(buffer != nullptr);
+		if (buffer == nullptr)
+			return;
+		buffer[0] = 0;
+	}
+	for (uint8_t* buffer : buffers)
+		pool.release(buffer);
+
+	std::atomic<uint8_t*> handOff[4] = {};
+	std::atomic<bool>     done(false);
+	std::atomic<uint32_t> doubled(0);
+	std::thread releaser([&]() {
+		while (!done.load()) {
+			for (std::atomic<uint8_t*>& slot : handOff) {
+				uint8_t* buffer = slot.exchange(nullptr);
+				if (buffer == nullptr)
+					continue;
+				doubled += buffer[0] == 1 ? 0 : 1;
+				buffer[0] = 0;
+				pool.release(buffer);
+			}
+		}
+	});
+
+	uint32_t acquired = 0;
+	for (uint32_t i = 0; i < 200000; i++) {
+		uint8_t* buffer = pool.acquire();
+		if (buffer == nullptr)
+			continue;
+		doubled += buffer[0] == 0 ? 0 : 1;
+		buffer[0] = 1;
+		acquired++;
+		for (uint8_t* expected = nullptr; ; expected = nullptr) {
+			if (handOff[i % 4].compare_exchange_strong(expected, buffer))
+				break;
+			std::this_thread::yield();
+		}
+	}
+	while (handOff[0].load() || handOff[1].load() || handOff[2].load() || handOff[3].load())
+		std::this_thread::yield();
+	done = true;
+	releaser.join();
+
+	FrameBufferPoolStats stats = pool.getStats();
+	CHECK(doubled == 0);
+	CHECK(stats.inUse == 0);
+	CHECK(stats.acquired == 200004 && stats.acquired - stats.exhausted == acquired + 4);
+	CHECK(stats.allocations == 4 && stats.highWater <= 4);
+}
+
+// Past the first few frames, a synthetic 720p camera capturing into the pool makes no
+// allocations, whether the engine keeps up or falls behind and frames get dropped
+static void testCaptureDoesNotAllocate(uint32_t fps, FrameDropPolicy policy, uint32_t delayUs) {
+	SyntheticCamera camera(makeMode(1280, 720, fps, PixelFormat::YUYV), policy, 3);
+	CountingSink    sink;
+	sink.delayUs = delayUs;
+	CameraMode mode;
+	CHECK(camera.open() && camera.getSupportedCameraMode(0, &mode));
+	CHECK(camera.start(mode, &sink));
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	uint64_t startAllocations = allocationCount;
+	uint64_t startFrames      = sink.frames;
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+	uint64_t allocations = allocationCount - startAllocations;
+	uint64_t frames      = sink.frames - startFrames;
+	camera.stop();
+
+	FrameBufferPoolStats stats    = camera.getBufferStats();
+	FrameQueueCounters   counters = camera.getQueueCounters();
+	CHECK(allocations == 0);
+	CHECK(frames > 0);
+	CHECK(sink.wrong == 0);
+	CHECK(stats.inUse == 0);
+	CHECK(stats.allocations == 4 + 2);
+	CHECK(stats.highWater <= stats.allocations);
+	std::printf("SyntheticCamera 720p at %u fps, %s, engine taking %u us: %llu frames, %llu dropped, %u buffers at most, %llu steady state allocations\n",
+		fps, policy == FrameDropPolicy::DropOldest ? "dropping the oldest" : policy == FrameDropPolicy::DropNewest ? "dropping the newest" : "blocking",
+		delayUs, (unsigned long long)sink.frames.load(), (unsigned long long)(counters.droppedOldest + counters.droppedNewest),
+		stats.highWater, (unsigned long long)allocations);
+}
+
+int main() {
+	testFrameLayout();
+	testAcquireAndRelease();
+	stressAcrossThreads();
+	testCaptureDoesNotAllocate(60, FrameDropPolicy::DropOldest, 0);
+	testCaptureDoesNotAllocate(60, FrameDropPolicy::DropOldest, 40000);
+	testCaptureDoesNotAllocate(60, FrameDropPolicy::DropNewest, 40000);
+	testCaptureDoesNotAllocate(0, FrameDropPolicy::Block, 0);
+	return testResult("FrameBufferPoolTests");
+}
@@ -0,0 +1,163 @@
+#include "Driver/FrameQueue.h"
+#include "TestCheck.h"
+#include <deque>
+#include <random>
+#include <vector>
+
+using namespace TestApp;
+using namespace VuforiaDriver;
+
+///////////////////////////////////////////
+
+// Every field the consumer checks is derived from the index, so a frame torn between two
+// pushes shows up as a mismatch
+static CameraFrame makeFrame(uint32_t index) {
+	CameraFrame frame = {};
+	frame.index     = index;
+	frame.timestamp = index * 7ull;
+	frame.width     = index + 1;
+	return frame;
+}
+
+static bool frameIsWhole(const CameraFrame& frame) {
+	return frame.timestamp == frame.index * 7ull && frame.width == frame.index + 1;
+}
+
+///////////////////////////////////////////
+
+// On one thread, the queue has to behave exactly like a bounded deque with the same policy
+static void testMatchesADequeOnOneThread() {
+	std::mt19937 random(5);
+	uint32_t     mismatches = 0;
+	for (FrameDropPolicy policy : { FrameDropPolicy::DropOldest, FrameDropPolicy::DropNewest }) {
+		FrameQueue              queue(4, policy);
+		std::deque<uint32_t>    reference;
+		uint32_t                next = 0;
+		for (int32_t step = 0; step < 20000; step++) {
+			if (random() % 3 != 0) {
+				QueuedFrame     dropped;
+				FramePushResult result = queue.push(makeFrame(next), &dropped);
+				if (reference.size() < 4) {
+					mismatches += result == FramePushResult::Queued ? 0 : 1;
+					reference.push_back(next);
+				} else if (policy == FrameDropPolicy::DropOldest) {
+					mismatches += result == FramePushResult::QueuedDroppedOldest && dropped.frame.index == reference.front() ? 0 : 1;
+					reference.pop_front();
+					reference.push_back(next);
+				} else {
+					mismatches += result == FramePushResult::DroppedNewest ? 0 : 1;
+				}
+				next++;
+			} else {
+				QueuedFrame item;
+				bool        popped = queue.tryPop(item);
+				if (reference.empty()) {
+					mismatches += popped ? 1 : 0;
+				} else {
+					mismatches += popped && item.frame.index == reference.front() ? 0 : 1;
+					reference.pop_front();
+				}
+			}
+			mismatches += queue.getCounters().depth == reference.size() ? 0 : 1;
+		}
+	}
+	CHECK(mismatches == 0);
+
+	FrameQueue rounded(3, FrameDropPolicy::Block);
+	CHECK(rounded.getCapacity() == 4);
+}
+
+// A producer pushing as fast as it can against a consumer on its own thread. Frames must
+// come out whole and in order, and the counters must add up.
+static void stressPolicy(FrameDropPolicy policy, uint32_t count) {
+	FrameQueue            queue(4, policy);
+	std::atomic<bool>     done(false);
+	std::vector<uint32_t> received;
+	uint32_t              torn = 0;
+	std::thread consumer([&]() {
+		QueuedFrame item;
+		for (;;) {
+			if (queue.pop(item, std::chrono::milliseconds(50))) {
+				torn += frameIsWhole(item.frame) ? 0 : 1;
+				received.push_back(item.frame.index);
+			} else if (done.load() && queue.getCounters().depth == 0) {
+				break;
+			}
+		}
+	});
+
+	uint64_t returned = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		QueuedFrame dropped;
+		if (queue.push(makeFrame(i), &dropped) == FramePushResult::QueuedDroppedOldest) {
+			torn += frameIsWhole(dropped.frame) ? 0 : 1;
+			returned++;
+		}
+	}
+	done = true;
+	queue.close();
+	consumer.join();
+
+	uint32_t outOfOrder = 0;
+	for (size_t i = 1; i < received.size(); i++)
+		outOfOrder += received[i] > received[i - 1] ? 0 : 1;
+	CHECK(torn == 0);
+	CHECK(outOfOrder == 0);
+
+	FrameQueueCounters counters = queue.getCounters();
+	CHECK(counters.pushed + counters.droppedNewest == count);
+	CHECK(counters.delivered == received.size());
+	CHECK(counters.droppedOldest == returned);
+	CHECK(counters.delivered + counters.droppedOldest == counters.pushed);
+	CHECK(counters.maxDepth <= 4);
+	if (policy == FrameDropPolicy::Block)
+		CHECK(received.size() == count);
+	if (policy == FrameDropPolicy::DropOldest)
+		CHECK(!received.empty() && received.back() == count - 1);
+}
+
+static void testClosing() {
+	FrameQueue queue(2, FrameDropPolicy::Block);
+	CHECK(queue.push(makeFrame(0)) == FramePushResult::Queued);
+	CHECK(queue.push(makeFrame(1)) == FramePushResult::Queued);
+
+	// A blocked producer gets let go by close
+	std::atomic<bool> released(false);
+	std::thread producer([&]() {
+		CHECK(queue.push(makeFrame(2)) == FramePushResult::Closed);
+		released = true;
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	CHECK(!released.load());
+	queue.close();
+	producer.join();
+
+	// What was queued can still be drained, then pop gives up straight away
+	QueuedFrame item;
+	CHECK(queue.pop(item, std::chrono::milliseconds(10)) && item.frame.index == 0);
+	CHECK(queue.tryPop(item) && item.frame.index == 1);
+	auto start = std::chrono::steady_clock::now();
+	CHECK(!queue.pop(item, std::chrono::seconds(5)));
+	CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+	CHECK(queue.push(makeFrame(3)) == FramePushResult::Closed);
+}
+
+static void reportPushTime() {
+	FrameQueue queue(4, FrameDropPolicy::DropOldest);
+	const uint32_t pushes = 1000000;
+	auto           start  = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < pushes; i++)
+		queue.push(makeFrame(i));
+	double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / pushes;
+	std::printf("FrameQueue push with no consumer, dropping the oldest: %.1f ns per frame\n", ns);
+}
+
+int main() {
+	testMatchesADequeOnOneThread();
+	stressPolicy(FrameDropPolicy::Block, 200000);
+	stressPolicy(FrameDropPolicy::DropOldest, 200000);
+	stressPolicy(FrameDropPolicy::DropNewest, 200000);
+	testClosing();
+	reportPushTime();
+	return testResult("FrameQueueTests");
+}
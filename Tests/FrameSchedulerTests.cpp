@@ -0,0 +1,145 @@
+#include "Common/SimulatedFrameBackend.h"
+#include "TestCheck.h"
+
+///////////////////////////////////////////
+
+// Counts the swapchain waits on top of the simulated backend
+class CountingBackend : public DX::SimulatedFrameBackend {
+public:
+	CountingBackend(double gpuFrameTime, double vsyncInterval) :
+		DX::SimulatedFrameBackend(gpuFrameTime, vsyncInterval), latencyWaits(0) {}
+
+	void WaitForFrameLatency() override {
+		latencyWaits++;
+		DX::SimulatedFrameBackend::WaitForFrameLatency();
+	}
+
+	uint32_t latencyWaits;
+};
+
+struct Steady {
+	double fps;
+	double latency;
+	double gpuStarved;
+	double cpuWait;
+};
+
+// Warms up, then runs long enough for the averages to settle
+static Steady runSteady(double cpu, double gpu, double vsync, uint32_t framesInFlight, uint32_t frameLatency) {
+	DX::SimulatedFrameBackend backend(gpu, vsync);
+	DX::FrameScheduler        scheduler(backend, 3, framesInFlight, frameLatency);
+	for (int32_t i = 0; i < 50; i++) {
+		scheduler.BeginFrame();
+		backend.AdvanceCpu(cpu);
+		scheduler.EndFrame();
+	}
+
+	scheduler.ResetStats();
+	double   start     = backend.GetTime();
+	uint64_t displayed = backend.GetDisplayedCount();
+	for (int32_t i = 0; i < 1000; i++) {
+		scheduler.BeginFrame();
+		backend.AdvanceCpu(cpu);
+		scheduler.EndFrame();
+	}
+
+	const DX::FrameStatsTotals& totals = scheduler.GetStatsTotals();
+	Steady result;
+	result.fps        = (double)(backend.GetDisplayedCount() - displayed) / (backend.GetTime() - start);
+	result.latency    = backend.GetAverageLatency();
+	result.gpuStarved = (double)totals.gpuStarvedCount / (double)totals.frameCount;
+	result.cpuWait    = totals.cpuWait / (double)totals.frameCount;
+	return result;
+}
+
+///////////////////////////////////////////
+
+// With one frame in flight the CPU and GPU take turns, with two they overlap and the
+// slower of the two sets the pace.
+static void testFramesInFlightOverlapCpuAndGpu() {
+	Steady serial = runSteady(0.010, 0.010, 0.0, 1, 2);
+	CHECK_NEAR(serial.fps, 50.0, 0.5);
+	CHECK_NEAR(serial.cpuWait, 0.010, 1e-6);
+	CHECK(serial.gpuStarved > 0.99);
+
+	Steady overlapped = runSteady(0.010, 0.010, 0.0, 2, 2);
+	CHECK_NEAR(overlapped.fps, 100.0, 0.5);
+	CHECK(overlapped.gpuStarved < 0.01);
+
+	Steady gpuBound = runSteady(0.008, 0.012, 0.0, 2, 2);
+	CHECK_NEAR(gpuBound.fps, 1.0 / 0.012, 0.5);
+}
+
+// Under vsync, a deeper queue costs latency and no throughput once the display is the limit
+static void testDeeperQueuesOnlyAddLatency() {
+	const double vsync = 1.0 / 60.0;
+	Steady shallow = runSteady(0.008, 0.012, vsync, 2, 2);
+	Steady deep    = runSteady(0.008, 0.012, vsync, 2, 3);
+	CHECK_NEAR(shallow.fps, 60.0, 0.5);
+	CHECK_NEAR(deep.fps, 60.0, 0.5);
+	CHECK(deep.latency > shallow.latency + vsync * 0.5);
+
+	// Each frame shows up at most frameLatency + 1 vsyncs after its CPU work started
+	CHECK(shallow.latency <= 3 * vsync + 1e-9);
+}
+
+// A frame that never got to EndFrame (nothing was rendered) goes on at the next BeginFrame:
+// nothing was presented since, so a second wait on the swapchain would only time out.
+static void testSkippedFramesDoNotWaitAgain() {
+	CountingBackend    backend(0.012, 1.0 / 60.0);
+	DX::FrameScheduler scheduler(backend, 3, 2, 2);
+
+	scheduler.BeginFrame();
+	CHECK(backend.latencyWaits == 1);
+	double before = backend.GetTime();
+	for (int32_t i = 0; i < 5; i++) {
+		scheduler.BeginFrame();
+		backend.AdvanceCpu(0.001);
+	}
+	CHECK(backend.latencyWaits == 1);
+	CHECK_NEAR(backend.GetTime() - before, 0.005, 1e-9);
+	CHECK(scheduler.GetStatsTotals().frameCount == 0);
+
+	// Once a frame is submitted, the next one waits as usual
+	scheduler.EndFrame();
+	scheduler.BeginFrame();
+	CHECK(backend.latencyWaits == 2);
+	scheduler.EndFrame();
+	CHECK(scheduler.GetStatsTotals().frameCount == 2);
+
+	// WaitForIdle doesn't present anything either
+	scheduler.BeginFrame();
+	scheduler.WaitForIdle();
+	scheduler.BeginFrame();
+	CHECK(backend.latencyWaits == 3);
+}
+
+static void testFenceValuesFollowTheFrames() {
+	DX::SimulatedFrameBackend backend(0.010, 0.0);
+	DX::FrameScheduler        scheduler(backend, 3, 3, 3);
+	CHECK(scheduler.GetCurrentFenceValue() == 1);
+	scheduler.BeginFrame();
+	scheduler.EndFrame();
+	CHECK(scheduler.GetCurrentFenceValue() == 2);
+	CHECK(backend.GetCompletedFenceValue() == 0);
+
+	scheduler.WaitForIdle();
+	CHECK(backend.GetCompletedFenceValue() >= 2);
+	CHECK(scheduler.GetCurrentFenceValue() == 3);
+
+	// Out of range settings are clamped
+	scheduler.SetFramesInFlight(10);
+	CHECK(scheduler.GetFramesInFlight() == 3);
+	scheduler.SetFramesInFlight(0);
+	CHECK(scheduler.GetFramesInFlight() == 1);
+	scheduler.SetFrameLatency(0);
+	CHECK(scheduler.GetFrameLatency() == 1);
+}
+
+int main() {
+	testFramesInFlightOverlapCpuAndGpu();
+	testDeeperQueuesOnlyAddLatency();
+	testSkippedFramesDoNotWaitAgain();
+	testFenceValuesFollowTheFrames();
+	return testResult("FrameSchedulerTests");
+}
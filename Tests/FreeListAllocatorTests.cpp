@@ -0,0 +1,109 @@
+#include "Common/FreeListAllocator.h"
+#include "Common/FencedPool.h"
+#include "TestCheck.h"
+#include <random>
+#include <utility>
+#include <vector>
+
+///////////////////////////////////////////
+
+// Random allocations and frees of descriptor ranges, checked slot by slot against who
+// owns each index. An allocation may only fail when there really is no free run that long.
+static void fuzzAgainstOwnership() {
+	std::mt19937 random(3);
+	uint32_t doubleOwned = 0, outOfRange = 0, wrongFailures = 0, wrongFreeCounts = 0;
+	for (int32_t round = 0; round < 20; round++) {
+		const uint32_t capacity = 1000 + random() % 3000;
+		DX::FreeListAllocator allocator(capacity);
+		std::vector<bool>     owned(capacity, false);
+		std::vector<std::pair<uint32_t, uint32_t>> live;
+		uint32_t freeCount = capacity;
+
+		for (int32_t i = 0; i < 10000; i++) {
+			if (live.empty() || random() % 2 == 0) {
+				uint32_t count = 1 + random() % 32, index;
+				if (allocator.Allocate(count, index)) {
+					if (index + count > capacity) {
+						outOfRange++;
+						continue;
+					}
+					for (uint32_t slot = index; slot < index + count; slot++) {
+						doubleOwned += owned[slot] ? 1 : 0;
+						owned[slot] = true;
+					}
+					live.push_back({ index, count });
+					freeCount -= count;
+				} else {
+					// First fit should have found any run of free slots that long
+					uint32_t run = 0, longest = 0;
+					for (uint32_t slot = 0; slot < capacity; slot++) {
+						run     = owned[slot] ? 0 : run + 1;
+						longest = run > longest ? run : longest;
+					}
+					if (longest >= count)
+						wrongFailures++;
+				}
+			} else {
+				size_t which = random() % live.size();
+				std::pair<uint32_t, uint32_t> range = live[which];
+				live[which] = live.back();
+				live.pop_back();
+				for (uint32_t slot = range.first; slot < range.first + range.second; slot++)
+					owned[slot] = false;
+				allocator.Free(range.first, range.second);
+				freeCount += range.second;
+			}
+			if (allocator.GetFreeCount() != freeCount)
+				wrongFreeCounts++;
+		}
+
+		// Everything merges back into one range
+		for (const std::pair<uint32_t, uint32_t>& range : live)
+			allocator.Free(range.first, range.second);
+		CHECK(allocator.GetLargestFreeRange() == capacity);
+	}
+	CHECK(doubleOwned == 0);
+	CHECK(outOfRange == 0);
+	CHECK(wrongFailures == 0);
+	CHECK(wrongFreeCounts == 0);
+}
+
+// The persistent region of a DescriptorHeap: freed ranges wait in a FencedPool until
+// the GPU is past the frame that freed them, and only then go back to the free list.
+static void testFreedRangesWaitForTheFence() {
+	DX::FreeListAllocator                        persistent(8);
+	DX::FencedPool<std::pair<uint32_t, uint32_t>> pendingFrees;
+	auto retire = [&](uint64_t completedFenceValue) {
+		std::pair<uint32_t, uint32_t> range;
+		while (pendingFrees.Acquire(completedFenceValue, range))
+			persistent.Free(range.first, range.second);
+	};
+
+	uint32_t texture, buffer, index;
+	CHECK(persistent.Allocate(4, texture) && texture == 0);
+	CHECK(persistent.Allocate(4, buffer) && buffer == 4);
+	CHECK(!persistent.Allocate(1, index));
+
+	// Freed during frame 1, while the GPU has only finished frame 0
+	pendingFrees.Release({ texture, 4 }, 1);
+	retire(0);
+	CHECK(!persistent.Allocate(1, index));
+
+	retire(1);
+	CHECK(persistent.GetFreeCount() == 4);
+	CHECK(persistent.Allocate(2, index) && index == 0);
+	CHECK(persistent.Allocate(2, index) && index == 2);
+
+	// Freeing both ends and then the range between them merges it all back into one
+	pendingFrees.Release({ 0, 2 }, 2);
+	pendingFrees.Release({ buffer, 4 }, 3);
+	pendingFrees.Release({ 2, 2 }, 3);
+	retire(3);
+	CHECK(persistent.GetLargestFreeRange() == 8);
+}
+
+int main() {
+	fuzzAgainstOwnership();
+	testFreedRangesWaitForTheFence();
+	return testResult("FreeListAllocatorTests");
+}
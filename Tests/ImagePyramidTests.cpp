@@ -0,0 +1,191 @@
+#include "Driver/ImagePyramid.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace TestApp;
+using namespace VuforiaDriver;
+
+///////////////////////////////////////////
+
+struct ReferenceLevel {
+	std::vector<uint8_t> pixels;
+	uint32_t             width;
+	uint32_t             height;
+};
+
+// A plain pyramid, one whole level after another, straight from the filter definitions
+static std::vector<ReferenceLevel> referencePyramid(const uint8_t* gray, uint32_t width, uint32_t height, uint32_t stride, uint32_t levelCount, PyramidFilter filter) {
+	std::vector<ReferenceLevel> levels(1);
+	levels[0].width  = width;
+	levels[0].height = height;
+	levels[0].pixels.resize(width * height);
+	for (uint32_t y = 0; y < height; y++)
+		std::memcpy(&levels[0].pixels[y * width], gray + (size_t)y * stride, width);
+
+	static const int32_t taps[5] = { 1, 4, 6, 4, 1 };
+	while (levels.size() < levelCount) {
+		const ReferenceLevel& above = levels.back();
+		ReferenceLevel        level;
+		level.width  = above.width / 2;
+		level.height = above.height / 2;
+		if (level.width == 0 || level.height == 0)
+			break;
+		auto pixel = [&](int32_t x, int32_t y) {
+			x = std::min(std::max(x, 0), (int32_t)above.width - 1);
+			y = std::min(std::max(y, 0), (int32_t)above.height - 1);
+			return (int32_t)above.pixels[y * above.width + x];
+		};
+		level.pixels.resize(level.width * level.height);
+		for (int32_t y = 0; y < (int32_t)level.height; y++) {
+			for (int32_t x = 0; x < (int32_t)level.width; x++) {
+				int32_t value;
+				if (filter == PyramidFilter::Box2x2) {
+					value = (pixel(2 * x, 2 * y) + pixel(2 * x + 1, 2 * y) + pixel(2 * x, 2 * y + 1) + pixel(2 * x + 1, 2 * y + 1) + 2) >> 2;
+				} else {
+					int32_t sum = 0;
+					for (int32_t j = 0; j < 5; j++) {
+						for (int32_t i = 0; i < 5; i++)
+							sum += taps[j] * taps[i] * pixel(2 * x + i - 2, 2 * y + j - 2);
+					}
+					value = (sum + 128) >> 8;
+				}
+				level.pixels[y * level.width + x] = (uint8_t)value;
+			}
+		}
+		levels.push_back(std::move(level));
+	}
+	return levels;
+}
+
+///////////////////////////////////////////
+
+// Random sizes, strides and level counts, at every kernel level, against the reference
+static void testMatchesReference() {
+	std::mt19937 random(3);
+	uint32_t     mismatches = 0, badLayouts = 0, compared = 0;
+	for (int32_t round = 0; round < 200; round++) {
+		uint32_t width  = 1 + random() % 300;
+		uint32_t height = 1 + random() % 200;
+		uint32_t stride = width + random() % 70;
+		uint32_t levels = 1 + random() % maxPyramidLevels;
+		std::vector<uint8_t> image((size_t)stride * height);
+		for (uint8_t& value : image)
+			value = round % 5 == 0 ? (random() % 2 ? 255 : 0) : (uint8_t)random();
+
+		for (PyramidFilter filter : { PyramidFilter::Box2x2, PyramidFilter::Gaussian5 }) {
+			std::vector<ReferenceLevel> expected = referencePyramid(image.data(), width, height, stride, levels, filter);
+			for (PixelKernelLevel level : { PixelKernelLevel::Scalar, PixelKernelLevel::Sse2, PixelKernelLevel::Avx2, PixelKernelLevel::Neon }) {
+				ImagePyramidBuilder builder(levels, filter, 2, level);
+				std::shared_ptr<const ImagePyramid> pyramid = builder.build(image.data(), width, height, stride, 77);
+				if (pyramid == nullptr || pyramid->getLevelCount() != expected.size() || pyramid->getTimestamp() != 77) {
+					mismatches++;
+					continue;
+				}
+				for (uint32_t index = 0; index < expected.size(); index++) {
+					const PyramidLevel& actual = pyramid->getLevel(index);
+					badLayouts += actual.width == expected[index].width && actual.height == expected[index].height &&
+						actual.stride % 64 == 0 && (uintptr_t)actual.data % 64 == 0 ? 0 : 1;
+					for (uint32_t y = 0; y < actual.height; y++)
+						mismatches += std::memcmp(actual.data + (size_t)y * actual.stride, &expected[index].pixels[y * actual.width], actual.width) == 0 ? 0 : 1;
+					compared++;
+				}
+			}
+		}
+	}
+	CHECK(mismatches == 0);
+	CHECK(badLayouts == 0);
+	CHECK(compared > 1000);
+}
+
+// Pyramids are shared until the last holder lets go, and the pool never grows for them
+static void testSharingAndExhaustion() {
+	std::vector<uint8_t> yuyv(128 * 40);
+	for (size_t i = 0; i < yuyv.size(); i++)
+		yuyv[i] = (uint8_t)(i * 7);
+	CameraFrame frame = {};
+	frame.width      = 64;
+	frame.height     = 40;
+	frame.format     = PixelFormat::YUYV;
+	frame.stride     = 128;
+	frame.buffer     = yuyv.data();
+	frame.bufferSize = (uint32_t)yuyv.size();
+	frame.timestamp  = 5;
+
+	ImagePyramidBuilder builder(3, PyramidFilter::Box2x2, 2);
+	std::shared_ptr<const ImagePyramid> first  = builder.build(frame);
+	std::shared_ptr<const ImagePyramid> second = builder.build(frame);
+	CHECK(first != nullptr && second != nullptr);
+	CHECK(builder.build(frame) == nullptr);
+	if (first == nullptr || second == nullptr)
+		return;
+
+	// Level 0 is the luma, every other byte of YUYV
+	CHECK(first->getLevel(0).data[3] == yuyv[6] && first->getTimestamp() == 5);
+
+	std::shared_ptr<const ImagePyramid> shared = first;
+	first.reset();
+	CHECK(builder.build(frame) == nullptr);
+	shared.reset();
+	CHECK(builder.build(frame) != nullptr);
+	ImagePyramidStats stats = builder.getStats();
+	CHECK(stats.built == 3 && stats.exhausted == 2 && stats.inUse == 1);
+
+	// A new frame size doesn't disturb pyramids still held at the old one
+	CameraFrame smaller = frame;
+	smaller.width = 32;
+	std::shared_ptr<const ImagePyramid> resized = builder.build(smaller);
+	CHECK(resized != nullptr && resized->getLevel(0).width == 32);
+	CHECK(second->getLevel(0).width == 64);
+
+	// Nor does the builder going away
+	std::shared_ptr<const ImagePyramid> kept;
+	{
+		ImagePyramidBuilder shortLived(2, PyramidFilter::Gaussian5);
+		kept = shortLived.build(frame);
+	}
+	CHECK(kept != nullptr && kept->getLevel(1).width == 32);
+
+	// Fewer levels come out of a frame too small for them all
+	ImagePyramidBuilder deep(maxPyramidLevels, PyramidFilter::Box2x2);
+	std::shared_ptr<const ImagePyramid> shallow = deep.build(frame);
+	CHECK(shallow != nullptr && shallow->getLevelCount() == 6 && shallow->getLevel(5).width == 2 && shallow->getLevel(5).height == 1);
+}
+
+static void reportBuildTime() {
+	std::mt19937         random(5);
+	std::vector<uint8_t> nv12(1920 * 1080 * 3 / 2);
+	for (uint8_t& value : nv12)
+		value = (uint8_t)random();
+	CameraFrame frame = {};
+	frame.width      = 1920;
+	frame.height     = 1080;
+	frame.stride     = 1920;
+	frame.format     = PixelFormat::NV12;
+	frame.buffer     = nv12.data();
+	frame.bufferSize = (uint32_t)nv12.size();
+
+	for (PyramidFilter filter : { PyramidFilter::Box2x2, PyramidFilter::Gaussian5 }) {
+		for (PixelKernelLevel level : { PixelKernelLevel::Scalar, getBestPixelKernelLevel() }) {
+			ImagePyramidBuilder builder(4, filter, 2, level);
+			builder.build(frame);
+			auto    start = std::chrono::steady_clock::now();
+			int32_t count = 0;
+			for (; std::chrono::steady_clock::now() - start < std::chrono::milliseconds(100); count++)
+				builder.build(frame);
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / count;
+			std::printf("ImagePyramidBuilder, 4 %s levels from 1080p NV12 at level %d: %.2f ms\n",
+				filter == PyramidFilter::Box2x2 ? "box" : "Gaussian", (int)builder.getLevel(), ms);
+		}
+	}
+}
+
+int main() {
+	testMatchesReference();
+	testSharingAndExhaustion();
+	reportBuildTime();
+	return testResult("ImagePyramidTests");
+}
@@ -0,0 +1,170 @@
+#include "xr_input_log.h"
+#include "TestCheck.h"
+#include <math.h>
+#include <vector>
+
+///////////////////////////////////////////
+
+static const XrDuration frameTime = 11111111; // 90Hz
+
+struct RecordedFrame {
+	XrSessionState       sessionState; // Changed to just before this frame, if not UNKNOWN
+	input_log_snapshot_t actions;
+	input_log_snapshot_t predicted;
+};
+
+static bool sameBits(const input_log_snapshot_t& a, const input_log_snapshot_t& b) {
+	bool same = a.predicted_time == b.predicted_time;
+	for (int32_t hand = 0; hand < 2; hand++) {
+		same = same && a.hand_pose_time[hand] == b.hand_pose_time[hand] &&
+			memcmp(&a.hand_pose[hand], &b.hand_pose[hand], sizeof(XrPosef)) == 0 &&
+			(a.render_hand[hand] != 0) == (b.render_hand[hand] != 0) &&
+			(a.hand_select[hand] != 0) == (b.hand_select[hand] != 0);
+	}
+	return same;
+}
+
+// A session that starts up, has hands wandering around and clicking for a while, loses
+// focus in the middle, and then stops. A few poses are -0 and NaN, which only come back
+// the same if nothing along the way treats them as numbers.
+static std::vector<RecordedFrame> makeSession(int32_t frames) {
+	std::vector<RecordedFrame> session(frames);
+	for (int32_t i = 0; i < frames; i++) {
+		RecordedFrame& frame = session[i];
+		frame = {};
+		if (i == 0)                        frame.sessionState = XR_SESSION_STATE_FOCUSED;
+		else if (i == frames / 2)          frame.sessionState = XR_SESSION_STATE_VISIBLE;
+		else if (i == frames / 2 + 30)     frame.sessionState = XR_SESSION_STATE_FOCUSED;
+		else if (i == frames - 1)          frame.sessionState = XR_SESSION_STATE_STOPPING;
+
+		XrTime time = (XrTime)(i + 1) * frameTime;
+		input_log_snapshot_t& predicted = frame.predicted;
+		predicted.predicted_time = time + 2 * frameTime;
+		for (int32_t hand = 0; hand < 2; hand++) {
+			predicted.render_hand[hand]    = (i / 40 + hand) % 3 != 0;
+			predicted.hand_pose_time[hand] = predicted.predicted_time;
+			predicted.hand_pose[hand]      = { { 0, sinf(i * 0.01f), 0, cosf(i * 0.01f) }, { hand ? 0.2f : -0.2f, sinf(i * 0.05f), -0.5f } };
+		}
+		if (i % 97 == 5) predicted.hand_pose[0].position.z = -0.0f;
+		if (i % 89 == 7) predicted.hand_pose[1].position.y = NAN;
+
+		// Actions come before the predicted poses, so they carry last frame's poses, and
+		// the odd select with a pose from between frames
+		frame.actions = i > 0 ? session[i - 1].predicted : input_log_snapshot_t{};
+		frame.actions.hand_select[i % 2] = i % 25 == 0;
+		if (frame.actions.hand_select[i % 2])
+			frame.actions.hand_pose_time[i % 2] = time - frameTime / 3;
+	}
+	return session;
+}
+
+static FILE* record(const std::vector<RecordedFrame>& session, uint64_t* outBytes) {
+	FILE*       file = tmpfile();
+	input_log_t log;
+	CHECK(file != nullptr && input_log_begin(log, file, input_log_record));
+	for (const RecordedFrame& frame : session) {
+		if (frame.sessionState != XR_SESSION_STATE_UNKNOWN)
+			input_log_write_session(log, frame.sessionState);
+		input_log_write_snapshot(log, input_log_tag_actions,   frame.actions);
+		input_log_write_snapshot(log, input_log_tag_predicted, frame.predicted);
+	}
+	*outBytes = log.bytes;
+
+	// The replay reads from the same file, so hand it back instead of closing it
+	fflush(file);
+	rewind(file);
+	return file;
+}
+
+///////////////////////////////////////////
+
+static void testReplayGivesBackTheSameBits() {
+	std::vector<RecordedFrame> session = makeSession(900);
+	uint64_t bytes;
+	FILE*    file = record(session, &bytes);
+
+	input_log_t log;
+	CHECK(input_log_begin(log, file, input_log_replay));
+	XrSessionState state    = XR_SESSION_STATE_UNKNOWN;
+	int32_t        mismatch = 0;
+	for (const RecordedFrame& frame : session) {
+		if (frame.sessionState != XR_SESSION_STATE_UNKNOWN)
+			state = frame.sessionState;
+
+		// Session changes have to show up with the frame they happened before, since that's
+		// what decides whether the replay draws it
+		input_log_snapshot_t actions, predicted;
+		CHECK(input_log_read_snapshot(log, input_log_tag_actions, &actions));
+		if (log.session_state != state || !sameBits(actions, frame.actions))
+			mismatch++;
+		CHECK(input_log_read_snapshot(log, input_log_tag_predicted, &predicted));
+		if (!sameBits(predicted, frame.predicted))
+			mismatch++;
+	}
+	CHECK(mismatch == 0);
+	CHECK(log.session_state == XR_SESSION_STATE_STOPPING);
+
+	input_log_snapshot_t extra;
+	CHECK(!input_log_read_snapshot(log, input_log_tag_actions, &extra));
+	CHECK(log.finished);
+	input_log_end(log);
+
+	std::printf("input log: %.1f bytes per frame\n", (double)bytes / session.size());
+}
+
+static void testOutOfOrderReplayFinishes() {
+	std::vector<RecordedFrame> session = makeSession(10);
+	uint64_t bytes;
+	FILE*    file = record(session, &bytes);
+
+	input_log_t log;
+	CHECK(input_log_begin(log, file, input_log_replay));
+	input_log_snapshot_t snapshot;
+	CHECK(!input_log_read_snapshot(log, input_log_tag_predicted, &snapshot));
+	CHECK(log.finished);
+	CHECK(!input_log_read_snapshot(log, input_log_tag_actions, &snapshot));
+	input_log_end(log);
+}
+
+static void testTruncatedLogFinishes() {
+	std::vector<RecordedFrame> session = makeSession(10);
+	uint64_t bytes;
+	FILE*    file = record(session, &bytes);
+
+	// Cut the last snapshot off half way through its pose
+	std::vector<uint8_t> data((size_t)bytes);
+	CHECK(fread(data.data(), 1, data.size(), file) == data.size());
+	fclose(file);
+	file = tmpfile();
+	fwrite(data.data(), 1, data.size() - 10, file);
+	rewind(file);
+
+	input_log_t log;
+	CHECK(input_log_begin(log, file, input_log_replay));
+	input_log_snapshot_t snapshot;
+	int32_t              read = 0;
+	while (input_log_read_snapshot(log, read % 2 == 0 ? input_log_tag_actions : input_log_tag_predicted, &snapshot))
+		read++;
+	CHECK(read == 19);
+	CHECK(log.finished);
+	input_log_end(log);
+}
+
+static void testRejectsOtherFiles() {
+	FILE* file = tmpfile();
+	fputs("definitely not an input log", file);
+	rewind(file);
+
+	input_log_t log;
+	CHECK(!input_log_begin(log, file, input_log_replay));
+	CHECK(log.finished);
+	input_log_end(log);
+}
+
+int main() {
+	testReplayGivesBackTheSameBits();
+	testOutOfOrderReplayFinishes();
+	testTruncatedLogFinishes();
+	testRejectsOtherFiles();
+	return testResult("InputLogTests");
+}
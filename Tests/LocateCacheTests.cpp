@@ -0,0 +1,102 @@
+#include "xr_locate_cache.h"
+#include "TestCheck.h"
+
+///////////////////////////////////////////
+
+// Stands in for xrLocateSpace. Every location is made up from its key, so a lookup that
+// comes back with another key's location shows up right away.
+static uint32_t standInCalls = 0;
+
+static XRAPI_ATTR XrResult XRAPI_CALL standInLocate(XrSpace space, XrSpace, XrTime time, XrSpaceLocation* location) {
+	standInCalls++;
+	location->locationFlags = XR_SPACE_LOCATION_POSITION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_VALID_BIT;
+	location->pose          = { { 0, 0, 0, 1 }, { (float)(uintptr_t)space, (float)time, 0 } };
+	return XR_SUCCESS;
+}
+
+static XrSpace space(uintptr_t id) {
+	return (XrSpace)id;
+}
+
+static bool poseIs(const XrPosef& pose, uintptr_t id, XrTime time) {
+	return pose.position.x == (float)id && pose.position.y == (float)time;
+}
+
+// Big enough that it shouldn't go on the stack
+static locate_cache_t cache;
+
+///////////////////////////////////////////
+
+// What openxr_poll_predicted does: two hands and the head requested, resolved, and then
+// read back, plus a select looked up on its own twice.
+static void testOneRuntimeCallPerLocation() {
+	locate_cache_init(cache, standInLocate);
+	standInCalls = 0;
+
+	const XrSpace base = space(99);
+	for (XrTime frame = 0; frame < 10; frame++) {
+		XrTime predicted = 1000 + frame;
+		locate_cache_begin_frame(cache);
+		for (uintptr_t id = 1; id <= 3; id++)
+			CHECK(locate_cache_request(cache, space(id), base, predicted) != nullptr);
+		// Asking again before the resolve isn't a hit, nothing has been saved yet
+		CHECK(locate_cache_request(cache, space(1), base, predicted) != nullptr);
+		CHECK(cache.counters.hits == (uint64_t)frame * 4);
+		locate_cache_resolve(cache);
+
+		XrPosef pose;
+		for (uintptr_t id = 1; id <= 3; id++)
+			CHECK(locate_cache_pose(cache, space(id), base, predicted, &pose) && poseIs(pose, id, predicted));
+		CHECK(locate_cache_pose(cache, space(1), base, 50, &pose) && poseIs(pose, 1, 50));
+		CHECK(locate_cache_pose(cache, space(1), base, 50, &pose) && poseIs(pose, 1, 50));
+	}
+
+	// Per frame: 4 requests, 3 reads, 2 selects. 3 resolved locations read back, and the
+	// second select, are the only hits
+	CHECK(standInCalls == 10 * 4);
+	CHECK(cache.counters.runtime_calls == standInCalls);
+	CHECK(cache.counters.queries == 10 * 9);
+	CHECK(cache.counters.hits == 10 * 4);
+}
+
+static void testLocationsDontOutliveTheFrame() {
+	locate_cache_init(cache, standInLocate);
+	standInCalls = 0;
+
+	XrPosef pose;
+	CHECK(locate_cache_pose(cache, space(1), space(2), 7, &pose));
+	locate_cache_begin_frame(cache);
+	CHECK(locate_cache_pose(cache, space(1), space(2), 7, &pose));
+	CHECK(standInCalls == 2);
+	CHECK(cache.counters.hits == 0);
+}
+
+// More locations than the table takes: the rest go straight to the runtime, and every
+// one of them still comes back right.
+static void testOverflowFallsBackToTheRuntime() {
+	locate_cache_init(cache, standInLocate);
+	standInCalls = 0;
+
+	const XrSpace base  = space(5000);
+	const int32_t count = 1000;
+	for (uintptr_t i = 0; i < count; i++)
+		locate_cache_request(cache, space(i + 10), base, 7);
+	locate_cache_resolve(cache);
+	CHECK(standInCalls == locate_cache_capacity / 2);
+
+	bool allRight = true;
+	for (uintptr_t i = 0; i < count; i++) {
+		XrPosef pose;
+		allRight = allRight && locate_cache_pose(cache, space(i + 10), base, 7, &pose) && poseIs(pose, i + 10, 7);
+	}
+	CHECK(allRight);
+	CHECK(standInCalls == count);
+	CHECK(cache.counters.hits == locate_cache_capacity / 2);
+}
+
+int main() {
+	testOneRuntimeCallPerLocation();
+	testLocationsDontOutliveTheFrame();
+	testOverflowFallsBackToTheRuntime();
+	return testResult("LocateCacheTests");
+}
@@ -0,0 +1,252 @@
+#include "ObservationTable.h"
+#include "VuforiaStandIn.h"
+#include "TestCheck.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using namespace TestApp;
+
+///////////////////////////////////////////
+
+// Every allocation in the process is counted, to show refilling a table doesn't make any
+// once it's warmed up
+static std::atomic<uint64_t> allocationCount(0);
+
+void* operator new(size_t size) {
+	allocationCount++;
+	void* data = std::malloc(size > 0 ? size : 1);
+	if (data == nullptr)
+		throw std::bad_alloc();
+	return data;
+}
+void operator delete(void* data) noexcept         { std::free(data); }
+void operator delete(void* data, size_t) noexcept { std::free(data); }
+
+// One observation, the way a table without the arrays would keep it
+struct ReferenceObservation {
+	int32_t                 observerId;
+	VuObservationType       type;
+	VuObservationPoseStatus poseStatus;
+	VuMatrix44F             pose;
+};
+
+// The first row with a pose for the observer, found by walking every row
+static int32_t referenceFindPose(const std::vector<ReferenceObservation>& rows, int32_t observerId) {
+	for (size_t row = 0; row < rows.size(); row++) {
+		if (rows[row].observerId == observerId && rows[row].poseStatus != VU_OBSERVATION_POSE_STATUS_NO_POSE)
+			return (int32_t)row;
+	}
+	return -1;
+}
+
+static const VuforiaEngineConfig engineConfig = { "key", "", nullptr };
+
+///////////////////////////////////////////
+
+// Random states, with ids on both sides of the index and repeated observers, refilled into
+// one table, against a plain list of the same rows
+static void testMatchesReference() {
+	std::mt19937     random(11);
+	ObservationTable table;
+	uint32_t         wrongRows = 0, wrongLookups = 0, lookups = 0;
+	for (int32_t round = 0; round < 500; round++) {
+		std::vector<ReferenceObservation> expected;
+		uint32_t size = random() % 64;
+		table.clear();
+		for (uint32_t i = 0; i < size; i++) {
+			ReferenceObservation observation = {};
+			switch (random() % 4) {
+			case 0:  observation.observerId = (int32_t)(random() % 16);                          break;
+			case 1:  observation.observerId = (int32_t)(random() % (maxIndexedObserverId + 100)); break;
+			case 2:  observation.observerId = -(int32_t)(random() % 5);                          break;
+			default: observation.observerId = maxIndexedObserverId + (int32_t)(random() % 8);    break;
+			}
+			observation.type = 1 + random() % 3;
+			VuPoseInfo poseInfo = {};
+			bool       hasPose  = random() % 3 != 0;
+			poseInfo.poseStatus = random() % 2 ? VU_OBSERVATION_POSE_STATUS_TRACKED : VU_OBSERVATION_POSE_STATUS_LIMITED;
+			for (float& value : poseInfo.pose.data)
+				value = (float)(random() % 100);
+			observation.poseStatus = hasPose ? poseInfo.poseStatus : VU_OBSERVATION_POSE_STATUS_NO_POSE;
+			for (int32_t j = 0; j < 16; j++)
+				observation.pose.data[j] = hasPose ? poseInfo.pose.data[j] : (j % 5 == 0 ? 1.0f : 0.0f);
+			table.add(observation.observerId, observation.type, hasPose ? &poseInfo : nullptr);
+			expected.push_back(observation);
+		}
+
+		if (table.getSize() != size) {
+			wrongRows++;
+			continue;
+		}
+		for (uint32_t row = 0; row < size; row++) {
+			wrongRows += table.getObserverIds()[row] == expected[row].observerId && table.getTypes()[row] == expected[row].type &&
+				table.getPoseStatuses()[row] == expected[row].poseStatus &&
+				std::memcmp(&table.getPoses()[row], &expected[row].pose, sizeof(VuMatrix44F)) == 0 ? 0 : 1;
+		}
+
+		// Every id in the table, some that aren't, and the ones left over from the state before
+		for (int32_t observerId = -6; observerId < 20; observerId++) {
+			wrongLookups += table.findPose(observerId) == referenceFindPose(expected, observerId) ? 0 : 1;
+			lookups++;
+		}
+		for (const ReferenceObservation& observation : expected) {
+			wrongLookups += table.findPose(observation.observerId) == referenceFindPose(expected, observation.observerId) ? 0 : 1;
+			lookups++;
+		}
+	}
+	CHECK(wrongRows == 0);
+	CHECK(wrongLookups == 0);
+	CHECK(lookups > 10000);
+
+	table.clear();
+	CHECK(table.getSize() == 0 && table.findPose(1) == -1 && table.findPose(maxIndexedObserverId) == -1);
+}
+
+// What the synthetic source makes: every fourth target lost, with an identity pose
+static void testSyntheticSource() {
+	ObservationTable           table;
+	SyntheticObservationSource source(10);
+	CHECK(source.read(table) && table.getSize() == 10);
+	CHECK(table.findPose(1) == 0 && table.findPose(3) == 2 && table.findPose(4) == -1);
+	CHECK(table.findPose(0) == -1 && table.findPose(11) == -1);
+	CHECK(table.getPoseStatuses()[2] == VU_OBSERVATION_POSE_STATUS_EXTENDED_TRACKED);
+	CHECK(table.getPoseStatuses()[3] == VU_OBSERVATION_POSE_STATUS_NO_POSE && table.getPoses()[3].data[0] == 1.0f && table.getPoses()[3].data[12] == 0.0f);
+
+	// A smaller state leaves nothing behind from the bigger one
+	source.setObservationCount(2);
+	CHECK(source.read(table) && table.getSize() == 2);
+	CHECK(table.findPose(2) == 1 && table.findPose(3) == -1);
+}
+
+// Once a table has held the biggest state, refilling it allocates nothing
+static void testNoSteadyStateAllocations() {
+	uint64_t allocations = 0;
+	for (uint32_t count : { 1u, 16u, 256u, (uint32_t)maxIndexedObserverId + 100 }) {
+		ObservationTable           table;
+		SyntheticObservationSource source(count);
+		source.read(table);
+		uint64_t before = allocationCount;
+		for (int32_t frame = 0; frame < 100; frame++)
+			source.read(table);
+		allocations += allocationCount - before;
+	}
+	CHECK(allocations == 0);
+}
+
+///////////////////////////////////////////
+
+// Reads through the host only reach the engine while it's running
+static void testHostReads() {
+	VuforiaStandInConfig config = {};
+	config.startDelay       = 20;
+	config.observationCount = 8;
+	VuforiaStandInCalls calls = {};
+	ObservationTable    table;
+	{
+		VuforiaHost host(std::make_unique<VuforiaStandInEngine>(config, &calls), engineConfig);
+		table.add(1, 1, nullptr);
+		CHECK(!host.readObservations(table) && table.getSize() == 0);
+
+		std::shared_future<bool> started = host.start();
+		CHECK(!host.readObservations(table));
+		CHECK(started.get());
+		CHECK(host.readObservations(table) && table.getSize() == 8 && table.findPose(1) == 0);
+
+		host.suspend().get();
+		CHECK(!host.readObservations(table) && table.getSize() == 0);
+	}
+	CHECK(calls.reads == 1 && calls.readsWhileStopped == 0);
+}
+
+// The frame loop reads every frame while the app starts and suspends the engine under it.
+// A suspend has to wait out a read in progress, and no read may reach the engine after it.
+static void testReadsDuringSuspend() {
+	VuforiaStandInConfig config = {};
+	config.stopDelay        = 1;
+	config.observationCount = 64;
+	VuforiaStandInCalls   calls = {};
+	std::atomic<bool>     running(true);
+	std::atomic<uint32_t> successes(0);
+	{
+		VuforiaHost host(std::make_unique<VuforiaStandInEngine>(config, &calls), engineConfig);
+		std::thread frameLoop([&]() {
+			ObservationTable table;
+			while (running.load()) {
+				if (host.readObservations(table))
+					successes++;
+			}
+		});
+		for (int32_t cycle = 0; cycle < 50; cycle++) {
+			CHECK(host.start().get());
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			host.suspend().get();
+		}
+		running = false;
+		frameLoop.join();
+	}
+	CHECK(calls.creates == 50 && calls.destroys == 50);
+	CHECK(successes > 0 && calls.reads == successes);
+	CHECK(calls.readsWhileStopped == 0);
+}
+
+// Walking the tracked poses and looking one target up, through the table, against copying
+// each state into a vector of structs and a hash map by observer id
+static void reportReadTime() {
+	for (uint32_t count : { 16u, 256u }) {
+		ObservationTable           table;
+		SyntheticObservationSource source(count);
+		source.read(table);
+		double sum = 0;
+
+		auto    start = std::chrono::steady_clock::now();
+		int32_t frames = 0;
+		for (; std::chrono::steady_clock::now() - start < std::chrono::milliseconds(50); frames++) {
+			source.read(table);
+			const VuObservationPoseStatus* statuses = table.getPoseStatuses();
+			const VuMatrix44F*             poses    = table.getPoses();
+			for (uint32_t row = 0; row < table.getSize(); row++) {
+				if (statuses[row] != VU_OBSERVATION_POSE_STATUS_NO_POSE)
+					sum += poses[row].data[12];
+			}
+			sum += table.findPose((int32_t)(frames % count) + 1);
+		}
+		double tableUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frames;
+
+		start  = std::chrono::steady_clock::now();
+		frames = 0;
+		for (; std::chrono::steady_clock::now() - start < std::chrono::milliseconds(50); frames++) {
+			source.read(table);
+			std::vector<ReferenceObservation>    observations;
+			std::unordered_map<int32_t, int32_t> poseRows;
+			for (uint32_t row = 0; row < table.getSize(); row++) {
+				observations.push_back({ table.getObserverIds()[row], table.getTypes()[row], table.getPoseStatuses()[row], table.getPoses()[row] });
+				if (observations.back().poseStatus != VU_OBSERVATION_POSE_STATUS_NO_POSE)
+					poseRows.emplace(observations.back().observerId, (int32_t)row);
+			}
+			for (const ReferenceObservation& observation : observations) {
+				if (observation.poseStatus != VU_OBSERVATION_POSE_STATUS_NO_POSE)
+					sum += observation.pose.data[12];
+			}
+			auto found = poseRows.find((int32_t)(frames % count) + 1);
+			sum += found == poseRows.end() ? -1 : found->second;
+		}
+		double containersUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frames;
+		CHECK(sum != 0);
+		std::printf("ObservationTable, %u observations: %.2f us per frame, %.2f us with per-frame containers\n", count, tableUs, containersUs);
+	}
+}
+
+int main() {
+	testMatchesReference();
+	testSyntheticSource();
+	testNoSteadyStateAllocations();
+	testHostReads();
+	testReadsDuringSuspend();
+	reportReadTime();
+	return testResult("ObservationTableTests");
+}
@@ -0,0 +1,173 @@
+#include "Common/PipelineCacheStore.h"
+#include "TestCheck.h"
+#include <atomic>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////
+
+static const char*    fileDirectory = "PipelineCacheStoreTests.files";
+static const wchar_t* cachePath     = L"PipelineCacheStoreTests.files/cache.bin";
+
+static std::vector<uint8_t> randomBlob(std::mt19937& random, size_t maxSize) {
+	std::vector<uint8_t> blob(random() % maxSize);
+	for (uint8_t& byte : blob)
+		byte = (uint8_t)random();
+	return blob;
+}
+
+///////////////////////////////////////////
+
+static void testKeyHashing() {
+	// Published FNV-1a 64 test vectors
+	DX::PipelineKeyHasher empty;
+	CHECK(empty.Get() == 0xcbf29ce484222325ull);
+	DX::PipelineKeyHasher letter;
+	letter.Add("a", 1);
+	CHECK(letter.Get() == 0xaf63dc4c8601ec8cull);
+	DX::PipelineKeyHasher word;
+	word.Add("foobar", 6);
+	CHECK(word.Get() == 0x85944171f73967e8ull);
+
+	// Strings keep their boundaries
+	DX::PipelineKeyHasher ab_c, a_bc;
+	ab_c.AddString("ab");
+	ab_c.AddString("c");
+	a_bc.AddString("a");
+	a_bc.AddString("bc");
+	CHECK(ab_c.Get() != a_bc.Get());
+
+	// A null string hashes like no string at all, and unlike an empty one
+	DX::PipelineKeyHasher none, nothing;
+	none.AddString(nullptr);
+	nothing.AddString("");
+	CHECK(none.Get() == empty.Get());
+	CHECK(nothing.Get() != empty.Get());
+
+	// Values hash their bytes, so the same fields in the same order give the same key
+	DX::PipelineKeyHasher first, second, swapped;
+	first.AddValue(uint32_t(1));
+	first.AddValue(uint64_t(2));
+	second.AddValue(uint32_t(1));
+	second.AddValue(uint64_t(2));
+	swapped.AddValue(uint64_t(2));
+	swapped.AddValue(uint32_t(1));
+	CHECK(first.Get() == second.Get());
+	CHECK(first.Get() != swapped.Get());
+}
+
+static void testSavesAndLoads() {
+	std::mt19937            random(3);
+	DX::PipelineCacheStore  store(42);
+	std::vector<uint64_t>   keys;
+	for (int32_t i = 0; i < 50; i++) {
+		std::vector<uint8_t> blob = randomBlob(random, 5000);
+		keys.push_back(((uint64_t)random() << 32) | random());
+		store.Put(keys.back(), blob.data(), blob.size());
+	}
+	store.Put(7, "", 0);
+	CHECK(store.IsDirty());
+	CHECK(store.SaveFile(cachePath));
+	CHECK(!store.IsDirty());
+
+	DX::PipelineCacheStore loaded(42);
+	CHECK(loaded.LoadFile(cachePath));
+	CHECK(!loaded.IsDirty());
+	CHECK(loaded.GetCount() == store.GetCount());
+	uint32_t mismatches = 0;
+	for (uint64_t key : keys)
+		mismatches += loaded.Find(key) != nullptr && *loaded.Find(key) == *store.Find(key) ? 0 : 1;
+	CHECK(mismatches == 0);
+	CHECK(loaded.Find(7) != nullptr && loaded.Find(7)->empty());
+	CHECK(loaded.Find(8) == nullptr);
+
+	// Removing something that isn't there changes nothing
+	loaded.Remove(8);
+	CHECK(!loaded.IsDirty());
+	loaded.Remove(7);
+	CHECK(loaded.IsDirty());
+
+	// Another driver's blobs are useless, and a missing file is just an empty cache
+	DX::PipelineCacheStore otherDriver(43);
+	CHECK(!otherDriver.LoadFile(cachePath));
+	CHECK(otherDriver.GetCount() == 0);
+	DX::PipelineCacheStore missing(42);
+	CHECK(!missing.LoadFile(L"PipelineCacheStoreTests.files/missing.bin"));
+}
+
+// Damaged files either load whole or not at all. The header's reserved word is the only
+// part nothing reads, so it's left alone.
+static void fuzzDamagedFiles() {
+	std::mt19937           random(4);
+	DX::PipelineCacheStore store(42);
+	for (int32_t i = 0; i < 20; i++) {
+		std::vector<uint8_t> blob = randomBlob(random, 300);
+		store.Put(random(), blob.data(), blob.size());
+	}
+	std::vector<uint8_t> data = store.Serialize();
+
+	uint32_t partial = 0, acceptedDamage = 0;
+	for (int32_t round = 0; round < 2000; round++) {
+		std::vector<uint8_t> damaged = data;
+		if (round % 2 == 0) {
+			size_t position = random() % damaged.size();
+			if (position >= 12 && position < 16)
+				continue;
+			damaged[position] ^= (uint8_t)(1 + random() % 255);
+		} else {
+			damaged.resize(random() % damaged.size());
+		}
+
+		DX::PipelineCacheStore target(42);
+		bool loaded = target.Deserialize(damaged.data(), damaged.size());
+		partial        += !loaded && target.GetCount() != 0 ? 1 : 0;
+		acceptedDamage += loaded ? 1 : 0;
+	}
+	CHECK(partial == 0);
+	CHECK(acceptedDamage == 0);
+}
+
+// Blobs put while a save is writing the file must not be marked as saved. Whenever the
+// store says it's clean, the file has everything in it.
+static void testPutsDuringSaveStayDirty() {
+	uint32_t lost = 0;
+	for (int32_t round = 0; round < 20; round++) {
+		DX::PipelineCacheStore store(42);
+		std::atomic<bool>      writing(true);
+		std::thread writer([&]() {
+			uint8_t blob[256] = {};
+			for (uint64_t key = 1; key <= 2000; key++)
+				store.Put(key, blob, sizeof(blob));
+			writing = false;
+		});
+		while (writing.load())
+			store.SaveFile(cachePath);
+		writer.join();
+
+		if (!store.IsDirty()) {
+			DX::PipelineCacheStore loaded(42);
+			lost += loaded.LoadFile(cachePath) && loaded.GetCount() == store.GetCount() ? 0 : 1;
+		}
+
+		// One more save always catches up
+		CHECK(store.IsDirty() ? store.SaveFile(cachePath) : true);
+		CHECK(!store.IsDirty());
+	}
+	CHECK(lost == 0);
+}
+
+int main() {
+	std::filesystem::remove_all(fileDirectory);
+	std::filesystem::create_directories(fileDirectory);
+
+	testKeyHashing();
+	testSavesAndLoads();
+	fuzzDamagedFiles();
+	testPutsDuringSaveStayDirty();
+
+	std::filesystem::remove_all(fileDirectory);
+	return testResult("PipelineCacheStoreTests");
+}
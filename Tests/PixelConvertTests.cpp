@@ -0,0 +1,225 @@
+#include "Driver/PixelConvert.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace TestApp;
+using namespace VuforiaDriver;
+
+///////////////////////////////////////////
+
+static const PixelFormat allFormats[] = { PixelFormat::YUYV, PixelFormat::NV12, PixelFormat::NV21, PixelFormat::RGB888, PixelFormat::RGBA8888 };
+static const uint8_t     guardByte    = 0xCD;
+
+static bool isYuv420(PixelFormat format) {
+	return format == PixelFormat::NV12 || format == PixelFormat::NV21;
+}
+
+static uint32_t pixelBytes(PixelFormat format) {
+	return format == PixelFormat::YUYV ? 2 : format == PixelFormat::RGB888 ? 3 : format == PixelFormat::RGBA8888 ? 4 : 1;
+}
+
+static uint32_t rowCount(PixelFormat format, uint32_t height) {
+	return isYuv420(format) ? height + (height + 1) / 2 : height;
+}
+
+// The bytes of a row that hold pixels, the rest of the stride being padding
+static uint32_t usedBytes(PixelFormat format, uint32_t width, uint32_t height, uint32_t row) {
+	return row < height ? width * pixelBytes(format) : (width + 1) / 2 * 2;
+}
+
+// A frame with padding after every row, and guard bytes after the buffer
+struct TestImage {
+	std::vector<uint8_t> memory;
+	CameraFrame          frame;
+
+	TestImage(PixelFormat format, uint32_t width, uint32_t height, uint32_t padding) {
+		frame = {};
+		frame.width      = width;
+		frame.height     = height;
+		frame.format     = format;
+		frame.stride     = (isYuv420(format) ? width + (width & 1) : width * pixelBytes(format)) + padding;
+		frame.bufferSize = frame.stride * rowCount(format, height);
+		memory.assign(frame.bufferSize + 64, guardByte);
+		frame.buffer = memory.data();
+	}
+
+	void fill(std::mt19937& random) {
+		for (uint32_t i = 0; i < frame.bufferSize; i++)
+			memory[i] = (uint8_t)random();
+	}
+
+	uint8_t* row(uint32_t index) { return memory.data() + (size_t)index * frame.stride; }
+
+	bool guardsIntact() const {
+		for (size_t i = frame.bufferSize; i < memory.size(); i++) {
+			if (memory[i] != guardByte)
+				return false;
+		}
+		return true;
+	}
+};
+
+static bool samePixels(TestImage& a, TestImage& b) {
+	for (uint32_t row = 0; row < rowCount(a.frame.format, a.frame.height); row++) {
+		if (std::memcmp(a.row(row), b.row(row), usedBytes(a.frame.format, a.frame.width, a.frame.height, row)) != 0)
+			return false;
+	}
+	return true;
+}
+
+///////////////////////////////////////////
+
+// Every level, with and without threads, has to match the scalar kernels byte for byte,
+// for every conversion, odd sizes and padded strides included
+static void testLevelsMatchScalar() {
+	std::mt19937   random(42);
+	PixelConverter scalar(0, PixelKernelLevel::Scalar);
+	std::vector<std::unique_ptr<PixelConverter>> converters;
+	for (PixelKernelLevel level : { PixelKernelLevel::Sse2, PixelKernelLevel::Avx2, PixelKernelLevel::Neon, getBestPixelKernelLevel() })
+		converters.push_back(std::make_unique<PixelConverter>(0, level));
+	converters.push_back(std::make_unique<PixelConverter>(3, getBestPixelKernelLevel()));
+
+	uint32_t mismatches = 0, overruns = 0, compared = 0;
+	for (uint32_t width : { 1u, 2u, 5u, 14u, 16u, 18u, 34u, 66u, 130u, 641u }) {
+		for (uint32_t height : { 1u, 2u, 3u, 7u, 65u }) {
+			for (PixelFormat srcFormat : allFormats) {
+				TestImage src(srcFormat, width, height, 5);
+				src.fill(random);
+
+				for (PixelFormat dstFormat : allFormats) {
+					TestImage expected(dstFormat, width, height, 8);
+					bool      converted = scalar.convert(src.frame, expected.frame);
+					for (auto& converter : converters) {
+						TestImage actual(dstFormat, width, height, 8);
+						mismatches += converter->convert(src.frame, actual.frame) == converted ? 0 : 1;
+						mismatches += !converted || samePixels(expected, actual) ? 0 : 1;
+						overruns   += actual.guardsIntact() ? 0 : 1;
+						compared++;
+					}
+					overruns += expected.guardsIntact() ? 0 : 1;
+				}
+
+				std::vector<uint8_t> expectedGray(width * height, guardByte);
+				CHECK(scalar.extractGray(src.frame, expectedGray.data(), width));
+				for (auto& converter : converters) {
+					std::vector<uint8_t> gray(width * height, guardByte);
+					mismatches += converter->extractGray(src.frame, gray.data(), width) && gray == expectedGray ? 0 : 1;
+				}
+			}
+		}
+	}
+	CHECK(mismatches == 0);
+	CHECK(overruns == 0);
+	CHECK(compared == 10 * 5 * 25 * 5);
+}
+
+// The scalar kernels against a plain per-pixel reference: 4:2:0 chroma is the rounded
+// average of the two rows it covers, and YUV to RGB is BT.601 video range
+static void testScalarMatchesReference() {
+	std::mt19937   random(7);
+	PixelConverter scalar(0, PixelKernelLevel::Scalar);
+
+	TestImage yuyv(PixelFormat::YUYV, 18, 7, 3);
+	yuyv.fill(random);
+	TestImage nv12(PixelFormat::NV12, 18, 7, 0);
+	CHECK(scalar.convert(yuyv.frame, nv12.frame));
+	uint32_t wrong = 0;
+	for (uint32_t y = 0; y < 7; y++) {
+		uint32_t next = y + 1 < 7 ? y + 1 : y;
+		for (uint32_t x = 0; x < 18; x++) {
+			wrong += nv12.row(y)[x] == yuyv.row(y)[x * 2] ? 0 : 1;
+			if (y % 2 == 0)
+				wrong += nv12.row(7 + y / 2)[x] == (yuyv.row(y)[x * 2 + 1] + yuyv.row(next)[x * 2 + 1] + 1) / 2 ? 0 : 1;
+		}
+	}
+	CHECK(wrong == 0);
+
+	int32_t maxError = 0;
+	for (int32_t luma = 16; luma <= 235; luma++) {
+		for (int32_t u = 16; u <= 240; u += 4) {
+			for (int32_t v = 16; v <= 240; v += 4) {
+				uint8_t     in[4] = { (uint8_t)luma, (uint8_t)luma, (uint8_t)u, (uint8_t)v };
+				uint8_t     out[6];
+				CameraFrame src = {}, dst = {};
+				src.width  = dst.width  = 2;
+				src.height = dst.height = 1;
+				src.format = PixelFormat::NV12;
+				src.buffer = in;
+				src.stride = 2;
+				src.bufferSize = 4;
+				dst.format = PixelFormat::RGB888;
+				dst.buffer = out;
+				dst.stride = 6;
+				dst.bufferSize = 6;
+				scalar.convert(src, dst);
+
+				double c = luma - 16, d = u - 128, e = v - 128;
+				double reference[3] = { 1.164 * c + 1.596 * e, 1.164 * c - 0.391 * d - 0.813 * e, 1.164 * c + 2.018 * d };
+				for (int32_t channel = 0; channel < 3; channel++) {
+					int32_t expected = (int32_t)std::lround(std::min(255.0, std::max(0.0, reference[channel])));
+					maxError = std::max(maxError, std::abs(expected - out[channel]));
+				}
+			}
+		}
+	}
+	CHECK(maxError <= 2);
+}
+
+// Copying a 4:2:0 frame with an odd width copies the whole chroma pair of the last pixel
+static void testOddWidthCopy() {
+	std::mt19937   random(9);
+	PixelConverter converter(0);
+	for (PixelFormat format : { PixelFormat::NV12, PixelFormat::NV21 }) {
+		TestImage src(format, 5, 5, 3);
+		src.fill(random);
+		TestImage dst(format, 5, 5, 1);
+		CHECK(converter.convert(src.frame, dst.frame));
+		CHECK(samePixels(src, dst));
+		CHECK(std::memcmp(src.row(5), dst.row(5), 6) == 0 && std::memcmp(src.row(7), dst.row(7), 6) == 0);
+		CHECK(dst.guardsIntact());
+	}
+
+	// Buffers too small for their stride are refused
+	TestImage src(PixelFormat::NV12, 5, 5, 0);
+	TestImage dst(PixelFormat::NV12, 5, 5, 0);
+	dst.frame.bufferSize -= 1;
+	CHECK(!converter.convert(src.frame, dst.frame));
+	dst.frame.bufferSize += 1;
+	dst.frame.stride      = 5;
+	CHECK(!converter.convert(src.frame, dst.frame));
+}
+
+static void reportThroughput() {
+	std::mt19937 random(1);
+	TestImage    yuyv(PixelFormat::YUYV, 1920, 1080, 0);
+	TestImage    nv12(PixelFormat::NV12, 1920, 1080, 0);
+	TestImage    rgba(PixelFormat::RGBA8888, 1920, 1080, 0);
+	yuyv.fill(random);
+	nv12.fill(random);
+	for (PixelKernelLevel level : { PixelKernelLevel::Scalar, getBestPixelKernelLevel() }) {
+		PixelConverter converter(0, level);
+		auto time = [&](TestImage& src, TestImage& dst) {
+			auto    start = std::chrono::steady_clock::now();
+			int32_t count = 0;
+			for (; std::chrono::steady_clock::now() - start < std::chrono::milliseconds(100); count++)
+				converter.convert(src.frame, dst.frame);
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / count;
+		};
+		double toNv12 = time(yuyv, nv12);
+		double toRgba = time(nv12, rgba);
+		std::printf("PixelConverter level %d at 1080p: YUYV to NV12 %.2f ms, NV12 to RGBA %.2f ms\n", (int)converter.getLevel(), toNv12, toRgba);
+	}
+}
+
+int main() {
+	testLevelsMatchScalar();
+	testScalarMatchesReference();
+	testOddWidthCopy();
+	reportThroughput();
+	return testResult("PixelConvertTests");
+}
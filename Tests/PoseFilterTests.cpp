@@ -0,0 +1,216 @@
+#include "xr_pose_filter.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+///////////////////////////////////////////
+
+static const XrDuration frameTime  = 11111111; // 90Hz
+static const int32_t    spaceCount = 5;        // A full group of 4 and one lane of the next
+
+// One Euro on position for a single space, written out the plain way, to check the
+// batched version against. Same config, same order of operations.
+struct ScalarFilter {
+	bool   initialized;
+	XrTime sampleTime;
+	float  position[3], velocity[3], rawPosition[3];
+};
+
+static float scalarAlpha(float cutoff, float dt) {
+	float tau = 1.0f / (cutoff * DirectX::XM_2PI);
+	return dt / (dt + tau);
+}
+
+static XrVector3f scalarUpdate(ScalarFilter& filter, const pose_filter_config_t& config, const XrVector3f& raw, XrTime sampleTime, XrTime targetTime) {
+	const float sample[3] = { raw.x, raw.y, raw.z };
+	if (!filter.initialized || sampleTime > filter.sampleTime) {
+		float seconds = filter.initialized ? (float)((sampleTime - filter.sampleTime) * 1e-9) : 1.0f;
+		float dt      = std::max(seconds, 0.0001f);
+		bool  reset   = !filter.initialized || seconds > config.reset_time;
+
+		float alphaD = scalarAlpha(config.d_cutoff, dt);
+		float speed  = 0;
+		float velocity[3];
+		for (int32_t c = 0; c < 3; c++) {
+			velocity[c] = filter.velocity[c] + ((sample[c] - filter.rawPosition[c]) / dt - filter.velocity[c]) * alphaD;
+			speed      += velocity[c] * velocity[c];
+		}
+		float alpha = scalarAlpha(config.min_cutoff + config.beta * std::sqrt(speed), dt);
+		for (int32_t c = 0; c < 3; c++) {
+			filter.position[c]    = reset ? sample[c] : filter.position[c] + (sample[c] - filter.position[c]) * alpha;
+			filter.velocity[c]    = reset ? 0 : velocity[c];
+			filter.rawPosition[c] = sample[c];
+		}
+		filter.sampleTime  = sampleTime;
+		filter.initialized = true;
+	}
+
+	float horizon = (float)((targetTime - filter.sampleTime) * 1e-9) + config.lead;
+	horizon = std::min(std::max(horizon, 0.0f), config.max_extrapolation);
+	return { filter.position[0] + filter.velocity[0] * horizon,
+	         filter.position[1] + filter.velocity[1] * horizon,
+	         filter.position[2] + filter.velocity[2] * horizon };
+}
+
+static XrPosef rotationAboutY(float angle, XrVector3f position) {
+	return { { 0, sinf(angle / 2), 0, cosf(angle / 2) }, position };
+}
+
+static float orientationLength(const XrQuaternionf& q) {
+	return sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+}
+
+///////////////////////////////////////////
+
+// Each lane gets its own noisy path, and drops out now and then, so a lane leaking into
+// its neighbours or the partial last group would show up against the scalar version.
+static void testMatchesScalarReference() {
+	pose_filter_config_t config = pose_filter_default_config;
+	config.lead = 0.01f;
+
+	pose_filter_t filter;
+	pose_filter_init(filter, spaceCount, config);
+	ScalarFilter reference[spaceCount] = {};
+
+	std::mt19937                    random(7);
+	std::normal_distribution<float> noise(0, 0.003f);
+	float maxError = 0;
+	for (int32_t frame = 0; frame < 600; frame++) {
+		XrTime   time = (XrTime)(frame + 1) * frameTime;
+		XrPosef  raw[spaceCount];
+		XrTime   sampleTimes[spaceCount];
+		XrBool32 valid[spaceCount];
+		for (int32_t i = 0; i < spaceCount; i++) {
+			float seconds = (float)(time * 1e-9);
+			raw[i]         = rotationAboutY(0, { sinf(seconds * (i + 1)) + noise(random), (float)i * seconds * 0.2f + noise(random), noise(random) });
+			sampleTimes[i] = time;
+			// Space 2 misses a couple of frames, space 4 is gone long enough to start over
+			valid[i] = !(i == 2 && frame % 7 < 2) && !(i == 4 && frame >= 200 && frame < 240);
+		}
+
+		XrPosef out[spaceCount];
+		pose_filter_update(filter, raw, sampleTimes, valid, time + frameTime, out);
+		for (int32_t i = 0; i < spaceCount; i++) {
+			if (!valid[i] && !reference[i].initialized)
+				continue;
+			XrVector3f expected = scalarUpdate(reference[i], config, raw[i].position, valid[i] ? sampleTimes[i] : reference[i].sampleTime, time + frameTime);
+			maxError = std::max(maxError, std::fabs(out[i].position.x - expected.x));
+			maxError = std::max(maxError, std::fabs(out[i].position.y - expected.y));
+			maxError = std::max(maxError, std::fabs(out[i].position.z - expected.z));
+		}
+	}
+	CHECK(maxError < 1e-4f);
+}
+
+static void testDisabledPassesThrough() {
+	pose_filter_config_t config = pose_filter_default_config;
+	config.enabled = false;
+
+	pose_filter_t filter;
+	pose_filter_init(filter, 2, config);
+	XrPosef  raw[2]         = { rotationAboutY(0.3f, { 1, 2, 3 }), rotationAboutY(-1, { 4, 5, 6 }) };
+	XrTime   sampleTimes[2] = { frameTime, frameTime };
+	XrBool32 valid[2]       = { true, true };
+	XrPosef  out[2];
+	pose_filter_update(filter, raw, sampleTimes, valid, 10 * frameTime, out);
+	for (int32_t i = 0; i < 2; i++) {
+		CHECK(out[i].position.x == raw[i].position.x && out[i].position.y == raw[i].position.y && out[i].position.z == raw[i].position.z);
+		CHECK(out[i].orientation.y == raw[i].orientation.y && out[i].orientation.w == raw[i].orientation.w);
+	}
+}
+
+// Turning at a steady 1rad/s, the filtered orientation should catch up with the truth,
+// to within a few frames, and always stay a unit quaternion, including across the q / -q flip.
+static void testOrientationFollowsSteadyTurn() {
+	pose_filter_t filter;
+	pose_filter_init(filter, 1, pose_filter_default_config);
+
+	float maxLengthError = 0, angleError = 0;
+	for (int32_t frame = 0; frame < 900; frame++) {
+		XrTime   time  = (XrTime)(frame + 1) * frameTime;
+		float    angle = (float)(time * 1e-9);
+		XrPosef  raw   = rotationAboutY(angle, { 0, 0, 0 });
+		XrBool32 valid = true;
+		XrPosef  out;
+		pose_filter_update(filter, &raw, &time, &valid, time, &out);
+
+		maxLengthError = std::max(maxLengthError, std::fabs(orientationLength(out.orientation) - 1));
+		float dot  = std::fabs(out.orientation.y * raw.orientation.y + out.orientation.w * raw.orientation.w);
+		angleError = 2 * std::acos(std::min(dot, 1.0f));
+	}
+	CHECK(maxLengthError < 1e-4f);
+	CHECK(angleError < 0.02f); // 20ms behind, same as we allow for position
+}
+
+// What the request asked to have numbers for, replayed headless: a hand that sits still
+// for 5s with tracking noise, then moves at 0.5m/s. Reports how much of the frame to frame
+// jitter is left at rest, and how far behind the truth the filtered pose runs while moving.
+static void benchmarkJitterAndLatency() {
+	pose_filter_t filter;
+	pose_filter_init(filter, 2, pose_filter_default_config);
+
+	std::mt19937                    random(1);
+	std::normal_distribution<float> noise(0, 0.002f);
+	const float speed = 0.5f;
+	double  rawJitter = 0, filteredJitter = 0, lag = 0;
+	int32_t lagFrames = 0;
+	XrPosef previousRaw = {}, previousOut = {};
+	for (int32_t frame = 0; frame < 900; frame++) {
+		XrTime   time    = (XrTime)frame * frameTime;
+		float    seconds = frame / 90.0f;
+		float    truth   = frame < 450 ? 0 : (seconds - 5) * speed;
+		XrPosef  raw[2];
+		XrTime   sampleTimes[2] = { time, time };
+		XrBool32 valid[2]       = { true, true };
+		for (int32_t i = 0; i < 2; i++)
+			raw[i] = rotationAboutY(0, { truth + noise(random), noise(random), noise(random) });
+
+		XrPosef out[2];
+		pose_filter_update(filter, raw, sampleTimes, valid, time, out);
+		if (frame > 10 && frame < 450) {
+			rawJitter      += std::fabs(raw[0].position.x - previousRaw.position.x);
+			filteredJitter += std::fabs(out[0].position.x - previousOut.position.x);
+		}
+		if (frame > 600) {
+			lag += truth - out[0].position.x;
+			lagFrames++;
+		}
+		previousRaw = raw[0];
+		previousOut = out[0];
+	}
+
+	double jitterLeft = filteredJitter / rawJitter;
+	double lagMs      = lag / lagFrames / speed * 1000;
+	std::printf("pose_filter: %.0f%% of jitter left at rest, %.1f ms behind at %.1f m/s\n", jitterLeft * 100, lagMs, speed);
+	CHECK(jitterLeft < 0.5);
+	CHECK(std::fabs(lagMs) < 20);
+
+	// With no new sample, the filter keeps going at its last velocity
+	XrPosef  raw[2]         = {};
+	XrTime   last           = 899 * frameTime;
+	XrTime   sampleTimes[2] = { last, last };
+	XrBool32 valid[2]       = { true, true };
+	XrPosef  now[2], later[2];
+	pose_filter_update(filter, raw, sampleTimes, valid, last, now);
+	pose_filter_update(filter, raw, sampleTimes, valid, last + 20000000, later);
+	CHECK_NEAR(later[0].position.x - now[0].position.x, speed * 0.02f, 0.003f);
+
+	const int32_t updates = 100000;
+	auto          start   = std::chrono::steady_clock::now();
+	for (int32_t i = 0; i < updates; i++) {
+		XrTime time = last + (XrTime)(i + 1) * frameTime;
+		sampleTimes[0] = sampleTimes[1] = time;
+		pose_filter_update(filter, now, sampleTimes, valid, time, later);
+	}
+	double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / updates;
+	std::printf("pose_filter_update: %.1f ns for 2 spaces, with scalar DirectXMath\n", ns);
+}
+
+int main() {
+	testMatchesScalarReference();
+	testDisabledPassesThrough();
+	testOrientationFollowsSteadyTurn();
+	benchmarkJitterAndLatency();
+	return testResult("PoseFilterTests");
+}
@@ -0,0 +1,140 @@
+#include "xr_pose_history.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+///////////////////////////////////////////
+
+static const XrDuration frameTime = 11111111; // 90Hz
+
+// Moves along x at 1m/s, and turns around y at 0.5rad/s, so both lerp and slerp between
+// samples land exactly on the trajectory.
+static XrPosef trajectory(XrTime time) {
+	float   seconds = (float)(time * 1e-9);
+	float   angle   = seconds * 0.5f;
+	XrPosef pose;
+	pose.position    = { seconds, 0, 0 };
+	pose.orientation = { 0, sinf(angle / 2), 0, cosf(angle / 2) };
+	return pose;
+}
+
+static double poseError(const XrPosef& a, const XrPosef& b) {
+	return fabs(a.position.x - b.position.x) + fabs(a.position.y - b.position.y) + fabs(a.position.z - b.position.z) +
+		fabs(a.orientation.x - b.orientation.x) + fabs(a.orientation.y - b.orientation.y) +
+		fabs(a.orientation.z - b.orientation.z) + fabs(a.orientation.w - b.orientation.w);
+}
+
+// Big enough that they shouldn't go on the stack
+static pose_history_t history;
+static pose_history_t gapHistory;
+static pose_history_t orderHistory;
+
+///////////////////////////////////////////
+
+static void testInterpolatesBetweenSamples() {
+	for (XrTime time = frameTime; time <= 1000 * frameTime; time += frameTime)
+		CHECK(pose_history_push(history, time, trajectory(time)));
+
+	// Only capacity - 1 samples are safe to read, the oldest slot may be mid-write
+	XrTime oldest = (1000 - (pose_history_capacity - 2)) * frameTime;
+	XrTime newest = 1000 * frameTime;
+	double maxError = 0;
+	for (int32_t i = 0; i <= 1000; i++) {
+		XrTime  time = oldest + (newest - oldest) * i / 1000;
+		XrPosef pose;
+		CHECK(pose_history_sample(history, time, &pose));
+		maxError = std::max(maxError, poseError(pose, trajectory(time)));
+	}
+	CHECK(maxError < 1e-4);
+
+	XrPosef pose;
+	CHECK(!pose_history_sample(history, oldest - frameTime, &pose));
+	CHECK(!pose_history_sample(history, newest + 1, &pose));
+
+	pose_sample_t sample;
+	CHECK(pose_history_newest(history, &sample));
+	CHECK(sample.time == newest);
+}
+
+static void testIgnoresOlderSamples() {
+	for (XrTime time = frameTime; time <= 10 * frameTime; time += frameTime)
+		CHECK(pose_history_push(orderHistory, time, trajectory(time)));
+
+	pose_sample_t before;
+	CHECK(pose_history_newest(orderHistory, &before));
+	CHECK(before.time == 10 * frameTime);
+	CHECK(!pose_history_push(orderHistory, before.time, trajectory(0)));
+	CHECK(!pose_history_push(orderHistory, before.time - 1, trajectory(0)));
+
+	pose_sample_t after;
+	CHECK(pose_history_newest(orderHistory, &after));
+	CHECK(after.time == before.time && poseError(after.pose, before.pose) == 0);
+}
+
+static void testDoesNotInterpolateAcrossGaps() {
+	XrTime lost  = 10 * frameTime;
+	XrTime found = lost + 2 * pose_history_max_gap;
+	for (XrTime time = frameTime; time <= lost; time += frameTime)
+		pose_history_push(gapHistory, time, trajectory(time));
+	for (XrTime time = found; time <= found + 10 * frameTime; time += frameTime)
+		pose_history_push(gapHistory, time, trajectory(time));
+
+	XrPosef pose;
+	CHECK(!pose_history_sample(gapHistory, lost + pose_history_max_gap, &pose));
+	CHECK(pose_history_sample(gapHistory, lost - frameTime / 2, &pose));
+	CHECK(pose_history_sample(gapHistory, found + frameTime / 2, &pose));
+}
+
+// A writer pushing as fast as it can while a reader samples just behind it. Anything torn
+// by the writer lapping the reader would land off the trajectory.
+static void testReadersNeverSeeTornSamples() {
+	static pose_history_t shared;
+	std::atomic<bool>     stop(false);
+	std::thread writer([&]() {
+		for (XrTime time = frameTime; !stop.load(); time += 1000)
+			pose_history_push(shared, time, trajectory(time));
+	});
+
+	uint64_t sampled = 0, wrong = 0;
+	auto     start   = std::chrono::steady_clock::now();
+	while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(200)) {
+		pose_sample_t newest;
+		XrPosef       pose;
+		if (!pose_history_newest(shared, &newest) || !pose_history_sample(shared, newest.time - 50000, &pose))
+			continue;
+		sampled++;
+		if (poseError(pose, trajectory(newest.time - 50000)) > 1e-3)
+			wrong++;
+	}
+	stop = true;
+	writer.join();
+
+	CHECK(sampled > 0);
+	CHECK(wrong == 0);
+}
+
+static void reportLookupTime() {
+	pose_sample_t newest;
+	pose_history_newest(history, &newest);
+
+	const int32_t  lookups = 1000000;
+	volatile float sink    = 0;
+	auto           start   = std::chrono::steady_clock::now();
+	for (int32_t i = 0; i < lookups; i++) {
+		XrPosef pose;
+		if (pose_history_sample(history, newest.time - (i % 100) * (frameTime / 10), &pose))
+			sink += pose.position.x;
+	}
+	double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / lookups;
+	std::printf("pose_history_sample: %.1f ns per lookup\n", ns);
+}
+
+int main() {
+	testInterpolatesBetweenSamples();
+	testIgnoresOlderSamples();
+	testDoesNotInterpolateAcrossGaps();
+	testReadersNeverSeeTornSamples();
+	reportLookupTime();
+	return testResult("PoseHistoryTests");
+}
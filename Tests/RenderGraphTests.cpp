@@ -0,0 +1,199 @@
+#include "Common/RenderGraph.h"
+#include "TestCheck.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+///////////////////////////////////////////
+
+// The D3D12_RESOURCE_STATES values the graph sees, without needing d3d12.h
+enum : uint32_t {
+	statePresent      = 0,
+	stateRenderTarget = 0x4,
+	stateDepthWrite   = 0x10,
+	stateDepthRead    = 0x20,
+	stateNonPixelSrv  = 0x40,
+	statePixelSrv     = 0x80,
+};
+static const uint32_t readOnlyStates = stateDepthRead | stateNonPixelSrv | statePixelSrv;
+
+// A frame with a dead pass, and transients whose lifetimes let two of them share memory:
+// clear, depth prepass, (dead), mask, blur, cubes, late, outline.
+struct TestFrame {
+	int             backBuffer, depth;
+	int             maskMemory, blurMemory, lateMemory;
+	DX::RenderGraph graph;
+	std::string     log;
+	uint32_t        bb, ds, mask, blur, unused, late;
+	uint32_t        clear, prepass, dead, maskPass, blurPass, cubes, latePass, outline;
+
+	TestFrame() {
+		bb     = graph.ImportResource("BackBuffer", &backBuffer, statePresent);
+		ds     = graph.ImportResource("DepthStencil", &depth);
+		mask   = graph.CreateTransient("Mask", 1 << 20, 65536);
+		blur   = graph.CreateTransient("Blur", 1 << 20, 65536);
+		unused = graph.CreateTransient("Unused", 4 << 20, 65536);
+		late   = graph.CreateTransient("Late", 1 << 20, 65536);
+
+		clear = graph.AddPass("Clear", [this]() { log += "C"; });
+		graph.Write(clear, bb, stateRenderTarget);
+		graph.Write(clear, ds, stateDepthWrite);
+		prepass = graph.AddPass("Prepass", [this]() { log += "P"; });
+		graph.Read(prepass, ds, stateDepthWrite);
+		graph.Write(prepass, ds, stateDepthWrite);
+		dead = graph.AddPass("Dead", [this]() { log += "X"; });
+		graph.Write(dead, unused, stateRenderTarget);
+		maskPass = graph.AddPass("Mask", [this]() { log += "M"; });
+		graph.Write(maskPass, mask, stateRenderTarget);
+		graph.Read(maskPass, ds, stateDepthRead);
+		blurPass = graph.AddPass("Blur", [this]() { log += "L"; });
+		graph.Read(blurPass, mask, statePixelSrv);
+		graph.Write(blurPass, blur, stateRenderTarget);
+		cubes = graph.AddPass("Cubes", [this]() { log += "Q"; });
+		graph.Read(cubes, bb, stateRenderTarget);
+		graph.Write(cubes, bb, stateRenderTarget);
+		graph.Read(cubes, ds, stateDepthWrite);
+		graph.Write(cubes, ds, stateDepthWrite);
+		latePass = graph.AddPass("Late", [this]() { log += "T"; });
+		graph.Write(latePass, late, stateRenderTarget);
+		outline = graph.AddPass("Outline", [this]() { log += "O"; });
+		graph.Read(outline, blur, statePixelSrv);
+		graph.Read(outline, late, statePixelSrv);
+		graph.Read(outline, bb, stateRenderTarget);
+		graph.Write(outline, bb, stateRenderTarget);
+		graph.Compile();
+
+		graph.SetTransientResource(mask, &maskMemory);
+		graph.SetTransientResource(blur, &blurMemory);
+		graph.SetTransientResource(late, &lateMemory);
+	}
+};
+
+///////////////////////////////////////////
+
+static void testCullsAndPlaces() {
+	TestFrame frame;
+	DX::RenderGraph& graph = frame.graph;
+	CHECK(graph.IsPassCulled(frame.dead));
+	CHECK(!graph.IsPassCulled(frame.prepass));
+	CHECK(graph.GetPassOrder().size() == 7);
+
+	// Mask lives over passes 2-3, blur 3-6 and late 5-6, so late can take the mask's bytes
+	CHECK(graph.GetTransientOffset(frame.mask) != graph.GetTransientOffset(frame.blur));
+	CHECK(graph.GetTransientOffset(frame.late) == graph.GetTransientOffset(frame.mask));
+	CHECK(graph.GetTransientMemorySize() == 2 << 20);
+	CHECK(graph.GetFirstUse(frame.unused) == DX::RenderGraph::c_invalid);
+	CHECK(graph.GetInitialState(frame.mask) == stateRenderTarget);
+}
+
+// Everything goes through the tracker: it starts from the registry, and the registry ends
+// up with the back buffer presentable and the depth buffer as the last pass left it.
+static void testBarriersComeFromTheTracker() {
+	TestFrame frame;
+	DX::ResourceStateRegistry registry(readOnlyStates);
+	registry.Register(&frame.backBuffer, statePresent);
+	registry.Register(&frame.depth, stateDepthWrite);
+
+	DX::ResourceStateTracker tracker(registry);
+	std::vector<DX::StateTransition> emitted;
+	uint32_t flushes = 0, aliasing = 0, aliasedLate = 0;
+	frame.graph.Execute(tracker, [&](uint32_t pass) {
+		flushes++;
+		for (const auto& alias : tracker.GetPendingAliasing()) {
+			aliasing++;
+			aliasedLate += alias.first == &frame.maskMemory && alias.second == &frame.lateMemory && pass == frame.latePass ? 1 : 0;
+		}
+		emitted.insert(emitted.end(), tracker.GetPendingTransitions().begin(), tracker.GetPendingTransitions().end());
+		tracker.ClearPendingTransitions();
+	});
+	CHECK(frame.log == "CPMLQTO");
+	CHECK(aliasing == 1 && aliasedLate == 1);
+
+	// Only real state changes: back buffer to render target, depth to read for the mask and
+	// back (split over the blur pass), and the mask to a shader resource for the blur
+	uint32_t backBufferChanges = 0, depthChanges = 0, depthSplits = 0, maskChanges = 0;
+	for (const DX::StateTransition& transition : emitted) {
+		CHECK(transition.before != transition.after);
+		backBufferChanges += transition.resource == &frame.backBuffer ? 1 : 0;
+		depthChanges      += transition.resource == &frame.depth ? 1 : 0;
+		depthSplits       += transition.resource == &frame.depth && transition.split != DX::TransitionSplit::None ? 1 : 0;
+		maskChanges       += transition.resource == &frame.maskMemory ? 1 : 0;
+	}
+	CHECK(backBufferChanges == 1);
+	CHECK(depthChanges == 3 && depthSplits == 2);
+	CHECK(maskChanges == 1);
+	CHECK(flushes >= 3);
+
+	// The move back to present is left for the end of the list
+	CHECK(tracker.GetPendingTransitions().size() == 1);
+	CHECK(tracker.GetPendingTransitions()[0].resource == &frame.backBuffer);
+	CHECK(tracker.GetPendingTransitions()[0].after == statePresent);
+	tracker.EndSplitTransitions();
+	tracker.ClearPendingTransitions();
+	tracker.Commit();
+
+	uint32_t state = ~0u;
+	CHECK(registry.GetState(&frame.backBuffer, state) && state == statePresent);
+	CHECK(registry.GetState(&frame.depth, state) && state == stateDepthWrite);
+	CHECK(!registry.GetState(&frame.maskMemory, state));
+}
+
+// A second frame starting from where the first one left things needs the same barriers,
+// and none at all for the depth buffer if nothing but the depth passes touch it.
+static void testStartsFromTheRegisteredState() {
+	int backBuffer, depth;
+	DX::ResourceStateRegistry registry(readOnlyStates);
+	registry.Register(&backBuffer, stateRenderTarget);
+	registry.Register(&depth, stateDepthWrite);
+
+	DX::RenderGraph graph;
+	uint32_t bb   = graph.ImportResource("BackBuffer", &backBuffer, statePresent);
+	uint32_t ds   = graph.ImportResource("DepthStencil", &depth);
+	uint32_t pass = graph.AddPass("Cubes", []() {});
+	graph.Write(pass, bb, stateRenderTarget);
+	graph.Write(pass, ds, stateDepthWrite);
+	graph.Compile();
+
+	DX::ResourceStateTracker tracker(registry);
+	uint32_t flushes = 0;
+	graph.Execute(tracker, [&](uint32_t) { flushes++; });
+	CHECK(flushes == 0);
+	CHECK(tracker.GetPendingTransitions().size() == 1);
+	CHECK(tracker.GetPendingTransitions()[0].before == stateRenderTarget);
+	tracker.ClearPendingTransitions();
+	tracker.Commit();
+}
+
+static void reportCompileTime() {
+	const int32_t   frames = 2000;
+	int             imported[8];
+	DX::RenderGraph graph;
+	auto            start = std::chrono::steady_clock::now();
+	for (int32_t frame = 0; frame < frames; frame++) {
+		graph.Reset();
+		uint32_t importedIds[8], transientIds[88];
+		for (int32_t i = 0; i < 8; i++)
+			importedIds[i] = graph.ImportResource("Imported", &imported[i], statePresent);
+		for (int32_t i = 0; i < 88; i++)
+			transientIds[i] = graph.CreateTransient("Transient", (uint64_t)(1 + i % 7) << 20, 65536);
+		for (int32_t p = 0; p < 64; p++) {
+			uint32_t pass = graph.AddPass("Pass", []() {});
+			graph.Read(pass, transientIds[(p * 7) % 88], statePixelSrv);
+			graph.Read(pass, transientIds[(p * 13 + 5) % 88], stateNonPixelSrv);
+			graph.Write(pass, transientIds[(p * 3 + 1) % 88], stateRenderTarget);
+			if (p % 8 == 7)
+				graph.Write(pass, importedIds[p / 8], stateRenderTarget);
+		}
+		graph.Compile();
+	}
+	double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frames;
+	std::printf("RenderGraph build and compile, 64 passes and 96 resources: %.1f us per frame\n", us);
+}
+
+int main() {
+	testCullsAndPlaces();
+	testBarriersComeFromTheTracker();
+	testStartsFromTheRegisteredState();
+	reportCompileTime();
+	return testResult("RenderGraphTests");
+}
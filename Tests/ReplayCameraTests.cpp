@@ -0,0 +1,224 @@
+#include "Driver/ReplayCamera.h"
+#include "TestCheck.h"
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace TestApp;
+using namespace VuforiaDriver;
+
+///////////////////////////////////////////
+
+static const char*    fileDirectory = "ReplayCameraTests.files";
+static const uint32_t frameStride   = 128;
+static const uint64_t firstTime     = 1000000000ull;
+
+// Keeps a copy of every frame, since the buffer only stays valid during the callback
+struct FrameSink : CameraCallback {
+	std::mutex               mutex;
+	std::vector<CameraFrame> frames;
+	std::vector<uint8_t>     firstBytes;
+
+	void VUFORIA_DRIVER_CALLING_CONVENTION onNewCameraFrame(CameraFrame* frame) override {
+		std::lock_guard<std::mutex> lock(mutex);
+		frames.push_back(*frame);
+		firstBytes.push_back(frame->buffer[0]);
+	}
+
+	size_t count() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return frames.size();
+	}
+};
+
+static CameraMode testMode(uint32_t fps) {
+	CameraMode mode;
+	mode.width  = 64;
+	mode.height = 48;
+	mode.fps    = fps;
+	mode.format = PixelFormat::YUYV;
+	return mode;
+}
+
+// Frame i is filled with the value i, and has its own exposure and focal length
+static std::wstring writeRecording(const std::string& name, uint32_t fps, const std::vector<uint64_t>& times) {
+	std::string  path = std::string(fileDirectory) + "/" + name;
+	std::wstring widePath(path.begin(), path.end());
+
+	FrameRecordingWriter writer;
+	CHECK(writer.open(widePath, testMode(fps), frameStride));
+	std::vector<uint8_t> pixels(frameStride * 48);
+	for (size_t i = 0; i < times.size(); i++) {
+		CameraIntrinsics intrinsics = {};
+		intrinsics.focalLengthX = 500.0f + (float)i;
+		std::fill(pixels.begin(), pixels.end(), (uint8_t)i);
+		CHECK(writer.addFrame(times[i], 8000000 + i, intrinsics, pixels.data(), (uint32_t)pixels.size()));
+	}
+	CHECK(writer.finish());
+	return widePath;
+}
+
+static bool waitForFrames(ReplayCamera& camera, FrameSink& sink, size_t count) {
+	auto start = std::chrono::steady_clock::now();
+	while (sink.count() < count && !camera.isFinished()) {
+		if (std::chrono::steady_clock::now() - start > std::chrono::seconds(5))
+			return false;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return sink.count() >= count;
+}
+
+///////////////////////////////////////////
+
+static void testPlaysEveryFrameInOrder() {
+	std::vector<uint64_t> times;
+	for (uint64_t i = 0; i < 10; i++)
+		times.push_back(firstTime + i * 33333333ull);
+	ReplayCamera camera(writeRecording("ten.vfr", 30, times), 0.0f, false, FrameDropPolicy::DropOldest, 2);
+	CHECK(camera.open());
+	CHECK(camera.getNumSupportedCameraModes() == 1);
+
+	CameraMode mode;
+	CHECK(camera.getSupportedCameraMode(0, &mode) && mode.width == 64 && mode.fps == 30);
+	FrameSink sink;
+	CameraMode other = mode;
+	other.width = 32;
+	CHECK(!camera.start(other, &sink));
+	CHECK(!camera.start(mode, nullptr));
+
+	CHECK(camera.start(mode, &sink));
+	CHECK(waitForFrames(camera, sink, 10));
+	camera.stop();
+
+	// A speed of 0 blocks instead of dropping, so nothing is lost
+	CHECK(sink.frames.size() == 10);
+	uint32_t wrong = 0;
+	for (size_t i = 0; i < sink.frames.size(); i++) {
+		const CameraFrame& frame = sink.frames[i];
+		wrong += frame.index == i && sink.firstBytes[i] == i && frame.stride == frameStride &&
+			frame.exposureTime == 8000000 + i && frame.intrinsics.focalLengthX == 500.0f + (float)i ? 0 : 1;
+		wrong += (uintptr_t)frame.buffer % c_frameRecordingAlignment == 0 ? 0 : 1;
+		if (i > 0)
+			wrong += frame.timestamp - sink.frames[i - 1].timestamp == 33333333ull ? 0 : 1;
+	}
+	CHECK(wrong == 0);
+	CHECK(camera.getDeliveredFrameCount() == 10);
+	CHECK(camera.getQueueCounters().droppedOldest == 0 && camera.getQueueCounters().droppedNewest == 0);
+}
+
+// One frame with no frame rate has nothing to say how long a loop takes
+static void testLoopsNeedALength() {
+	std::wstring single = writeRecording("single.vfr", 0, { firstTime });
+	CameraMode   mode   = testMode(0);
+	FrameSink    sink;
+
+	ReplayCamera realTime(single, 1.0f, true, FrameDropPolicy::DropOldest, 2);
+	CHECK(realTime.open());
+	CHECK(!realTime.start(mode, &sink));
+
+	// Without looping it's just the one frame
+	ReplayCamera once(single, 1.0f, false, FrameDropPolicy::DropOldest, 2);
+	CHECK(once.open());
+	CHECK(once.start(mode, &sink));
+	CHECK(waitForFrames(once, sink, 1));
+	once.stop();
+	CHECK(sink.frames.size() == 1);
+
+	// With a frame rate, a single frame loops at it
+	FrameSink    rated;
+	ReplayCamera looped(writeRecording("single100.vfr", 100, { firstTime }), 10.0f, true, FrameDropPolicy::Block, 4);
+	CHECK(looped.open());
+	CHECK(looped.start(testMode(100), &rated));
+	CHECK(waitForFrames(looped, rated, 5));
+	looped.stop();
+	uint32_t wrongSpacing = 0;
+	for (size_t i = 1; i < rated.frames.size(); i++)
+		wrongSpacing += rated.frames[i].timestamp - rated.frames[i - 1].timestamp == 10000000ull ? 0 : 1;
+	CHECK(wrongSpacing == 0);
+}
+
+// Without a frame rate, the gap back to the first frame is the average recorded spacing
+static void testLoopsUseTheRecordedSpacing() {
+	std::wstring path = writeRecording("unrated.vfr", 0, { firstTime, firstTime + 10000000ull, firstTime + 20000000ull });
+	FrameSink    sink;
+	ReplayCamera camera(path, 10.0f, true, FrameDropPolicy::Block, 4);
+	CHECK(camera.open());
+	CHECK(camera.start(testMode(0), &sink));
+	CHECK(waitForFrames(camera, sink, 7));
+	camera.stop();
+
+	uint32_t wrongSpacing = 0;
+	for (size_t i = 1; i < sink.frames.size(); i++)
+		wrongSpacing += sink.frames[i].timestamp - sink.frames[i - 1].timestamp == 10000000ull ? 0 : 1;
+	CHECK(wrongSpacing == 0);
+	CHECK(sink.firstBytes.size() >= 4 && sink.firstBytes[3] == 0);
+}
+
+// At twice the recorded rate, 30fps plays back at about 60fps
+static void testPlaysAtTheScaledRate() {
+	std::vector<uint64_t> times;
+	for (uint64_t i = 0; i < 10; i++)
+		times.push_back(firstTime + i * 33333333ull);
+	FrameSink    sink;
+	ReplayCamera camera(writeRecording("rate.vfr", 30, times), 2.0f, true, FrameDropPolicy::DropOldest, 4);
+	CHECK(camera.open());
+	CHECK(camera.start(testMode(30), &sink));
+	std::this_thread::sleep_for(std::chrono::milliseconds(500));
+	camera.stop();
+
+	// Loose bounds, the machine running the tests may be busy
+	size_t delivered = sink.frames.size();
+	CHECK(delivered >= 15 && delivered <= 33);
+	uint32_t backwards = 0;
+	for (size_t i = 1; i < sink.frames.size(); i++)
+		backwards += sink.frames[i].timestamp > sink.frames[i - 1].timestamp ? 0 : 1;
+	CHECK(backwards == 0);
+	std::printf("ReplayCamera at 2x for 500ms: %zu frames, 30 expected\n", delivered);
+}
+
+// Holds the delivery thread in its first callback, with the queue full behind it, until
+// stop() has been called. None of the queued frames may reach the callback after that.
+struct GatedSink : CameraCallback {
+	std::atomic<uint32_t> calls{ 0 };
+	std::atomic<bool>     open{ false };
+
+	void VUFORIA_DRIVER_CALLING_CONVENTION onNewCameraFrame(CameraFrame*) override {
+		calls++;
+		while (!open.load())
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+};
+
+static void testStopDropsQueuedFrames() {
+	std::vector<uint64_t> times;
+	for (uint64_t i = 0; i < 10; i++)
+		times.push_back(firstTime + i * 33333333ull);
+	GatedSink    sink;
+	ReplayCamera camera(writeRecording("gated.vfr", 30, times), 0.0f, false, FrameDropPolicy::Block, 4);
+	CHECK(camera.open());
+	CHECK(camera.start(testMode(30), &sink));
+	while (sink.calls == 0 || camera.getQueueCounters().depth < 4)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	std::thread stopper([&]() { camera.stop(); });
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	sink.open = true;
+	stopper.join();
+	CHECK(sink.calls == 1);
+	CHECK(camera.getDeliveredFrameCount() == 1 && !camera.isFinished());
+}
+
+int main() {
+	std::filesystem::remove_all(fileDirectory);
+	std::filesystem::create_directories(fileDirectory);
+
+	testPlaysEveryFrameInOrder();
+	testLoopsNeedALength();
+	testLoopsUseTheRecordedSpacing();
+	testPlaysAtTheScaledRate();
+	testStopDropsQueuedFrames();
+
+	std::filesystem::remove_all(fileDirectory);
+	return testResult("ReplayCameraTests");
+}
@@ -0,0 +1,228 @@
+#include "Common/ResourceStateTracker.h"
+#include "TestCheck.h"
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+///////////////////////////////////////////
+
+// The D3D12_RESOURCE_STATES values the tracker sees, without needing d3d12.h
+enum : uint32_t {
+	stateCommon        = 0,
+	stateVertexBuffer  = 0x1,
+	stateIndexBuffer   = 0x2,
+	stateRenderTarget  = 0x4,
+	stateDepthWrite    = 0x10,
+	stateNonPixelSrv   = 0x40,
+	statePixelSrv      = 0x80,
+	stateCopyDest      = 0x400,
+	statePresent       = 0,
+};
+static const uint32_t readOnlyStates = stateVertexBuffer | stateIndexBuffer | stateNonPixelSrv | statePixelSrv;
+
+static bool satisfies(uint32_t current, uint32_t wanted) {
+	return current == wanted || (wanted != 0 && (current & ~readOnlyStates) == 0 && (current & wanted) == wanted);
+}
+
+///////////////////////////////////////////
+
+static void testOnlyRegisteredResourcesChange() {
+	int a, b, c;
+	DX::ResourceStateRegistry registry(readOnlyStates);
+	registry.Register(&a, statePresent);
+	registry.Register(&b, stateDepthWrite);
+
+	DX::ResourceStateTracker tracker(registry);
+	tracker.Transition(&a, stateRenderTarget);
+	tracker.Transition(&b, stateDepthWrite);
+	tracker.Transition(&c, stateRenderTarget);
+	const std::vector<DX::StateTransition>& pending = tracker.GetPendingTransitions();
+	CHECK(pending.size() == 1);
+	CHECK(pending[0].resource == &a && pending[0].before == statePresent && pending[0].after == stateRenderTarget);
+	CHECK(pending[0].split == DX::TransitionSplit::None);
+
+	// Already there, nothing more to do
+	tracker.ClearPendingTransitions();
+	tracker.Transition(&a, stateRenderTarget);
+	CHECK(!tracker.HasPendingBarriers());
+
+	// The registry only hears about it on Commit
+	tracker.Transition(&a, statePixelSrv);
+	uint32_t state = ~0u;
+	CHECK(registry.GetState(&a, state) && state == statePresent);
+	tracker.ClearPendingTransitions();
+	tracker.Commit();
+	CHECK(registry.GetState(&a, state) && state == statePixelSrv);
+	CHECK(!registry.GetState(&c, state));
+}
+
+static void testTransitionsInABatchMerge() {
+	int a;
+	DX::ResourceStateRegistry registry(readOnlyStates);
+	registry.Register(&a, statePresent);
+
+	DX::ResourceStateTracker tracker(registry);
+	tracker.Transition(&a, stateRenderTarget);
+	tracker.Transition(&a, statePixelSrv);
+	CHECK(tracker.GetPendingTransitions().size() == 1);
+	CHECK(tracker.GetPendingTransitions()[0].before == statePresent && tracker.GetPendingTransitions()[0].after == statePixelSrv);
+
+	// Back where it started, so the batch is empty again
+	tracker.Transition(&a, statePresent);
+	CHECK(tracker.GetPendingTransitions().empty());
+	tracker.Commit();
+}
+
+static void testCombinedReadStatesSatisfyEachRead() {
+	int a;
+	DX::ResourceStateRegistry registry(readOnlyStates);
+	registry.Register(&a, stateVertexBuffer | statePixelSrv);
+
+	DX::ResourceStateTracker tracker(registry);
+	tracker.Transition(&a, stateVertexBuffer);
+	tracker.Transition(&a, statePixelSrv);
+	CHECK(tracker.GetPendingTransitions().empty());
+
+	// A write isn't covered by any read
+	tracker.Transition(&a, stateCopyDest);
+	CHECK(tracker.GetPendingTransitions().size() == 1);
+
+	// Nor is the combination covered by just one of its reads
+	int b;
+	registry.Register(&b, statePixelSrv);
+	tracker.Transition(&b, stateVertexBuffer | statePixelSrv);
+	CHECK(tracker.GetPendingTransitions().size() == 2);
+	tracker.Commit();
+}
+
+static void testSplitTransitions() {
+	int a, b;
+	DX::ResourceStateRegistry registry(readOnlyStates);
+	registry.Register(&a, statePresent);
+	registry.Register(&b, statePixelSrv | stateNonPixelSrv);
+
+	DX::ResourceStateTracker tracker(registry);
+	tracker.BeginTransition(&a, stateRenderTarget);
+	CHECK(tracker.GetPendingTransitions().size() == 1 && tracker.GetPendingTransitions()[0].split == DX::TransitionSplit::Begin);
+
+	// Asking for the same state ends it, with the same before and after
+	tracker.ClearPendingTransitions();
+	tracker.Transition(&a, stateRenderTarget);
+	CHECK(tracker.GetPendingTransitions().size() == 1);
+	const DX::StateTransition& end = tracker.GetPendingTransitions()[0];
+	CHECK(end.split == DX::TransitionSplit::End && end.before == statePresent && end.after == stateRenderTarget);
+
+	// Nothing to split when a read state is already covered
+	tracker.ClearPendingTransitions();
+	tracker.BeginTransition(&b, statePixelSrv);
+	CHECK(tracker.GetPendingTransitions().empty());
+
+	// Splits still open at the end of the list get ended there
+	tracker.BeginTransition(&a, statePresent);
+	tracker.EndSplitTransitions();
+	CHECK(tracker.GetPendingTransitions().size() == 2);
+	CHECK(tracker.GetPendingTransitions()[1].split == DX::TransitionSplit::End);
+	tracker.ClearPendingTransitions();
+	tracker.Commit();
+
+	uint32_t state = ~0u;
+	CHECK(registry.GetState(&a, state) && state == statePresent);
+}
+
+static void testTrackedTransientsAndAliasing() {
+	int a, b;
+	DX::ResourceStateRegistry registry(readOnlyStates);
+	DX::ResourceStateTracker  tracker(registry);
+	tracker.Track(&a, stateRenderTarget);
+	tracker.Track(&b, stateRenderTarget);
+
+	tracker.Alias(&a, &b);
+	CHECK(tracker.HasPendingBarriers());
+	CHECK(tracker.GetPendingAliasing().size() == 1 && tracker.GetPendingAliasing()[0].first == &a);
+	CHECK(tracker.GetPendingTransitions().empty());
+
+	tracker.Transition(&b, statePixelSrv);
+	CHECK(tracker.GetPendingTransitions().size() == 1 && tracker.GetPendingTransitions()[0].before == stateRenderTarget);
+	tracker.ClearPendingTransitions();
+	CHECK(!tracker.HasPendingBarriers());
+
+	// They aren't in the registry, so Commit doesn't add them to it
+	tracker.Commit();
+	uint32_t state;
+	CHECK(!registry.GetState(&a, state) && !registry.GetState(&b, state));
+}
+
+// Many lists of random uses, some of them splits, over the same resources. Replaying the
+// transitions each batch emits has to start from the state the resource is really in, leave
+// every resource in a state that satisfies its last use, and end up where the registry says.
+static void replaySyntheticLists() {
+	const int32_t  resourceCount = 32;
+	const uint32_t states[]      = { stateCommon, stateRenderTarget, stateDepthWrite, stateVertexBuffer, stateIndexBuffer,
+		statePixelSrv, stateNonPixelSrv, stateCopyDest, stateVertexBuffer | statePixelSrv };
+	const uint32_t stateCount    = sizeof(states) / sizeof(states[0]);
+
+	std::mt19937 random(1);
+	int          resources[resourceCount];
+	uint32_t     truth[resourceCount];
+	DX::ResourceStateRegistry registry(readOnlyStates);
+	for (int32_t i = 0; i < resourceCount; i++) {
+		truth[i] = states[random() % stateCount];
+		registry.Register(&resources[i], truth[i]);
+	}
+
+	uint32_t wrongBefores = 0, emptyTransitions = 0, unsatisfied = 0, wrongCommits = 0;
+	for (int32_t list = 0; list < 200; list++) {
+		DX::ResourceStateTracker tracker(registry);
+		for (int32_t batch = 0; batch < 10; batch++) {
+			std::unordered_map<int32_t, uint32_t> lastWanted;
+			int32_t uses = 1 + random() % 8;
+			for (int32_t use = 0; use < uses; use++) {
+				int32_t  i      = random() % resourceCount;
+				uint32_t wanted = states[1 + random() % (stateCount - 1)];
+				if (random() % 5 == 0) {
+					tracker.BeginTransition(&resources[i], wanted);
+					lastWanted.erase(i);
+				} else {
+					tracker.Transition(&resources[i], wanted);
+					lastWanted[i] = wanted;
+				}
+			}
+
+			for (const DX::StateTransition& transition : tracker.GetPendingTransitions()) {
+				int32_t i = (int32_t)((int*)transition.resource - resources);
+				if (transition.split != DX::TransitionSplit::End) {
+					wrongBefores     += transition.before != truth[i] ? 1 : 0;
+					emptyTransitions += transition.before == transition.after ? 1 : 0;
+				}
+				truth[i] = transition.after;
+			}
+			tracker.ClearPendingTransitions();
+			for (const auto& wanted : lastWanted)
+				unsatisfied += satisfies(truth[wanted.first], wanted.second) ? 0 : 1;
+		}
+
+		tracker.EndSplitTransitions();
+		for (const DX::StateTransition& transition : tracker.GetPendingTransitions())
+			truth[(int*)transition.resource - resources] = transition.after;
+		tracker.ClearPendingTransitions();
+		tracker.Commit();
+		for (int32_t i = 0; i < resourceCount; i++) {
+			uint32_t state = ~0u;
+			wrongCommits += registry.GetState(&resources[i], state) && state == truth[i] ? 0 : 1;
+		}
+	}
+	CHECK(wrongBefores == 0);
+	CHECK(emptyTransitions == 0);
+	CHECK(unsatisfied == 0);
+	CHECK(wrongCommits == 0);
+}
+
+int main() {
+	testOnlyRegisteredResourcesChange();
+	testTransitionsInABatchMerge();
+	testCombinedReadStatesSatisfyEachRead();
+	testSplitTransitions();
+	testTrackedTransientsAndAliasing();
+	replaySyntheticLists();
+	return testResult("ResourceStateTrackerTests");
+}
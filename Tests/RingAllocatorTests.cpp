@@ -0,0 +1,118 @@
+#include "Common/RingAllocator.h"
+#include "TestCheck.h"
+#include <random>
+#include <vector>
+
+///////////////////////////////////////////
+
+struct LiveAllocation {
+	uint64_t offset;
+	uint64_t size;
+	uint64_t fenceValue; // Free once the GPU gets here
+};
+
+static bool overlaps(uint64_t offset, uint64_t size, const LiveAllocation& other) {
+	return offset < other.offset + other.size && other.offset < offset + size;
+}
+
+///////////////////////////////////////////
+
+// Allocates, submits and retires at random against a naive list of everything the GPU
+// could still be reading. Nothing handed out may overlap it, or run off the end.
+static void testNeverHandsOutMemoryInUse() {
+	const uint64_t capacity = 1 << 16;
+	DX::RingAllocator ring(capacity);
+	std::mt19937      random(5);
+
+	std::vector<LiveAllocation> live;
+	uint64_t submitted = 0, completed = 0;
+	uint32_t allocations = 0, failures = 0, overlapping = 0, misplaced = 0;
+	for (int32_t i = 0; i < 100000; i++) {
+		uint64_t size      = 1 + random() % 5000;
+		uint64_t alignment = 1ull << (random() % 9);
+		uint64_t offset;
+		if (ring.Allocate(size, alignment, offset)) {
+			allocations++;
+			if (offset % alignment != 0 || offset + size > capacity)
+				misplaced++;
+			for (const LiveAllocation& other : live)
+				overlapping += overlaps(offset, size, other) ? 1 : 0;
+			live.push_back({ offset, size, submitted + 1 });
+		} else {
+			failures++;
+		}
+
+		if (random() % 4 == 0)
+			ring.Submit(++submitted);
+		if (random() % 3 == 0 && completed < submitted) {
+			ring.Retire(++completed);
+			std::vector<LiveAllocation> stillLive;
+			for (const LiveAllocation& allocation : live)
+				if (allocation.fenceValue > completed)
+					stillLive.push_back(allocation);
+			live.swap(stillLive);
+		}
+	}
+
+	CHECK(misplaced == 0);
+	CHECK(overlapping == 0);
+	CHECK(allocations > failures);
+}
+
+// Fills the ring a frame at a time, the way UploadQueue uses it, and checks it only gets
+// space back as the fence passes each frame.
+static void testSpaceComesBackWithTheFence() {
+	DX::RingAllocator ring(1024);
+	uint64_t offset;
+
+	CHECK(!ring.Allocate(1025, 1, offset));
+	CHECK(ring.GetOldestFenceValue() == 0);
+
+	for (uint64_t frame = 1; frame <= 4; frame++) {
+		CHECK(ring.Allocate(256, 256, offset) && offset == (frame - 1) * 256);
+		ring.Submit(frame);
+	}
+	CHECK(ring.GetUsed() == 1024);
+	CHECK(!ring.Allocate(1, 1, offset));
+	CHECK(ring.GetOldestFenceValue() == 1);
+
+	// Submitting with nothing new allocated doesn't add an empty batch
+	ring.Submit(5);
+	ring.Retire(1);
+	CHECK(ring.GetOldestFenceValue() == 2);
+	CHECK(ring.Allocate(256, 1, offset) && offset == 0);
+	CHECK(!ring.Allocate(1, 1, offset));
+
+	ring.Submit(6);
+	ring.Retire(6);
+	CHECK(ring.GetUsed() == 0 && ring.GetOldestFenceValue() == 0);
+}
+
+static void testWrapsAroundWhenTheEndIsTooShort() {
+	DX::RingAllocator ring(1024);
+	uint64_t offset;
+
+	CHECK(ring.Allocate(700, 1, offset) && offset == 0);
+	ring.Submit(1);
+	CHECK(ring.Allocate(200, 1, offset) && offset == 700);
+	ring.Submit(2);
+
+	// 124 bytes left at the end isn't enough, so it goes back to the start, but only once
+	// the first batch is done with it
+	CHECK(!ring.Allocate(300, 1, offset));
+	ring.Retire(1);
+	CHECK(ring.Allocate(300, 1, offset) && offset == 0);
+	ring.Submit(3);
+	ring.Retire(3);
+	CHECK(ring.GetUsed() == 0);
+
+	// Once everything is back, the whole ring is available again, wherever the head was
+	CHECK(ring.Allocate(1024, 1, offset) && offset == 0);
+}
+
+int main() {
+	testNeverHandsOutMemoryInUse();
+	testSpaceComesBackWithTheFence();
+	testWrapsAroundWhenTheEndIsTooShort();
+	return testResult("RingAllocatorTests");
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Stands in for the part of DirectXMath the root helpers use, so they build where the
+// Windows SDK isn't around. Each function does per lane what the real one does, the
+// way DirectXMath itself does with _XM_NO_INTRINSICS_, so the filter math comes out the
+// same, give or take rounding. Comparisons give all-ones or all-zeros lanes, and select
+// picks on those bits, same as the real thing.
+
+namespace DirectX
+{
+	struct alignas(16) XMVECTOR {
+		float f[4];
+	};
+	typedef const XMVECTOR FXMVECTOR;
+
+	struct alignas(16) XMVECTORF32 {
+		float f[4];
+		operator XMVECTOR() const {
+			XMVECTOR v;
+			std::memcpy(v.f, f, sizeof(v.f));
+			return v;
+		}
+	};
+
+	struct alignas(16) XMFLOAT4A {
+		float x, y, z, w;
+	};
+
+	const float XM_PI  = 3.141592654f;
+	const float XM_2PI = 6.283185307f;
+
+	const XMVECTORF32 g_XMOne         = { {  1.0f,  1.0f,  1.0f,  1.0f } };
+	const XMVECTORF32 g_XMNegativeOne = { { -1.0f, -1.0f, -1.0f, -1.0f } };
+	const XMVECTORF32 g_XMOneHalf     = { {  0.5f,  0.5f,  0.5f,  0.5f } };
+
+	namespace StandIn
+	{
+		template <typename Op>
+		inline XMVECTOR perLane(FXMVECTOR a, Op op) {
+			XMVECTOR r;
+			for (int i = 0; i < 4; i++) r.f[i] = op(a.f[i]);
+			return r;
+		}
+
+		template <typename Op>
+		inline XMVECTOR perLane(FXMVECTOR a, FXMVECTOR b, Op op) {
+			XMVECTOR r;
+			for (int i = 0; i < 4; i++) r.f[i] = op(a.f[i], b.f[i]);
+			return r;
+		}
+
+		inline float mask(bool set) {
+			uint32_t bits = set ? 0xFFFFFFFFu : 0u;
+			float    lane;
+			std::memcpy(&lane, &bits, sizeof(lane));
+			return lane;
+		}
+
+		inline bool isSet(float lane) {
+			uint32_t bits;
+			std::memcpy(&bits, &lane, sizeof(bits));
+			return bits != 0;
+		}
+	}
+
+	inline XMVECTOR XMVectorZero()             { return { { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+	inline XMVECTOR XMVectorReplicate(float v) { return { { v, v, v, v } }; }
+
+	inline XMVECTOR XMLoadFloat4A(const XMFLOAT4A* source)        { return { { source->x, source->y, source->z, source->w } }; }
+	inline void     XMStoreFloat4A(XMFLOAT4A* destination, FXMVECTOR v) { *destination = { v.f[0], v.f[1], v.f[2], v.f[3] }; }
+
+	inline XMVECTOR XMVectorAdd(FXMVECTOR a, FXMVECTOR b)      { return StandIn::perLane(a, b, [](float x, float y) { return x + y; }); }
+	inline XMVECTOR XMVectorSubtract(FXMVECTOR a, FXMVECTOR b) { return StandIn::perLane(a, b, [](float x, float y) { return x - y; }); }
+	inline XMVECTOR XMVectorMultiply(FXMVECTOR a, FXMVECTOR b) { return StandIn::perLane(a, b, [](float x, float y) { return x * y; }); }
+	inline XMVECTOR XMVectorDivide(FXMVECTOR a, FXMVECTOR b)   { return StandIn::perLane(a, b, [](float x, float y) { return x / y; }); }
+	inline XMVECTOR XMVectorMin(FXMVECTOR a, FXMVECTOR b)      { return StandIn::perLane(a, b, [](float x, float y) { return x < y ? x : y; }); }
+	inline XMVECTOR XMVectorGreater(FXMVECTOR a, FXMVECTOR b)  { return StandIn::perLane(a, b, [](float x, float y) { return StandIn::mask(x > y); }); }
+	inline XMVECTOR XMVectorLess(FXMVECTOR a, FXMVECTOR b)     { return StandIn::perLane(a, b, [](float x, float y) { return StandIn::mask(x < y); }); }
+
+	inline XMVECTOR XMVectorMultiplyAdd(FXMVECTOR a, FXMVECTOR b, FXMVECTOR c) { return XMVectorAdd(XMVectorMultiply(a, b), c); }
+	inline XMVECTOR XMVectorLerpV(FXMVECTOR a, FXMVECTOR b, FXMVECTOR t)       { return XMVectorMultiplyAdd(XMVectorSubtract(b, a), t, a); }
+
+	inline XMVECTOR XMVectorSelect(FXMVECTOR a, FXMVECTOR b, FXMVECTOR control) {
+		XMVECTOR r;
+		for (int i = 0; i < 4; i++) r.f[i] = StandIn::isSet(control.f[i]) ? b.f[i] : a.f[i];
+		return r;
+	}
+
+	inline XMVECTOR XMVectorAbs(FXMVECTOR v)             { return StandIn::perLane(v, [](float x) { return std::fabs(x); }); }
+	inline XMVECTOR XMVectorSqrt(FXMVECTOR v)            { return StandIn::perLane(v, [](float x) { return std::sqrt(x); }); }
+	inline XMVECTOR XMVectorReciprocal(FXMVECTOR v)      { return StandIn::perLane(v, [](float x) { return 1.0f / x; }); }
+	inline XMVECTOR XMVectorReciprocalSqrt(FXMVECTOR v)  { return StandIn::perLane(v, [](float x) { return 1.0f / std::sqrt(x); }); }
+	inline XMVECTOR XMVectorSin(FXMVECTOR v)             { return StandIn::perLane(v, [](float x) { return std::sin(x); }); }
+	inline XMVECTOR XMVectorCos(FXMVECTOR v)             { return StandIn::perLane(v, [](float x) { return std::cos(x); }); }
+	inline XMVECTOR XMVectorACos(FXMVECTOR v)            { return StandIn::perLane(v, [](float x) { return std::acos(x); }); }
+}
@@ -0,0 +1,204 @@
+#include "xr_swapchain_images.h"
+#include "TestCheck.h"
+#include <stdint.h>
+#include <thread>
+
+using namespace std::chrono;
+
+///////////////////////////////////////////
+
+// Stands in for the runtime's side of a swapchain: every image the app acquires is
+// still held by the compositor for compositorLatency, and calls can be told to fail.
+// Calls made out of the order the spec allows fail like a runtime would, and are counted.
+//
+// The compositor runs on its own clock, which only moves while the app is waiting, so
+// how many slices a wait takes doesn't depend on how the test machine sleeps. Waits
+// still really sleep as long as they say, so the blocked time adds up.
+struct StandInSwapchain {
+	uint32_t                 imageCount;
+	uint32_t                 next;
+	bool                     acquired;
+	bool                     waited;
+	nanoseconds              readyAt;
+	XrResult                 acquireResult;
+	uint32_t                 failWaits; // The next this many waits fail
+	uint32_t                 callOrderErrors;
+	uint32_t                 releases;
+};
+
+static const uint32_t   standInCount = 2;
+static StandInSwapchain standIns[standInCount];
+static milliseconds     compositorLatency(0);
+static nanoseconds      compositorNow(0);
+
+static void compositorSleep(nanoseconds duration) {
+	std::this_thread::sleep_for(duration);
+	compositorNow += duration;
+}
+
+static StandInSwapchain& standIn(XrSwapchain handle) {
+	return standIns[(uintptr_t)handle - 1];
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL standInAcquire(XrSwapchain handle, const XrSwapchainImageAcquireInfo*, uint32_t* index) {
+	StandInSwapchain& swapchain = standIn(handle);
+	if (swapchain.acquireResult != XR_SUCCESS)
+		return swapchain.acquireResult;
+	if (swapchain.acquired) {
+		swapchain.callOrderErrors++;
+		return XR_ERROR_CALL_ORDER_INVALID;
+	}
+	swapchain.acquired = true;
+	swapchain.waited   = false;
+	swapchain.readyAt  = compositorNow + compositorLatency;
+	*index         = swapchain.next;
+	swapchain.next = (swapchain.next + 1) % swapchain.imageCount;
+	return XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL standInWait(XrSwapchain handle, const XrSwapchainImageWaitInfo* info) {
+	StandInSwapchain& swapchain = standIn(handle);
+	if (!swapchain.acquired || swapchain.waited) {
+		swapchain.callOrderErrors++;
+		return XR_ERROR_CALL_ORDER_INVALID;
+	}
+	if (swapchain.failWaits > 0) {
+		swapchain.failWaits--;
+		return XR_ERROR_RUNTIME_FAILURE;
+	}
+
+	nanoseconds remaining = swapchain.readyAt - compositorNow;
+	if (info->timeout != XR_INFINITE_DURATION && remaining > nanoseconds(info->timeout)) {
+		compositorSleep(nanoseconds(info->timeout));
+		return XR_TIMEOUT_EXPIRED;
+	}
+	if (remaining > nanoseconds(0))
+		compositorSleep(remaining);
+	swapchain.waited = true;
+	return XR_SUCCESS;
+}
+
+static XRAPI_ATTR XrResult XRAPI_CALL standInRelease(XrSwapchain handle, const XrSwapchainImageReleaseInfo*) {
+	StandInSwapchain& swapchain = standIn(handle);
+	if (!swapchain.acquired || !swapchain.waited) {
+		swapchain.callOrderErrors++;
+		return XR_ERROR_CALL_ORDER_INVALID;
+	}
+	swapchain.acquired = false;
+	swapchain.waited   = false;
+	swapchain.releases++;
+	return XR_SUCCESS;
+}
+
+static const swapchain_calls_t standInCalls = { standInAcquire, standInWait, standInRelease };
+
+static void resetStandIns(swapchain_image_t* images, milliseconds latency) {
+	compositorLatency = latency;
+	for (uint32_t i = 0; i < standInCount; i++) {
+		standIns[i]               = {};
+		standIns[i].imageCount    = 3;
+		standIns[i].acquireResult = XR_SUCCESS;
+		images[i]           = {};
+		images[i].swapchain = (XrSwapchain)(uintptr_t)(i + 1);
+	}
+}
+
+// One frame the way openxr_render_layer does it.
+static bool renderFrame(swapchain_image_t* images, swapchain_timing_t& timing) {
+	if (!swapchain_acquire_all(standInCalls, images, standInCount, timing))
+		return false;
+	for (uint32_t i = 0; i < standInCount; i++) {
+		if (!swapchain_wait(standInCalls, images[i], timing)) {
+			swapchain_release_all(standInCalls, images, standInCount, timing);
+			return false;
+		}
+		swapchain_release(standInCalls, images[i], timing);
+	}
+	return true;
+}
+
+static bool nothingHeld() {
+	bool held = false;
+	for (uint32_t i = 0; i < standInCount; i++)
+		held = held || standIns[i].acquired || standIns[i].callOrderErrors != 0;
+	return !held;
+}
+
+///////////////////////////////////////////
+
+static void testCompositorLatencyIsCountedAsBlocked() {
+	swapchain_image_t  images[standInCount];
+	swapchain_timing_t timing = {};
+	resetStandIns(images, milliseconds(7));
+
+	for (int32_t frame = 0; frame < 3; frame++)
+		CHECK(renderFrame(images, timing));
+	CHECK(nothingHeld());
+	CHECK(standIns[0].releases == 3 && standIns[1].releases == 3);
+
+	// The first image of each frame holds us up for 7ms, 3 slices of 2ms and then the
+	// rest. The second one is ready by the time we get to it.
+	CHECK(timing.blocked_ms >= 3 * 7.0);
+	CHECK(timing.wait_timeouts == 3 * 3);
+	CHECK(timing.acquire_ms < timing.blocked_ms);
+	CHECK(timing.failures == 0);
+}
+
+static void testAcquireFailureReleasesEarlierImages() {
+	swapchain_image_t  images[standInCount];
+	swapchain_timing_t timing = {};
+	resetStandIns(images, milliseconds(1));
+
+	standIns[1].acquireResult = XR_ERROR_RUNTIME_FAILURE;
+	CHECK(!renderFrame(images, timing));
+	CHECK(nothingHeld());
+	CHECK(standIns[0].releases == 1);
+	CHECK(timing.failures == 1);
+
+	// With everything handed back, the next frame goes through normally
+	standIns[1].acquireResult = XR_SUCCESS;
+	CHECK(renderFrame(images, timing));
+	CHECK(nothingHeld());
+	CHECK(timing.failures == 1);
+}
+
+static void testWaitFailureReleasesEveryImage() {
+	swapchain_image_t  images[standInCount];
+	swapchain_timing_t timing = {};
+	resetStandIns(images, milliseconds(1));
+
+	// The first view's wait fails, while both images are held
+	standIns[0].failWaits = 1;
+	CHECK(!renderFrame(images, timing));
+	CHECK(nothingHeld());
+	CHECK(standIns[0].releases == 1 && standIns[1].releases == 1);
+
+	CHECK(renderFrame(images, timing));
+	CHECK(nothingHeld());
+
+	// Now the second view's, after the first was drawn and released
+	standIns[1].failWaits = 1;
+	CHECK(!renderFrame(images, timing));
+	CHECK(nothingHeld());
+	CHECK(renderFrame(images, timing));
+	CHECK(nothingHeld());
+	CHECK(timing.failures == 2);
+}
+
+static void testLongWaitsFallBackToInfinite() {
+	swapchain_image_t  images[standInCount];
+	swapchain_timing_t timing = {};
+	resetStandIns(images, milliseconds((swapchain_wait_retries * swapchain_wait_timeout) / 1000000 + 20));
+
+	CHECK(renderFrame(images, timing));
+	CHECK(nothingHeld());
+	CHECK(timing.wait_timeouts == swapchain_wait_retries);
+}
+
+int main() {
+	testCompositorLatencyIsCountedAsBlocked();
+	testAcquireFailureReleasesEarlierImages();
+	testWaitFailureReleasesEveryImage();
+	testLongWaitsFallBackToInfinite();
+	return testResult("SwapchainImagesTests");
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+
+// Just enough of a test framework for the portable parts of the app. Each test file is
+// its own executable: CHECK counts failures instead of stopping, and main ends with
+// testResult(), which prints a summary and gives ctest the exit code.
+
+namespace TestCheck
+{
+	inline int& failures() {
+		static int count = 0;
+		return count;
+	}
+
+	inline void fail(const char* file, int line, const char* what) {
+		std::printf("%s:%d: check failed: %s\n", file, line, what);
+		std::fflush(stdout);
+		failures()++;
+	}
+}
+
+#define CHECK(condition) \
+	do { if (!(condition)) TestCheck::fail(__FILE__, __LINE__, #condition); } while (0)
+
+#define CHECK_NEAR(a, b, tolerance) \
+	do { if (!(std::fabs((double)(a) - (double)(b)) <= (double)(tolerance))) TestCheck::fail(__FILE__, __LINE__, #a " ~= " #b); } while (0)
+
+inline int testResult(const char* name) {
+	if (TestCheck::failures() == 0)
+		std::printf("%s: all checks passed\n", name);
+	else
+		std::printf("%s: %d checks failed\n", name, TestCheck::failures());
+	return TestCheck::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+#include "Driver/UndistortMap.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace TestApp;
+using namespace VuforiaDriver;
+
+///////////////////////////////////////////
+
+static const uint32_t imageWidth  = 640;
+static const uint32_t imageHeight = 480;
+static const uint8_t  fillValue   = 7;
+
+// A wide angle lens with every coefficient of the rational model in use
+static CameraIntrinsics lensIntrinsics() {
+	CameraIntrinsics intrinsics = {};
+	intrinsics.focalLengthX    = 466.0f;
+	intrinsics.focalLengthY    = 463.0f;
+	intrinsics.principalPointX = 318.4f;
+	intrinsics.principalPointY = 242.1f;
+	const float coefficients[8] = { -0.28f, 0.09f, 0.0012f, -0.0008f, -0.012f, 0.02f, 0.001f, 0.0005f };
+	std::memcpy(intrinsics.distortionCoefficients, coefficients, sizeof(coefficients));
+	return intrinsics;
+}
+
+// Smooth shading plus a little noise, so bilinear sampling has something to get wrong
+static std::vector<uint8_t> makeImage(uint32_t stride, uint32_t channels, std::mt19937& random) {
+	std::vector<uint8_t> image((size_t)stride * imageHeight);
+	for (uint32_t y = 0; y < imageHeight; y++) {
+		for (uint32_t x = 0; x < imageWidth * channels; x++)
+			image[(size_t)y * stride + x] = (uint8_t)(128 + 100 * std::sin(x * 0.04 + y * 0.06) + (int32_t)(random() % 9) - 4);
+	}
+	return image;
+}
+
+// Where undistorted pixel (u, v) comes from, worked out in double
+static void distortPoint(const CameraIntrinsics& intrinsics, uint32_t u, uint32_t v, double& sourceX, double& sourceY) {
+	float k[8];
+	std::memcpy(k, intrinsics.distortionCoefficients, sizeof(k));
+	double x  = (u - intrinsics.principalPointX) / intrinsics.focalLengthX;
+	double y  = (v - intrinsics.principalPointY) / intrinsics.focalLengthY;
+	double r2 = x * x + y * y, r4 = r2 * r2, r6 = r4 * r2;
+	double radial = (1 + k[0] * r2 + k[1] * r4 + k[4] * r6) / (1 + k[5] * r2 + k[6] * r4 + k[7] * r6);
+	double xd = x * radial + 2 * k[2] * x * y + k[3] * (r2 + 2 * x * x);
+	double yd = y * radial + k[2] * (r2 + 2 * y * y) + 2 * k[3] * x * y;
+	sourceX = intrinsics.focalLengthX * xd + intrinsics.principalPointX;
+	sourceY = intrinsics.focalLengthY * yd + intrinsics.principalPointY;
+}
+
+///////////////////////////////////////////
+
+// Every level and a threaded undistorter match the scalar kernels exactly, and the scalar
+// result stays within a couple of levels of double precision bilinear sampling
+static void testRemapMatchesReference(uint32_t channels) {
+	std::mt19937         random(7);
+	CameraIntrinsics     intrinsics = lensIntrinsics();
+	uint32_t             srcStride  = imageWidth * channels + 32;
+	uint32_t             dstStride  = imageWidth * channels + 16;
+	std::vector<uint8_t> image      = makeImage(srcStride, channels, random);
+
+	Undistorter scalar(0, PixelKernelLevel::Scalar);
+	std::shared_ptr<const UndistortMap> map = scalar.getMap(imageWidth, imageHeight, intrinsics);
+	CHECK(map != nullptr);
+	if (map == nullptr)
+		return;
+
+	std::vector<uint8_t> expected((size_t)dstStride * imageHeight, 0xEE);
+	scalar.remap(*map, image.data(), srcStride, expected.data(), dstStride, channels, fillValue);
+	for (uint32_t threads : { 0u, 3u }) {
+		Undistorter          undistorter(threads);
+		std::vector<uint8_t> actual((size_t)dstStride * imageHeight, 0xEE);
+		undistorter.remap(*map, image.data(), srcStride, actual.data(), dstStride, channels, fillValue);
+		CHECK(actual == expected);
+	}
+
+	double   maxError = 0;
+	uint32_t wrongFill = 0;
+	for (uint32_t v = 0; v < imageHeight; v++) {
+		for (uint32_t u = 0; u < imageWidth; u++) {
+			double sourceX, sourceY;
+			distortPoint(intrinsics, u, v, sourceX, sourceY);
+			bool outside = sourceX < -0.5 || sourceY < -0.5 || sourceX > imageWidth - 0.5 || sourceY > imageHeight - 0.5;
+			bool filled  = map->getRow(v)[u].x == undistortMapOutside;
+
+			// Within half a pixel of the edge, rounding may land either side
+			bool nearEdge = sourceX < 0.5 || sourceY < 0.5 || sourceX > imageWidth - 1.5 || sourceY > imageHeight - 1.5;
+			if (filled != outside && !nearEdge)
+				wrongFill++;
+			for (uint32_t channel = 0; channel < channels; channel++) {
+				uint8_t result = expected[(size_t)v * dstStride + u * channels + channel];
+				if (filled) {
+					wrongFill += result == fillValue ? 0 : 1;
+					continue;
+				}
+				double x = std::min(std::max(sourceX, 0.0), imageWidth - 1 - 1e-9);
+				double y = std::min(std::max(sourceY, 0.0), imageHeight - 1 - 1e-9);
+				uint32_t xi = (uint32_t)x, yi = (uint32_t)y;
+				double   fx = x - xi, fy = y - yi;
+				auto pixel = [&](uint32_t px, uint32_t py) { return (double)image[(size_t)py * srcStride + px * channels + channel]; };
+				double sample = (pixel(xi, yi) * (1 - fx) + pixel(xi + 1, yi) * fx) * (1 - fy) + (pixel(xi, yi + 1) * (1 - fx) + pixel(xi + 1, yi + 1) * fx) * fy;
+				maxError = std::max(maxError, std::fabs(sample - result));
+			}
+		}
+	}
+	CHECK(maxError <= 2.5);
+	CHECK(wrongFill == 0);
+}
+
+// Maps are built once per size and intrinsics, and the least recently used one goes first
+static void testMapCache() {
+	Undistorter          undistorter(0, getBestPixelKernelLevel(), 2);
+	std::vector<uint8_t> buffer(64 * 72, 100);
+	std::vector<uint8_t> output(64 * 48);
+	CameraFrame frame = {};
+	frame.buffer     = buffer.data();
+	frame.bufferSize = (uint32_t)buffer.size();
+	frame.width      = 64;
+	frame.height     = 48;
+	frame.stride     = 64;
+	frame.format     = PixelFormat::NV12;
+	frame.intrinsics = lensIntrinsics();
+	frame.intrinsics.focalLengthX = frame.intrinsics.focalLengthY = 50;
+	frame.intrinsics.principalPointX = 32;
+	frame.intrinsics.principalPointY = 24;
+
+	for (int32_t i = 0; i < 10; i++)
+		CHECK(undistorter.undistort(frame, output.data(), 64));
+	CameraIntrinsics first = frame.intrinsics;
+	frame.intrinsics.focalLengthX = 51;
+	CHECK(undistorter.undistort(frame, output.data(), 64));
+	UndistorterStats stats = undistorter.getStats();
+	CHECK(stats.frames == 11 && stats.mapBuilds == 2 && stats.mapHits == 9);
+
+	// A third set of intrinsics pushes the first one out
+	frame.intrinsics.focalLengthX = 52;
+	CHECK(undistorter.undistort(frame, output.data(), 64));
+	frame.intrinsics = first;
+	CHECK(undistorter.undistort(frame, output.data(), 64));
+	CHECK(undistorter.getStats().mapBuilds == 4);
+
+	// Formats with nothing to undistort, and missing focal lengths, are refused
+	frame.format = PixelFormat::YUYV;
+	CHECK(!undistorter.undistort(frame, output.data(), 64));
+	frame.format = PixelFormat::NV12;
+	frame.intrinsics.focalLengthX = 0;
+	CHECK(!undistorter.undistort(frame, output.data(), 64));
+	CHECK(UndistortMap::build(1, 48, first) == nullptr);
+}
+
+// With no distortion, the map lands on whole pixels and the image comes back unchanged.
+// The last row and column are the exception: positions there clamp just short of the edge,
+// to keep the 2x2 neighbourhood inside, so they blend in a little of their neighbour.
+static void testIdentity() {
+	CameraIntrinsics intrinsics = {};
+	intrinsics.focalLengthX    = 100;
+	intrinsics.focalLengthY    = 100;
+	intrinsics.principalPointX = 32;
+	intrinsics.principalPointY = 24;
+	std::shared_ptr<const UndistortMap> map = UndistortMap::build(64, 48, intrinsics);
+	CHECK(map != nullptr && map->matches(64, 48, intrinsics));
+	if (map == nullptr)
+		return;
+	CameraIntrinsics output = map->getOutputIntrinsics();
+	CHECK(output.focalLengthX == 100 && output.principalPointY == 24 && output.distortionCoefficients[0] == 0);
+
+	std::vector<uint8_t> image(64 * 48);
+	for (size_t i = 0; i < image.size(); i++)
+		image[i] = (uint8_t)(i * 7);
+	std::vector<uint8_t> result(64 * 48);
+	Undistorter undistorter(0);
+	undistorter.remap(*map, image.data(), 64, result.data(), 64, 1);
+	uint32_t changed = 0;
+	for (uint32_t y = 0; y < 47; y++)
+		changed += std::memcmp(result.data() + y * 64, image.data() + y * 64, 63) == 0 ? 0 : 1;
+	CHECK(changed == 0);
+}
+
+static void reportRemapTime() {
+	std::mt19937         random(3);
+	std::vector<uint8_t> image = makeImage(imageWidth, 1, random);
+	std::vector<uint8_t> result(image.size());
+	for (PixelKernelLevel level : { PixelKernelLevel::Scalar, getBestPixelKernelLevel() }) {
+		Undistorter undistorter(0, level);
+		std::shared_ptr<const UndistortMap> map = undistorter.getMap(imageWidth, imageHeight, lensIntrinsics());
+		auto    start = std::chrono::steady_clock::now();
+		int32_t count = 0;
+		for (; std::chrono::steady_clock::now() - start < std::chrono::milliseconds(100); count++)
+			undistorter.remap(*map, image.data(), imageWidth, result.data(), imageWidth, 1);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / count;
+		std::printf("Undistorter level %d, 640x480 gray: %.3f ms per frame\n", (int)undistorter.getLevel(), ms);
+	}
+}
+
+int main() {
+	testRemapMatchesReference(1);
+	testRemapMatchesReference(4);
+	testMapCache();
+	testIdentity();
+	reportRemapTime();
+	return testResult("UndistortMapTests");
+}
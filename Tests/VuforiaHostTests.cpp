@@ -0,0 +1,163 @@
+#include "VuforiaHost.h"
+#include "VuforiaStandIn.h"
+#include "TestCheck.h"
+#include <vector>
+
+using namespace TestApp;
+
+///////////////////////////////////////////
+
+static const VuforiaEngineConfig engineConfig = { "key", "", nullptr };
+
+static VuforiaStandInConfig standIn(uint32_t createDelay, uint32_t startDelay = 0, int32_t creationError = 0, bool failStart = false) {
+	VuforiaStandInConfig config = {};
+	config.createDelay   = createDelay;
+	config.startDelay    = startDelay;
+	config.stopDelay     = createDelay / 10;
+	config.destroyDelay  = createDelay / 10;
+	config.creationError = creationError;
+	config.failStart     = failStart;
+	return config;
+}
+
+// Every state the listener heard, and whether it always heard them on the host's thread
+struct StateLog {
+	std::mutex                    mutex;
+	std::vector<VuforiaHostState> states;
+	std::thread::id               hostThread;
+	std::thread::id               mainThread = std::this_thread::get_id();
+	bool                          sameThread = true;
+
+	std::function<void(VuforiaHostState)> listener() {
+		return [this](VuforiaHostState state) {
+			std::lock_guard<std::mutex> lock(mutex);
+			if (states.empty())
+				hostThread = std::this_thread::get_id();
+			sameThread &= hostThread == std::this_thread::get_id() && hostThread != mainThread;
+			states.push_back(state);
+		};
+	}
+};
+
+///////////////////////////////////////////
+
+// Creating the engine takes 200ms, and start() has to come back long before that, with the
+// frame loop free to keep going until the future is ready
+static void testStartDoesNotBlock() {
+	VuforiaStandInCalls calls = {};
+	StateLog            log;
+	{
+		VuforiaHost host(std::make_unique<VuforiaStandInEngine>(standIn(200, 50), &calls), engineConfig);
+		host.setStateListener(log.listener());
+
+		auto start = std::chrono::steady_clock::now();
+		std::shared_future<bool> started = host.start();
+		auto returned = std::chrono::steady_clock::now() - start;
+		uint32_t frames = 0;
+		while (started.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(11));
+			frames++;
+		}
+		CHECK(returned < std::chrono::milliseconds(20));
+		CHECK(frames >= 10);
+		CHECK(started.get());
+		CHECK(host.getState() == VuforiaHostState::Running);
+		std::printf("VuforiaHost::start returned in %lld us, %u frames went by while the engine started\n",
+			(long long)std::chrono::duration_cast<std::chrono::microseconds>(returned).count(), frames);
+
+		// Already running, so there's nothing to wait for
+		std::shared_future<bool> again = host.start();
+		CHECK(again.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready && again.get());
+
+		host.suspend().get();
+		CHECK(host.getState() == VuforiaHostState::Stopped);
+	}
+	CHECK(calls.creates == 1 && calls.starts == 1 && calls.stops == 1 && calls.destroys == 1);
+
+	std::lock_guard<std::mutex> lock(log.mutex);
+	std::vector<VuforiaHostState> expected = { VuforiaHostState::Starting, VuforiaHostState::Running, VuforiaHostState::Stopping, VuforiaHostState::Stopped };
+	CHECK(log.states == expected);
+	CHECK(log.sameThread);
+}
+
+// Requests that come in while the host is busy fold together
+static void testRequestsCoalesce() {
+	VuforiaStandInCalls calls = {};
+	{
+		VuforiaHost host(std::make_unique<VuforiaStandInEngine>(standIn(50), &calls), engineConfig);
+
+		// Two starts in a row are the same start
+		std::shared_future<bool> first  = host.start();
+		std::shared_future<bool> second = host.start();
+		CHECK(first.get() && second.get());
+		CHECK(calls.creates == 1);
+
+		// A suspend, then a start and a suspend queued behind it: the start never happens
+		std::shared_future<void> stopped   = host.suspend();
+		std::shared_future<bool> cancelled = host.start();
+		std::shared_future<void> resuspend = host.suspend();
+		CHECK(!cancelled.get());
+		stopped.get();
+		resuspend.get();
+		CHECK(host.getState() == VuforiaHostState::Stopped);
+		CHECK(calls.creates == 1 && calls.destroys == 1);
+
+		// Suspending a host that's stopped is done straight away, and leaves the engine alone
+		CHECK(host.suspend().wait_for(std::chrono::milliseconds(0)) == std::future_status::ready);
+		CHECK(calls.stops == 1 && calls.destroys == 1);
+
+		// Likewise starting a host that's running
+		CHECK(host.start().get());
+		CHECK(host.start().wait_for(std::chrono::milliseconds(0)) == std::future_status::ready);
+		host.suspend().get();
+	}
+	CHECK(calls.creates == 2 && calls.destroys == 2);
+}
+
+static void testFailures() {
+	// Creation errors are kept for the app to show
+	{
+		VuforiaHost host(std::make_unique<VuforiaStandInEngine>(standIn(10, 0, 0x201)), engineConfig);
+		CHECK(!host.start().get());
+		CHECK(host.getState() == VuforiaHostState::Failed);
+		CHECK(host.getCreationError() == 0x201);
+		host.suspend().get();
+	}
+
+	// An engine that won't start is destroyed, so another one can be created after it
+	VuforiaStandInCalls calls = {};
+	VuforiaHost failing(std::make_unique<VuforiaStandInEngine>(standIn(0, 0, 0, true), &calls), engineConfig);
+	CHECK(!failing.start().get());
+	CHECK(calls.destroys == 1);
+
+	VuforiaHost other(std::make_unique<VuforiaStandInEngine>(standIn(0)), engineConfig);
+	CHECK(other.start().get());
+
+	// Only one engine at a time, like the SDK
+	VuforiaHost third(std::make_unique<VuforiaStandInEngine>(standIn(0)), engineConfig);
+	CHECK(!third.start().get() && third.getCreationError() == 4);
+}
+
+// Destroying the host while it's starting waits for the engine, then tears it down, and
+// starts nobody has begun on come back false
+static void testDestroyWhileStarting() {
+	VuforiaStandInCalls      calls = {};
+	std::shared_future<bool> queued;
+	{
+		VuforiaHost host(std::make_unique<VuforiaStandInEngine>(standIn(50), &calls), engineConfig);
+		std::shared_future<bool> started = host.start();
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		host.suspend();
+		queued = host.start();
+	}
+	CHECK(calls.creates == 1 && calls.destroys == 1);
+	CHECK(queued.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready && !queued.get());
+}
+
+int main() {
+	testStartDoesNotBlock();
+	testRequestsCoalesce();
+	testFailures();
+	testDestroyWhileStarting();
+	return testResult("VuforiaHostTests");
+}
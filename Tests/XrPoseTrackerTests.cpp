@@ -0,0 +1,246 @@
+#include "Driver/ReplayDriver.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+using namespace TestApp;
+using namespace VuforiaDriver;
+
+///////////////////////////////////////////
+
+static XrPosef yawPose(float angle, float x) {
+	XrPosef pose;
+	pose.orientation = { 0, std::sin(angle / 2), 0, std::cos(angle / 2) };
+	pose.position    = { x, 1.5f, 0 };
+	return pose;
+}
+
+static XrPosef identityPose() {
+	XrPosef pose;
+	pose.orientation = { 0, 0, 0, 1 };
+	pose.position    = { 0, 0, 0 };
+	return pose;
+}
+
+// The rotation matrix of a pose, row-major, worked out the textbook way as a reference
+static void rotationMatrix(const XrPosef& pose, float m[9]) {
+	const XrQuaternionf& q = pose.orientation;
+	m[0] = 1 - 2 * (q.y * q.y + q.z * q.z); m[1] = 2 * (q.x * q.y - q.w * q.z);     m[2] = 2 * (q.x * q.z + q.w * q.y);
+	m[3] = 2 * (q.x * q.y + q.w * q.z);     m[4] = 1 - 2 * (q.x * q.x + q.z * q.z); m[5] = 2 * (q.y * q.z - q.w * q.x);
+	m[6] = 2 * (q.x * q.z - q.w * q.y);     m[7] = 2 * (q.y * q.z + q.w * q.x);     m[8] = 1 - 2 * (q.x * q.x + q.y * q.y);
+}
+
+struct PoseSink : PoseCallback {
+	std::mutex        mutex;
+	std::vector<Pose> poses;
+
+	void VUFORIA_DRIVER_CALLING_CONVENTION onNewPose(Pose* pose) override {
+		std::lock_guard<std::mutex> lock(mutex);
+		poses.push_back(*pose);
+	}
+
+	size_t count() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return poses.size();
+	}
+
+	// Poses go out on the pose thread, so give it a moment
+	bool waitFor(size_t expected) {
+		auto start = std::chrono::steady_clock::now();
+		while (count() < expected && std::chrono::steady_clock::now() - start < std::chrono::seconds(2))
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		return count() == expected;
+	}
+};
+
+struct FrameCounter : CameraCallback {
+	std::atomic<uint32_t> frames{ 0 };
+	void VUFORIA_DRIVER_CALLING_CONVENTION onNewCameraFrame(CameraFrame*) override { frames++; }
+};
+
+///////////////////////////////////////////
+
+static pose_history_t history;
+
+static void testAlignment() {
+	// Head poses every 10ms, from 1s on
+	for (int32_t i = 0; i < 10; i++)
+		pose_history_push(history, 1000000000ll + i * 10000000ll, yawPose(i * 0.1f, i * 0.01f));
+
+	XrPosef pose;
+	CHECK(alignHeadPose(history, 1015000000ll, false, &pose) == PoseAlignment::Interpolated);
+	CHECK(std::fabs(pose.position.x - 0.015f) < 1e-5f);
+	CHECK(alignHeadPose(history, 999000000ll, false, &pose) == PoseAlignment::Missing);
+	CHECK(alignHeadPose(history, 1095000000ll, false, &pose) == PoseAlignment::Waiting);
+	CHECK(alignHeadPose(history, 1095000000ll, true, &pose) == PoseAlignment::Held);
+	CHECK(std::fabs(pose.position.x - 0.09f) < 1e-6f);
+
+	// Holding only reaches so far past the newest pose
+	CHECK(alignHeadPose(history, 1290000000ll, true, &pose) == PoseAlignment::Missing);
+}
+
+// Composition and the camera pose against plain matrix products
+static void testPoseMath() {
+	XrPosef a = yawPose(0.7f, 1), b;
+	b.orientation = { std::sin(0.3f), 0, 0, std::cos(0.3f) };
+	b.position    = { 0.1f, -0.2f, 0.05f };
+	XrPosef composed = composePoses(a, b);
+
+	float ma[9], mb[9], mc[9];
+	rotationMatrix(a, ma);
+	rotationMatrix(b, mb);
+	rotationMatrix(composed, mc);
+	const float* pa = &a.position.x;
+	const float* pb = &b.position.x;
+	const float* pc = &composed.position.x;
+	float maxError = 0;
+	for (int32_t i = 0; i < 3; i++) {
+		float translation = pa[i];
+		for (int32_t j = 0; j < 3; j++) {
+			float product = 0;
+			for (int32_t k = 0; k < 3; k++)
+				product += ma[i * 3 + k] * mb[k * 3 + j];
+			maxError = std::max(maxError, std::fabs(product - mc[i * 3 + j]));
+			translation += ma[i * 3 + j] * pb[j];
+		}
+		maxError = std::max(maxError, std::fabs(translation - pc[i]));
+	}
+	CHECK(maxError < 1e-5f);
+
+	// At identity, the camera looks down world -z with y down, so y and z flip
+	XrPosef at = identityPose();
+	at.position = { 1, 2, 3 };
+	Pose    cameraPose = makeCameraPose(at, 42, PoseValidity::VALID);
+	const float flipped[9] = { 1, 0, 0, 0, -1, 0, 0, 0, -1 };
+	maxError = 0;
+	for (int32_t i = 0; i < 9; i++)
+		maxError = std::max(maxError, std::fabs(cameraPose.rotationData[i] - flipped[i]));
+	CHECK(maxError < 1e-6f);
+	CHECK(cameraPose.translationData[2] == 3 && cameraPose.timestamp == 42 && cameraPose.coordinateSystem == PoseCoordSystem::CAMERA);
+
+	// Turned 90 degrees left, the camera looks down world -x
+	Pose turned = makeCameraPose(yawPose(1.5707963f, 0), 0, PoseValidity::VALID);
+	CHECK(std::fabs(turned.rotationData[2] + 1) < 1e-5f && std::fabs(turned.rotationData[5]) < 1e-5f && std::fabs(turned.rotationData[8]) < 1e-5f);
+}
+
+// Frames ahead of the history wait for it, in order, until their deadline on the tracker's
+// own clock, and then go out held
+static std::atomic<uint64_t> fakeNow(0);
+
+static void testWaitingAndHolding() {
+	XrPoseTrackerConfig config = {};
+	config.headHistory    = &history;
+	config.headFromCamera = identityPose();
+	config.now            = []() { return fakeNow.load(); };
+	config.maxLatency     = 5000000;
+	config.toXrTime       = [](uint64_t time) { return (XrTime)(time + 1000000000ll); };
+
+	XrPoseTracker tracker(config);
+	PoseSink      sink;
+	CHECK(tracker.open() && tracker.start(&sink));
+
+	// Inside the history, so the pose goes out straight away
+	CameraFrame frame = {};
+	frame.timestamp = 25000000;
+	tracker.onCameraFrame(frame);
+	CHECK(sink.count() == 1);
+
+	// Past the newest head pose, so these two wait
+	frame.timestamp = 120000000;
+	tracker.onCameraFrame(frame);
+	frame.timestamp = 125000000;
+	tracker.onCameraFrame(frame);
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	CHECK(sink.count() == 1);
+
+	// The history catches up with the first one only
+	pose_history_push(history, 1100000000ll, yawPose(1.0f, 0.1f));
+	pose_history_push(history, 1122000000ll, yawPose(1.2f, 0.12f));
+	CHECK(sink.waitFor(2));
+
+	// The deadline passes for the other
+	fakeNow += 6000000;
+	CHECK(sink.waitFor(3));
+	tracker.stop();
+	tracker.close();
+
+	CHECK(sink.poses.size() == 3);
+	if (sink.poses.size() == 3) {
+		CHECK(sink.poses[1].validity == PoseValidity::VALID && sink.poses[1].timestamp == 120000000);
+		CHECK(sink.poses[2].validity == PoseValidity::UNRELIABLE && sink.poses[2].timestamp == 125000000);
+	}
+	XrPoseTrackerStats stats = tracker.getStats();
+	CHECK(stats.frames == 3 && stats.interpolated == 2 && stats.held == 1 && stats.missing == 0);
+	CHECK(stats.maxLatency >= 5000000);
+}
+
+// The driver hands the tracker every synthetic camera frame, while the head history is
+// written on another thread, ahead of the camera the way the frame loop's predictions are
+static pose_history_t liveHistory;
+
+static void testThroughTheDriver() {
+	std::atomic<bool> running(true);
+	std::thread writer([&]() {
+		while (running.load()) {
+			XrTime time = (XrTime)frameQueueNow() + 20000000;
+			pose_history_push(liveHistory, time, yawPose(time * 1e-9f, 0));
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		}
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+	ReplayDriverConfig config = {};
+	config.syntheticMode.width  = 64;
+	config.syntheticMode.height = 48;
+	config.syntheticMode.fps    = 60;
+	config.syntheticMode.format = PixelFormat::NV12;
+	config.pose.headHistory     = &liveHistory;
+	config.pose.headFromCamera  = identityPose();
+	ReplayDriver driver(config);
+	CHECK(driver.getCapabilities() == 1);
+
+	ExternalCamera*                  camera  = driver.createExternalCamera();
+	ExternalPositionalDeviceTracker* tracker = driver.createExternalPositionalDeviceTracker();
+	CHECK(driver.createExternalPositionalDeviceTracker() == nullptr);
+	PoseSink     poses;
+	FrameCounter frames;
+	CameraMode   mode;
+	CHECK(tracker->open() && tracker->start(&poses));
+	CHECK(camera->open() && camera->getSupportedCameraMode(0, &mode) && camera->start(mode, &frames));
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+	// The tracker can go away while the camera keeps running
+	driver.destroyExternalPositionalDeviceTracker(tracker);
+	size_t delivered = poses.count();
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	CHECK(poses.count() == delivered);
+	camera->stop();
+	camera->close();
+	driver.destroyExternalCamera(camera);
+	running = false;
+	writer.join();
+
+	uint32_t notValid = 0;
+	for (const Pose& pose : poses.poses)
+		notValid += pose.validity == PoseValidity::VALID ? 0 : 1;
+	CHECK(poses.poses.size() >= 10);
+	CHECK(notValid == 0);
+	std::printf("XrPoseTracker through the driver: %u frames, %zu poses\n", frames.frames.load(), poses.poses.size());
+
+	// Without a head history there's no tracker to offer
+	ReplayDriverConfig cameraOnly = {};
+	cameraOnly.syntheticMode = config.syntheticMode;
+	ReplayDriver imagesOnly(cameraOnly);
+	CHECK(imagesOnly.getCapabilities() == 0);
+	CHECK(imagesOnly.createExternalPositionalDeviceTracker() == nullptr);
+}
+
+int main() {
+	testAlignment();
+	testPoseMath();
+	testWaitingAndHolding();
+	testThroughTheDriver();
+	return testResult("XrPoseTrackerTests");
+}
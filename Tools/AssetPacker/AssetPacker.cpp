@@ -0,0 +1,201 @@
+﻿// Outil d'empaquetage des actifs dans une archive lue par DX::AssetArchive.
+//
+// Utilisation : AssetPacker [--store] <sortie.pak> <fichier>[=<nom>]...
+//
+// Chaque fichier est ajouté sous son nom sans répertoire, ou sous <nom> s'il est précisé. Une entrée
+// n'est compressée que si elle y gagne au moins un huitième ; --store désactive la compression pour
+// toutes les entrées, ce qui permet de copier chacune directement vers une ressource GPU.
+//
+// Ne dépend que de la bibliothèque standard et des en-têtes de Common, et se compile aussi hors de
+// Visual Studio, par exemple : g++ -std=c++17 -O2 -o AssetPacker AssetPacker.cpp
+
+#include "../../Common/AssetArchive.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+	struct PackedAsset
+	{
+		std::string				name;
+		std::vector<uint8_t>	data;
+		AssetArchiveEntry		entry;
+	};
+
+	bool ReadFile(const std::string& path, std::vector<uint8_t>& data)
+	{
+		FILE* file = fopen(path.c_str(), "rb");
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		data.clear();
+		uint8_t chunk[64 * 1024];
+		size_t read;
+		while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+		{
+			data.insert(data.end(), chunk, chunk + read);
+		}
+		bool ok = ferror(file) == 0;
+		fclose(file);
+		return ok;
+	}
+
+	AssetKind KindFromName(const std::string& name)
+	{
+		size_t dot = name.find_last_of('.');
+		std::string extension = dot == std::string::npos ? std::string() : name.substr(dot + 1);
+		for (char& c : extension)
+		{
+			if (c >= 'A' && c <= 'Z')
+			{
+				c = static_cast<char>(c - 'A' + 'a');
+			}
+		}
+
+		if (extension == "cso")
+		{
+			return AssetKind::Shader;
+		}
+		if (extension == "mesh" || extension == "obj" || extension == "cmo")
+		{
+			return AssetKind::Mesh;
+		}
+		if (extension == "dds" || extension == "png" || extension == "ktx")
+		{
+			return AssetKind::Texture;
+		}
+		return AssetKind::Raw;
+	}
+
+	uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int argument = 1;
+	bool store = false;
+	if (argument < argc && std::string(argv[argument]) == "--store")
+	{
+		store = true;
+		argument++;
+	}
+	if (argc - argument < 2)
+	{
+		fprintf(stderr, "Utilisation : AssetPacker [--store] <sortie.pak> <fichier>[=<nom>]...\n");
+		return 1;
+	}
+
+	const char* outputPath = argv[argument++];
+	std::vector<PackedAsset> assets;
+	for (; argument < argc; argument++)
+	{
+		std::string input = argv[argument];
+		std::string path = input;
+		std::string name;
+		size_t equals = input.find('=');
+		if (equals != std::string::npos)
+		{
+			path = input.substr(0, equals);
+			name = input.substr(equals + 1);
+		}
+		else
+		{
+			size_t slash = input.find_last_of("/\\");
+			name = slash == std::string::npos ? input : input.substr(slash + 1);
+		}
+
+		PackedAsset asset;
+		asset.name = name;
+		if (!ReadFile(path, asset.data))
+		{
+			fprintf(stderr, "Impossible de lire %s\n", path.c_str());
+			return 1;
+		}
+
+		asset.entry = {};
+		asset.entry.nameHash = AssetArchiveHash(name.data(), name.size());
+		asset.entry.size = asset.data.size();
+		asset.entry.kind = KindFromName(name);
+
+		if (!store)
+		{
+			std::vector<uint8_t> compressed = LzCompress(asset.data.data(), asset.data.size());
+			if (compressed.size() + asset.data.size() / 8 <= asset.data.size())
+			{
+				asset.data.swap(compressed);
+				asset.entry.flags |= AssetArchiveFlagCompressed;
+			}
+		}
+		asset.entry.storedSize = asset.data.size();
+		assets.push_back(std::move(asset));
+	}
+
+	// La table est triée par hachage pour une recherche dichotomique ; deux noms de même hachage ne
+	// pourraient pas être distingués.
+	std::sort(assets.begin(), assets.end(), [](const PackedAsset& a, const PackedAsset& b) { return a.entry.nameHash < b.entry.nameHash; });
+	for (size_t i = 1; i < assets.size(); i++)
+	{
+		if (assets[i].entry.nameHash == assets[i - 1].entry.nameHash)
+		{
+			fprintf(stderr, "%s et %s ont le même hachage (ou le même nom)\n", assets[i - 1].name.c_str(), assets[i].name.c_str());
+			return 1;
+		}
+	}
+
+	uint64_t offset = AlignUp(c_assetArchiveTocOffset + assets.size() * sizeof(AssetArchiveEntry), c_assetArchiveAlignment);
+	for (PackedAsset& asset : assets)
+	{
+		asset.entry.offset = offset;
+		offset = AlignUp(offset + asset.entry.storedSize, c_assetArchiveAlignment);
+	}
+
+	AssetArchiveHeader header = {};
+	header.magic = c_assetArchiveMagic;
+	header.version = c_assetArchiveVersion;
+	header.entryCount = static_cast<uint32_t>(assets.size());
+	header.alignment = c_assetArchiveAlignment;
+	header.tocOffset = c_assetArchiveTocOffset;
+	header.fileSize = offset;
+
+	std::vector<uint8_t> archive(static_cast<size_t>(offset), 0);
+	memcpy(archive.data(), &header, sizeof(header));
+	for (size_t i = 0; i < assets.size(); i++)
+	{
+		const PackedAsset& asset = assets[i];
+		memcpy(archive.data() + c_assetArchiveTocOffset + i * sizeof(AssetArchiveEntry), &asset.entry, sizeof(AssetArchiveEntry));
+		if (!asset.data.empty())
+		{
+			memcpy(archive.data() + asset.entry.offset, asset.data.data(), asset.data.size());
+		}
+	}
+
+	FILE* output = fopen(outputPath, "wb");
+	if (output == nullptr || fwrite(archive.data(), 1, archive.size(), output) != archive.size())
+	{
+		fprintf(stderr, "Impossible d'écrire %s\n", outputPath);
+		if (output != nullptr)
+		{
+			fclose(output);
+		}
+		return 1;
+	}
+	fclose(output);
+
+	for (const PackedAsset& asset : assets)
+	{
+		printf("%-32s %10llu -> %10llu%s\n", asset.name.c_str(),
+			static_cast<unsigned long long>(asset.entry.size),
+			static_cast<unsigned long long>(asset.entry.storedSize),
+			(asset.entry.flags & AssetArchiveFlagCompressed) ? " (compressé)" : "");
+	}
+	printf("%s : %zu entrées, %llu octets\n", outputPath, assets.size(), static_cast<unsigned long long>(offset));
+	return 0;
+}
@@ -20,3 +20,102 @@ void VuforiaTest::setupVuforia() {
 	// Destroy the engine 
 	vuEngineDestroy(engine);
 }
+
+///////////////////////////////////////////
+
+VuforiaSdkEngine::~VuforiaSdkEngine() {
+	destroy();
+}
+
+bool VuforiaSdkEngine::create(const VuforiaEngineConfig& config, int32_t& errorCode) {
+	VuEngineConfigSet* configSet = nullptr;
+	if (vuEngineConfigSetCreate(&configSet) != VU_SUCCESS) {
+		errorCode = VU_ENGINE_CREATION_ERROR_INITIALIZATION;
+		return false;
+	}
+
+	VuLicenseConfig license = vuLicenseConfigDefault();
+	license.key = config.licenseKey.c_str();
+	vuEngineConfigSetAddLicenseConfig(configSet, &license);
+
+	if (!config.driverName.empty()) {
+		VuDriverConfig driver = vuDriverConfigDefault();
+		driver.driverName = config.driverName.c_str();
+		driver.userData   = config.driverUserData;
+		vuEngineConfigSetAddDriverConfig(configSet, &driver);
+	}
+
+	VuErrorCode error = VU_ENGINE_CREATION_ERROR_NONE;
+	VuResult result = vuEngineCreate(&m_engine, configSet, &error);
+	vuEngineConfigSetDestroy(configSet);
+	if (result != VU_SUCCESS) {
+		m_engine  = nullptr;
+		errorCode = (int32_t)error;
+		return false;
+	}
+	return true;
+}
+
+bool VuforiaSdkEngine::start() {
+	return m_engine != nullptr && vuEngineStart(m_engine) == VU_SUCCESS;
+}
+
+void VuforiaSdkEngine::stop() {
+	if (m_engine != nullptr)
+		vuEngineStop(m_engine);
+}
+
+void VuforiaSdkEngine::destroy() {
+	if (m_engine == nullptr)
+		return;
+	vuEngineDestroy(m_engine);
+	m_engine = nullptr;
+}
+
+std::unique_ptr<ObservationSource> VuforiaSdkEngine::createObservationSource() {
+	return std::make_unique<VuforiaObservationSource>(m_engine);
+}
+
+///////////////////////////////////////////
+
+VuforiaObservationSource::VuforiaObservationSource(const VuEngine* engine) :
+	m_engine(engine),
+	m_list(nullptr) {
+	if (vuObservationListCreate(&m_list) != VU_SUCCESS)
+		m_list = nullptr;
+}
+
+VuforiaObservationSource::~VuforiaObservationSource() {
+	if (m_list != nullptr)
+		vuObservationListDestroy(m_list);
+}
+
+bool VuforiaObservationSource::read(ObservationTable& table) {
+	table.clear();
+	if (m_engine == nullptr || m_list == nullptr)
+		return false;
+
+	VuState* state = nullptr;
+	if (vuEngineAcquireLatestState(m_engine, &state) != VU_SUCCESS)
+		return false;
+
+	// The list only points into the state, so it's all read before the state goes back
+	int32_t size = 0;
+	if (vuStateGetObservations(state, m_list) == VU_SUCCESS && vuObservationListGetSize(m_list, &size) == VU_SUCCESS) {
+		table.reserve((uint32_t)size);
+		for (int32_t i = 0; i < size; i++) {
+			VuObservation* observation = nullptr;
+			if (vuObservationListGetElement(m_list, i, &observation) != VU_SUCCESS)
+				continue;
+
+			VuObservationType type = 0;
+			vuObservationGetType(observation, &type);
+
+			VuPoseInfo poseInfo;
+			bool hasPose = vuObservationHasPoseInfo(observation) == VU_TRUE && vuObservationGetPoseInfo(observation, &poseInfo) == VU_SUCCESS;
+			table.add(vuObservationGetObserverId(observation), type, hasPose ? &poseInfo : nullptr);
+		}
+	}
+	vuStateRelease(state);
+	return true;
+}
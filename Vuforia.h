@@ -1,6 +1,8 @@
 #pragma once
 
 //#include <vuforia-sdk-uwp-10-2-5/build/include/VuforiaEngine/VuforiaEngine.h>
+#include "ObservationTable.h"
+#include "VuforiaHost.h"
 
 
 namespace TestApp
@@ -13,4 +15,39 @@ namespace TestApp
 
 	};
 
+	// The real engine, for a VuforiaHost.
+	class VuforiaSdkEngine final : public VuforiaEngineApi {
+
+	public:
+		VuforiaSdkEngine() : m_engine(nullptr) {}
+		~VuforiaSdkEngine();
+
+		bool create(const VuforiaEngineConfig& config, int32_t& errorCode) override;
+		bool start() override;
+		void stop() override;
+		void destroy() override;
+
+		std::unique_ptr<ObservationSource> createObservationSource() override;
+
+	private:
+		VuEngine* m_engine;
+	};
+
+	// Reads the observations of the engine's latest state, through one observation list kept
+	// for as long as the source is, instead of one created and destroyed every frame. Made by
+	// VuforiaSdkEngine for its VuforiaHost, which only reads through it while the engine runs
+	// and drops it before stopping the engine.
+	class VuforiaObservationSource final : public ObservationSource {
+
+	public:
+		explicit VuforiaObservationSource(const VuEngine* engine);
+		~VuforiaObservationSource();
+
+		bool read(ObservationTable& table) override;
+
+	private:
+		const VuEngine*    m_engine;
+		VuObservationList* m_list;
+	};
+
 }
@@ -0,0 +1,218 @@
+#include "VuforiaHost.h"
+
+using namespace TestApp;
+
+///////////////////////////////////////////
+
+VuforiaHost::VuforiaHost(std::unique_ptr<VuforiaEngineApi> engine, const VuforiaEngineConfig& config) :
+	m_engine(std::move(engine)),
+	m_config(config),
+	m_created(false),
+	m_busy(false),
+	m_exiting(false),
+	m_state(VuforiaHostState::Stopped),
+	m_creationError(0) {
+	m_thread = std::thread(&VuforiaHost::hostLoop, this);
+}
+
+VuforiaHost::~VuforiaHost() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// Starts nobody has begun on won't be now, suspends still get done on the way out
+		for (auto it = m_requests.begin(); it != m_requests.end(); ) {
+			if ((*it)->start) {
+				(*it)->started.set_value(false);
+				it = m_requests.erase(it);
+			} else {
+				++it;
+			}
+		}
+		m_exiting = true;
+	}
+	m_wakeup.notify_all();
+	m_thread.join();
+}
+
+///////////////////////////////////////////
+
+std::unique_ptr<VuforiaHost::Request> VuforiaHost::makeRequest(bool start) {
+	auto request = std::make_unique<Request>();
+	request->start         = start;
+	request->startedFuture = request->started.get_future().share();
+	request->stoppedFuture = request->stopped.get_future().share();
+	return request;
+}
+
+std::shared_future<bool> VuforiaHost::start() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// Another start already on its way covers this one
+	if (!m_requests.empty() && m_requests.back()->start)
+		return m_requests.back()->startedFuture;
+	if (m_requests.empty() && !m_busy && m_state == VuforiaHostState::Running) {
+		std::promise<bool> running;
+		running.set_value(true);
+		return running.get_future().share();
+	}
+
+	m_requests.push_back(makeRequest(true));
+	std::shared_future<bool> started = m_requests.back()->startedFuture;
+	m_wakeup.notify_one();
+	return started;
+}
+
+std::shared_future<void> VuforiaHost::suspend() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (!m_requests.empty() && !m_requests.back()->start)
+		return m_requests.back()->stoppedFuture;
+
+	// A start that hasn't begun yet never needs to happen. Before it, there's either a
+	// suspend that does what this one would, or nothing.
+	if (!m_requests.empty()) {
+		m_requests.back()->started.set_value(false);
+		m_requests.pop_back();
+		if (!m_requests.empty())
+			return m_requests.back()->stoppedFuture;
+	}
+	if (!m_busy && (m_state == VuforiaHostState::Stopped || m_state == VuforiaHostState::Failed)) {
+		std::promise<void> stopped;
+		stopped.set_value();
+		return stopped.get_future().share();
+	}
+
+	m_requests.push_back(makeRequest(false));
+	std::shared_future<void> stopped = m_requests.back()->stoppedFuture;
+	m_wakeup.notify_one();
+	return stopped;
+}
+
+///////////////////////////////////////////
+
+VuforiaHostState VuforiaHost::getState() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_state;
+}
+
+int32_t VuforiaHost::getCreationError() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_creationError;
+}
+
+void VuforiaHost::setStateListener(std::function<void(VuforiaHostState)> listener) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_listener = std::move(listener);
+}
+
+bool VuforiaHost::readObservations(ObservationTable& table) {
+	std::lock_guard<std::mutex> lock(m_sourceMutex);
+	if (m_source == nullptr) {
+		table.clear();
+		return false;
+	}
+	return m_source->read(table);
+}
+
+void VuforiaHost::setState(VuforiaHostState state) {
+	std::function<void(VuforiaHostState)> listener;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_state  = state;
+		listener = m_listener;
+
+		// The last state of a request with nothing queued behind it: from here on, start() and
+		// suspend() can go by the state alone
+		if (state != VuforiaHostState::Starting && state != VuforiaHostState::Stopping && m_requests.empty())
+			m_busy = false;
+	}
+	if (listener)
+		listener(state);
+}
+
+///////////////////////////////////////////
+
+void VuforiaHost::hostLoop() {
+	for (;;) {
+		std::unique_ptr<Request> request;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_busy = false;
+			m_wakeup.wait(lock, [this]() { return m_exiting || !m_requests.empty(); });
+			if (m_requests.empty())
+				break;
+			request = std::move(m_requests.front());
+			m_requests.pop_front();
+			m_busy = true;
+		}
+
+		if (request->start) {
+			if (m_created)
+				markIdleIfDone();
+			request->started.set_value(m_created || runStart());
+		} else {
+			if (m_created)
+				runStop();
+			else
+				markIdleIfDone();
+			request->stopped.set_value();
+		}
+	}
+
+	if (m_created)
+		runStop();
+}
+
+// For requests that leave the state as it is, so they're done before their future is ready.
+void VuforiaHost::markIdleIfDone() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_requests.empty())
+		m_busy = false;
+}
+
+bool VuforiaHost::runStart() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_creationError = 0;
+	}
+	setState(VuforiaHostState::Starting);
+
+	int32_t errorCode = 0;
+	if (!m_engine->create(m_config, errorCode)) {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_creationError = errorCode;
+		}
+		setState(VuforiaHostState::Failed);
+		return false;
+	}
+
+	// A created engine that won't start is no use, and would keep the next create from working
+	if (!m_engine->start()) {
+		m_engine->destroy();
+		setState(VuforiaHostState::Failed);
+		return false;
+	}
+
+	std::unique_ptr<ObservationSource> source = m_engine->createObservationSource();
+	{
+		std::lock_guard<std::mutex> lock(m_sourceMutex);
+		m_source = std::move(source);
+	}
+	m_created = true;
+	setState(VuforiaHostState::Running);
+	return true;
+}
+
+void VuforiaHost::runStop() {
+	setState(VuforiaHostState::Stopping);
+
+	// Waits for a read that's under way, and no new one gets to the engine after this
+	{
+		std::lock_guard<std::mutex> lock(m_sourceMutex);
+		m_source.reset();
+	}
+	m_engine->stop();
+	m_engine->destroy();
+	m_created = false;
+	setState(VuforiaHostState::Stopped);
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "ObservationTable.h"
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace TestApp
+{
+	// What the engine gets created with.
+	struct VuforiaEngineConfig {
+		std::string licenseKey;
+		std::string driverName;     // Empty for the device's own camera
+		void*       driverUserData; // Handed to the driver's vuforiaDriver_init, e.g. a ReplayDriverConfig
+	};
+
+	// The engine calls the host makes, so a stand-in can take the SDK's place. Every call
+	// comes from the host's thread, one at a time.
+	class VuforiaEngineApi {
+	public:
+		virtual ~VuforiaEngineApi() {}
+
+		// On failure, errorCode gets a VuEngineCreationError, or one of the config errors.
+		virtual bool create(const VuforiaEngineConfig& config, int32_t& errorCode) = 0;
+		virtual bool start() = 0;
+		virtual void stop() = 0;
+		virtual void destroy() = 0;
+
+		// What the host reads observations through while the engine runs. Made right after
+		// start() succeeds, and dropped before stop(), so it never outlives the engine.
+		virtual std::unique_ptr<ObservationSource> createObservationSource() = 0;
+	};
+
+	enum class VuforiaHostState {
+		Stopped,  // No engine
+		Starting, // Creating and starting it, which loads the license, driver and databases
+		Running,
+		Stopping, // Stopping and destroying it
+		Failed,   // The last start didn't make it, see getCreationError
+	};
+
+	///////////////////////////////////////////
+
+	// Owns the engine, and runs its whole lifecycle on a thread of its own, so creating it,
+	// which can take seconds, never holds up the XR frame loop, and neither does tearing it
+	// down on suspend.
+	//
+	// start() and suspend() queue a request and return right away, with a future that's
+	// ready once the request is done. Requests run in the order they came in. A suspend that
+	// comes in before a queued start gets going cancels it, and both are done at once.
+	// Listeners hear about every state change, on the host's thread.
+	//
+	// The engine is only ever reached through the host: the frame loop reads observations
+	// with readObservations(), which a suspend waits out before it stops the engine.
+	class VuforiaHost final {
+
+	public:
+		VuforiaHost(std::unique_ptr<VuforiaEngineApi> engine, const VuforiaEngineConfig& config);
+
+		// Tears the engine down if it's up, and waits for that.
+		~VuforiaHost();
+
+		VuforiaHost(const VuforiaHost&) = delete;
+		VuforiaHost& operator=(const VuforiaHost&) = delete;
+
+		// True once the engine is running, false if it failed, or was suspended before it got going.
+		std::shared_future<bool> start();
+
+		// Ready once the engine is gone. On a host that's stopped or failed, and has nothing
+		// queued, it's ready straight away, even right after another suspend's future got ready.
+		std::shared_future<void> suspend();
+
+		VuforiaHostState getState();
+		int32_t          getCreationError();
+
+		// Called with each new state, on the host's thread. Set it before the first start().
+		void setStateListener(std::function<void(VuforiaHostState)> listener);
+
+		// Refills table from the engine's newest state. False, with the table left empty,
+		// unless the engine is running. Any thread can call it.
+		bool readObservations(ObservationTable& table);
+
+	private:
+		struct Request {
+			bool                     start;
+			std::promise<bool>       started;
+			std::promise<void>       stopped;
+			std::shared_future<bool> startedFuture;
+			std::shared_future<void> stoppedFuture;
+		};
+
+		static std::unique_ptr<Request> makeRequest(bool start);
+
+		void hostLoop();
+		void setState(VuforiaHostState state);
+		void markIdleIfDone();
+		bool runStart();
+		void runStop();
+
+		std::unique_ptr<VuforiaEngineApi>     m_engine;
+		VuforiaEngineConfig                   m_config;
+		bool                                  m_created; // Only touched on the host's thread
+
+		std::thread                           m_thread;
+		std::mutex                            m_mutex;
+		std::condition_variable               m_wakeup;
+		std::deque<std::unique_ptr<Request>>  m_requests;
+		bool                                  m_busy;    // A request is under way, until its last state is set with none queued
+		bool                                  m_exiting;
+		VuforiaHostState                      m_state;
+		int32_t                               m_creationError;
+		std::function<void(VuforiaHostState)> m_listener;
+
+		// Set only while the engine runs. Its own mutex, so a read never waits on a request.
+		std::mutex                            m_sourceMutex;
+		std::unique_ptr<ObservationSource>    m_source;
+	};
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "ObservationTable.h"
+#include "VuforiaHost.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <thread>
+
+namespace TestApp
+{
+	// How a VuforiaStandInEngine behaves. Every delay is in milliseconds.
+	struct VuforiaStandInConfig {
+		uint32_t createDelay;
+		uint32_t startDelay;
+		uint32_t stopDelay;
+		uint32_t destroyDelay;
+		int32_t  creationError; // Non-zero makes create() fail with it
+		bool     failStart;
+		uint32_t observationCount; // Made up by each read of the engine's observation source
+	};
+
+	struct VuforiaStandInCalls {
+		std::atomic<uint32_t> creates;
+		std::atomic<uint32_t> starts;
+		std::atomic<uint32_t> stops;
+		std::atomic<uint32_t> destroys;
+		std::atomic<uint32_t> reads;
+		std::atomic<uint32_t> readsWhileStopped; // Reads that got to the engine when it wasn't running
+	};
+
+	///////////////////////////////////////////
+
+	// Makes up observationCount observations per state, for running and timing what reads the
+	// ObservationTables without the engine. Observer ids go from 1 up, one observation each.
+	// Every fourth target is lost, the others move along a circle, a step per read().
+	class SyntheticObservationSource final : public ObservationSource {
+
+	public:
+		explicit SyntheticObservationSource(uint32_t observationCount, VuObservationType type = 0x1) :
+			m_observationCount(observationCount), m_type(type), m_reads(0) {}
+
+		void setObservationCount(uint32_t observationCount) { m_observationCount = observationCount; }
+
+		bool read(ObservationTable& table) override {
+			table.clear();
+			table.reserve(m_observationCount);
+
+			float angle = 0.01f * (float)m_reads++;
+			for (uint32_t i = 0; i < m_observationCount; i++) {
+				int32_t observerId = (int32_t)i + 1;
+				if (i % 4 == 3) {
+					table.add(observerId, m_type, nullptr);
+					continue;
+				}
+
+				VuPoseInfo poseInfo = {};
+				poseInfo.poseStatus = i % 4 == 2 ? VU_OBSERVATION_POSE_STATUS_EXTENDED_TRACKED : VU_OBSERVATION_POSE_STATUS_TRACKED;
+				poseInfo.pose.data[0]  = 1.0f;
+				poseInfo.pose.data[5]  = 1.0f;
+				poseInfo.pose.data[10] = 1.0f;
+				poseInfo.pose.data[15] = 1.0f;
+				poseInfo.pose.data[12] = std::cos(angle + (float)i);
+				poseInfo.pose.data[13] = std::sin(angle + (float)i);
+				poseInfo.pose.data[14] = -1.0f - 0.01f * (float)i;
+				table.add(observerId, m_type, &poseInfo);
+			}
+			return true;
+		}
+
+	private:
+		uint32_t          m_observationCount;
+		VuObservationType m_type;
+		uint64_t          m_reads;
+	};
+
+	///////////////////////////////////////////
+
+	// Takes the engine's place where there's no SDK: it takes about as long as the real one
+	// would, fails when told to, and counts the calls. Like the real one, only one instance
+	// can be alive in the process at a time. Its observation source makes observations up,
+	// and counts the reads that came when the engine wasn't running.
+	class VuforiaStandInEngine final : public VuforiaEngineApi {
+
+	public:
+		VuforiaStandInEngine(const VuforiaStandInConfig& config, VuforiaStandInCalls* calls = nullptr) :
+			m_config(config), m_calls(calls), m_alive(false), m_running(false) {}
+
+		~VuforiaStandInEngine() {
+			destroy();
+		}
+
+		bool create(const VuforiaEngineConfig&, int32_t& errorCode) override {
+			count(m_calls ? &m_calls->creates : nullptr);
+			wait(m_config.createDelay);
+			if (m_config.creationError != 0) {
+				errorCode = m_config.creationError;
+				return false;
+			}
+
+			// VU_ENGINE_CREATION_ERROR_INITIALIZATION, what the SDK gives when an instance already exists
+			if (instanceAlive().exchange(true)) {
+				errorCode = 0x4;
+				return false;
+			}
+			m_alive = true;
+			return true;
+		}
+
+		bool start() override {
+			count(m_calls ? &m_calls->starts : nullptr);
+			wait(m_config.startDelay);
+			m_running = m_alive && !m_config.failStart;
+			return m_running;
+		}
+
+		void stop() override {
+			count(m_calls ? &m_calls->stops : nullptr);
+			wait(m_config.stopDelay);
+			m_running = false;
+		}
+
+		void destroy() override {
+			if (!m_alive)
+				return;
+			count(m_calls ? &m_calls->destroys : nullptr);
+			wait(m_config.destroyDelay);
+			m_running = false;
+			m_alive   = false;
+			instanceAlive() = false;
+		}
+
+		std::unique_ptr<ObservationSource> createObservationSource() override {
+			return std::make_unique<Source>(*this);
+		}
+
+		bool isRunning() const { return m_running; }
+
+	private:
+		class Source final : public ObservationSource {
+		public:
+			explicit Source(const VuforiaStandInEngine& engine) :
+				m_engine(engine), m_observations(engine.m_config.observationCount) {}
+
+			bool read(ObservationTable& table) override {
+				count(m_engine.m_calls ? &m_engine.m_calls->reads : nullptr);
+				if (!m_engine.isRunning())
+					count(m_engine.m_calls ? &m_engine.m_calls->readsWhileStopped : nullptr);
+				return m_observations.read(table);
+			}
+
+		private:
+			const VuforiaStandInEngine& m_engine;
+			SyntheticObservationSource  m_observations;
+		};
+
+		static std::atomic<bool>& instanceAlive() {
+			static std::atomic<bool> alive(false);
+			return alive;
+		}
+
+		static void count(std::atomic<uint32_t>* counter) {
+			if (counter)
+				counter->fetch_add(1);
+		}
+
+		static void wait(uint32_t milliseconds) {
+			if (milliseconds > 0)
+				std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+		}
+
+		VuforiaStandInConfig  m_config;
+		VuforiaStandInCalls*  m_calls;
+		std::atomic<bool>     m_alive;
+		std::atomic<bool>     m_running;
+	};
+
+}
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <openxr/openxr.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+///////////////////////////////////////////
+
+// Records what the OpenXR input path handed to the app each frame, so it can be fed
+// back in later instead of the runtime. Poses are stored as raw floats and never
+// quantized, so a replay gives the app exactly the same bits it saw live.
+//
+// The file is the magic "XRIL", a u32 version, and then a stream of records that each
+// start with a one byte tag:
+//   session   - varint session state, whenever the session changes state
+//   actions   - an input snapshot, taken after openxr_poll_actions
+//   predicted - an input snapshot, taken after openxr_poll_predicted
+// A snapshot is a flags byte (render and select bits for each hand, and which hand
+// poses changed), a zigzag varint delta for the predicted time, and then for each hand
+// pose that changed, a zigzag varint delta for its timestamp and its 7 floats. Most
+// frames that don't change anything come out to 3 bytes.
+
+const uint32_t input_log_magic   = 0x4C495258; // "XRIL"
+const uint32_t input_log_version = 1;
+
+enum input_log_mode_t {
+	input_log_off,
+	input_log_record,
+	input_log_replay,
+};
+
+enum input_log_tag_ {
+	input_log_tag_session   = 1,
+	input_log_tag_actions   = 2,
+	input_log_tag_predicted = 3,
+};
+
+enum input_log_flag_ {
+	input_log_flag_render0 = 1 << 0,
+	input_log_flag_render1 = 1 << 1,
+	input_log_flag_select0 = 1 << 2,
+	input_log_flag_select1 = 1 << 3,
+	input_log_flag_pose0   = 1 << 4,
+	input_log_flag_pose1   = 1 << 5,
+};
+
+struct input_log_snapshot_t {
+	XrTime   predicted_time;
+	XrTime   hand_pose_time[2];
+	XrPosef  hand_pose[2];
+	XrBool32 render_hand[2];
+	XrBool32 hand_select[2];
+};
+
+struct input_log_t {
+	input_log_mode_t     mode;
+	FILE*                file;
+	bool                 finished;      // Replay ran out of records, or found one it didn't expect
+	XrSessionState       session_state; // Last session state seen in the log
+	input_log_snapshot_t last;          // What deltas are relative to, kept in sync on both ends
+	uint64_t             records;
+	uint64_t             bytes;
+};
+
+static_assert(sizeof(XrPosef) == 7 * sizeof(float), "Poses are written to the log as 7 packed floats");
+
+///////////////////////////////////////////
+
+inline void input_log_write_varint(input_log_t& log, uint64_t value) {
+	uint8_t buffer[10];
+	int32_t size = 0;
+	do {
+		uint8_t byte = value & 0x7F;
+		value >>= 7;
+		buffer[size++] = byte | (value ? 0x80 : 0);
+	} while (value);
+	fwrite(buffer, 1, size, log.file);
+	log.bytes += size;
+}
+
+inline bool input_log_read_varint(input_log_t& log, uint64_t* out_value) {
+	uint64_t value = 0;
+	for (int32_t shift = 0; shift < 64; shift += 7) {
+		int byte = fgetc(log.file);
+		if (byte == EOF)
+			return false;
+		value |= (uint64_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			*out_value = value;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Zigzag encoding maps small negative numbers to small positive ones, so time deltas
+// in either direction stay short.
+inline uint64_t input_log_zigzag  (int64_t  value) { return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63); }
+inline int64_t  input_log_unzigzag(uint64_t value) { return (int64_t)(value >> 1) ^ -(int64_t)(value & 1); }
+
+///////////////////////////////////////////
+
+// Starts recording to, or replaying from, an already opened file. The log takes
+// ownership of the file, and closes it in input_log_end.
+inline bool input_log_begin(input_log_t& log, FILE* file, input_log_mode_t mode) {
+	log      = {};
+	log.file = file;
+	log.mode = mode;
+	log.last.hand_pose[0] = log.last.hand_pose[1] = { {0,0,0,1}, {0,0,0} };
+
+	uint32_t header[2] = { input_log_magic, input_log_version };
+	if (mode == input_log_record) {
+		log.bytes = fwrite(header, 1, sizeof(header), file);
+		return log.bytes == sizeof(header);
+	}
+
+	uint32_t file_header[2] = {};
+	if (fread(file_header, 1, sizeof(file_header), file) != sizeof(file_header) ||
+		memcmp(header, file_header, sizeof(header)) != 0) {
+		log.finished = true;
+		return false;
+	}
+	return true;
+}
+
+///////////////////////////////////////////
+
+inline void input_log_end(input_log_t& log) {
+	if (log.file)
+		fclose(log.file);
+	log.file = nullptr;
+	log.mode = input_log_off;
+}
+
+///////////////////////////////////////////
+
+inline void input_log_write_session(input_log_t& log, XrSessionState state) {
+	fputc(input_log_tag_session, log.file);
+	log.bytes += 1;
+	input_log_write_varint(log, (uint64_t)state);
+	log.session_state = state;
+	log.records += 1;
+}
+
+///////////////////////////////////////////
+
+inline void input_log_write_snapshot(input_log_t& log, uint8_t tag, const input_log_snapshot_t& snapshot) {
+	uint8_t flags = 0;
+	if (snapshot.render_hand[0]) flags |= input_log_flag_render0;
+	if (snapshot.render_hand[1]) flags |= input_log_flag_render1;
+	if (snapshot.hand_select[0]) flags |= input_log_flag_select0;
+	if (snapshot.hand_select[1]) flags |= input_log_flag_select1;
+	for (int32_t hand = 0; hand < 2; hand++) {
+		// Compare bits rather than floats, so -0 and NaNs come back exactly as they went in
+		if (snapshot.hand_pose_time[hand] != log.last.hand_pose_time[hand] ||
+			memcmp(&snapshot.hand_pose[hand], &log.last.hand_pose[hand], sizeof(XrPosef)) != 0)
+			flags |= hand == 0 ? input_log_flag_pose0 : input_log_flag_pose1;
+	}
+
+	uint8_t prefix[2] = { tag, flags };
+	fwrite(prefix, 1, sizeof(prefix), log.file);
+	log.bytes += sizeof(prefix);
+	input_log_write_varint(log, input_log_zigzag(snapshot.predicted_time - log.last.predicted_time));
+	for (int32_t hand = 0; hand < 2; hand++) {
+		if ((flags & (hand == 0 ? input_log_flag_pose0 : input_log_flag_pose1)) == 0)
+			continue;
+		input_log_write_varint(log, input_log_zigzag(snapshot.hand_pose_time[hand] - log.last.hand_pose_time[hand]));
+		fwrite(&snapshot.hand_pose[hand], 1, sizeof(XrPosef), log.file);
+		log.bytes += sizeof(XrPosef);
+	}
+
+	log.last     = snapshot;
+	log.records += 1;
+}
+
+///////////////////////////////////////////
+
+// Reads records up to the next snapshot, which must have the tag we're expecting, since
+// the replay makes the same calls in the same order the recording did. Session records
+// along the way just update log.session_state. Once the log runs out or goes off the
+// rails, this marks it finished and returns false.
+inline bool input_log_read_snapshot(input_log_t& log, uint8_t tag, input_log_snapshot_t* out_snapshot) {
+	while (!log.finished) {
+		int record_tag = fgetc(log.file);
+		if (record_tag == input_log_tag_session) {
+			uint64_t state;
+			if (!input_log_read_varint(log, &state))
+				break;
+			log.session_state = (XrSessionState)state;
+			log.records += 1;
+			continue;
+		}
+		if (record_tag != tag)
+			break;
+
+		int      flags = fgetc(log.file);
+		uint64_t delta;
+		if (flags == EOF || !input_log_read_varint(log, &delta))
+			break;
+
+		input_log_snapshot_t snapshot = log.last;
+		snapshot.predicted_time += input_log_unzigzag(delta);
+		snapshot.render_hand[0] = (flags & input_log_flag_render0) != 0;
+		snapshot.render_hand[1] = (flags & input_log_flag_render1) != 0;
+		snapshot.hand_select[0] = (flags & input_log_flag_select0) != 0;
+		snapshot.hand_select[1] = (flags & input_log_flag_select1) != 0;
+		bool valid = true;
+		for (int32_t hand = 0; hand < 2 && valid; hand++) {
+			if ((flags & (hand == 0 ? input_log_flag_pose0 : input_log_flag_pose1)) == 0)
+				continue;
+			valid = input_log_read_varint(log, &delta) &&
+				fread(&snapshot.hand_pose[hand], 1, sizeof(XrPosef), log.file) == sizeof(XrPosef);
+			snapshot.hand_pose_time[hand] += input_log_unzigzag(delta);
+		}
+		if (!valid)
+			break;
+
+		log.last      = snapshot;
+		log.records  += 1;
+		*out_snapshot = snapshot;
+		return true;
+	}
+	log.finished = true;
+	return false;
+}
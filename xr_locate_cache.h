@@ -0,0 +1,168 @@
+#pragma once
+
+#include <openxr/openxr.h>
+#include <stdint.h>
+#include <string.h>
+
+///////////////////////////////////////////
+
+// Remembers every xrLocateSpace result for the current frame, keyed by (space, base
+// space, time), so asking for the same location twice in a frame only goes to the
+// runtime once. Callers that know what they'll need can request their locations up
+// front, and resolve them together before reading any of them back. That's still one
+// xrLocateSpace call for each location: OpenXR 1.0 has no call that locates several
+// spaces at once. What it saves is the duplicates, everyone after the first asking for
+// the same location gets the one already located.
+//
+// Locations are only kept for a single frame, since the runtime keeps refining its
+// tracking, and a location for the same time may come out differently next frame.
+
+const int32_t locate_cache_capacity = 256; // Must be a power of two
+
+struct locate_entry_t {
+	XrSpace         space;
+	XrSpace         base;
+	XrTime          time;
+	XrResult        result;
+	XrSpaceLocation location;
+	bool            used;
+	bool            resolved;
+};
+
+struct locate_cache_counters_t {
+	uint64_t queries;       // Locations asked for
+	uint64_t hits;          // Queries answered by a location that was already resolved
+	uint64_t runtime_calls; // Calls that actually went to the runtime
+};
+
+struct locate_cache_t {
+	PFN_xrLocateSpace       locate; // xrLocateSpace, unless something else is standing in for the runtime
+	locate_entry_t          entries[locate_cache_capacity];
+	int32_t                 count;
+	int32_t                 pending; // Requested, but not resolved yet
+	locate_cache_counters_t counters;
+};
+
+///////////////////////////////////////////
+
+inline void locate_cache_init(locate_cache_t& cache, PFN_xrLocateSpace locate) {
+	cache        = {};
+	cache.locate = locate;
+}
+
+///////////////////////////////////////////
+
+// Forgets everything from last frame.
+inline void locate_cache_begin_frame(locate_cache_t& cache) {
+	if (cache.count == 0)
+		return;
+	for (int32_t i = 0; i < locate_cache_capacity; i++)
+		cache.entries[i].used = false;
+	cache.count   = 0;
+	cache.pending = 0;
+}
+
+///////////////////////////////////////////
+
+inline uint64_t locate_cache_hash(XrSpace space, XrSpace base, XrTime time) {
+	// Handles are pointers on 64 bit platforms and integers on 32 bit ones, so copy the bits out
+	uint64_t space_bits = 0, base_bits = 0;
+	memcpy(&space_bits, &space, sizeof(space));
+	memcpy(&base_bits,  &base,  sizeof(base));
+
+	uint64_t hash = 14695981039346656037ull;
+	uint64_t keys[3] = { space_bits, base_bits, (uint64_t)time };
+	for (int32_t i = 0; i < 3; i++) {
+		hash = (hash ^ keys[i]) * 1099511628211ull;
+		hash ^= hash >> 29;
+	}
+	return hash;
+}
+
+///////////////////////////////////////////
+
+// Finds the entry for this location, adding an unresolved one if it's new. Returns
+// nullptr if the cache is too full to take it.
+inline locate_entry_t* locate_cache_request(locate_cache_t& cache, XrSpace space, XrSpace base, XrTime time) {
+	cache.counters.queries += 1;
+
+	// Keep the table at most half full, so probes stay short
+	uint32_t mask = locate_cache_capacity - 1;
+	for (uint32_t slot = (uint32_t)locate_cache_hash(space, base, time) & mask; ; slot = (slot + 1) & mask) {
+		locate_entry_t& entry = cache.entries[slot];
+		if (!entry.used) {
+			if (cache.count >= locate_cache_capacity / 2)
+				return nullptr;
+			entry          = {};
+			entry.used     = true;
+			entry.space    = space;
+			entry.base     = base;
+			entry.time     = time;
+			entry.result   = XR_ERROR_VALIDATION_FAILURE;
+			entry.location = { XR_TYPE_SPACE_LOCATION };
+			cache.count   += 1;
+			cache.pending += 1;
+			return &entry;
+		}
+		// Asking again before the resolve doesn't save anything yet, it's only a hit
+		// once it gets an answer without going to the runtime
+		if (entry.space == space && entry.base == base && entry.time == time) {
+			if (entry.resolved)
+				cache.counters.hits += 1;
+			return &entry;
+		}
+	}
+}
+
+///////////////////////////////////////////
+
+// Goes to the runtime for everything that's been requested but not located yet, one
+// xrLocateSpace call each.
+inline void locate_cache_resolve(locate_cache_t& cache) {
+	if (cache.pending == 0)
+		return;
+	for (int32_t i = 0; i < locate_cache_capacity; i++) {
+		locate_entry_t& entry = cache.entries[i];
+		if (!entry.used || entry.resolved)
+			continue;
+		entry.result   = cache.locate(entry.space, entry.base, entry.time, &entry.location);
+		entry.resolved = true;
+		cache.counters.runtime_calls += 1;
+	}
+	cache.pending = 0;
+}
+
+///////////////////////////////////////////
+
+// Locates a space the same way xrLocateSpace would, but through the cache.
+inline XrResult locate_cache_locate(locate_cache_t& cache, XrSpace space, XrSpace base, XrTime time, XrSpaceLocation* out_location) {
+	locate_entry_t* entry = locate_cache_request(cache, space, base, time);
+	if (entry == nullptr) {
+		cache.counters.runtime_calls += 1;
+		return cache.locate(space, base, time, out_location);
+	}
+	if (!entry->resolved) {
+		entry->result   = cache.locate(space, base, time, &entry->location);
+		entry->resolved = true;
+		cache.pending  -= 1;
+		cache.counters.runtime_calls += 1;
+	}
+	*out_location = entry->location;
+	return entry->result;
+}
+
+///////////////////////////////////////////
+
+// Same as locate_cache_locate, but only hands back the pose, and only if both its
+// position and orientation are valid.
+inline bool locate_cache_pose(locate_cache_t& cache, XrSpace space, XrSpace base, XrTime time, XrPosef* out_pose) {
+	XrSpaceLocation location = { XR_TYPE_SPACE_LOCATION };
+	XrResult        result   = locate_cache_locate(cache, space, base, time, &location);
+	if (XR_UNQUALIFIED_SUCCESS(result) &&
+		(location.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT) != 0 &&
+		(location.locationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT) != 0) {
+		*out_pose = location.pose;
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <openxr/openxr.h>
+#include <directxmath.h>
+#include <stdint.h>
+
+///////////////////////////////////////////
+
+// A One Euro filter for tracked poses (https://cristal.univ-lille.fr/~casiez/1euro/)!
+// When a pose is sitting still, the cutoff frequency is low, so jitter gets smoothed
+// away. As it starts moving, the cutoff rises with its speed, so the filter stops
+// lagging behind. Orientation gets the same treatment using angular speed and slerp.
+// The filtered velocities are then used to extrapolate a short way to the time the
+// frame will actually be displayed.
+//
+// State is stored structure-of-arrays: each XMVECTOR holds the same component for 4
+// tracked spaces, so a whole batch of spaces goes through the same SIMD math at once.
+
+struct pose_filter_config_t {
+	bool  enabled;
+	float min_cutoff;        // Hz, position cutoff at rest. Lower is smoother, but lags more
+	float beta;              // How quickly the position cutoff rises with speed, per m/s
+	float rot_min_cutoff;    // Hz, orientation cutoff at rest
+	float rot_beta;          // How quickly the orientation cutoff rises with speed, per rad/s
+	float d_cutoff;          // Hz, cutoff for the velocity estimates themselves
+	float lead;              // Seconds to extrapolate past the target time, to hide filter lag
+	float max_extrapolation; // Seconds, we never extrapolate further than this
+	float reset_time;        // Seconds, a space we haven't seen in this long starts over
+};
+
+const pose_filter_config_t pose_filter_default_config = {
+	true,  // enabled
+	1.0f,  // min_cutoff
+	50.0f, // beta
+	1.0f,  // rot_min_cutoff
+	10.0f, // rot_beta
+	1.0f,  // d_cutoff
+	0.0f,  // lead
+	0.05f, // max_extrapolation
+	0.25f, // reset_time
+};
+
+const int32_t pose_filter_max_spaces = 8; // Must be a multiple of 4
+
+struct pose_filter_lanes_t {
+	DirectX::XMVECTOR position[3];
+	DirectX::XMVECTOR velocity[3];
+	DirectX::XMVECTOR orientation[4];
+	DirectX::XMVECTOR angular_velocity[3]; // World space, radians per second
+	DirectX::XMVECTOR raw_position[3];     // Last unfiltered sample, velocities come from these
+	DirectX::XMVECTOR raw_orientation[4];
+};
+
+struct pose_filter_t {
+	pose_filter_config_t config;
+	int32_t              space_count;
+	pose_filter_lanes_t  lanes[pose_filter_max_spaces / 4];
+	XrTime               sample_time[pose_filter_max_spaces];
+	bool                 initialized[pose_filter_max_spaces];
+};
+
+///////////////////////////////////////////
+
+inline void pose_filter_init(pose_filter_t& filter, int32_t space_count, const pose_filter_config_t& config) {
+	filter             = {};
+	filter.config      = config;
+	filter.space_count = space_count < pose_filter_max_spaces ? space_count : pose_filter_max_spaces;
+	for (int32_t g = 0; g < pose_filter_max_spaces / 4; g++) {
+		filter.lanes[g].orientation    [3] = DirectX::g_XMOne;
+		filter.lanes[g].raw_orientation[3] = DirectX::g_XMOne;
+	}
+}
+
+///////////////////////////////////////////
+
+// How much of the new value to blend in for a low-pass filter with this cutoff. This is
+// dt / (dt + tau), with tau = 1 / (2 pi cutoff).
+inline DirectX::XMVECTOR pose_filter_alpha(DirectX::FXMVECTOR cutoff, DirectX::FXMVECTOR dt) {
+	using namespace DirectX;
+	XMVECTOR tau = XMVectorReciprocal(XMVectorMultiply(cutoff, XMVectorReplicate(XM_2PI)));
+	return XMVectorDivide(dt, XMVectorAdd(dt, tau));
+}
+
+///////////////////////////////////////////
+
+inline DirectX::XMVECTOR pose_filter_length(DirectX::FXMVECTOR x, DirectX::FXMVECTOR y, DirectX::FXMVECTOR z) {
+	using namespace DirectX;
+	return XMVectorSqrt(XMVectorMultiplyAdd(x, x, XMVectorMultiplyAdd(y, y, XMVectorMultiply(z, z))));
+}
+
+///////////////////////////////////////////
+
+// Filters a batch of poses. raw[i] is the latest pose for space i, located at sample_time[i].
+// Spaces that aren't valid, or haven't got a newer sample since the last call, keep their
+// filter state and just extrapolate further. The results are extrapolated to target_time
+// (plus the configured lead), and written to out[i].
+inline void pose_filter_update(pose_filter_t& filter, const XrPosef* raw, const XrTime* sample_time, const XrBool32* valid, XrTime target_time, XrPosef* out) {
+	using namespace DirectX;
+	const pose_filter_config_t& config = filter.config;
+
+	if (!config.enabled) {
+		for (int32_t i = 0; i < filter.space_count; i++) {
+			out[i]                = raw[i];
+			filter.initialized[i] = false;
+		}
+		return;
+	}
+
+	for (int32_t g = 0; g * 4 < filter.space_count; g++) {
+		pose_filter_lanes_t& lanes = filter.lanes[g];
+
+		// Gather this group's samples into SoA form. Lanes that don't have a new sample get
+		// a dt of 1 and a zeroed update mask, so the math stays finite and leaves them alone.
+		XMFLOAT4A dt, update, reset, raw_p[3], raw_q[4];
+		float*    dt_f     = &dt.x;
+		float*    update_f = &update.x;
+		float*    reset_f  = &reset.x;
+		for (int32_t l = 0; l < 4; l++) {
+			int32_t i       = g * 4 + l;
+			bool    has_new = i < filter.space_count && valid[i] && (!filter.initialized[i] || sample_time[i] > filter.sample_time[i]);
+			float   seconds = has_new && filter.initialized[i] ? (float)((sample_time[i] - filter.sample_time[i]) * 1e-9) : 1.0f;
+
+			const XrPosef& pose = has_new ? raw[i] : XrPosef{ { 0, 0, 0, 1 }, { 0, 0, 0 } };
+			(&raw_p[0].x)[l] = pose.position.x;
+			(&raw_p[1].x)[l] = pose.position.y;
+			(&raw_p[2].x)[l] = pose.position.z;
+			(&raw_q[0].x)[l] = pose.orientation.x;
+			(&raw_q[1].x)[l] = pose.orientation.y;
+			(&raw_q[2].x)[l] = pose.orientation.z;
+			(&raw_q[3].x)[l] = pose.orientation.w;
+
+			dt_f[l]     = seconds < 0.0001f ? 0.0001f : seconds;
+			update_f[l] = has_new ? 1.0f : 0.0f;
+			reset_f[l]  = has_new && (!filter.initialized[i] || seconds > config.reset_time) ? 1.0f : 0.0f;
+			if (has_new) {
+				filter.sample_time[i] = sample_time[i];
+				filter.initialized[i] = true;
+			}
+		}
+
+		XMVECTOR v_dt        = XMLoadFloat4A(&dt);
+		XMVECTOR v_inv_dt    = XMVectorReciprocal(v_dt);
+		XMVECTOR mask_update = XMVectorGreater(XMLoadFloat4A(&update), XMVectorZero());
+		XMVECTOR mask_reset  = XMVectorGreater(XMLoadFloat4A(&reset),  XMVectorZero());
+		XMVECTOR alpha_d     = pose_filter_alpha(XMVectorReplicate(config.d_cutoff), v_dt);
+
+		// Position: estimate and smooth the velocity, then use its speed to pick a cutoff. The
+		// velocity comes from raw samples rather than filtered ones, since the filtered pose
+		// lags behind and would make the extrapolation overshoot.
+		XMVECTOR p_raw[3], p_vel[3];
+		for (int32_t c = 0; c < 3; c++) {
+			p_raw[c] = XMLoadFloat4A(&raw_p[c]);
+			p_vel[c] = XMVectorLerpV(lanes.velocity[c], XMVectorMultiply(XMVectorSubtract(p_raw[c], lanes.raw_position[c]), v_inv_dt), alpha_d);
+		}
+		XMVECTOR p_speed  = pose_filter_length(p_vel[0], p_vel[1], p_vel[2]);
+		XMVECTOR p_cutoff = XMVectorMultiplyAdd(p_speed, XMVectorReplicate(config.beta), XMVectorReplicate(config.min_cutoff));
+		XMVECTOR p_alpha  = pose_filter_alpha(p_cutoff, v_dt);
+
+		// Orientation: q and -q are the same rotation, so flip the new sample onto the same
+		// side as our filtered one, or we'd end up slerping the long way around.
+		XMVECTOR q_prev[4] = { lanes.orientation[0], lanes.orientation[1], lanes.orientation[2], lanes.orientation[3] };
+		XMVECTOR q_raw[4];
+		for (int32_t c = 0; c < 4; c++) q_raw[c] = XMLoadFloat4A(&raw_q[c]);
+		XMVECTOR q_dot  = XMVectorMultiplyAdd(q_raw[0], q_prev[0], XMVectorMultiplyAdd(q_raw[1], q_prev[1], XMVectorMultiplyAdd(q_raw[2], q_prev[2], XMVectorMultiply(q_raw[3], q_prev[3]))));
+		XMVECTOR q_sign = XMVectorSelect(g_XMOne, g_XMNegativeOne, XMVectorLess(q_dot, XMVectorZero()));
+		for (int32_t c = 0; c < 4; c++) q_raw[c] = XMVectorMultiply(q_raw[c], q_sign);
+		q_dot = XMVectorMin(XMVectorAbs(q_dot), g_XMOne);
+
+		// The rotation from the last raw orientation to the new one is raw * conjugate(last). For
+		// the small steps between frames, its vector part is about half the rotation vector. Its
+		// sign doesn't depend on which side of the hemisphere the last sample was on, since
+		// flipping one side flips the whole product.
+		XMVECTOR q_last[4] = { lanes.raw_orientation[0], lanes.raw_orientation[1], lanes.raw_orientation[2], lanes.raw_orientation[3] };
+		XMVECTOR l_dot     = XMVectorMultiplyAdd(q_raw[0], q_last[0], XMVectorMultiplyAdd(q_raw[1], q_last[1], XMVectorMultiplyAdd(q_raw[2], q_last[2], XMVectorMultiply(q_raw[3], q_last[3]))));
+		XMVECTOR l_sign    = XMVectorSelect(g_XMOne, g_XMNegativeOne, XMVectorLess(l_dot, XMVectorZero()));
+		for (int32_t c = 0; c < 4; c++) q_last[c] = XMVectorMultiply(q_last[c], l_sign);
+		XMVECTOR d_x = XMVectorSubtract(XMVectorSubtract(XMVectorMultiply(q_raw[0], q_last[3]), XMVectorMultiply(q_raw[3], q_last[0])), XMVectorSubtract(XMVectorMultiply(q_raw[1], q_last[2]), XMVectorMultiply(q_raw[2], q_last[1])));
+		XMVECTOR d_y = XMVectorSubtract(XMVectorSubtract(XMVectorMultiply(q_raw[1], q_last[3]), XMVectorMultiply(q_raw[3], q_last[1])), XMVectorSubtract(XMVectorMultiply(q_raw[2], q_last[0]), XMVectorMultiply(q_raw[0], q_last[2])));
+		XMVECTOR d_z = XMVectorSubtract(XMVectorSubtract(XMVectorMultiply(q_raw[2], q_last[3]), XMVectorMultiply(q_raw[3], q_last[2])), XMVectorSubtract(XMVectorMultiply(q_raw[0], q_last[1]), XMVectorMultiply(q_raw[1], q_last[0])));
+		XMVECTOR two_inv_dt = XMVectorAdd(v_inv_dt, v_inv_dt);
+		XMVECTOR r_vel[3] = {
+			XMVectorLerpV(lanes.angular_velocity[0], XMVectorMultiply(d_x, two_inv_dt), alpha_d),
+			XMVectorLerpV(lanes.angular_velocity[1], XMVectorMultiply(d_y, two_inv_dt), alpha_d),
+			XMVectorLerpV(lanes.angular_velocity[2], XMVectorMultiply(d_z, two_inv_dt), alpha_d) };
+		XMVECTOR r_speed  = pose_filter_length(r_vel[0], r_vel[1], r_vel[2]);
+		XMVECTOR r_cutoff = XMVectorMultiplyAdd(r_speed, XMVectorReplicate(config.rot_beta), XMVectorReplicate(config.rot_min_cutoff));
+		XMVECTOR r_alpha  = pose_filter_alpha(r_cutoff, v_dt);
+
+		// Slerp weights for each lane, falling back to a plain lerp when the two are close
+		// enough that sin(theta) gets too small to divide by.
+		XMVECTOR theta     = XMVectorACos(q_dot);
+		XMVECTOR sin_theta = XMVectorSin(theta);
+		XMVECTOR use_lerp  = XMVectorGreater(q_dot, XMVectorReplicate(0.9995f));
+		XMVECTOR w_prev    = XMVectorSelect(XMVectorDivide(XMVectorSin(XMVectorMultiply(XMVectorSubtract(g_XMOne, r_alpha), theta)), sin_theta), XMVectorSubtract(g_XMOne, r_alpha), use_lerp);
+		XMVECTOR w_raw     = XMVectorSelect(XMVectorDivide(XMVectorSin(XMVectorMultiply(r_alpha, theta)), sin_theta), r_alpha, use_lerp);
+		XMVECTOR q_new[4];
+		for (int32_t c = 0; c < 4; c++) q_new[c] = XMVectorMultiplyAdd(q_prev[c], w_prev, XMVectorMultiply(q_raw[c], w_raw));
+		XMVECTOR q_inv_len = XMVectorReciprocalSqrt(XMVectorMultiplyAdd(q_new[0], q_new[0], XMVectorMultiplyAdd(q_new[1], q_new[1], XMVectorMultiplyAdd(q_new[2], q_new[2], XMVectorMultiply(q_new[3], q_new[3])))));
+
+		// Commit the new state for lanes that had a sample, and start over on lanes that
+		// are new or have been gone for a while.
+		for (int32_t c = 0; c < 3; c++) {
+			XMVECTOR position = XMVectorSelect(lanes.position[c], XMVectorLerpV(lanes.position[c], p_raw[c], p_alpha), mask_update);
+			lanes.position[c]         = XMVectorSelect(position, p_raw[c], mask_reset);
+			lanes.velocity[c]         = XMVectorSelect(XMVectorSelect(lanes.velocity[c], p_vel[c], mask_update), XMVectorZero(), mask_reset);
+			lanes.angular_velocity[c] = XMVectorSelect(XMVectorSelect(lanes.angular_velocity[c], r_vel[c], mask_update), XMVectorZero(), mask_reset);
+			lanes.raw_position[c]     = XMVectorSelect(lanes.raw_position[c], p_raw[c], mask_update);
+		}
+		for (int32_t c = 0; c < 4; c++) {
+			XMVECTOR orientation = XMVectorSelect(lanes.orientation[c], XMVectorMultiply(q_new[c], q_inv_len), mask_update);
+			lanes.orientation[c]     = XMVectorSelect(orientation, q_raw[c], mask_reset);
+			lanes.raw_orientation[c] = XMVectorSelect(lanes.raw_orientation[c], q_raw[c], mask_update);
+		}
+
+		// Extrapolate each lane from its last sample to the target time, with constant
+		// linear and angular velocity.
+		XMFLOAT4A horizon;
+		float*    horizon_f = &horizon.x;
+		for (int32_t l = 0; l < 4; l++) {
+			int32_t i = g * 4 + l;
+			float   h = i < filter.space_count ? (float)((target_time - filter.sample_time[i]) * 1e-9) + config.lead : 0.0f;
+			horizon_f[l] = h < 0 ? 0 : (h > config.max_extrapolation ? config.max_extrapolation : h);
+		}
+		XMVECTOR v_horizon = XMLoadFloat4A(&horizon);
+
+		XMFLOAT4A out_p[3], out_q[4];
+		for (int32_t c = 0; c < 3; c++) {
+			XMStoreFloat4A(&out_p[c], XMVectorMultiplyAdd(lanes.velocity[c], v_horizon, lanes.position[c]));
+		}
+
+		// Rotation by angular velocity w over time h, as a quaternion: axis * sin(|w|h/2), cos(|w|h/2).
+		// sin(|w|h/2) / |w| is written out so we never divide by a zero speed.
+		XMVECTOR w_speed = pose_filter_length(lanes.angular_velocity[0], lanes.angular_velocity[1], lanes.angular_velocity[2]);
+		XMVECTOR half    = XMVectorMultiply(XMVectorMultiply(w_speed, v_horizon), g_XMOneHalf);
+		XMVECTOR tiny    = XMVectorLess(w_speed, XMVectorReplicate(1e-6f));
+		XMVECTOR scale   = XMVectorSelect(XMVectorDivide(XMVectorSin(half), w_speed), XMVectorMultiply(v_horizon, g_XMOneHalf), tiny);
+		XMVECTOR e_x = XMVectorMultiply(lanes.angular_velocity[0], scale);
+		XMVECTOR e_y = XMVectorMultiply(lanes.angular_velocity[1], scale);
+		XMVECTOR e_z = XMVectorMultiply(lanes.angular_velocity[2], scale);
+		XMVECTOR e_w = XMVectorCos(half);
+
+		// out = e * orientation
+		const XMVECTOR* q = lanes.orientation;
+		XMStoreFloat4A(&out_q[0], XMVectorAdd(XMVectorAdd(XMVectorMultiply(e_w, q[0]), XMVectorMultiply(e_x, q[3])), XMVectorSubtract(XMVectorMultiply(e_y, q[2]), XMVectorMultiply(e_z, q[1]))));
+		XMStoreFloat4A(&out_q[1], XMVectorAdd(XMVectorAdd(XMVectorMultiply(e_w, q[1]), XMVectorMultiply(e_y, q[3])), XMVectorSubtract(XMVectorMultiply(e_z, q[0]), XMVectorMultiply(e_x, q[2]))));
+		XMStoreFloat4A(&out_q[2], XMVectorAdd(XMVectorAdd(XMVectorMultiply(e_w, q[2]), XMVectorMultiply(e_z, q[3])), XMVectorSubtract(XMVectorMultiply(e_x, q[1]), XMVectorMultiply(e_y, q[0]))));
+		XMStoreFloat4A(&out_q[3], XMVectorSubtract(XMVectorMultiply(e_w, q[3]), XMVectorAdd(XMVectorMultiply(e_x, q[0]), XMVectorAdd(XMVectorMultiply(e_y, q[1]), XMVectorMultiply(e_z, q[2])))));
+
+		for (int32_t l = 0; l < 4 && g * 4 + l < filter.space_count; l++) {
+			int32_t i = g * 4 + l;
+			if (!filter.initialized[i]) {
+				out[i] = raw[i];
+				continue;
+			}
+			out[i].position    = { (&out_p[0].x)[l], (&out_p[1].x)[l], (&out_p[2].x)[l] };
+			out[i].orientation = { (&out_q[0].x)[l], (&out_q[1].x)[l], (&out_q[2].x)[l], (&out_q[3].x)[l] };
+		}
+	}
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <openxr/openxr.h>
+#include <atomic>
+#include <math.h>
+#include <stdint.h>
+
+///////////////////////////////////////////
+
+// A fixed size history of timestamped poses for one tracked space. A single thread
+// (the frame loop) writes samples in increasing time order, and any number of threads
+// can read from it at the same time without taking a lock. Readers copy out what they
+// need, and then check that the writer didn't lap them while they were reading, which
+// is the same trick a seqlock uses.
+//
+// This lets select events, camera frames and telemetry ask "where was this hand at
+// time T?" without another trip to xrLocateSpace.
+
+const uint32_t   pose_history_capacity = 128;       // Must be a power of two
+const XrDuration pose_history_max_gap  = 100000000; // 100ms, we won't interpolate across tracking gaps longer than this
+
+struct pose_sample_t {
+	XrTime  time;
+	XrPosef pose;
+};
+
+struct pose_history_t {
+	pose_sample_t         samples[pose_history_capacity];
+	std::atomic<uint64_t> writing;   // Number of samples the writer has started on
+	std::atomic<uint64_t> committed; // Number of samples that are finished and readable
+};
+
+///////////////////////////////////////////
+
+inline XrQuaternionf pose_quat_slerp(XrQuaternionf a, XrQuaternionf b, float t) {
+	// Quaternions q and -q are the same rotation, so flip b if that gets us the short way around
+	float dot = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+	if (dot < 0) {
+		b   = { -b.x, -b.y, -b.z, -b.w };
+		dot = -dot;
+	}
+
+	// When the two are nearly identical, sin(theta) gets too small to divide by, but a
+	// plain lerp is just as good there.
+	float weight_a = 1 - t;
+	float weight_b = t;
+	if (dot < 0.9995f) {
+		float theta     = acosf(dot);
+		float sin_theta = sinf(theta);
+		weight_a = sinf((1 - t) * theta) / sin_theta;
+		weight_b = sinf(t * theta) / sin_theta;
+	}
+
+	XrQuaternionf result = {
+		weight_a * a.x + weight_b * b.x,
+		weight_a * a.y + weight_b * b.y,
+		weight_a * a.z + weight_b * b.z,
+		weight_a * a.w + weight_b * b.w };
+	float length = sqrtf(result.x * result.x + result.y * result.y + result.z * result.z + result.w * result.w);
+	result = { result.x / length, result.y / length, result.z / length, result.w / length };
+	return result;
+}
+
+///////////////////////////////////////////
+
+inline XrPosef pose_interpolate(const XrPosef& a, const XrPosef& b, float t) {
+	XrPosef result;
+	result.orientation = pose_quat_slerp(a.orientation, b.orientation, t);
+	result.position    = {
+		a.position.x + (b.position.x - a.position.x) * t,
+		a.position.y + (b.position.y - a.position.y) * t,
+		a.position.z + (b.position.z - a.position.z) * t };
+	return result;
+}
+
+///////////////////////////////////////////
+
+// Adds a new sample to the history, overwriting the oldest one once it's full. Samples
+// must come in with increasing timestamps, anything at or before the newest sample is
+// ignored. Only one thread may call this for a given history!
+inline bool pose_history_push(pose_history_t& history, XrTime time, const XrPosef& pose) {
+	uint64_t count = history.committed.load(std::memory_order_relaxed);
+	if (count > 0 && time <= history.samples[(count - 1) & (pose_history_capacity - 1)].time)
+		return false;
+
+	// Let readers know this slot is about to change before we touch it
+	history.writing.store(count + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	pose_sample_t& sample = history.samples[count & (pose_history_capacity - 1)];
+	sample.time = time;
+	sample.pose = pose;
+
+	history.committed.store(count + 1, std::memory_order_release);
+	return true;
+}
+
+///////////////////////////////////////////
+
+// Finds the pose at an arbitrary time by binary searching for the two samples around it,
+// and interpolating between them. Returns false if the time is outside of the history,
+// or falls in a gap where tracking was lost, we don't extrapolate here.
+inline bool pose_history_sample(const pose_history_t& history, XrTime time, XrPosef* out_pose) {
+	for (int32_t attempt = 0; attempt < 4; attempt++) {
+		uint64_t count = history.committed.load(std::memory_order_acquire);
+		if (count == 0)
+			return false;
+
+		// The slot after the newest one may be getting overwritten right now, so the
+		// oldest sample we can trust is one newer than capacity would suggest.
+		uint64_t oldest = count > pose_history_capacity - 1 ? count - (pose_history_capacity - 1) : 0;
+		uint64_t newest = count - 1;
+
+		pose_sample_t first = history.samples[oldest & (pose_history_capacity - 1)];
+		pose_sample_t last  = history.samples[newest & (pose_history_capacity - 1)];
+		pose_sample_t before = first;
+		pose_sample_t after  = first;
+		bool          found  = time >= first.time && time <= last.time;
+		if (found) {
+			// Find the first sample at or after the time we're looking for
+			uint64_t lo = oldest, hi = newest;
+			while (lo < hi) {
+				uint64_t mid = lo + (hi - lo) / 2;
+				if (history.samples[mid & (pose_history_capacity - 1)].time < time) lo = mid + 1;
+				else                                                                hi = mid;
+			}
+			after  = history.samples[lo & (pose_history_capacity - 1)];
+			before = lo > oldest ? history.samples[(lo - 1) & (pose_history_capacity - 1)] : after;
+			found  = after.time - before.time <= pose_history_max_gap;
+		}
+
+		// If the writer started on a slot we read from, what we copied may be torn, so
+		// try again with a fresh view of the history.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint64_t writing = history.writing.load(std::memory_order_relaxed);
+		if (writing > pose_history_capacity && oldest < writing - pose_history_capacity)
+			continue;
+
+		if (!found)
+			return false;
+		float t = after.time == before.time
+			? 1.0f
+			: (float)((double)(time - before.time) / (double)(after.time - before.time));
+		*out_pose = pose_interpolate(before.pose, after.pose, t);
+		return true;
+	}
+	return false;
+}
+
+///////////////////////////////////////////
+
+// Gets the most recent sample in the history, returns false if there isn't one yet.
+inline bool pose_history_newest(const pose_history_t& history, pose_sample_t* out_sample) {
+	for (int32_t attempt = 0; attempt < 4; attempt++) {
+		uint64_t count = history.committed.load(std::memory_order_acquire);
+		if (count == 0)
+			return false;
+
+		pose_sample_t sample = history.samples[(count - 1) & (pose_history_capacity - 1)];
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint64_t writing = history.writing.load(std::memory_order_relaxed);
+		if (writing > pose_history_capacity && count - 1 < writing - pose_history_capacity)
+			continue;
+
+		*out_sample = sample;
+		return true;
+	}
+	return false;
+}
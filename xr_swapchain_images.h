@@ -0,0 +1,124 @@
+#pragma once
+
+#include <openxr/openxr.h>
+#include <chrono>
+#include <stdint.h>
+
+///////////////////////////////////////////
+
+// Acquiring, waiting on and releasing the swapchain images for a frame, with the time
+// spent blocked on the compositor counted apart from everything else. The OpenXR calls
+// go through swapchain_calls_t, so something else can stand in for the runtime.
+//
+// Rather than blocking forever on an image, we wait in short slices so we can count how
+// often the compositor makes us wait. After enough retries we give up on counting and
+// just wait it out, since we can't release an image we haven't waited on.
+//
+// An image that was acquired always gets released again, even when something fails
+// part way through the frame. Otherwise the next xrAcquireSwapchainImage on that
+// swapchain fails with XR_ERROR_CALL_ORDER_INVALID, and we'd never draw to it again.
+
+const XrDuration swapchain_wait_timeout = 2000000; // 2ms, in nanoseconds
+const uint32_t   swapchain_wait_retries = 50;
+
+struct swapchain_calls_t {
+	PFN_xrAcquireSwapchainImage acquire;
+	PFN_xrWaitSwapchainImage    wait;
+	PFN_xrReleaseSwapchainImage release;
+};
+
+struct swapchain_image_t {
+	XrSwapchain swapchain;
+	uint32_t    index;    // Image index we got from xrAcquireSwapchainImage this frame
+	bool        acquired;
+	bool        waited;
+};
+
+struct swapchain_timing_t {
+	double   acquire_ms; // Inside xrAcquireSwapchainImage
+	double   blocked_ms; // Inside xrWaitSwapchainImage
+	uint32_t wait_timeouts;
+	uint32_t failures;   // Frames where a call failed, and the images went back undrawn
+};
+
+///////////////////////////////////////////
+
+inline double swapchain_ms_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+///////////////////////////////////////////
+
+// Releases an image, whether or not it's been waited on yet. The runtime won't take
+// back an image that hasn't been waited on, so that happens first, for as long as it
+// takes. The release is tried even if that wait fails, it's the only way to get the
+// image back.
+inline void swapchain_release(const swapchain_calls_t& calls, swapchain_image_t& image, swapchain_timing_t& timing) {
+	if (!image.acquired)
+		return;
+	if (!image.waited) {
+		XrSwapchainImageWaitInfo wait_info = { XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO };
+		wait_info.timeout = XR_INFINITE_DURATION;
+
+		auto wait_start = std::chrono::steady_clock::now();
+		calls.wait(image.swapchain, &wait_info);
+		timing.blocked_ms += swapchain_ms_since(wait_start);
+	}
+
+	XrSwapchainImageReleaseInfo release_info = { XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO };
+	calls.release(image.swapchain, &release_info);
+	image.acquired = false;
+	image.waited   = false;
+}
+
+// Gives back every image still held, for when the frame can't be finished.
+inline void swapchain_release_all(const swapchain_calls_t& calls, swapchain_image_t* images, uint32_t count, swapchain_timing_t& timing) {
+	for (uint32_t i = 0; i < count; i++)
+		swapchain_release(calls, images[i], timing);
+	timing.failures += 1;
+}
+
+///////////////////////////////////////////
+
+// Acquires an image from each swapchain. If any of them fails, the ones already acquired
+// are released, and nothing is left held.
+inline bool swapchain_acquire_all(const swapchain_calls_t& calls, swapchain_image_t* images, uint32_t count, swapchain_timing_t& timing) {
+	auto acquire_start = std::chrono::steady_clock::now();
+	bool acquired      = true;
+	for (uint32_t i = 0; i < count && acquired; i++) {
+		XrSwapchainImageAcquireInfo acquire_info = { XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO };
+		acquired = XR_UNQUALIFIED_SUCCESS(calls.acquire(images[i].swapchain, &acquire_info, &images[i].index));
+		images[i].acquired = acquired;
+		images[i].waited   = false;
+	}
+	timing.acquire_ms += swapchain_ms_since(acquire_start);
+
+	if (!acquired)
+		swapchain_release_all(calls, images, count, timing);
+	return acquired;
+}
+
+///////////////////////////////////////////
+
+// Waits until the image is available to render to. The compositor could still be
+// reading from it! Any time spent in here is time we're blocked on the compositor.
+inline bool swapchain_wait(const swapchain_calls_t& calls, swapchain_image_t& image, swapchain_timing_t& timing) {
+	XrSwapchainImageWaitInfo wait_info = { XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO };
+	wait_info.timeout = swapchain_wait_timeout;
+
+	auto     wait_start = std::chrono::steady_clock::now();
+	XrResult result     = XR_TIMEOUT_EXPIRED;
+	for (uint32_t attempt = 0; result == XR_TIMEOUT_EXPIRED; attempt++) {
+		if (attempt == swapchain_wait_retries)
+			wait_info.timeout = XR_INFINITE_DURATION;
+		result = calls.wait(image.swapchain, &wait_info);
+		if (result == XR_TIMEOUT_EXPIRED)
+			timing.wait_timeouts++;
+	}
+	timing.blocked_ms += swapchain_ms_since(wait_start);
+
+	// If it failed, the image still isn't ours to draw into, and swapchain_release
+	// gives the wait one more go before handing it back.
+	image.waited = XR_UNQUALIFIED_SUCCESS(result);
+	return image.waited;
+}